@@ -53,28 +53,32 @@ function(add_sample_inner TARGET SOURCES)
 	file(GLOB fragment-shaders ${CMAKE_CURRENT_SOURCE_DIR}/shaders/*.frag)
 	file(GLOB compute-shaders ${CMAKE_CURRENT_SOURCE_DIR}/shaders/*.comp)
 
-	# Add them to the build.
+	if(ANDROID)
+		set(output-assets ${CMAKE_CURRENT_SOURCE_DIR}/app/assets)
+	else(ANDROID)
+		set(output-assets ${CMAKE_BINARY_DIR}/samples/${TARGET}/assets)
+	endif(ANDROID)
+
+	# Add them to the build, and keep track of the compiled shaders for the asset pack.
+	set(shader-outputs)
 	foreach(vertex-shader ${vertex-shaders})
 		get_filename_component(p ${vertex-shader} NAME)
 		add_shader(${TARGET} ${p})
+		list(APPEND shader-outputs ${output-assets}/shaders/${p}.spv)
 	endforeach(vertex-shader)
 
 	foreach(fragment-shader ${fragment-shaders})
 		get_filename_component(p ${fragment-shader} NAME)
 		add_shader(${TARGET} ${p})
+		list(APPEND shader-outputs ${output-assets}/shaders/${p}.spv)
 	endforeach(fragment-shader)
 
 	foreach(compute-shader ${compute-shaders})
 		get_filename_component(p ${compute-shader} NAME)
 		add_shader(${TARGET} ${p})
+		list(APPEND shader-outputs ${output-assets}/shaders/${p}.spv)
 	endforeach(compute-shader)
 
-	if(ANDROID)
-		set(output-assets ${CMAKE_CURRENT_SOURCE_DIR}/app/assets)
-	else(ANDROID)
-		set(output-assets ${CMAKE_BINARY_DIR}/samples/${TARGET}/assets)
-	endif(ANDROID)
-
 	# Copy assets from sample to the appropriate location.
 	if(EXISTS ${CMAKE_CURRENT_SOURCE_DIR}/assets/textures)
 		file(MAKE_DIRECTORY ${output-assets})
@@ -82,6 +86,33 @@ function(add_sample_inner TARGET SOURCES)
 			COMMAND ${CMAKE_COMMAND} -E copy_directory ${CMAKE_CURRENT_SOURCE_DIR}/assets/textures ${output-assets}/textures)
 	endif(EXISTS ${CMAKE_CURRENT_SOURCE_DIR}/assets/textures)
 
+	# Bundle all assets into a single pack, which the asset manager reads instead of the loose files.
+	# The pack is rebuilt whenever a texture or shader changes, even if the sample does not relink,
+	# since a stale pack would silently win over the loose files. The textures are copied again first,
+	# so the pack never picks up old copies.
+	# The packer runs on the host, so this is not available when cross-compiling.
+	if(PACK_ASSETS AND TARGET asset-packer)
+		file(MAKE_DIRECTORY ${output-assets})
+		set(pack-commands)
+		set(texture-sources)
+		if(EXISTS ${CMAKE_CURRENT_SOURCE_DIR}/assets/textures)
+			file(GLOB_RECURSE texture-sources ${CMAKE_CURRENT_SOURCE_DIR}/assets/textures/*)
+			set(pack-commands
+				COMMAND ${CMAKE_COMMAND} -E copy_directory ${CMAKE_CURRENT_SOURCE_DIR}/assets/textures ${output-assets}/textures)
+		endif(EXISTS ${CMAKE_CURRENT_SOURCE_DIR}/assets/textures)
+
+		add_custom_command(
+			OUTPUT ${output-assets}/assets.pack
+			${pack-commands}
+			COMMAND $<TARGET_FILE:asset-packer> ${output-assets} ${output-assets}/assets.pack
+			DEPENDS ${texture-sources} ${shader-outputs} asset-packer
+			VERBATIM)
+		add_custom_target(${TARGET}-assets ALL DEPENDS ${output-assets}/assets.pack)
+
+		# The shaders are compiled as part of the sample, so build it first.
+		add_dependencies(${TARGET}-assets ${TARGET})
+	endif(PACK_ASSETS AND TARGET asset-packer)
+
 	# Make a test out of every sample if not on Android.
 	if(NOT ANDROID)
 		add_test(NAME ${TARGET} COMMAND $<TARGET_FILE:${TARGET}> 200)
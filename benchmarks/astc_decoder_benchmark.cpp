@@ -0,0 +1,252 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Decodes an ASTC image with the software decoder and measures its throughput
+// on a single thread and on a thread pool. If a reference decode is given as
+// an uncompressed RGBA8 KTX file written by astcenc -dl (or -ds for sRGB),
+// the result is compared with it bit by bit. An empty reference path skips
+// the check. ctest checks the sample icons against the decodes in data/.
+// With --srgb, the image is decoded as the matching SRGB format.
+// Returns a non-zero exit code if the decode fails or differs from the
+// reference, and SkipExitCode if the reference does not exist.
+//
+// Usage: astc-decoder-benchmark [--srgb] image.astc [reference.ktx] [threads]
+
+#include "framework/astc_decoder.hpp"
+#include "framework/thread_pool.hpp"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+using namespace MaliSDK;
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+namespace
+{
+const unsigned Iterations = 20;
+
+// Matches SKIP_RETURN_CODE of the ctest checks.
+const int SkipExitCode = 77;
+
+bool readFile(const char *pPath, vector<uint8_t> *pData)
+{
+	FILE *pFile = fopen(pPath, "rb");
+	if (!pFile)
+		return false;
+
+	fseek(pFile, 0, SEEK_END);
+	long size = ftell(pFile);
+	fseek(pFile, 0, SEEK_SET);
+	pData->resize(size > 0 ? size : 0);
+	bool success = fread(pData->data(), 1, pData->size(), pFile) == pData->size();
+	fclose(pFile);
+	return success;
+}
+
+uint32_t readLE(const uint8_t *pData, unsigned bytes)
+{
+	uint32_t value = 0;
+	for (unsigned i = 0; i < bytes; i++)
+		value |= uint32_t(pData[i]) << (8 * i);
+	return value;
+}
+
+VkFormat getFormat(unsigned blockWidth, unsigned blockHeight, bool srgb)
+{
+	static const VkFormat Formats[][2] = {
+		{ VK_FORMAT_ASTC_4x4_UNORM_BLOCK, VK_FORMAT_ASTC_4x4_SRGB_BLOCK },
+		{ VK_FORMAT_ASTC_5x4_UNORM_BLOCK, VK_FORMAT_ASTC_5x4_SRGB_BLOCK },
+		{ VK_FORMAT_ASTC_5x5_UNORM_BLOCK, VK_FORMAT_ASTC_5x5_SRGB_BLOCK },
+		{ VK_FORMAT_ASTC_6x5_UNORM_BLOCK, VK_FORMAT_ASTC_6x5_SRGB_BLOCK },
+		{ VK_FORMAT_ASTC_6x6_UNORM_BLOCK, VK_FORMAT_ASTC_6x6_SRGB_BLOCK },
+		{ VK_FORMAT_ASTC_8x5_UNORM_BLOCK, VK_FORMAT_ASTC_8x5_SRGB_BLOCK },
+		{ VK_FORMAT_ASTC_8x6_UNORM_BLOCK, VK_FORMAT_ASTC_8x6_SRGB_BLOCK },
+		{ VK_FORMAT_ASTC_8x8_UNORM_BLOCK, VK_FORMAT_ASTC_8x8_SRGB_BLOCK },
+		{ VK_FORMAT_ASTC_10x5_UNORM_BLOCK, VK_FORMAT_ASTC_10x5_SRGB_BLOCK },
+		{ VK_FORMAT_ASTC_10x6_UNORM_BLOCK, VK_FORMAT_ASTC_10x6_SRGB_BLOCK },
+		{ VK_FORMAT_ASTC_10x8_UNORM_BLOCK, VK_FORMAT_ASTC_10x8_SRGB_BLOCK },
+		{ VK_FORMAT_ASTC_10x10_UNORM_BLOCK, VK_FORMAT_ASTC_10x10_SRGB_BLOCK },
+		{ VK_FORMAT_ASTC_12x10_UNORM_BLOCK, VK_FORMAT_ASTC_12x10_SRGB_BLOCK },
+		{ VK_FORMAT_ASTC_12x12_UNORM_BLOCK, VK_FORMAT_ASTC_12x12_SRGB_BLOCK },
+	};
+
+	for (auto &formats : Formats)
+	{
+		unsigned width, height;
+		getASTCBlockSize(formats[0], &width, &height);
+		if (width == blockWidth && height == blockHeight)
+			return formats[srgb ? 1 : 0];
+	}
+	return VK_FORMAT_UNDEFINED;
+}
+
+// Reads the first image of an uncompressed RGBA8 KTX file.
+bool readReference(const char *pPath, unsigned width, unsigned height, vector<uint8_t> *pPixels)
+{
+	static const uint8_t Identifier[12] = { 0xab, 'K', 'T', 'X', ' ', '1', '1', 0xbb, '\r', '\n', 0x1a, '\n' };
+	const uint32_t GL_UNSIGNED_BYTE = 0x1401;
+	const uint32_t GL_RGBA = 0x1908;
+
+	vector<uint8_t> file;
+	if (!readFile(pPath, &file) || file.size() < 68 || memcmp(file.data(), Identifier, sizeof(Identifier)) != 0 ||
+	    readLE(file.data() + 12, 4) != 0x04030201)
+	{
+		fprintf(stderr, "%s is not a little endian KTX file.\n", pPath);
+		return false;
+	}
+
+	if (readLE(file.data() + 16, 4) != GL_UNSIGNED_BYTE || readLE(file.data() + 24, 4) != GL_RGBA ||
+	    readLE(file.data() + 36, 4) != width || readLE(file.data() + 40, 4) != height)
+	{
+		fprintf(stderr, "%s is not a %u x %u RGBA8 image.\n", pPath, width, height);
+		return false;
+	}
+
+	size_t offset = 64 + readLE(file.data() + 60, 4);
+	size_t size = size_t(width) * height * 4;
+	if (offset + 4 + size > file.size() || readLE(file.data() + offset, 4) < size)
+	{
+		fprintf(stderr, "%s is truncated.\n", pPath);
+		return false;
+	}
+
+	pPixels->assign(file.begin() + offset + 4, file.begin() + offset + 4 + size);
+	return true;
+}
+
+size_t countMismatches(const vector<uint8_t> &decoded, const vector<uint8_t> &reference, unsigned width,
+                       unsigned height, bool flipped)
+{
+	size_t rowSize = size_t(width) * 4;
+	size_t mismatches = 0;
+	for (unsigned y = 0; y < height; y++)
+	{
+		const uint8_t *pDecoded = decoded.data() + y * rowSize;
+		const uint8_t *pReference = reference.data() + (flipped ? height - 1 - y : y) * rowSize;
+		for (size_t i = 0; i < rowSize; i++)
+			mismatches += pDecoded[i] != pReference[i];
+	}
+	return mismatches;
+}
+}
+
+int main(int argc, char **argv)
+{
+	bool srgb = argc > 1 && strcmp(argv[1], "--srgb") == 0;
+	if (srgb)
+	{
+		argv[1] = argv[0];
+		argc--;
+		argv++;
+	}
+
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s [--srgb] image.astc [reference.ktx] [threads]\n", argv[0]);
+		return 1;
+	}
+
+	const char *pReferencePath = argc > 2 && argv[2][0] != '\0' ? argv[2] : nullptr;
+	unsigned numThreads = argc > 3 ? strtoul(argv[3], nullptr, 0) : thread::hardware_concurrency();
+	if (numThreads == 0)
+		numThreads = 1;
+
+	vector<uint8_t> file;
+	if (!readFile(argv[1], &file) || file.size() < 16 || readLE(file.data(), 4) != 0x5ca1ab13)
+	{
+		fprintf(stderr, "Failed to read ASTC image %s.\n", argv[1]);
+		return 1;
+	}
+
+	unsigned blockWidth = file[4];
+	unsigned blockHeight = file[5];
+	unsigned width = readLE(file.data() + 7, 3);
+	unsigned height = readLE(file.data() + 10, 3);
+	VkFormat format = getFormat(blockWidth, blockHeight, srgb);
+	if (format == VK_FORMAT_UNDEFINED || file[6] != 1 || readLE(file.data() + 13, 3) != 1)
+	{
+		fprintf(stderr, "Unsupported block size %u x %u x %u.\n", blockWidth, blockHeight, file[6]);
+		return 1;
+	}
+
+	printf("%u x %u, %u x %u %s blocks, %u threads.\n", width, height, blockWidth, blockHeight,
+	       srgb ? "sRGB" : "UNORM", numThreads);
+
+	ThreadPool pool;
+	pool.setWorkerThreadCount(numThreads);
+
+	vector<uint8_t> decoded(size_t(width) * height * 4);
+	auto decode = [&](ThreadPool *pPool) {
+		return decodeASTCToRgba8888(decoded.data(), width * 4, file.data() + 16, file.size() - 16, format, width,
+		                            height, pPool);
+	};
+
+	if (FAILED(decode(nullptr)))
+		return 1;
+
+	for (unsigned run = 0; run < 2; run++)
+	{
+		ThreadPool *pPool = run ? &pool : nullptr;
+		auto start = Clock::now();
+		for (unsigned i = 0; i < Iterations; i++)
+			decode(pPool);
+		double elapsed = chrono::duration<double>(Clock::now() - start).count();
+		printf("%-8s %8.1f MTexels/s\n", run ? "parallel" : "single",
+		       width * double(height) * Iterations / elapsed * 1e-6);
+	}
+
+	if (!pReferencePath)
+		return 0;
+
+	FILE *pReferenceFile = fopen(pReferencePath, "rb");
+	if (!pReferenceFile)
+	{
+		printf("No reference decode at %s, skipping the check.\n", pReferencePath);
+		return SkipExitCode;
+	}
+	fclose(pReferenceFile);
+
+	vector<uint8_t> reference;
+	if (!readReference(pReferencePath, width, height, &reference))
+		return 1;
+
+	// Tools disagree on whether the first row is the top or the bottom of
+	// the image, so accept either orientation.
+	size_t mismatches = countMismatches(decoded, reference, width, height, false);
+	if (mismatches != 0 && countMismatches(decoded, reference, width, height, true) == 0)
+	{
+		printf("Bit exact with the reference, which is stored bottom row first.\n");
+		return 0;
+	}
+
+	if (mismatches != 0)
+	{
+		printf("%zu of %zu components differ from the reference.\n", mismatches, reference.size());
+		return 1;
+	}
+
+	printf("Bit exact with the reference.\n");
+	return 0;
+}
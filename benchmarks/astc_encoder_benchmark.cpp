@@ -0,0 +1,171 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Encodes a synthetic image with the software ASTC encoder at several block
+// sizes and measures its throughput on a single thread and on a thread pool.
+// Every encode is decoded again and compared with the source.
+// Returns a non-zero exit code if the encoder fails, if the thread pool
+// changes its output, or if the quality drops below what it is known to reach.
+//
+// Usage: astc-encoder-benchmark [threads] [iterations]
+
+#include "framework/astc_decoder.hpp"
+#include "framework/astc_encoder.hpp"
+#include "framework/thread_pool.hpp"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+using namespace MaliSDK;
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+namespace
+{
+const unsigned Width = 512;
+const unsigned Height = 512;
+
+// A mix of what textures contain: smooth gradients, hard edges, flat areas
+// and translucency.
+vector<uint8_t> createImage()
+{
+	vector<uint8_t> pixels(Width * Height * 4);
+	for (unsigned y = 0; y < Height; y++)
+	{
+		for (unsigned x = 0; x < Width; x++)
+		{
+			uint8_t *pPixel = pixels.data() + 4 * (y * Width + x);
+			float dx = x - Width * 0.5f;
+			float dy = y - Height * 0.5f;
+			float radius = sqrtf(dx * dx + dy * dy);
+			bool stripe = ((x + y) / 24) & 1;
+
+			if (y < Height / 2)
+			{
+				pPixel[0] = uint8_t(x / 2);
+				pPixel[1] = uint8_t(128 + 127 * sinf(radius * 0.05f));
+				pPixel[2] = stripe ? 220 : 30;
+				pPixel[3] = 0xff;
+			}
+			else if (x < Width / 2)
+			{
+				uint8_t grey = stripe ? uint8_t(y / 2) : 255;
+				pPixel[0] = grey;
+				pPixel[1] = grey;
+				pPixel[2] = grey;
+				pPixel[3] = uint8_t(x / 2);
+			}
+			else
+			{
+				pPixel[0] = 40;
+				pPixel[1] = 90;
+				pPixel[2] = 200;
+				pPixel[3] = radius < 100.0f ? 0xff : 0x80;
+			}
+		}
+	}
+	return pixels;
+}
+
+double computePSNR(const vector<uint8_t> &a, const vector<uint8_t> &b)
+{
+	double squaredError = 0.0;
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		double difference = double(a[i]) - double(b[i]);
+		squaredError += difference * difference;
+	}
+	return squaredError > 0.0 ? 10.0 * log10(255.0 * 255.0 * a.size() / squaredError) : 99.0;
+}
+}
+
+int main(int argc, char **argv)
+{
+	unsigned numThreads = argc > 1 ? strtoul(argv[1], nullptr, 0) : thread::hardware_concurrency();
+	unsigned iterations = argc > 2 ? strtoul(argv[2], nullptr, 0) : 3;
+	if (numThreads == 0)
+		numThreads = 1;
+	if (iterations == 0)
+		iterations = 1;
+
+	ThreadPool pool;
+	pool.setWorkerThreadCount(numThreads);
+	printf("%u x %u texels, %u threads.\n", Width, Height, numThreads);
+
+	// The minimum quality is a couple of dB below what the encoder reaches.
+	static const struct
+	{
+		VkFormat format;
+		const char *pName;
+		double minimumPSNR;
+	} Formats[] = {
+		{ VK_FORMAT_ASTC_4x4_UNORM_BLOCK, "4x4", 49.0 },
+		{ VK_FORMAT_ASTC_6x6_UNORM_BLOCK, "6x6", 38.0 },
+		{ VK_FORMAT_ASTC_8x8_UNORM_BLOCK, "8x8", 40.0 },
+		{ VK_FORMAT_ASTC_12x12_UNORM_BLOCK, "12x12", 28.0 },
+	};
+
+	vector<uint8_t> image = createImage();
+	vector<uint8_t> decoded(image.size());
+	bool success = true;
+
+	for (auto &format : Formats)
+	{
+		vector<uint8_t> blocks[2];
+		double rates[2];
+		for (unsigned run = 0; run < 2; run++)
+		{
+			ThreadPool *pPool = run ? &pool : nullptr;
+			auto start = Clock::now();
+			for (unsigned i = 0; i < iterations; i++)
+			{
+				if (FAILED(encodeASTCFromRgba8888(&blocks[run], image.data(), Width * 4, Width, Height, format.format,
+				                                  pPool)))
+					return 1;
+			}
+			double elapsed = chrono::duration<double>(Clock::now() - start).count();
+			rates[run] = Width * double(Height) * iterations / elapsed * 1e-6;
+		}
+
+		decodeASTCToRgba8888(decoded.data(), Width * 4, blocks[0].data(), blocks[0].size(), format.format, Width,
+		                     Height);
+		double psnr = computePSNR(image, decoded);
+		printf("%-6s single %6.2f MTexels/s, parallel %6.2f MTexels/s, %.2f dB\n", format.pName, rates[0], rates[1],
+		       psnr);
+
+		if (blocks[0] != blocks[1])
+		{
+			printf("%s: encoding on the thread pool changes the result.\n", format.pName);
+			success = false;
+		}
+
+		if (psnr < format.minimumPSNR)
+		{
+			printf("%s: quality is below %.1f dB.\n", format.pName, format.minimumPSNR);
+			success = false;
+		}
+	}
+
+	return success ? 0 : 1;
+}
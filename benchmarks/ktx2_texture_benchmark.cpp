@@ -0,0 +1,186 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Loads the KTX2 textures in data/, written by make_ktx2_fixtures.py, and
+// measures how long it takes to load them. Every texture is checked against
+// what the file describes: its type, size, mip levels, layers and cube faces,
+// and that the copy regions point at the right texels of every level, layer
+// and face at offsets which copies to images accept.
+// Returns a non-zero exit code if any of the checks fail.
+//
+// Usage: ktx2-texture-benchmark data-directory
+
+#include "framework/ktx2_texture.hpp"
+#include "platform/os.hpp"
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <string>
+
+using namespace MaliSDK;
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+namespace MaliSDK
+{
+// The default asset manager reads paths as they are.
+AssetManager &OS::getAssetManager()
+{
+	static AssetManager manager;
+	return manager;
+}
+}
+
+namespace
+{
+const unsigned Iterations = 1000;
+
+struct Fixture
+{
+	const char *pName;
+	VkFormat format;
+	VkImageViewType viewType;
+	VkImageCreateFlags flags;
+	unsigned width;
+	unsigned height;
+	unsigned mipLevels;
+	unsigned arrayLayers;
+	unsigned blockSize;
+};
+
+const Fixture Fixtures[] = {
+	{ "ktx2-mipmapped.ktx2", VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_VIEW_TYPE_2D, 0, 16, 8, 5, 1, 4 },
+	{ "ktx2-array.ktx2", VK_FORMAT_R8G8B8_UNORM, VK_IMAGE_VIEW_TYPE_2D_ARRAY, 0, 8, 4, 4, 3, 3 },
+	{ "ktx2-cube.ktx2", VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_VIEW_TYPE_CUBE, VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT, 8, 8, 4,
+	  6, 4 },
+};
+
+// The texel pattern of make_ktx2_fixtures.py.
+uint8_t getExpectedComponent(unsigned x, unsigned y, unsigned layer, unsigned level, unsigned component)
+{
+	return uint8_t(7 * x + 13 * y + 29 * layer + 53 * level + 71 * component);
+}
+
+bool checkTexture(const Fixture &fixture, const KTX2Texture &texture)
+{
+	if (texture.format != fixture.format || texture.imageType != VK_IMAGE_TYPE_2D ||
+	    texture.viewType != fixture.viewType || texture.flags != fixture.flags ||
+	    texture.extent.width != fixture.width || texture.extent.height != fixture.height ||
+	    texture.extent.depth != 1 || texture.mipLevels != fixture.mipLevels ||
+	    texture.arrayLayers != fixture.arrayLayers || texture.blockSize != fixture.blockSize)
+	{
+		printf("%s: the texture does not match the file.\n", fixture.pName);
+		return false;
+	}
+
+	if (texture.regions.size() != fixture.mipLevels)
+	{
+		printf("%s: expected one region per mip level.\n", fixture.pName);
+		return false;
+	}
+
+	const uint8_t *pData = static_cast<const uint8_t *>(texture.data.getData());
+	for (unsigned level = 0; level < fixture.mipLevels; level++)
+	{
+		const VkBufferImageCopy &region = texture.regions[level];
+		unsigned width = max(fixture.width >> level, 1u);
+		unsigned height = max(fixture.height >> level, 1u);
+		if (region.imageSubresource.mipLevel != level || region.imageSubresource.baseArrayLayer != 0 ||
+		    region.imageSubresource.layerCount != fixture.arrayLayers || region.imageExtent.width != width ||
+		    region.imageExtent.height != height || region.imageExtent.depth != 1)
+		{
+			printf("%s: region %u does not cover mip level %u.\n", fixture.pName, level, level);
+			return false;
+		}
+
+		if (region.bufferOffset % 4 != 0 || region.bufferOffset % fixture.blockSize != 0)
+		{
+			printf("%s: mip level %u is not aligned for copies.\n", fixture.pName, level);
+			return false;
+		}
+
+		size_t levelSize = size_t(width) * height * fixture.arrayLayers * fixture.blockSize;
+		if (region.bufferOffset + levelSize > texture.data.getSize())
+		{
+			printf("%s: mip level %u is outside of the data.\n", fixture.pName, level);
+			return false;
+		}
+
+		// Rows and images of a level are tightly packed.
+		const uint8_t *pTexel = pData + region.bufferOffset;
+		for (unsigned layer = 0; layer < fixture.arrayLayers; layer++)
+		{
+			for (unsigned y = 0; y < height; y++)
+			{
+				for (unsigned x = 0; x < width; x++, pTexel += fixture.blockSize)
+				{
+					for (unsigned c = 0; c < fixture.blockSize; c++)
+					{
+						if (pTexel[c] != getExpectedComponent(x, y, layer, level, c))
+						{
+							printf("%s: texel (%u, %u) of layer %u in mip level %u is wrong.\n", fixture.pName,
+							       x, y, layer, level);
+							return false;
+						}
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s data-directory\n", argv[0]);
+		return 1;
+	}
+
+	bool success = true;
+	for (auto &fixture : Fixtures)
+	{
+		string path = string(argv[1]) + "/" + fixture.pName;
+		KTX2Texture texture;
+		if (FAILED(loadKTX2TextureFromAsset(path.c_str(), &texture)))
+		{
+			printf("%s: failed to load.\n", fixture.pName);
+			success = false;
+			continue;
+		}
+
+		if (!checkTexture(fixture, texture))
+		{
+			success = false;
+			continue;
+		}
+
+		auto start = Clock::now();
+		for (unsigned i = 0; i < Iterations; i++)
+			loadKTX2TextureFromAsset(path.c_str(), &texture);
+		double elapsed = chrono::duration<double>(Clock::now() - start).count();
+		printf("%-20s %8.2f us per load\n", fixture.pName, elapsed / Iterations * 1e6);
+	}
+
+	return success ? 0 : 1;
+}
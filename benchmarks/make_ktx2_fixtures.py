@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+# Copyright (c) 2016-2017, ARM Limited and Contributors
+#
+# SPDX-License-Identifier: MIT
+#
+# Permission is hereby granted, free of charge,
+# to any person obtaining a copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation the rights to
+# use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+# and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+# INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+# IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+# WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+# Writes the KTX2 textures in benchmarks/data which ktx2-texture-benchmark loads:
+#
+#   make_ktx2_fixtures.py benchmarks/data
+#
+# Component c of the texel at (x, y) in layer or face l of mip level m is
+# (7 * x + 13 * y + 29 * l + 53 * m + 71 * c) & 0xff, so every copy region can be
+# checked texel by texel.
+
+import os, struct, sys
+from math import gcd
+
+VK_FORMAT_R8G8B8_UNORM = 23
+VK_FORMAT_R8G8B8A8_UNORM = 37
+VK_FORMAT_R8G8B8A8_SRGB = 43
+
+def texel(x, y, layer, level, components):
+    return bytes((7 * x + 13 * y + 29 * layer + 53 * level + 71 * c) & 0xff for c in range(components))
+
+def dfd(components, srgb):
+    # Basic data format descriptor with one 8-bit sample per channel. Alpha
+    # is linear in sRGB formats.
+    channels = [0, 1, 2, 15 | (0x10 if srgb else 0)][:components]
+    samples = b''.join(struct.pack('<HBBIII', 8 * i, 7, channel, 0, 0, 255) for i, channel in enumerate(channels))
+    block = struct.pack('<IHHBBBB4B8B', 0, 2, 24 + len(samples), 1, 1, 2 if srgb else 1, 0, 0, 0, 0, 0,
+                        components, 0, 0, 0, 0, 0, 0, 0) + samples
+    return struct.pack('<I', 4 + len(block)) + block
+
+def write_ktx2(path, vk_format, components, srgb, width, height, layers, faces, levels):
+    images = max(layers, 1) * faces
+    alignment = components * 4 // gcd(components, 4)
+    header_size = 80 + 24 * levels
+    descriptor = dfd(components, srgb)
+    offset = header_size + len(descriptor)
+
+    # The smallest level comes first, and every level starts at a multiple
+    # of the least common multiple of the texel size and 4.
+    level_index = [None] * levels
+    data = b''
+    for level in reversed(range(levels)):
+        w = max(width >> level, 1)
+        h = max(height >> level, 1)
+        padding = -(offset + len(data)) % alignment
+        data += b'\0' * padding
+        begin = offset + len(data)
+        for image in range(images):
+            for y in range(h):
+                for x in range(w):
+                    data += texel(x, y, image, level, components)
+        length = offset + len(data) - begin
+        level_index[level] = (begin, length, length)
+
+    header = bytes([0xab, 0x4b, 0x54, 0x58, 0x20, 0x32, 0x30, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a])
+    header += struct.pack('<9I', vk_format, 1, width, height, 0, layers, faces, levels, 0)
+    header += struct.pack('<4I2Q', header_size, len(descriptor), 0, 0, 0, 0)
+    for entry in level_index:
+        header += struct.pack('<3Q', *entry)
+    with open(path, 'wb') as f:
+        f.write(header + descriptor + data)
+
+directory = sys.argv[1] if len(sys.argv) > 1 else '.'
+write_ktx2(os.path.join(directory, 'ktx2-mipmapped.ktx2'), VK_FORMAT_R8G8B8A8_UNORM, 4, False, 16, 8, 0, 1, 5)
+write_ktx2(os.path.join(directory, 'ktx2-array.ktx2'), VK_FORMAT_R8G8B8_UNORM, 3, False, 8, 4, 3, 1, 4)
+write_ktx2(os.path.join(directory, 'ktx2-cube.ktx2'), VK_FORMAT_R8G8B8A8_SRGB, 4, True, 8, 8, 0, 6, 4)
@@ -0,0 +1,227 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Generates full mip chains for a synthetic image with the CPU mip generator
+// and measures its throughput on a single thread and on a thread pool.
+// Returns a non-zero exit code if the generator fails, if the thread pool
+// changes its output, if a box filtered level differs from the average of
+// the texels it covers, if a flat image of an odd size does not stay flat,
+// or if SRGB textures are not filtered in linear space.
+//
+// Usage: mip-generator-benchmark [threads] [iterations]
+
+#include "framework/mip_generator.hpp"
+#include "framework/thread_pool.hpp"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+using namespace MaliSDK;
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+namespace
+{
+const unsigned Width = 1024;
+const unsigned Height = 1024;
+
+vector<uint8_t> createImage()
+{
+	vector<uint8_t> pixels(Width * Height * 4);
+	for (unsigned y = 0; y < Height; y++)
+	{
+		for (unsigned x = 0; x < Width; x++)
+		{
+			uint8_t *pPixel = pixels.data() + 4 * (y * Width + x);
+			float dx = x - Width * 0.5f;
+			float dy = y - Height * 0.5f;
+			pPixel[0] = uint8_t(x / 4);
+			pPixel[1] = uint8_t(128 + 127 * sinf(sqrtf(dx * dx + dy * dy) * 0.1f));
+			pPixel[2] = ((x ^ y) & 8) ? 230 : 20;
+			pPixel[3] = uint8_t(y / 4);
+		}
+	}
+	return pixels;
+}
+
+// Every texel of the first box filtered level should be the average of the
+// 2x2 texels it covers, up to rounding.
+bool checkBoxFilter(const vector<uint8_t> &image, const vector<uint8_t> &chain, const VkBufferImageCopy &region)
+{
+	const uint8_t *pLevel = chain.data() + region.bufferOffset;
+	for (unsigned y = 0; y < Height / 2; y++)
+	{
+		for (unsigned x = 0; x < Width / 2; x++)
+		{
+			for (unsigned c = 0; c < 4; c++)
+			{
+				const uint8_t *pSrc = image.data() + 4 * (2 * y * Width + 2 * x) + c;
+				int sum = pSrc[0] + pSrc[4] + pSrc[4 * Width] + pSrc[4 * Width + 4];
+				if (abs(4 * pLevel[4 * (y * Width / 2 + x) + c] - sum) > 2)
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+// A flat image must stay flat at every level, whatever the size of the
+// levels, the filter and the address mode.
+bool checkFlatImage()
+{
+	static const VkSamplerAddressMode AddressModes[] = {
+		VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+	};
+	const unsigned width = 37;
+	const unsigned height = 23;
+	const uint8_t color[4] = { 13, 200, 97, 180 };
+
+	vector<uint8_t> image(width * height * 4);
+	for (size_t i = 0; i < image.size(); i++)
+		image[i] = color[i & 3];
+
+	for (VkFormat format : { VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_R8G8B8A8_SRGB })
+	{
+		for (MipFilter filter : { MIP_FILTER_BOX, MIP_FILTER_KAISER })
+		{
+			for (VkSamplerAddressMode addressMode : AddressModes)
+			{
+				vector<uint8_t> chain;
+				vector<VkBufferImageCopy> regions;
+				if (FAILED(generateMipChainRgba8888(&chain, &regions, image.data(), width * 4, width, height, format,
+				                                    filter, addressMode)))
+					return false;
+				if (regions.size() != 6)
+					return false;
+				for (size_t i = 0; i < chain.size(); i++)
+					if (chain[i] != color[i & 3])
+						return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Averaging black and white gives half the light, which is 188 in sRGB.
+bool checkSrgb()
+{
+	vector<uint8_t> image(4 * 4 * 4);
+	for (unsigned i = 0; i < 16; i++)
+	{
+		uint8_t value = ((i ^ (i >> 2)) & 1) ? 255 : 0;
+		image[4 * i + 0] = value;
+		image[4 * i + 1] = value;
+		image[4 * i + 2] = value;
+		image[4 * i + 3] = value;
+	}
+
+	vector<uint8_t> chain;
+	vector<VkBufferImageCopy> regions;
+	if (FAILED(generateMipChainRgba8888(&chain, &regions, image.data(), 16, 4, 4, VK_FORMAT_R8G8B8A8_SRGB,
+	                                    MIP_FILTER_BOX, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, 2)))
+		return false;
+
+	const uint8_t *pTexel = chain.data() + regions[1].bufferOffset;
+	return pTexel[0] == 188 && pTexel[1] == 188 && pTexel[2] == 188 && pTexel[3] == 128;
+}
+}
+
+int main(int argc, char **argv)
+{
+	unsigned numThreads = argc > 1 ? strtoul(argv[1], nullptr, 0) : thread::hardware_concurrency();
+	unsigned iterations = argc > 2 ? strtoul(argv[2], nullptr, 0) : 3;
+	if (numThreads == 0)
+		numThreads = 1;
+	if (iterations == 0)
+		iterations = 1;
+
+	ThreadPool pool;
+	pool.setWorkerThreadCount(numThreads);
+	printf("%u x %u texels, %u threads.\n", Width, Height, numThreads);
+
+	static const struct
+	{
+		VkFormat format;
+		MipFilter filter;
+		const char *pName;
+	} Configurations[] = {
+		{ VK_FORMAT_R8G8B8A8_UNORM, MIP_FILTER_BOX, "unorm box" },
+		{ VK_FORMAT_R8G8B8A8_SRGB, MIP_FILTER_BOX, "srgb box" },
+		{ VK_FORMAT_R8G8B8A8_UNORM, MIP_FILTER_KAISER, "unorm kaiser" },
+		{ VK_FORMAT_R8G8B8A8_SRGB, MIP_FILTER_KAISER, "srgb kaiser" },
+	};
+
+	vector<uint8_t> image = createImage();
+	bool success = true;
+
+	for (auto &configuration : Configurations)
+	{
+		vector<uint8_t> chains[2];
+		vector<VkBufferImageCopy> regions;
+		double rates[2];
+		for (unsigned run = 0; run < 2; run++)
+		{
+			ThreadPool *pPool = run ? &pool : nullptr;
+			auto start = Clock::now();
+			for (unsigned i = 0; i < iterations; i++)
+			{
+				if (FAILED(generateMipChainRgba8888(&chains[run], &regions, image.data(), Width * 4, Width, Height,
+				                                    configuration.format, configuration.filter,
+				                                    VK_SAMPLER_ADDRESS_MODE_REPEAT, 0, pPool)))
+					return 1;
+			}
+			double elapsed = chrono::duration<double>(Clock::now() - start).count();
+			rates[run] = Width * double(Height) * iterations / elapsed * 1e-6;
+		}
+
+		printf("%-12s single %7.2f MTexels/s, parallel %7.2f MTexels/s\n", configuration.pName, rates[0], rates[1]);
+
+		if (chains[0] != chains[1])
+		{
+			printf("%s: filtering on the thread pool changes the result.\n", configuration.pName);
+			success = false;
+		}
+
+		if (configuration.format == VK_FORMAT_R8G8B8A8_UNORM && configuration.filter == MIP_FILTER_BOX &&
+		    !checkBoxFilter(image, chains[0], regions[1]))
+		{
+			printf("%s: texels are not the average of the texels they cover.\n", configuration.pName);
+			success = false;
+		}
+	}
+
+	if (!checkFlatImage())
+	{
+		printf("Flat images do not stay flat.\n");
+		success = false;
+	}
+
+	if (!checkSrgb())
+	{
+		printf("SRGB textures are not filtered in linear space.\n");
+		success = false;
+	}
+
+	return success ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Validates the RGBA8888 conversion and premultiplication kernels against
+// scalar reference implementations, and measures their throughput on a single
+// thread and split into strips of rows over a thread pool, the way
+// decodeRgba8888TextureFromAsset uses them.
+// Returns a non-zero exit code if any kernel produces a wrong result.
+//
+// Usage: pixel-conversion-benchmark [megapixels] [threads]
+
+#include "framework/pixel_conversion.hpp"
+#include "framework/thread_pool.hpp"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+using namespace MaliSDK;
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+namespace
+{
+const unsigned Width = 4096;
+const unsigned Iterations = 10;
+
+void referenceConvert(uint8_t *pDst, const uint8_t *pSrc, size_t count, unsigned components)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		const uint8_t *pIn = pSrc + i * components;
+		uint8_t *pOut = pDst + i * 4;
+		switch (components)
+		{
+		case 1:
+		case 2:
+			pOut[0] = pOut[1] = pOut[2] = pIn[0];
+			pOut[3] = components == 2 ? pIn[1] : 0xff;
+			break;
+
+		default:
+			pOut[0] = pIn[0];
+			pOut[1] = pIn[1];
+			pOut[2] = pIn[2];
+			pOut[3] = components == 4 ? pIn[3] : 0xff;
+			break;
+		}
+	}
+}
+
+void referencePremultiply(uint8_t *pPixels, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		for (unsigned c = 0; c < 3; c++)
+			pPixels[4 * i + c] = uint8_t((pPixels[4 * i + c] * pPixels[4 * i + 3] * 2 + 255) / 510);
+}
+
+template <typename Func>
+double measure(const Func &func, size_t pixels)
+{
+	func();
+	auto start = Clock::now();
+	for (unsigned i = 0; i < Iterations; i++)
+		func();
+	double elapsed = chrono::duration<double>(Clock::now() - start).count();
+	return pixels * double(Iterations) / elapsed * 1e-6;
+}
+
+bool runComponents(ThreadPool &pool, unsigned components, unsigned height)
+{
+	size_t count = size_t(Width) * height;
+	vector<uint8_t> source(count * components);
+	for (auto &byte : source)
+		byte = uint8_t(rand());
+
+	vector<uint8_t> expected(count * 4);
+	vector<uint8_t> result(count * 4);
+	referenceConvert(expected.data(), source.data(), count, components);
+	convertToRgba8888(result.data(), source.data(), count, components);
+	bool success = expected == result;
+
+	referencePremultiply(expected.data(), count);
+	premultiplyRgba8888(result.data(), count);
+	success &= expected == result;
+
+	double scalar = measure(
+	    [&]() {
+		    referenceConvert(result.data(), source.data(), count, components);
+		    referencePremultiply(result.data(), count);
+		},
+	    count);
+
+	double simd = measure(
+	    [&]() {
+		    convertToRgba8888(result.data(), source.data(), count, components);
+		    premultiplyRgba8888(result.data(), count);
+		},
+	    count);
+
+	unsigned rowsPerStrip = 64 * 1024 / Width;
+	double parallel = measure(
+	    [&]() {
+		    pool.parallelFor(0, height, rowsPerStrip, [&](unsigned, unsigned begin, unsigned end) {
+			    for (unsigned row = begin; row < end; row++)
+			    {
+				    uint8_t *pRow = result.data() + size_t(row) * Width * 4;
+				    convertToRgba8888(pRow, source.data() + size_t(row) * Width * components, Width, components);
+				    premultiplyRgba8888(pRow, Width);
+			    }
+			});
+		},
+	    count);
+
+	printf("%u components: scalar %8.1f MPixels/s   simd %8.1f MPixels/s   parallel %8.1f MPixels/s   %s\n",
+	       components, scalar, simd, parallel, success ? "OK" : "MISMATCH");
+	return success;
+}
+}
+
+int main(int argc, char **argv)
+{
+	unsigned megapixels = argc > 1 ? strtoul(argv[1], nullptr, 0) : 16;
+	unsigned numThreads = argc > 2 ? strtoul(argv[2], nullptr, 0) : thread::hardware_concurrency();
+	if (megapixels == 0)
+		megapixels = 1;
+	if (numThreads == 0)
+		numThreads = 1;
+
+	printf("%u megapixels, %u threads.\n", megapixels, numThreads);
+
+	ThreadPool pool;
+	pool.setWorkerThreadCount(numThreads);
+
+	unsigned height = megapixels * 1024 * 1024 / Width;
+	bool success = true;
+	for (unsigned components = 1; components <= 4; components++)
+		success &= runComponents(pool, components, height);
+
+	return success ? 0 : 1;
+}
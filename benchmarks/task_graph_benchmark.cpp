@@ -0,0 +1,206 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Validates dependency ordering of TaskGraph and measures its throughput on a
+// diamond shaped graph and on a wide fan-out/fan-in graph.
+// Returns a non-zero exit code if any task runs before its dependencies, or if
+// a graph with a dependency cycle is not rejected.
+//
+// Usage: task-graph-benchmark [threads] [iterations]
+
+#include "framework/task_graph.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+using namespace MaliSDK;
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+namespace
+{
+// Builds a graph where every task records the order in which it ran,
+// so dependencies can be validated afterwards.
+class OrderedGraph
+{
+public:
+	OrderedGraph(ThreadPool &pool, unsigned workPerTask)
+	    : graph(pool)
+	    , workPerTask(workPerTask)
+	{
+	}
+
+	TaskGraph::TaskHandle addTask()
+	{
+		unsigned index = order.size();
+		order.push_back(0);
+		return graph.addTask([this, index](unsigned) {
+			// Burn some cycles to simulate real work.
+			volatile unsigned sink = 0;
+			for (unsigned i = 0; i < workPerTask; i++)
+				sink = sink + i;
+			order[index] = ++counter;
+		});
+	}
+
+	void addDependency(TaskGraph::TaskHandle task, TaskGraph::TaskHandle dependency)
+	{
+		graph.addDependency(task, dependency);
+		edges.push_back({ task, dependency });
+	}
+
+	bool run()
+	{
+		counter = 0;
+		fill(order.begin(), order.end(), 0u);
+		if (FAILED(graph.run()))
+			return false;
+		graph.wait();
+
+		for (auto &edge : edges)
+		{
+			if (order[edge.task] <= order[edge.dependency])
+			{
+				fprintf(stderr, "Task %u ran before its dependency %u.\n", edge.task, edge.dependency);
+				return false;
+			}
+		}
+
+		for (auto value : order)
+		{
+			if (value == 0)
+			{
+				fprintf(stderr, "Task did not run.\n");
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	unsigned getTaskCount() const
+	{
+		return graph.getTaskCount();
+	}
+
+private:
+	struct Edge
+	{
+		TaskGraph::TaskHandle task;
+		TaskGraph::TaskHandle dependency;
+	};
+
+	TaskGraph graph;
+	unsigned workPerTask;
+	vector<unsigned> order;
+	vector<Edge> edges;
+	atomic<unsigned> counter{ 0 };
+};
+
+bool runGraph(const char *pName, OrderedGraph &graph, unsigned iterations)
+{
+	auto start = Clock::now();
+	for (unsigned i = 0; i < iterations; i++)
+	{
+		if (!graph.run())
+		{
+			fprintf(stderr, "%s: FAILED in iteration %u.\n", pName, i);
+			return false;
+		}
+	}
+	double elapsed = chrono::duration<double>(Clock::now() - start).count();
+
+	printf("%-16s %12.0f graphs/s %14.0f tasks/s\n", pName, iterations / elapsed,
+	       (double(iterations) * graph.getTaskCount()) / elapsed);
+	return true;
+}
+}
+
+int main(int argc, char **argv)
+{
+	unsigned numThreads = argc > 1 ? strtoul(argv[1], nullptr, 0) : thread::hardware_concurrency();
+	unsigned iterations = argc > 2 ? strtoul(argv[2], nullptr, 0) : 10000;
+	if (numThreads == 0)
+		numThreads = 1;
+
+	printf("%u threads, %u iterations.\n", numThreads, iterations);
+
+	ThreadPool pool;
+	pool.setWorkerThreadCount(numThreads);
+	bool success = true;
+
+	// A -> (B, C) -> D
+	{
+		OrderedGraph graph(pool, 1000);
+		auto a = graph.addTask();
+		auto b = graph.addTask();
+		auto c = graph.addTask();
+		auto d = graph.addTask();
+		graph.addDependency(b, a);
+		graph.addDependency(c, a);
+		graph.addDependency(d, b);
+		graph.addDependency(d, c);
+		success &= runGraph("diamond", graph, iterations);
+	}
+
+	// A -> 256 tasks -> B -> 256 tasks -> C
+	{
+		OrderedGraph graph(pool, 1000);
+		auto source = graph.addTask();
+		auto middle = graph.addTask();
+		auto sink = graph.addTask();
+		for (unsigned i = 0; i < 256; i++)
+		{
+			auto first = graph.addTask();
+			graph.addDependency(first, source);
+			graph.addDependency(middle, first);
+
+			auto second = graph.addTask();
+			graph.addDependency(second, middle);
+			graph.addDependency(sink, second);
+		}
+		success &= runGraph("fan-out/fan-in", graph, iterations / 10 + 1);
+	}
+
+	// A -> B -> C -> B must be rejected rather than hang.
+	{
+		TaskGraph graph(pool);
+		auto a = graph.addTask([](unsigned) {});
+		auto b = graph.addTask([](unsigned) {});
+		auto c = graph.addTask([](unsigned) {});
+		graph.addDependency(b, a);
+		graph.addDependency(c, b);
+		graph.addDependency(b, c);
+		if (!FAILED(graph.run()))
+		{
+			fprintf(stderr, "cycle: FAILED, the graph was not rejected.\n");
+			success = false;
+		}
+		else
+			printf("%-16s rejected\n", "cycle");
+	}
+
+	return success ? 0 : 1;
+}
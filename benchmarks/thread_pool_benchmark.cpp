@@ -0,0 +1,365 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Measures job throughput and submit-to-start latency of ThreadPool, with both
+// wait policies, against the original std::function and std::queue based
+// implementation.
+// Also checks that parallelFor and stolen work run every item exactly once,
+// including parallelFor calls nested inside work on the worker threads, and
+// that workers can push more pinned work to themselves than their queue holds,
+// and returns a non-zero exit code if they do not.
+//
+// Usage: thread-pool-benchmark [threads] [jobs per batch] [batches]
+
+#include "framework/thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+using namespace MaliSDK;
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+namespace
+{
+// The original thread pool, where every job is a std::function
+// in a mutex protected std::queue.
+class LegacyThreadPool
+{
+public:
+	void setWorkerThreadCount(unsigned workerThreadCount)
+	{
+		workerThreads.clear();
+		for (unsigned i = 0; i < workerThreadCount; i++)
+			workerThreads.emplace_back(new Worker);
+	}
+
+	unsigned getWorkerThreadCount() const
+	{
+		return workerThreads.size();
+	}
+
+	void pushWorkToThread(unsigned threadIndex, std::function<void()> func)
+	{
+		workerThreads[threadIndex]->pushWork(move(func));
+	}
+
+	void waitIdle()
+	{
+		for (auto &worker : workerThreads)
+			worker->waitIdle();
+	}
+
+private:
+	class Worker
+	{
+	public:
+		Worker()
+		{
+			workerThread = thread(&Worker::threadEntry, this);
+		}
+
+		~Worker()
+		{
+			waitIdle();
+
+			lock.lock();
+			threadIsAlive = false;
+			cond.notify_one();
+			lock.unlock();
+
+			workerThread.join();
+		}
+
+		void pushWork(std::function<void()> func)
+		{
+			lock_guard<mutex> holder{ lock };
+			workQueue.push(move(func));
+			cond.notify_one();
+		}
+
+		void waitIdle()
+		{
+			unique_lock<mutex> holder{ lock };
+			cond.wait(holder, [this] { return workQueue.empty(); });
+		}
+
+	private:
+		thread workerThread;
+		mutex lock;
+		condition_variable cond;
+		queue<function<void()>> workQueue;
+		bool threadIsAlive = true;
+
+		void threadEntry()
+		{
+			for (;;)
+			{
+				function<void()> *pWork = nullptr;
+				{
+					unique_lock<mutex> holder{ lock };
+					cond.wait(holder, [this] { return !workQueue.empty() || !threadIsAlive; });
+					if (!threadIsAlive)
+						break;
+
+					pWork = &workQueue.front();
+				}
+
+				(*pWork)();
+
+				{
+					lock_guard<mutex> holder{ lock };
+					workQueue.pop();
+					cond.notify_one();
+				}
+			}
+		}
+	};
+
+	vector<unique_ptr<Worker>> workerThreads;
+};
+
+struct Results
+{
+	double jobsPerSecond;
+	double p50Latency;
+	double p99Latency;
+};
+
+template <typename Pool>
+Results runBenchmark(Pool &pool, unsigned jobsPerBatch, unsigned batches)
+{
+	unsigned numThreads = pool.getWorkerThreadCount();
+	vector<double> latencies(size_t(jobsPerBatch) * batches);
+	double *pLatencies = latencies.data();
+
+	// Capture enough state to be representative of real work, i.e. a couple of
+	// pointers and indices like the multithreading sample does.
+	auto start = Clock::now();
+	for (unsigned batch = 0; batch < batches; batch++)
+	{
+		for (unsigned i = 0; i < jobsPerBatch; i++)
+		{
+			size_t index = size_t(batch) * jobsPerBatch + i;
+			Clock::time_point submitTime = Clock::now();
+			pool.pushWorkToThread(i % numThreads, [=] {
+				pLatencies[index] = chrono::duration<double, micro>(Clock::now() - submitTime).count();
+			});
+		}
+		pool.waitIdle();
+	}
+	double elapsed = chrono::duration<double>(Clock::now() - start).count();
+
+	sort(latencies.begin(), latencies.end());
+	Results results;
+	results.jobsPerSecond = latencies.size() / elapsed;
+	results.p50Latency = latencies[latencies.size() / 2];
+	results.p99Latency = latencies[(latencies.size() * 99) / 100];
+	return results;
+}
+
+void printResults(const char *pName, const Results &results)
+{
+	printf("%-8s %14.0f jobs/s   p50 %9.2f us   p99 %9.2f us\n", pName, results.jobsPerSecond, results.p50Latency,
+	       results.p99Latency);
+}
+
+// Burns a number of cycles which grows with the index, so later chunks are
+// much more expensive and have to be stolen to balance the load.
+void unevenWork(unsigned index)
+{
+	volatile unsigned sink = 0;
+	for (unsigned i = 0; i < (index & 63) * 64; i++)
+		sink = sink + i;
+}
+
+bool checkCounts(const char *pName, const vector<atomic<unsigned>> &counts, unsigned expected)
+{
+	for (size_t i = 0; i < counts.size(); i++)
+	{
+		if (counts[i].load() != expected)
+		{
+			fprintf(stderr, "%s: FAILED, item %u ran %u times.\n", pName, unsigned(i), counts[i].load());
+			return false;
+		}
+	}
+	return true;
+}
+
+// Runs parallelFor from the main thread and from inside chunks running on
+// the workers, and checks that every index ran once with a valid thread index.
+bool checkParallelFor(ThreadPool &pool, unsigned iterations)
+{
+	const unsigned outer = 64;
+	const unsigned inner = 256;
+	unsigned maxThreadIndex = pool.getWorkerThreadCount();
+	vector<atomic<unsigned>> counts(outer * inner);
+	atomic<unsigned> badThreadIndices{ 0 };
+
+	auto start = Clock::now();
+	for (unsigned iteration = 0; iteration < iterations; iteration++)
+	{
+		pool.parallelFor(0, outer, 1, [&](unsigned threadIndex, unsigned begin, unsigned end) {
+			if (threadIndex > maxThreadIndex)
+				badThreadIndices++;
+
+			for (unsigned o = begin; o < end; o++)
+			{
+				pool.parallelFor(0, inner, 16, [&](unsigned innerThreadIndex, unsigned innerBegin, unsigned innerEnd) {
+					if (innerThreadIndex > maxThreadIndex)
+						badThreadIndices++;
+
+					for (unsigned i = innerBegin; i < innerEnd; i++)
+					{
+						unevenWork(i);
+						counts[o * inner + i]++;
+					}
+				});
+			}
+		});
+	}
+	double elapsed = chrono::duration<double>(Clock::now() - start).count();
+
+	if (badThreadIndices != 0)
+	{
+		fprintf(stderr, "parallelFor: FAILED, %u chunks got an invalid thread index.\n", badThreadIndices.load());
+		return false;
+	}
+	if (!checkCounts("parallelFor", counts, iterations))
+		return false;
+
+	printf("%-8s %14.0f items/s\n", "nested", (double(iterations) * counts.size()) / elapsed);
+	return true;
+}
+
+// Pushes uneven stealable work and checks that every job ran once.
+bool checkPushWork(ThreadPool &pool, unsigned jobs)
+{
+	vector<atomic<unsigned>> counts(jobs);
+	for (unsigned i = 0; i < jobs; i++)
+	{
+		atomic<unsigned> *pCount = &counts[i];
+		pool.pushWork([=](unsigned) {
+			unevenWork(i);
+			(*pCount)++;
+		});
+	}
+	pool.waitIdle();
+	return checkCounts("pushWork", counts, 1);
+}
+
+// Has every worker push more pinned work to itself than its queue holds,
+// which it has to run itself to make room, and checks that every job ran once.
+bool checkPinnedSelfPush(ThreadPool &pool)
+{
+	const unsigned jobsPerWorker = ThreadPool::QueueSize * 3;
+	unsigned numThreads = pool.getWorkerThreadCount();
+	vector<atomic<unsigned>> counts(size_t(numThreads) * jobsPerWorker);
+	vector<thread::id> workerIds(numThreads);
+	atomic<unsigned> wrongThreads{ 0 };
+
+	for (unsigned t = 0; t < numThreads; t++)
+	{
+		pool.pushWorkToThread(t, [&, t] {
+			workerIds[t] = this_thread::get_id();
+			for (unsigned i = 0; i < jobsPerWorker; i++)
+			{
+				atomic<unsigned> *pCount = &counts[t * jobsPerWorker + i];
+				pool.pushWorkToThread(t, [&, t, pCount] {
+					if (this_thread::get_id() != workerIds[t])
+						wrongThreads++;
+					(*pCount)++;
+				});
+			}
+		});
+	}
+	pool.waitIdle();
+
+	if (wrongThreads != 0)
+	{
+		fprintf(stderr, "pinned: FAILED, %u jobs ran on the wrong thread.\n", wrongThreads.load());
+		return false;
+	}
+	return checkCounts("pinned", counts, 1);
+}
+}
+
+int main(int argc, char **argv)
+{
+	unsigned numThreads = argc > 1 ? strtoul(argv[1], nullptr, 0) : thread::hardware_concurrency();
+	unsigned jobsPerBatch = argc > 2 ? strtoul(argv[2], nullptr, 0) : 64;
+	unsigned batches = argc > 3 ? strtoul(argv[3], nullptr, 0) : 20000;
+
+	if (numThreads == 0)
+		numThreads = 1;
+	if (jobsPerBatch == 0 || batches == 0)
+	{
+		fprintf(stderr, "Usage: %s [threads] [jobs per batch] [batches]\n", argv[0]);
+		return 1;
+	}
+
+	printf("%u threads, %u jobs per batch, %u batches.\n", numThreads, jobsPerBatch, batches);
+
+	{
+		LegacyThreadPool pool;
+		pool.setWorkerThreadCount(numThreads);
+		runBenchmark(pool, jobsPerBatch, batches / 10 + 1);
+		printResults("legacy", runBenchmark(pool, jobsPerBatch, batches));
+	}
+
+	static const struct
+	{
+		const char *pName;
+		ThreadPool::WaitPolicy policy;
+	} policies[] = {
+		{ "park", ThreadPool::WAIT_POLICY_PARK }, { "spin", ThreadPool::WAIT_POLICY_SPIN_THEN_PARK },
+	};
+
+	bool success = true;
+	for (auto &policy : policies)
+	{
+		ThreadPool pool;
+		pool.setWorkerThreadCount(numThreads);
+		pool.setWaitPolicy(policy.policy);
+		runBenchmark(pool, jobsPerBatch, batches / 10 + 1);
+		pool.resetStatistics();
+		printResults(policy.pName, runBenchmark(pool, jobsPerBatch, batches));
+
+		ThreadPool::Statistics statistics = pool.getStatistics();
+		printf("         spin iterations %llu, spin hits %llu, parks %llu, wakeups %llu\n",
+		       (unsigned long long)statistics.spinIterations, (unsigned long long)statistics.spinHits,
+		       (unsigned long long)statistics.parks, (unsigned long long)statistics.wakeups);
+
+		success &= checkPushWork(pool, jobsPerBatch * 16);
+		success &= checkPinnedSelfPush(pool);
+		success &= checkParallelFor(pool, batches / 1000 + 1);
+	}
+
+	return success ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "asset_loader.hpp"
+
+using namespace std;
+
+namespace MaliSDK
+{
+AssetLoader::AssetLoader(ThreadPool &pool)
+    : pool(pool)
+{
+}
+
+AssetLoader::~AssetLoader()
+{
+	waitAll();
+}
+
+void AssetLoader::complete()
+{
+	// Waiters check the ready flags under the lock, so taking it here makes
+	// sure no waiter misses the notification.
+	{
+		lock_guard<mutex> holder{ lock };
+		pending--;
+	}
+	cond.notify_all();
+}
+
+void AssetLoader::waitAll()
+{
+	unique_lock<mutex> holder{ lock };
+	cond.wait(holder, [this]() { return pending.load() == 0; });
+}
+
+AssetLoader::TextureHandle AssetLoader::loadRgba8888Texture(const char *pPath)
+{
+	return submit<LoadedTexture>(pPath, [](const char *pPath, LoadedTexture *pTexture) {
+		pTexture->format = VK_FORMAT_R8G8B8A8_UNORM;
+		return loadRgba8888TextureFromAsset(pPath, &pTexture->buffer, &pTexture->width, &pTexture->height);
+	});
+}
+
+AssetLoader::TextureHandle AssetLoader::loadASTCTexture(const char *pPath)
+{
+	return submit<LoadedTexture>(pPath, [](const char *pPath, LoadedTexture *pTexture) {
+		return loadASTCTextureFromAsset(pPath, &pTexture->payload, &pTexture->width, &pTexture->height,
+		                                &pTexture->format);
+	});
+}
+
+AssetLoader::TextureHandle AssetLoader::loadOrEncodeASTCTexture(const char *pPath, VkFormat format)
+{
+	return submit<LoadedTexture>(pPath, [format](const char *pPath, LoadedTexture *pTexture) {
+		pTexture->format = format;
+		return loadOrEncodeASTCTextureFromAsset(pPath, format, &pTexture->payload, &pTexture->width,
+		                                        &pTexture->height);
+	});
+}
+
+AssetLoader::KTX2Handle AssetLoader::loadKTX2Texture(const char *pPath)
+{
+	return submit<KTX2Texture>(pPath, loadKTX2TextureFromAsset);
+}
+
+AssetLoader::ShaderHandle AssetLoader::loadShaderModule(VkDevice device, const char *pPath)
+{
+	return submit<VkShaderModule>(pPath, [device](const char *pPath, VkShaderModule *pModule) {
+		*pModule = MaliSDK::loadShaderModule(device, pPath);
+		return *pModule != VK_NULL_HANDLE ? RESULT_SUCCESS : RESULT_ERROR_GENERIC;
+	});
+}
+}
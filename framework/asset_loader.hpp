@@ -0,0 +1,217 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FRAMEWORK_ASSET_LOADER_HPP
+#define FRAMEWORK_ASSET_LOADER_HPP
+
+#include "assets.hpp"
+#include "common.hpp"
+#include "ktx2_texture.hpp"
+#include "thread_pool.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace MaliSDK
+{
+/// @brief A texture loaded by @ref AssetLoader.
+struct LoadedTexture
+{
+	/// The decoded pixels, for textures which have to be decoded.
+	std::vector<uint8_t> buffer;
+
+	/// A view of the payload in the asset, for textures which are used as
+	/// they are stored.
+	AssetData payload;
+
+	/// The width of the texture.
+	unsigned width = 0;
+
+	/// The height of the texture.
+	unsigned height = 0;
+
+	/// The format of the texture.
+	VkFormat format = VK_FORMAT_UNDEFINED;
+
+	/// @brief Gets the texture data to upload.
+	/// @returns A pointer to the data
+	const void *getData() const
+	{
+		return buffer.empty() ? payload.getData() : buffer.data();
+	}
+
+	/// @brief Gets the size of the texture data.
+	/// @returns The size in bytes
+	size_t getSize() const
+	{
+		return buffer.empty() ? payload.getSize() : buffer.size();
+	}
+};
+
+/// @brief An asset which is being loaded by @ref AssetLoader.
+template <typename T>
+class AssetRequest
+{
+public:
+	/// @brief Checks if the asset has been loaded, or failed to load.
+	/// @returns true if the request has completed.
+	bool isReady() const
+	{
+		return ready.load(std::memory_order_acquire);
+	}
+
+	/// @brief Gets the result of the request. Only valid once the request is
+	/// ready.
+	/// @returns Error code
+	Result getResult() const
+	{
+		return result;
+	}
+
+	/// @brief Gets the loaded asset. Only valid once the request is ready.
+	/// @returns The asset
+	T &getValue()
+	{
+		return value;
+	}
+
+	/// @brief Gets the path of the asset.
+	/// @returns The path
+	const std::string &getPath() const
+	{
+		return path;
+	}
+
+private:
+	friend class AssetLoader;
+
+	std::string path;
+	Result result = RESULT_SUCCESS;
+	T value = T();
+	std::atomic<bool> ready{ false };
+};
+
+/// @brief Loads assets on the worker threads of a @ref ThreadPool.
+///
+/// Reading and decoding assets is independent work, so rather than loading
+/// one asset after another, an application requests all of its assets up
+/// front and waits for them when it needs them. Every request returns a
+/// handle which can be polled with `isReady()`, waited for with @ref wait,
+/// or waited for together with all other requests with @ref waitAll.
+///
+/// If the pool has no worker threads, assets are loaded synchronously.
+/// Waiting for a request from a worker thread of the same pool can deadlock.
+class AssetLoader
+{
+public:
+	typedef std::shared_ptr<AssetRequest<LoadedTexture>> TextureHandle;
+	typedef std::shared_ptr<AssetRequest<VkShaderModule>> ShaderHandle;
+	typedef std::shared_ptr<AssetRequest<KTX2Texture>> KTX2Handle;
+
+	/// @brief Constructor
+	/// @param pool The thread pool to load assets on.
+	AssetLoader(ThreadPool &pool);
+
+	/// @brief Destructor. Waits for all requests to complete.
+	~AssetLoader();
+
+	/// @brief Loads and decodes a texture into VK_FORMAT_R8G8B8A8_UNORM, like
+	/// `loadRgba8888TextureFromAsset`.
+	/// @param pPath The path of the texture.
+	/// @returns A handle to the request.
+	TextureHandle loadRgba8888Texture(const char *pPath);
+
+	/// @brief Loads an ASTC texture, like `loadASTCTextureFromAsset`. The
+	/// payload is returned as a view of the asset.
+	/// @param pPath The path of the texture.
+	/// @returns A handle to the request.
+	TextureHandle loadASTCTexture(const char *pPath);
+
+	/// @brief Loads a texture as ASTC, compressing it on first load, like
+	/// `loadOrEncodeASTCTextureFromAsset`. The texture is compressed on a
+	/// single worker thread, so that several textures compress in parallel.
+	/// @param pPath The path of the texture.
+	/// @param format The 2D ASTC format to compress to.
+	/// @returns A handle to the request.
+	TextureHandle loadOrEncodeASTCTexture(const char *pPath, VkFormat format);
+
+	/// @brief Loads a texture with all of its mip levels and layers from a
+	/// KTX2 container, like `loadKTX2TextureFromAsset`.
+	/// @param pPath The path of the texture.
+	/// @returns A handle to the request.
+	KTX2Handle loadKTX2Texture(const char *pPath);
+
+	/// @brief Loads a SPIR-V shader module, like `loadShaderModule`.
+	/// @param device The Vulkan device.
+	/// @param pPath The path of the SPIR-V module.
+	/// @returns A handle to the request. The value is VK_NULL_HANDLE if the
+	/// module failed to load.
+	ShaderHandle loadShaderModule(VkDevice device, const char *pPath);
+
+	/// @brief Waits for a request to complete.
+	/// @param request The request to wait for.
+	template <typename T>
+	void wait(const std::shared_ptr<AssetRequest<T>> &request)
+	{
+		std::unique_lock<std::mutex> holder{ lock };
+		cond.wait(holder, [&request]() { return request->isReady(); });
+	}
+
+	/// @brief Waits for all requests to complete.
+	void waitAll();
+
+	/// @brief Gets the number of requests which have not completed yet.
+	/// @returns The number of requests
+	unsigned getPendingCount() const
+	{
+		return pending.load();
+	}
+
+private:
+	ThreadPool &pool;
+	std::atomic<unsigned> pending{ 0 };
+	std::mutex lock;
+	std::condition_variable cond;
+
+	void complete();
+
+	template <typename T, typename Load>
+	std::shared_ptr<AssetRequest<T>> submit(const char *pPath, Load load)
+	{
+		auto request = std::make_shared<AssetRequest<T>>();
+		request->path = pPath;
+		pending++;
+
+		auto task = [this, request, load](unsigned) {
+			request->result = load(request->path.c_str(), &request->value);
+			request->ready.store(true, std::memory_order_release);
+			complete();
+		};
+
+		pool.pushWork(std::move(task));
+		return request;
+	}
+};
+}
+
+#endif
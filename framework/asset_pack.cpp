@@ -0,0 +1,178 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "asset_pack.hpp"
+#include <string.h>
+
+using namespace std;
+
+namespace MaliSDK
+{
+uint64_t hashAssetName(const char *pName, size_t length)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (size_t i = 0; i < length; i++)
+	{
+		hash ^= uint8_t(pName[i]);
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+// The compressed data is a sequence of runs of literals, each followed by a
+// back-reference into the decompressed data. Every run starts with a token
+// which holds the literal count in the upper four bits and the match length
+// minus MinMatch in the lower four bits. A nibble of 15 means that the count
+// continues in the following bytes, which are added up until a byte is not
+// 255. The literals follow, then the 16-bit distance of the match. The last
+// run has no match.
+static const size_t MinMatch = 4;
+static const size_t MaxDistance = 65535;
+static const unsigned HashBits = 14;
+
+static inline uint32_t read32(const uint8_t *p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static void writeLength(vector<uint8_t> &output, size_t length)
+{
+	while (length >= 255)
+	{
+		output.push_back(255);
+		length -= 255;
+	}
+	output.push_back(uint8_t(length));
+}
+
+static void writeRun(vector<uint8_t> &output, const uint8_t *pLiterals, size_t literalCount, size_t distance,
+                     size_t matchLength)
+{
+	size_t matchCode = matchLength ? matchLength - MinMatch : 0;
+	output.push_back(uint8_t(((literalCount < 15 ? literalCount : 15) << 4) | (matchCode < 15 ? matchCode : 15)));
+	if (literalCount >= 15)
+		writeLength(output, literalCount - 15);
+	output.insert(end(output), pLiterals, pLiterals + literalCount);
+
+	if (matchLength)
+	{
+		output.push_back(uint8_t(distance & 0xff));
+		output.push_back(uint8_t(distance >> 8));
+		if (matchCode >= 15)
+			writeLength(output, matchCode - 15);
+	}
+}
+
+void compressAssetData(const uint8_t *pInput, size_t size, vector<uint8_t> *pOutput)
+{
+	pOutput->clear();
+	pOutput->reserve(size + size / 255 + 16);
+
+	// The most recent position of every hashed 4-byte sequence.
+	vector<size_t> table(1u << HashBits, SIZE_MAX);
+
+	size_t anchor = 0;
+	size_t pos = 0;
+	while (pos + MinMatch <= size)
+	{
+		uint32_t sequence = read32(pInput + pos);
+		uint32_t hash = (sequence * 2654435761u) >> (32 - HashBits);
+		size_t candidate = table[hash];
+		table[hash] = pos;
+
+		if (candidate != SIZE_MAX && pos - candidate <= MaxDistance && read32(pInput + candidate) == sequence)
+		{
+			size_t length = MinMatch;
+			while (pos + length < size && pInput[candidate + length] == pInput[pos + length])
+				length++;
+
+			writeRun(*pOutput, pInput + anchor, pos - anchor, pos - candidate, length);
+			pos += length;
+			anchor = pos;
+		}
+		else
+			pos++;
+	}
+
+	writeRun(*pOutput, pInput + anchor, size - anchor, 0, 0);
+}
+
+static bool readLength(const uint8_t *&pInput, const uint8_t *pEnd, size_t *pLength)
+{
+	uint8_t byte;
+	do
+	{
+		if (pInput >= pEnd)
+			return false;
+		byte = *pInput++;
+		*pLength += byte;
+	} while (byte == 255);
+	return true;
+}
+
+bool decompressAssetData(const uint8_t *pInput, size_t inputSize, uint8_t *pOutput, size_t outputSize)
+{
+	const uint8_t *pEnd = pInput + inputSize;
+	size_t pos = 0;
+
+	while (pInput < pEnd)
+	{
+		uint8_t token = *pInput++;
+
+		size_t literalCount = token >> 4;
+		if (literalCount == 15 && !readLength(pInput, pEnd, &literalCount))
+			return false;
+		if (literalCount > size_t(pEnd - pInput) || literalCount > outputSize - pos)
+			return false;
+
+		memcpy(pOutput + pos, pInput, literalCount);
+		pInput += literalCount;
+		pos += literalCount;
+
+		// The last run has no match.
+		if (pInput == pEnd)
+			break;
+
+		if (pEnd - pInput < 2)
+			return false;
+		size_t distance = pInput[0] | (size_t(pInput[1]) << 8);
+		pInput += 2;
+		if (distance == 0 || distance > pos)
+			return false;
+
+		size_t matchLength = token & 15;
+		if (matchLength == 15 && !readLength(pInput, pEnd, &matchLength))
+			return false;
+		matchLength += MinMatch;
+		if (matchLength > outputSize - pos)
+			return false;
+
+		// Matches can overlap the bytes they produce, so copy byte by byte.
+		const uint8_t *pMatch = pOutput + pos - distance;
+		for (size_t i = 0; i < matchLength; i++)
+			pOutput[pos + i] = pMatch[i];
+		pos += matchLength;
+	}
+
+	return pos == outputSize;
+}
+}
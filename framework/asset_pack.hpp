@@ -0,0 +1,120 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FRAMEWORK_ASSET_PACK_HPP
+#define FRAMEWORK_ASSET_PACK_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace MaliSDK
+{
+/// @brief The on-disk format of asset packs, which bundle all assets of a
+/// sample into a single file.
+///
+/// A pack starts with an @ref AssetPackHeader, followed by the index, which
+/// is an array of @ref AssetPackEntry sorted by name hash, and by the names
+/// of all entries. The data of every entry starts at a multiple of
+/// ASSET_PACK_ALIGNMENT, so uncompressed entries of a memory mapped pack can
+/// be used in place, e.g. as SPIR-V words.
+///
+/// All values are little-endian.
+enum
+{
+	/// "MAPK"
+	ASSET_PACK_MAGIC = 0x4b50414d,
+	ASSET_PACK_VERSION = 1,
+	ASSET_PACK_ALIGNMENT = 16,
+
+	/// The entry is compressed with @ref compressAssetData.
+	ASSET_PACK_ENTRY_COMPRESSED = 1 << 0
+};
+
+/// @brief The header of an asset pack.
+struct AssetPackHeader
+{
+	/// ASSET_PACK_MAGIC.
+	uint32_t magic;
+
+	/// ASSET_PACK_VERSION.
+	uint32_t version;
+
+	/// The number of entries in the index.
+	uint32_t entryCount;
+
+	/// The size of the names following the index.
+	uint32_t namesSize;
+};
+static_assert(sizeof(AssetPackHeader) == 16, "Unexpected asset pack header size.");
+
+/// @brief An entry in the index of an asset pack.
+struct AssetPackEntry
+{
+	/// The hash of the name, from @ref hashAssetName.
+	uint64_t nameHash;
+
+	/// The offset of the data from the start of the pack.
+	uint64_t offset;
+
+	/// The size of the asset.
+	uint64_t size;
+
+	/// The size of the data in the pack, which is smaller than @ref size if
+	/// the entry is compressed.
+	uint64_t storedSize;
+
+	/// The offset of the name from the start of the names.
+	uint32_t nameOffset;
+
+	/// The length of the name, without a terminator.
+	uint32_t nameLength;
+
+	/// ASSET_PACK_ENTRY_* flags.
+	uint32_t flags;
+
+	uint32_t reserved;
+};
+static_assert(sizeof(AssetPackEntry) == 48, "Unexpected asset pack entry size.");
+
+/// @brief Hashes the name of an asset with 64-bit FNV-1a.
+/// @param pName The name, relative to the assets directory, e.g.
+/// "shaders/triangle.vert.spv".
+/// @param length The length of the name.
+/// @returns The hash
+uint64_t hashAssetName(const char *pName, size_t length);
+
+/// @brief Compresses data with a byte-oriented LZ77 scheme which is cheap to
+/// decompress.
+/// @param pInput The data to compress.
+/// @param size The size of the data.
+/// @param[out] pOutput The compressed data.
+void compressAssetData(const uint8_t *pInput, size_t size, std::vector<uint8_t> *pOutput);
+
+/// @brief Decompresses data compressed with @ref compressAssetData.
+/// @param pInput The compressed data.
+/// @param inputSize The size of the compressed data.
+/// @param[out] pOutput The decompressed data.
+/// @param outputSize The size of the decompressed data.
+/// @returns true if the data decompressed to exactly outputSize bytes.
+bool decompressAssetData(const uint8_t *pInput, size_t inputSize, uint8_t *pOutput, size_t outputSize);
+}
+
+#endif
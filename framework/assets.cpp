@@ -19,10 +19,19 @@
  */
 
 #include "assets.hpp"
+#include "astc_decoder.hpp"
+#include "astc_encoder.hpp"
 #include "common.hpp"
+#include "pixel_conversion.hpp"
 #include "platform/os.hpp"
 #include "platform/platform.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <memory>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
 #include <vector>
 
 #define STB_IMAGE_STATIC
@@ -36,50 +45,106 @@ namespace MaliSDK
 
 VkShaderModule loadShaderModule(VkDevice device, const char *pPath)
 {
-	vector<uint32_t> buffer;
-	if (FAILED(OS::getAssetManager().readBinaryFile(&buffer, pPath)))
+	AssetData data;
+	if (FAILED(OS::getAssetManager().mapBinaryFile(pPath, &data)))
 	{
 		LOGE("Failed to read SPIR-V file: %s.\n", pPath);
 		return VK_NULL_HANDLE;
 	}
 
 	VkShaderModuleCreateInfo moduleInfo = { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
-	moduleInfo.codeSize = buffer.size() * sizeof(uint32_t);
-	moduleInfo.pCode = buffer.data();
+	moduleInfo.codeSize = data.getSize() & ~size_t(3);
+	moduleInfo.pCode = static_cast<const uint32_t *>(data.getData());
+
+	// SPIR-V is consumed in place, unless the asset is not aligned to words,
+	// which can happen for assets which are stored inside archives.
+	vector<uint32_t> aligned;
+	if (reinterpret_cast<uintptr_t>(moduleInfo.pCode) & 3)
+	{
+		aligned.resize(moduleInfo.codeSize / sizeof(uint32_t));
+		memcpy(aligned.data(), data.getData(), moduleInfo.codeSize);
+		moduleInfo.pCode = aligned.data();
+	}
 
 	VkShaderModule shaderModule;
 	VK_CHECK(vkCreateShaderModule(device, &moduleInfo, nullptr, &shaderModule));
 	return shaderModule;
 }
 
-Result loadRgba8888TextureFromAsset(const char *pPath, vector<uint8_t> *pBuffer, unsigned *pWidth, unsigned *pHeight)
+static Result decodeRgba8888Texture(const AssetData &compressed, const char *pPath,
+                                    const TextureDestinationCallback &destination, unsigned *pWidth,
+                                    unsigned *pHeight, unsigned flags, ThreadPool *pPool)
 {
-	vector<uint8_t> compressed;
-	if (FAILED(OS::getAssetManager().readBinaryFile(&compressed, pPath)))
-	{
-		LOGE("Failed to read texture: %s.\n", pPath);
-		return RESULT_ERROR_IO;
-	}
-
+	// Decode with the components stored in the image and expand them to RGBA
+	// ourselves, straight into the destination. Letting stb_image expand them
+	// would cost another pass over the whole image.
 	int x, y, comp;
-
-	uint8_t *pResult = stbi_load_from_memory(compressed.data(), compressed.size(), &x, &y, &comp, STBI_rgb_alpha);
-	if (!pResult || comp != STBI_rgb_alpha)
+	uint8_t *pDecoded = stbi_load_from_memory(static_cast<const stbi_uc *>(compressed.getData()),
+	                                          int(compressed.getSize()), &x, &y, &comp, 0);
+	if (!pDecoded || comp < 1 || comp > 4)
 	{
 		LOGE("Failed to decompress texture: %s.\n", pPath);
-		free(pResult);
+		stbi_image_free(pDecoded);
 		return RESULT_ERROR_GENERIC;
 	}
 
-	pBuffer->clear();
-	pBuffer->insert(end(*pBuffer), pResult, pResult + x * y * 4);
+	size_t rowPitch = size_t(x) * 4;
+	uint8_t *pDst = static_cast<uint8_t *>(destination(x, y, &rowPitch));
+	if (!pDst)
+	{
+		stbi_image_free(pDecoded);
+		return RESULT_ERROR_OUT_OF_MEMORY;
+	}
+
+	// Premultiply each row right after converting it, while it is still in
+	// the cache.
+	bool premultiply = (flags & TEXTURE_DECODE_PREMULTIPLY_ALPHA_BIT) != 0 && (comp == 2 || comp == 4);
+	auto convertRows = [=](unsigned, unsigned begin, unsigned end) {
+		for (unsigned row = begin; row < end; row++)
+		{
+			uint8_t *pRow = pDst + row * rowPitch;
+			convertToRgba8888(pRow, pDecoded + size_t(row) * x * comp, x, comp);
+			if (premultiply)
+				premultiplyRgba8888(pRow, x);
+		}
+	};
+
+	// Small images are not worth the synchronization.
+	static const unsigned StripPixels = 64 * 1024;
+	unsigned rowsPerStrip = max(StripPixels / unsigned(x), 1u);
+	if (pPool && unsigned(y) > rowsPerStrip)
+		pPool->parallelFor(0, y, rowsPerStrip, convertRows);
+	else
+		convertRows(0, 0, y);
+
 	*pWidth = x;
 	*pHeight = y;
-	free(pResult);
-
+	stbi_image_free(pDecoded);
 	return RESULT_SUCCESS;
 }
 
+Result decodeRgba8888TextureFromAsset(const char *pPath, const TextureDestinationCallback &destination,
+                                      unsigned *pWidth, unsigned *pHeight, unsigned flags, ThreadPool *pPool)
+{
+	AssetData compressed;
+	if (FAILED(OS::getAssetManager().mapBinaryFile(pPath, &compressed)))
+	{
+		LOGE("Failed to read texture: %s.\n", pPath);
+		return RESULT_ERROR_IO;
+	}
+
+	return decodeRgba8888Texture(compressed, pPath, destination, pWidth, pHeight, flags, pPool);
+}
+
+Result loadRgba8888TextureFromAsset(const char *pPath, vector<uint8_t> *pBuffer, unsigned *pWidth, unsigned *pHeight)
+{
+	auto allocate = [pBuffer](unsigned width, unsigned height, size_t *) -> void * {
+		pBuffer->resize(size_t(width) * height * 4);
+		return pBuffer->data();
+	};
+	return decodeRgba8888TextureFromAsset(pPath, allocate, pWidth, pHeight);
+}
+
 /// Header for the on-disk format generated by astcenc.
 struct ASTCHeader
 {
@@ -102,21 +167,14 @@ static_assert(sizeof(ASTCHeader) == 16, "Packed ASTC header struct is not 16 byt
 
 #define ASTC_MAGIC 0x5CA1AB13
 
-Result loadASTCTextureFromAsset(const char *pPath, vector<uint8_t> *pBuffer, unsigned *pWidth, unsigned *pHeight,
-                                VkFormat *pFormat)
+static Result parseASTCFile(const AssetData &compressed, const char *pPath, AssetData *pPayload, unsigned *pWidth,
+                            unsigned *pHeight, VkFormat *pFormat)
 {
-	vector<uint8_t> compressed;
-	if (FAILED(OS::getAssetManager().readBinaryFile(&compressed, pPath)))
-	{
-		LOGE("Failed to read ASTC texture: %s.\n", pPath);
-		return RESULT_ERROR_IO;
-	}
-
-	if (compressed.size() < sizeof(ASTCHeader))
+	if (compressed.getSize() < sizeof(ASTCHeader))
 		return RESULT_ERROR_GENERIC;
 
 	ASTCHeader header;
-	memcpy(&header, compressed.data(), sizeof(ASTCHeader));
+	memcpy(&header, compressed.getData(), sizeof(ASTCHeader));
 	uint32_t magic = header.magic[0] | (uint32_t(header.magic[1]) << 8) | (uint32_t(header.magic[2]) << 16) |
 	                 (uint32_t(header.magic[3]) << 24);
 
@@ -166,10 +224,132 @@ Result loadASTCTextureFromAsset(const char *pPath, vector<uint8_t> *pBuffer, uns
 		return RESULT_ERROR_GENERIC;
 	}
 
-	pBuffer->clear();
-	pBuffer->insert(end(*pBuffer), begin(compressed) + sizeof(ASTCHeader), end(compressed));
+	*pPayload = compressed.getSubData(sizeof(ASTCHeader), compressed.getSize() - sizeof(ASTCHeader));
 	*pWidth = header.xsize[0] | (header.xsize[1] << 8) | (header.xsize[2] << 16);
 	*pHeight = header.ysize[0] | (header.ysize[1] << 8) | (header.ysize[2] << 16);
 	return RESULT_SUCCESS;
 }
+
+Result loadASTCTextureFromAsset(const char *pPath, AssetData *pPayload, unsigned *pWidth, unsigned *pHeight,
+                                VkFormat *pFormat)
+{
+	AssetData compressed;
+	if (FAILED(OS::getAssetManager().mapBinaryFile(pPath, &compressed)))
+	{
+		LOGE("Failed to read ASTC texture: %s.\n", pPath);
+		return RESULT_ERROR_IO;
+	}
+
+	return parseASTCFile(compressed, pPath, pPayload, pWidth, pHeight, pFormat);
+}
+
+Result loadASTCTextureFromAsset(const char *pPath, vector<uint8_t> *pBuffer, unsigned *pWidth, unsigned *pHeight,
+                                VkFormat *pFormat)
+{
+	AssetData payload;
+	Result res = loadASTCTextureFromAsset(pPath, &payload, pWidth, pHeight, pFormat);
+	if (FAILED(res))
+		return res;
+
+	const uint8_t *pData = static_cast<const uint8_t *>(payload.getData());
+	pBuffer->clear();
+	pBuffer->insert(end(*pBuffer), pData, pData + payload.getSize());
+	return RESULT_SUCCESS;
+}
+
+uint64_t hashData(uint64_t hash, const void *pData, size_t size)
+{
+	const uint8_t *pBytes = static_cast<const uint8_t *>(pData);
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= pBytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+Result writeCacheFile(const char *pPath, const void *pData, size_t size)
+{
+	if (!OS::writeFileAtomically(pPath, pData, size))
+	{
+		LOGE("Failed to write cache file: %s.\n", pPath);
+		return RESULT_ERROR_IO;
+	}
+	return RESULT_SUCCESS;
+}
+
+Result loadOrEncodeASTCTextureFromAsset(const char *pPath, VkFormat format, AssetData *pPayload, unsigned *pWidth,
+                                        unsigned *pHeight, ThreadPool *pPool)
+{
+	unsigned blockWidth, blockHeight;
+	if (!getASTCBlockSize(format, &blockWidth, &blockHeight))
+	{
+		LOGE("Format %d is not a 2D ASTC format.\n", int(format));
+		return RESULT_ERROR_GENERIC;
+	}
+
+	AssetData source;
+	if (FAILED(OS::getAssetManager().mapBinaryFile(pPath, &source)))
+	{
+		LOGE("Failed to read texture: %s.\n", pPath);
+		return RESULT_ERROR_IO;
+	}
+
+	// The name of a cached file is a hash of everything which determines its
+	// contents, so cached files never go stale.
+	string cachePath = OS::getCacheDirectory();
+	if (!cachePath.empty())
+	{
+		const uint32_t parameters[2] = { uint32_t(format), ASTC_ENCODER_VERSION };
+		uint64_t hash = hashData(0xcbf29ce484222325ull, source.getData(), source.getSize());
+		hash = hashData(hash, parameters, sizeof(parameters));
+
+		char name[32];
+		snprintf(name, sizeof(name), "/%016llx.astc", static_cast<unsigned long long>(hash));
+		cachePath += name;
+
+		// Cached files are read from the file system, not from assets.
+		AssetManager fileSystem;
+		AssetData cached;
+		VkFormat cachedFormat;
+		if (SUCCEEDED(fileSystem.mapBinaryFile(cachePath.c_str(), &cached)) &&
+		    SUCCEEDED(parseASTCFile(cached, cachePath.c_str(), pPayload, pWidth, pHeight, &cachedFormat)))
+		{
+			size_t blocksX = (*pWidth + blockWidth - 1) / blockWidth;
+			size_t blocksY = (*pHeight + blockHeight - 1) / blockHeight;
+			if (pPayload->getSize() == blocksX * blocksY * 16)
+				return RESULT_SUCCESS;
+			LOGE("Ignoring truncated cache file: %s.\n", cachePath.c_str());
+		}
+	}
+
+	vector<uint8_t> pixels;
+	auto allocate = [&pixels](unsigned width, unsigned height, size_t *) -> void * {
+		pixels.resize(size_t(width) * height * 4);
+		return pixels.data();
+	};
+
+	unsigned width, height;
+	Result res = decodeRgba8888Texture(source, pPath, allocate, &width, &height, 0, pPool);
+	if (FAILED(res))
+		return res;
+
+	vector<uint8_t> blocks;
+	res = encodeASTCFromRgba8888(&blocks, pixels.data(), size_t(width) * 4, width, height, format, pPool);
+	if (FAILED(res))
+		return res;
+
+	// Keep the file, header included, so the payload can be returned as a
+	// view of it.
+	auto pFile = make_shared<vector<uint8_t>>(ASTC_FILE_HEADER_SIZE);
+	writeASTCFileHeader(pFile->data(), format, width, height);
+	pFile->insert(end(*pFile), begin(blocks), end(blocks));
+	if (!cachePath.empty())
+		writeCacheFile(cachePath.c_str(), pFile->data(), pFile->size());
+
+	*pPayload = AssetData(pFile->data() + ASTC_FILE_HEADER_SIZE, blocks.size(), pFile);
+	*pWidth = width;
+	*pHeight = height;
+	return RESULT_SUCCESS;
+}
 }
@@ -23,11 +23,15 @@
 
 #include "common.hpp"
 #include "libvulkan-stub.h"
+#include "platform/asset_manager.hpp"
+#include <functional>
 #include <stdint.h>
 #include <vector>
 
 namespace MaliSDK
 {
+class ThreadPool;
+
 /// @brief Loads a SPIR-V shader module from assets.
 /// @param device The Vulkan device.
 /// @param path Path to the SPIR-V shader.
@@ -45,6 +49,54 @@ VkShaderModule loadShaderModule(VkDevice device, const char *pPath);
 Result loadRgba8888TextureFromAsset(const char *pPath, std::vector<uint8_t> *pBuffer, unsigned *pWidth,
                                     unsigned *pHeight);
 
+/// @brief Flags which control how @ref decodeRgba8888TextureFromAsset
+/// converts pixels.
+enum TextureDecodeFlagBits
+{
+	/// Multiply the color components by the alpha component.
+	TEXTURE_DECODE_PREMULTIPLY_ALPHA_BIT = 1 << 0
+};
+
+/// @brief Provides the memory a texture is decoded into.
+///
+/// Called once the dimensions of the texture are known. Returns the
+/// destination, or nullptr to cancel decoding. pRowPitch is initialized to
+/// width * 4 and can be changed to the number of bytes between the rows of the
+/// destination.
+typedef std::function<void *(unsigned width, unsigned height, size_t *pRowPitch)> TextureDestinationCallback;
+
+/// @brief Decodes a texture from assets straight into memory provided by the
+/// caller, such as a mapped staging buffer.
+///
+/// The image is converted to VK_FORMAT_R8G8B8A8_UNORM with NEON or SSE2
+/// where available. Images are decoded by a single thread, but if a thread
+/// pool is given, the conversion of large images is split into strips of
+/// rows which are converted in parallel.
+///
+/// @param      pPath Path to texture.
+/// @param      destination Provides the memory to decode into.
+/// @param[out] pWidth Width of the loaded texture.
+/// @param[out] pHeight Height of the loaded texture.
+/// @param      flags A combination of @ref TextureDecodeFlagBits.
+/// @param      pPool The thread pool to convert pixels on, or nullptr.
+///
+/// @returns Error code.
+Result decodeRgba8888TextureFromAsset(const char *pPath, const TextureDestinationCallback &destination,
+                                      unsigned *pWidth, unsigned *pHeight, unsigned flags = 0,
+                                      ThreadPool *pPool = nullptr);
+
+/// @brief Loads an ASTC texture from assets without copying the payload.
+///
+/// Loads files created by astcenc tool.
+///
+/// @param pPath Path to texture.
+/// @param[out] pPayload A view of the ASTC payload in the asset.
+/// @param[out] pWidth Width of the loaded texture.
+/// @param[out] pHeight Height of the loaded texture.
+/// @param[out] pFormat The format of the loaded texture.
+Result loadASTCTextureFromAsset(const char *pPath, AssetData *pPayload, unsigned *pWidth, unsigned *pHeight,
+                                VkFormat *pFormat);
+
 /// @brief Loads an ASTC texture from assets.
 ///
 /// Loads files created by astcenc tool.
@@ -56,6 +108,45 @@ Result loadRgba8888TextureFromAsset(const char *pPath, std::vector<uint8_t> *pBu
 /// @param[out] pFormat The format of the loaded texture.
 Result loadASTCTextureFromAsset(const char *pPath, std::vector<uint8_t> *pBuffer, unsigned *pWidth, unsigned *pHeight,
                                 VkFormat *pFormat);
+
+/// @brief Loads a texture from assets as ASTC, compressing it on first load.
+///
+/// The texture, e.g. a PNG, is decoded and compressed with
+/// `encodeASTCFromRgba8888`, and the result is written to the cache
+/// directory of the platform, from where later loads read it directly.
+/// Cached files are named after a hash of the source texture, the format
+/// and the encoder version, so changing any of them compresses the texture
+/// again. Without a cache directory, the texture is compressed on every load.
+///
+/// @param pPath Path to texture.
+/// @param format The 2D ASTC format to compress to.
+/// @param[out] pPayload The ASTC payload.
+/// @param[out] pWidth Width of the loaded texture.
+/// @param[out] pHeight Height of the loaded texture.
+/// @param pPool The thread pool to decode and compress on, or nullptr.
+///
+/// @returns Error code.
+Result loadOrEncodeASTCTextureFromAsset(const char *pPath, VkFormat format, AssetData *pPayload, unsigned *pWidth,
+                                        unsigned *pHeight, ThreadPool *pPool = nullptr);
+
+/// @brief Hashes data with 64-bit FNV-1a.
+/// @param hash The hash to continue from, or 0xcbf29ce484222325 to start a
+/// new hash.
+/// @param pData The data to hash.
+/// @param size The size of the data in bytes.
+/// @returns The hash.
+uint64_t hashData(uint64_t hash, const void *pData, size_t size);
+
+/// @brief Writes a file to the file system, typically to the cache directory
+/// of the platform.
+///
+/// The file is written with OS::writeFileAtomically, so concurrent or
+/// interrupted writers never leave a partial file behind.
+/// @param pPath The path of the file.
+/// @param pData The contents of the file.
+/// @param size The size of the contents in bytes.
+/// @returns Error code.
+Result writeCacheFile(const char *pPath, const void *pData, size_t size);
 }
 
 #endif
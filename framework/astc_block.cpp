@@ -0,0 +1,693 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "astc_block.hpp"
+#include <algorithm>
+
+using namespace std;
+
+namespace MaliSDK
+{
+namespace
+{
+uint64_t reverseBits(uint64_t value)
+{
+	value = ((value >> 1) & 0x5555555555555555ull) | ((value & 0x5555555555555555ull) << 1);
+	value = ((value >> 2) & 0x3333333333333333ull) | ((value & 0x3333333333333333ull) << 2);
+	value = ((value >> 4) & 0x0f0f0f0f0f0f0f0full) | ((value & 0x0f0f0f0f0f0f0f0full) << 4);
+	value = ((value >> 8) & 0x00ff00ff00ff00ffull) | ((value & 0x00ff00ff00ff00ffull) << 8);
+	value = ((value >> 16) & 0x0000ffff0000ffffull) | ((value & 0x0000ffff0000ffffull) << 16);
+	return (value >> 32) | (value << 32);
+}
+
+void decodeTrits(unsigned t, unsigned *pTrits)
+{
+	// Integer Sequence Encoding, trit decoding.
+	unsigned c;
+	if (((t >> 2) & 7) == 7)
+	{
+		c = ((t >> 3) & 0x1c) | (t & 3);
+		pTrits[3] = 2;
+		pTrits[4] = 2;
+	}
+	else
+	{
+		c = t & 0x1f;
+		if (((t >> 5) & 3) == 3)
+		{
+			pTrits[4] = 2;
+			pTrits[3] = (t >> 7) & 1;
+		}
+		else
+		{
+			pTrits[4] = (t >> 7) & 1;
+			pTrits[3] = (t >> 5) & 3;
+		}
+	}
+
+	if ((c & 3) == 3)
+	{
+		pTrits[2] = 2;
+		pTrits[1] = (c >> 4) & 1;
+		pTrits[0] = (((c >> 3) & 1) << 1) | (((c >> 2) & 1) & ~((c >> 3) & 1));
+	}
+	else if (((c >> 2) & 3) == 3)
+	{
+		pTrits[2] = 2;
+		pTrits[1] = 2;
+		pTrits[0] = c & 3;
+	}
+	else
+	{
+		pTrits[2] = (c >> 4) & 1;
+		pTrits[1] = (c >> 2) & 3;
+		pTrits[0] = (((c >> 1) & 1) << 1) | ((c & 1) & ~((c >> 1) & 1));
+	}
+}
+
+void decodeQuints(unsigned q, unsigned *pQuints)
+{
+	// Integer Sequence Encoding, quint decoding.
+	if (((q >> 1) & 3) == 3 && ((q >> 5) & 3) == 0)
+	{
+		unsigned q0 = q & 1;
+		pQuints[2] = (q0 << 2) | ((((q >> 4) & 1) & ~q0) << 1) | (((q >> 3) & 1) & ~q0);
+		pQuints[1] = 4;
+		pQuints[0] = 4;
+		return;
+	}
+
+	unsigned c;
+	if (((q >> 1) & 3) == 3)
+	{
+		pQuints[2] = 4;
+		c = (((q >> 3) & 3) << 3) | (((~q >> 5) & 3) << 1) | (q & 1);
+	}
+	else
+	{
+		pQuints[2] = (q >> 5) & 3;
+		c = q & 0x1f;
+	}
+
+	if ((c & 7) == 5)
+	{
+		pQuints[1] = 4;
+		pQuints[0] = (c >> 3) & 3;
+	}
+	else
+	{
+		pQuints[1] = (c >> 3) & 3;
+		pQuints[0] = c & 7;
+	}
+}
+
+unsigned replicateBits(unsigned value, unsigned bits, unsigned targetBits)
+{
+	unsigned result = 0;
+	int shift = int(targetBits) - int(bits);
+	while (shift > -int(bits))
+	{
+		result |= shift >= 0 ? value << shift : value >> -shift;
+		shift -= bits;
+	}
+	return result & ((1u << targetBits) - 1);
+}
+
+uint32_t hashPartitionSeed(uint32_t seed)
+{
+	seed ^= seed >> 15;
+	seed *= 0xeede0891u;
+	seed ^= seed >> 5;
+	seed += seed << 16;
+	seed ^= seed >> 7;
+	seed ^= seed >> 3;
+	seed ^= seed << 6;
+	seed ^= seed >> 17;
+	return seed;
+}
+
+/// Inverts trit and quint decoding, indexed by the values packed in base 3
+/// or base 5.
+struct ISEEncodeTables
+{
+	uint8_t trits[3 * 3 * 3 * 3 * 3];
+	uint8_t quints[5 * 5 * 5];
+
+	ISEEncodeTables()
+	{
+		// Several packings decode to the same values. Going downwards keeps
+		// the smallest one, whose unused high bits are zero.
+		for (int t = 255; t >= 0; t--)
+		{
+			unsigned values[5];
+			decodeTrits(unsigned(t), values);
+			trits[values[0] + 3 * values[1] + 9 * values[2] + 27 * values[3] + 81 * values[4]] = uint8_t(t);
+		}
+		for (int q = 127; q >= 0; q--)
+		{
+			unsigned values[3];
+			decodeQuints(unsigned(q), values);
+			quints[values[0] + 5 * values[1] + 25 * values[2]] = uint8_t(q);
+		}
+	}
+};
+
+const ISEEncodeTables &getISEEncodeTables()
+{
+	static const ISEEncodeTables tables;
+	return tables;
+}
+
+}
+
+const ASTCQuantMode ASTCQuantModes[ASTC_QUANT_COUNT] = {
+	{ 0, 0, 1 }, // 2
+	{ 1, 0, 0 }, // 3
+	{ 0, 0, 2 }, // 4
+	{ 0, 1, 0 }, // 5
+	{ 1, 0, 1 }, // 6
+	{ 0, 0, 3 }, // 8
+	{ 0, 1, 1 }, // 10
+	{ 1, 0, 2 }, // 12
+	{ 0, 0, 4 }, // 16
+	{ 0, 1, 2 }, // 20
+	{ 1, 0, 3 }, // 24
+	{ 0, 0, 5 }, // 32
+	{ 0, 1, 3 }, // 40
+	{ 1, 0, 4 }, // 48
+	{ 0, 0, 6 }, // 64
+	{ 0, 1, 4 }, // 80
+	{ 1, 0, 5 }, // 96
+	{ 0, 0, 7 }, // 128
+	{ 0, 1, 5 }, // 160
+	{ 1, 0, 6 }, // 192
+	{ 0, 0, 8 }, // 256
+};
+
+unsigned ASTCBits128::read(unsigned offset, unsigned count, unsigned end) const
+{
+	if (offset >= end || count == 0)
+		return 0;
+	count = min(count, end - offset);
+
+	uint64_t value;
+	if (offset >= 64)
+		value = hi >> (offset - 64);
+	else if (offset == 0)
+		value = lo;
+	else
+		value = (lo >> offset) | (hi << (64 - offset));
+	return unsigned(value & ((uint64_t(1) << count) - 1));
+}
+
+void ASTCBits128::write(unsigned offset, unsigned count, unsigned value)
+{
+	if (count == 0)
+		return;
+
+	uint64_t bits = uint64_t(value) & ((uint64_t(1) << count) - 1);
+	if (offset >= 64)
+		hi |= bits << (offset - 64);
+	else
+	{
+		lo |= bits << offset;
+		if (offset + count > 64)
+			hi |= bits >> (64 - offset);
+	}
+}
+
+ASTCBits128 ASTCBits128::reversed() const
+{
+	ASTCBits128 result = { reverseBits(hi), reverseBits(lo) };
+	return result;
+}
+
+unsigned getASTCISEBitCount(unsigned count, unsigned quant)
+{
+	const ASTCQuantMode &mode = ASTCQuantModes[quant];
+	unsigned bits = mode.bits * count;
+	if (mode.trits)
+		bits += (8 * count + 4) / 5;
+	if (mode.quints)
+		bits += (7 * count + 2) / 3;
+	return bits;
+}
+
+void decodeASTCISE(const ASTCBits128 &block, unsigned offset, unsigned count, unsigned quant, uint8_t *pBits,
+               uint8_t *pTritsQuints)
+{
+	const ASTCQuantMode &mode = ASTCQuantModes[quant];
+	unsigned bits = mode.bits;
+	unsigned end = offset + getASTCISEBitCount(count, quant);
+
+	if (mode.trits)
+	{
+		// Five values share eight trit bits, interleaved between their low bits.
+		static const unsigned TritBits[5] = { 2, 2, 1, 2, 1 };
+		for (unsigned i = 0; i < count; i += 5)
+		{
+			unsigned lowBits[5];
+			unsigned packed = 0;
+			for (unsigned j = 0, shift = 0; j < 5; j++)
+			{
+				lowBits[j] = block.read(offset, bits, end);
+				offset += bits;
+				packed |= block.read(offset, TritBits[j], end) << shift;
+				offset += TritBits[j];
+				shift += TritBits[j];
+			}
+
+			unsigned trits[5];
+			decodeTrits(packed, trits);
+			for (unsigned j = 0; j < 5 && i + j < count; j++)
+			{
+				pBits[i + j] = uint8_t(lowBits[j]);
+				pTritsQuints[i + j] = uint8_t(trits[j]);
+			}
+		}
+	}
+	else if (mode.quints)
+	{
+		// Three values share seven quint bits.
+		static const unsigned QuintBits[3] = { 3, 2, 2 };
+		for (unsigned i = 0; i < count; i += 3)
+		{
+			unsigned lowBits[3];
+			unsigned packed = 0;
+			for (unsigned j = 0, shift = 0; j < 3; j++)
+			{
+				lowBits[j] = block.read(offset, bits, end);
+				offset += bits;
+				packed |= block.read(offset, QuintBits[j], end) << shift;
+				offset += QuintBits[j];
+				shift += QuintBits[j];
+			}
+
+			unsigned quints[3];
+			decodeQuints(packed, quints);
+			for (unsigned j = 0; j < 3 && i + j < count; j++)
+			{
+				pBits[i + j] = uint8_t(lowBits[j]);
+				pTritsQuints[i + j] = uint8_t(quints[j]);
+			}
+		}
+	}
+	else
+	{
+		for (unsigned i = 0; i < count; i++, offset += bits)
+		{
+			pBits[i] = uint8_t(block.read(offset, bits, end));
+			pTritsQuints[i] = 0;
+		}
+	}
+}
+
+void encodeASTCISE(ASTCBits128 *pBlock, unsigned offset, unsigned count, unsigned quant, const uint8_t *pBits,
+                   const uint8_t *pTritsQuints)
+{
+	const ASTCQuantMode &mode = ASTCQuantModes[quant];
+	unsigned bits = mode.bits;
+	unsigned end = offset + getASTCISEBitCount(count, quant);
+
+	// Writes the bits of a value which fall before the end of the sequence.
+	// The bits past the end of a partial group are zero by construction.
+	auto write = [&](unsigned value, unsigned valueBits) {
+		if (offset < end)
+			pBlock->write(offset, min(valueBits, end - offset), value);
+		offset += valueBits;
+	};
+
+	if (mode.trits)
+	{
+		static const unsigned TritBits[5] = { 2, 2, 1, 2, 1 };
+		const uint8_t *pTable = getISEEncodeTables().trits;
+		for (unsigned i = 0; i < count; i += 5)
+		{
+			unsigned index = 0;
+			for (unsigned j = 5; j-- > 0;)
+				index = index * 3 + (i + j < count ? pTritsQuints[i + j] : 0);
+
+			unsigned packed = pTable[index];
+			for (unsigned j = 0; j < 5; j++)
+			{
+				write(i + j < count ? pBits[i + j] : 0, bits);
+				write(packed, TritBits[j]);
+				packed >>= TritBits[j];
+			}
+		}
+	}
+	else if (mode.quints)
+	{
+		static const unsigned QuintBits[3] = { 3, 2, 2 };
+		const uint8_t *pTable = getISEEncodeTables().quints;
+		for (unsigned i = 0; i < count; i += 3)
+		{
+			unsigned index = 0;
+			for (unsigned j = 3; j-- > 0;)
+				index = index * 5 + (i + j < count ? pTritsQuints[i + j] : 0);
+
+			unsigned packed = pTable[index];
+			for (unsigned j = 0; j < 3; j++)
+			{
+				write(i + j < count ? pBits[i + j] : 0, bits);
+				write(packed, QuintBits[j]);
+				packed >>= QuintBits[j];
+			}
+		}
+	}
+	else
+	{
+		for (unsigned i = 0; i < count; i++)
+			write(pBits[i], bits);
+	}
+}
+
+uint8_t unquantizeASTCColor(unsigned quant, unsigned bits, unsigned tritQuint)
+{
+	// Color Endpoint Unquantization.
+	const ASTCQuantMode &mode = ASTCQuantModes[quant];
+	if (!mode.trits && !mode.quints)
+		return uint8_t(replicateBits(bits, mode.bits, 8));
+
+	unsigned a = bits & 1;
+	unsigned x = bits >> 1;
+	unsigned A = a ? 0x1ff : 0;
+	unsigned B = 0;
+	unsigned C = 0;
+
+	if (mode.trits)
+	{
+		switch (mode.bits)
+		{
+		case 1:
+			C = 204;
+			break;
+		case 2:
+			B = x * 0x116;
+			C = 93;
+			break;
+		case 3:
+			B = (x << 7) | (x << 2) | x;
+			C = 44;
+			break;
+		case 4:
+			B = (x << 6) | x;
+			C = 22;
+			break;
+		case 5:
+			B = (x << 5) | (x >> 2);
+			C = 11;
+			break;
+		case 6:
+			B = (x << 4) | (x >> 4);
+			C = 5;
+			break;
+		}
+	}
+	else
+	{
+		switch (mode.bits)
+		{
+		case 1:
+			C = 113;
+			break;
+		case 2:
+			B = x * 0x10c;
+			C = 54;
+			break;
+		case 3:
+			B = (x << 7) | (x << 1) | (x >> 1);
+			C = 26;
+			break;
+		case 4:
+			B = (x << 6) | (x >> 1);
+			C = 13;
+			break;
+		case 5:
+			B = (x << 5) | (x >> 3);
+			C = 6;
+			break;
+		}
+	}
+
+	unsigned T = (tritQuint * C + B) ^ A;
+	return uint8_t((A & 0x80) | (T >> 2));
+}
+
+uint8_t unquantizeASTCWeight(unsigned quant, unsigned bits, unsigned tritQuint)
+{
+	// Weight Unquantization. Weights are unquantized to [0, 64].
+	const ASTCQuantMode &mode = ASTCQuantModes[quant];
+	unsigned result;
+
+	if (!mode.trits && !mode.quints)
+		result = replicateBits(bits, mode.bits, 6);
+	else if (mode.bits == 0)
+	{
+		static const uint8_t Trits[3] = { 0, 32, 63 };
+		static const uint8_t Quints[5] = { 0, 16, 32, 47, 63 };
+		result = mode.trits ? Trits[tritQuint] : Quints[tritQuint];
+	}
+	else
+	{
+		unsigned a = bits & 1;
+		unsigned x = bits >> 1;
+		unsigned A = a ? 0x7f : 0;
+		unsigned B = 0;
+		unsigned C = 0;
+
+		if (mode.trits)
+		{
+			switch (mode.bits)
+			{
+			case 1:
+				C = 50;
+				break;
+			case 2:
+				B = x * 0x45;
+				C = 23;
+				break;
+			case 3:
+				B = (x << 5) | x;
+				C = 11;
+				break;
+			}
+		}
+		else
+		{
+			switch (mode.bits)
+			{
+			case 1:
+				C = 28;
+				break;
+			case 2:
+				B = x * 0x42;
+				C = 13;
+				break;
+			}
+		}
+
+		unsigned T = (tritQuint * C + B) ^ A;
+		result = (A & 0x20) | (T >> 2);
+	}
+
+	return uint8_t(result > 32 ? result + 1 : result);
+}
+
+bool decodeASTCBlockMode(unsigned blockMode, ASTCBlockMode *pMode)
+{
+	// Block Mode, 2D layouts.
+	unsigned R = (blockMode >> 4) & 1;
+	unsigned H = (blockMode >> 9) & 1;
+	unsigned D = (blockMode >> 10) & 1;
+	unsigned A = (blockMode >> 5) & 3;
+	unsigned N = 0;
+	unsigned M = 0;
+
+	if ((blockMode & 3) != 0)
+	{
+		R |= (blockMode & 3) << 1;
+		unsigned B = (blockMode >> 7) & 3;
+		switch ((blockMode >> 2) & 3)
+		{
+		case 0:
+			N = B + 4;
+			M = A + 2;
+			break;
+		case 1:
+			N = B + 8;
+			M = A + 2;
+			break;
+		case 2:
+			N = A + 2;
+			M = B + 8;
+			break;
+		case 3:
+			B &= 1;
+			if (blockMode & 0x100)
+			{
+				N = B + 2;
+				M = A + 2;
+			}
+			else
+			{
+				N = A + 2;
+				M = B + 6;
+			}
+			break;
+		}
+	}
+	else
+	{
+		R |= ((blockMode >> 2) & 3) << 1;
+		if (((blockMode >> 2) & 3) == 0)
+			return false;
+
+		unsigned B = (blockMode >> 9) & 3;
+		switch ((blockMode >> 7) & 3)
+		{
+		case 0:
+			N = 12;
+			M = A + 2;
+			break;
+		case 1:
+			N = A + 2;
+			M = 12;
+			break;
+		case 2:
+			N = A + 6;
+			M = B + 6;
+			D = 0;
+			H = 0;
+			break;
+		case 3:
+			if (A == 0)
+			{
+				N = 6;
+				M = 10;
+			}
+			else if (A == 1)
+			{
+				N = 10;
+				M = 6;
+			}
+			else
+				return false;
+			break;
+		}
+	}
+
+	pMode->xWeights = N;
+	pMode->yWeights = M;
+	pMode->dualPlane = D != 0;
+	pMode->weightQuant = (R - 2) + 6 * H;
+
+	unsigned weightCount = N * M * (D + 1);
+	unsigned weightBits = getASTCISEBitCount(weightCount, pMode->weightQuant);
+	return weightCount <= ASTC_MAX_WEIGHTS && weightBits >= 24 && weightBits <= 96;
+}
+
+unsigned selectASTCPartition(unsigned seed, unsigned x, unsigned y, unsigned partitionCount, bool smallBlock)
+{
+	// Partition Pattern Generation.
+	if (smallBlock)
+	{
+		x <<= 1;
+		y <<= 1;
+	}
+
+	seed += (partitionCount - 1) * 1024;
+	uint32_t rnum = hashPartitionSeed(seed);
+
+	uint8_t seeds[8];
+	for (unsigned i = 0; i < 8; i++)
+	{
+		seeds[i] = (rnum >> (4 * i)) & 0xf;
+		seeds[i] *= seeds[i];
+	}
+
+	unsigned sh1, sh2;
+	if (seed & 1)
+	{
+		sh1 = (seed & 2) ? 4 : 5;
+		sh2 = partitionCount == 3 ? 6 : 5;
+	}
+	else
+	{
+		sh1 = partitionCount == 3 ? 6 : 5;
+		sh2 = (seed & 2) ? 4 : 5;
+	}
+
+	for (unsigned i = 0; i < 8; i += 2)
+	{
+		seeds[i] >>= sh1;
+		seeds[i + 1] >>= sh2;
+	}
+
+	// The seeds which scale z are not needed for 2D blocks.
+	unsigned a = (seeds[0] * x + seeds[1] * y + (rnum >> 14)) & 0x3f;
+	unsigned b = (seeds[2] * x + seeds[3] * y + (rnum >> 10)) & 0x3f;
+	unsigned c = (seeds[4] * x + seeds[5] * y + (rnum >> 6)) & 0x3f;
+	unsigned d = (seeds[6] * x + seeds[7] * y + (rnum >> 2)) & 0x3f;
+
+	if (partitionCount < 4)
+		d = 0;
+	if (partitionCount < 3)
+		c = 0;
+
+	if (a >= b && a >= c && a >= d)
+		return 0;
+	else if (b >= c && b >= d)
+		return 1;
+	else if (c >= d)
+		return 2;
+	else
+		return 3;
+}
+
+void computeASTCInfill(unsigned blockWidth, unsigned blockHeight, unsigned xWeights, unsigned yWeights,
+                       ASTCTexelInfill *pInfill)
+{
+	unsigned ds = (1024 + blockWidth / 2) / (blockWidth - 1);
+	unsigned dt = (1024 + blockHeight / 2) / (blockHeight - 1);
+
+	for (unsigned t = 0; t < blockHeight; t++)
+	{
+		unsigned gt = (dt * t * (yWeights - 1) + 32) >> 6;
+		unsigned jt = gt >> 4;
+		unsigned ft = gt & 0xf;
+
+		for (unsigned s = 0; s < blockWidth; s++)
+		{
+			unsigned gs = (ds * s * (xWeights - 1) + 32) >> 6;
+			unsigned js = gs >> 4;
+			unsigned fs = gs & 0xf;
+
+			ASTCTexelInfill &infill = pInfill[t * blockWidth + s];
+			unsigned w11 = (fs * ft + 8) >> 4;
+			infill.index = uint8_t(js + jt * xWeights);
+			infill.factors[0] = uint8_t(16 - fs - ft + w11);
+			infill.factors[1] = uint8_t(fs - w11);
+			infill.factors[2] = uint8_t(ft - w11);
+			infill.factors[3] = uint8_t(w11);
+		}
+	}
+}
+}
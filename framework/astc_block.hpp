@@ -0,0 +1,156 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FRAMEWORK_ASTC_BLOCK_HPP
+#define FRAMEWORK_ASTC_BLOCK_HPP
+
+#include <stdint.h>
+
+// The pieces of the ASTC block format shared by the ASTC decoder and
+// encoder. Section names in the comments refer to the ASTC chapter of the
+// Khronos Data Format Specification.
+namespace MaliSDK
+{
+/// @brief The ranges of integer sequence encoding, in increasing order.
+/// Weights can use the ranges up to ASTC_QUANT_32.
+enum ASTCQuant
+{
+	ASTC_QUANT_2,
+	ASTC_QUANT_3,
+	ASTC_QUANT_4,
+	ASTC_QUANT_5,
+	ASTC_QUANT_6,
+	ASTC_QUANT_8,
+	ASTC_QUANT_10,
+	ASTC_QUANT_12,
+	ASTC_QUANT_16,
+	ASTC_QUANT_20,
+	ASTC_QUANT_24,
+	ASTC_QUANT_32,
+	ASTC_QUANT_40,
+	ASTC_QUANT_48,
+	ASTC_QUANT_64,
+	ASTC_QUANT_80,
+	ASTC_QUANT_96,
+	ASTC_QUANT_128,
+	ASTC_QUANT_160,
+	ASTC_QUANT_192,
+	ASTC_QUANT_256,
+	ASTC_QUANT_COUNT
+};
+
+/// @brief The encoding of a range in integer sequence encoding.
+struct ASTCQuantMode
+{
+	/// 1 if values have a trit.
+	uint8_t trits;
+	/// 1 if values have a quint.
+	uint8_t quints;
+	/// The number of low bits of every value.
+	uint8_t bits;
+};
+
+/// @brief The encodings of all ranges, indexed by @ref ASTCQuant.
+extern const ASTCQuantMode ASTCQuantModes[ASTC_QUANT_COUNT];
+
+/// @brief Limits of the ASTC block format.
+enum
+{
+	ASTC_MAX_TEXELS = 12 * 12,
+	ASTC_MAX_WEIGHTS = 64,
+	ASTC_MAX_COLOR_VALUES = 18,
+	ASTC_MAX_PARTITIONS = 4
+};
+
+/// @brief A block of 128 bits, least significant bit first.
+struct ASTCBits128
+{
+	uint64_t lo;
+	uint64_t hi;
+
+	/// @brief Reads up to 32 bits. Bits at or past end read as zero.
+	unsigned read(unsigned offset, unsigned count, unsigned end = 128) const;
+
+	/// @brief Sets up to 32 bits, which must be zero before.
+	void write(unsigned offset, unsigned count, unsigned value);
+
+	/// @brief Gets the block with the order of its bits reversed.
+	ASTCBits128 reversed() const;
+};
+
+/// @brief Gets the number of bits count values take up in a range.
+unsigned getASTCISEBitCount(unsigned count, unsigned quant);
+
+/// @brief Decodes count values of an integer sequence. Each value is returned
+/// as its low bits and its trit or quint.
+void decodeASTCISE(const ASTCBits128 &block, unsigned offset, unsigned count, unsigned quant, uint8_t *pBits,
+                   uint8_t *pTritsQuints);
+
+/// @brief Encodes count values, given as their low bits and their trit or
+/// quint, as an integer sequence. The bits written to must be zero before.
+void encodeASTCISE(ASTCBits128 *pBlock, unsigned offset, unsigned count, unsigned quant, const uint8_t *pBits,
+                   const uint8_t *pTritsQuints);
+
+/// @brief Unquantizes a color endpoint value to [0, 255]. The range must be
+/// ASTC_QUANT_6 or larger.
+uint8_t unquantizeASTCColor(unsigned quant, unsigned bits, unsigned tritQuint);
+
+/// @brief Unquantizes a weight to [0, 64].
+uint8_t unquantizeASTCWeight(unsigned quant, unsigned bits, unsigned tritQuint);
+
+/// @brief The decoded block mode of a block.
+struct ASTCBlockMode
+{
+	unsigned xWeights;
+	unsigned yWeights;
+	bool dualPlane;
+	unsigned weightQuant;
+};
+
+/// @brief Decodes the 11 block mode bits of a 2D block.
+/// @returns false if the block mode is reserved or invalid.
+bool decodeASTCBlockMode(unsigned blockMode, ASTCBlockMode *pMode);
+
+/// @brief Gets the partition of a texel in a 2D block.
+unsigned selectASTCPartition(unsigned seed, unsigned x, unsigned y, unsigned partitionCount, bool smallBlock);
+
+/// @brief How a texel of a block gets its weight from the weight grid.
+struct ASTCTexelInfill
+{
+	/// The grid weight at the top left of the texel. The texel also uses the
+	/// weights to the right and below it.
+	uint8_t index;
+	/// The factors of the top left, top right, bottom left and bottom right
+	/// weights, which add up to 16.
+	uint8_t factors[4];
+};
+
+/// @brief Computes how the texels of a block are interpolated from the
+/// weight grid, as described in Weight Infill.
+/// @param blockWidth The width of the block.
+/// @param blockHeight The height of the block.
+/// @param xWeights The width of the weight grid.
+/// @param yWeights The height of the weight grid.
+/// @param[out] pInfill One entry for each texel.
+void computeASTCInfill(unsigned blockWidth, unsigned blockHeight, unsigned xWeights, unsigned yWeights,
+                       ASTCTexelInfill *pInfill);
+}
+
+#endif
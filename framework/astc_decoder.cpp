@@ -0,0 +1,551 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "astc_decoder.hpp"
+#include "astc_block.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define ASTC_DECODER_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ASTC_DECODER_SSE2 1
+#endif
+
+using namespace std;
+
+// The decoder follows the ASTC chapter of the Khronos Data Format
+// Specification. Section names in the comments below refer to it.
+namespace MaliSDK
+{
+namespace
+{
+void transferBitsSigned(int &a, int &b)
+{
+	b >>= 1;
+	b |= a & 0x80;
+	a >>= 1;
+	a &= 0x3f;
+	if (a & 0x20)
+		a -= 0x40;
+}
+
+uint8_t clampUnorm8(int value)
+{
+	return uint8_t(max(min(value, 255), 0));
+}
+
+void setEndpoint(uint8_t *pEndpoint, int r, int g, int b, int a)
+{
+	pEndpoint[0] = clampUnorm8(r);
+	pEndpoint[1] = clampUnorm8(g);
+	pEndpoint[2] = clampUnorm8(b);
+	pEndpoint[3] = clampUnorm8(a);
+}
+
+void setBlueContractedEndpoint(uint8_t *pEndpoint, int r, int g, int b, int a)
+{
+	setEndpoint(pEndpoint, (r + b) >> 1, (g + b) >> 1, b, a);
+}
+
+/// Decodes the endpoints of an LDR color endpoint mode. Returns false for HDR
+/// modes.
+bool decodeEndpoints(unsigned mode, const uint8_t *pValues, uint8_t *pEndpoint0, uint8_t *pEndpoint1)
+{
+	// LDR Endpoint Decoding.
+	int v[8];
+	for (unsigned i = 0; i < ((mode >> 2) + 1) * 2; i++)
+		v[i] = pValues[i];
+
+	switch (mode)
+	{
+	case 0: // Luminance, direct
+		setEndpoint(pEndpoint0, v[0], v[0], v[0], 0xff);
+		setEndpoint(pEndpoint1, v[1], v[1], v[1], 0xff);
+		return true;
+
+	case 1: // Luminance, base + offset
+	{
+		int l0 = (v[0] >> 2) | (v[1] & 0xc0);
+		int l1 = l0 + (v[1] & 0x3f);
+		setEndpoint(pEndpoint0, l0, l0, l0, 0xff);
+		setEndpoint(pEndpoint1, l1, l1, l1, 0xff);
+		return true;
+	}
+
+	case 4: // Luminance and alpha, direct
+		setEndpoint(pEndpoint0, v[0], v[0], v[0], v[2]);
+		setEndpoint(pEndpoint1, v[1], v[1], v[1], v[3]);
+		return true;
+
+	case 5: // Luminance and alpha, base + offset
+		transferBitsSigned(v[1], v[0]);
+		transferBitsSigned(v[3], v[2]);
+		setEndpoint(pEndpoint0, v[0], v[0], v[0], v[2]);
+		setEndpoint(pEndpoint1, v[0] + v[1], v[0] + v[1], v[0] + v[1], v[2] + v[3]);
+		return true;
+
+	case 6: // RGB, base + scale
+		setEndpoint(pEndpoint0, (v[0] * v[3]) >> 8, (v[1] * v[3]) >> 8, (v[2] * v[3]) >> 8, 0xff);
+		setEndpoint(pEndpoint1, v[0], v[1], v[2], 0xff);
+		return true;
+
+	case 8: // RGB, direct
+		if (v[1] + v[3] + v[5] >= v[0] + v[2] + v[4])
+		{
+			setEndpoint(pEndpoint0, v[0], v[2], v[4], 0xff);
+			setEndpoint(pEndpoint1, v[1], v[3], v[5], 0xff);
+		}
+		else
+		{
+			setBlueContractedEndpoint(pEndpoint0, v[1], v[3], v[5], 0xff);
+			setBlueContractedEndpoint(pEndpoint1, v[0], v[2], v[4], 0xff);
+		}
+		return true;
+
+	case 9: // RGB, base + offset
+		transferBitsSigned(v[1], v[0]);
+		transferBitsSigned(v[3], v[2]);
+		transferBitsSigned(v[5], v[4]);
+		if (v[1] + v[3] + v[5] >= 0)
+		{
+			setEndpoint(pEndpoint0, v[0], v[2], v[4], 0xff);
+			setEndpoint(pEndpoint1, v[0] + v[1], v[2] + v[3], v[4] + v[5], 0xff);
+		}
+		else
+		{
+			setBlueContractedEndpoint(pEndpoint0, v[0] + v[1], v[2] + v[3], v[4] + v[5], 0xff);
+			setBlueContractedEndpoint(pEndpoint1, v[0], v[2], v[4], 0xff);
+		}
+		return true;
+
+	case 10: // RGB, base + scale, plus two alpha
+		setEndpoint(pEndpoint0, (v[0] * v[3]) >> 8, (v[1] * v[3]) >> 8, (v[2] * v[3]) >> 8, v[4]);
+		setEndpoint(pEndpoint1, v[0], v[1], v[2], v[5]);
+		return true;
+
+	case 12: // RGBA, direct
+		if (v[1] + v[3] + v[5] >= v[0] + v[2] + v[4])
+		{
+			setEndpoint(pEndpoint0, v[0], v[2], v[4], v[6]);
+			setEndpoint(pEndpoint1, v[1], v[3], v[5], v[7]);
+		}
+		else
+		{
+			setBlueContractedEndpoint(pEndpoint0, v[1], v[3], v[5], v[7]);
+			setBlueContractedEndpoint(pEndpoint1, v[0], v[2], v[4], v[6]);
+		}
+		return true;
+
+	case 13: // RGBA, base + offset
+		transferBitsSigned(v[1], v[0]);
+		transferBitsSigned(v[3], v[2]);
+		transferBitsSigned(v[5], v[4]);
+		transferBitsSigned(v[7], v[6]);
+		if (v[1] + v[3] + v[5] >= 0)
+		{
+			setEndpoint(pEndpoint0, v[0], v[2], v[4], v[6]);
+			setEndpoint(pEndpoint1, v[0] + v[1], v[2] + v[3], v[4] + v[5], v[6] + v[7]);
+		}
+		else
+		{
+			setBlueContractedEndpoint(pEndpoint0, v[0] + v[1], v[2] + v[3], v[4] + v[5], v[6] + v[7]);
+			setBlueContractedEndpoint(pEndpoint1, v[0], v[2], v[4], v[6]);
+		}
+		return true;
+
+	default: // HDR modes
+		return false;
+	}
+}
+
+void interpolateTexels(uint8_t *pTexels, const uint8_t *pEndpoints0, const uint8_t *pEndpoints1,
+                       const uint8_t *pWeights, unsigned count, bool srgb)
+{
+	// LDR endpoints are expanded to 16 bits by replication, C = c * 257, and
+	// interpolated as (C0 * (64 - w) + C1 * w + 32) / 64. With decode_unorm8,
+	// the result is the top 8 bits, so the whole computation collapses to
+	// (257 * (c0 * (64 - w) + c1 * w) + 32) >> 14.
+	//
+	// With sRGB, the RGB endpoints are expanded as C = (c << 8) | 0x80
+	// instead, which gives (256 * (c0 * (64 - w) + c1 * w) + 0x80 * 64 + 32) >> 14.
+	// Alpha is always linear. The texels are RGBA, so every group of four
+	// components uses the same multipliers and biases.
+	const unsigned rgbMultiplier = srgb ? 256 : 257;
+	const unsigned rgbBias = srgb ? 0x80 * 64 + 32 : 32;
+	unsigned i = 0;
+#if defined(ASTC_DECODER_NEON)
+	const uint8x8_t sixtyFour = vdup_n_u8(64);
+	const uint16_t multiplierLanes[4] = { uint16_t(rgbMultiplier), uint16_t(rgbMultiplier), uint16_t(rgbMultiplier),
+	                                      257 };
+	const uint32_t biasLanes[4] = { rgbBias, rgbBias, rgbBias, 32 };
+	const uint16x4_t multiplier = vld1_u16(multiplierLanes);
+	const uint32x4_t bias = vld1q_u32(biasLanes);
+	for (; i + 8 <= count; i += 8)
+	{
+		uint8x8_t weights = vld1_u8(pWeights + i);
+		uint16x8_t x = vmull_u8(vld1_u8(pEndpoints0 + i), vsub_u8(sixtyFour, weights));
+		x = vmlal_u8(x, vld1_u8(pEndpoints1 + i), weights);
+		uint32x4_t lo = vmlal_u16(bias, vget_low_u16(x), multiplier);
+		uint32x4_t hi = vmlal_u16(bias, vget_high_u16(x), multiplier);
+		vst1_u8(pTexels + i, vmovn_u16(vcombine_u16(vshrn_n_u32(lo, 14), vshrn_n_u32(hi, 14))));
+	}
+#elif defined(ASTC_DECODER_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i sixtyFour = _mm_set1_epi16(64);
+	// Multiplying by 257 is x * 256 + x, and by 256 drops the second term.
+	const __m128i replicate = _mm_set_epi32(-1, srgb ? 0 : -1, srgb ? 0 : -1, srgb ? 0 : -1);
+	const __m128i bias = _mm_set_epi32(32, rgbBias, rgbBias, rgbBias);
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i weights = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(pWeights + i)), zero);
+		__m128i e0 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(pEndpoints0 + i)), zero);
+		__m128i e1 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(pEndpoints1 + i)), zero);
+		__m128i x = _mm_add_epi16(_mm_mullo_epi16(e0, _mm_sub_epi16(sixtyFour, weights)), _mm_mullo_epi16(e1, weights));
+
+		__m128i lo = _mm_unpacklo_epi16(x, zero);
+		__m128i hi = _mm_unpackhi_epi16(x, zero);
+		lo = _mm_add_epi32(_mm_slli_epi32(lo, 8), _mm_and_si128(lo, replicate));
+		hi = _mm_add_epi32(_mm_slli_epi32(hi, 8), _mm_and_si128(hi, replicate));
+		lo = _mm_srli_epi32(_mm_add_epi32(lo, bias), 14);
+		hi = _mm_srli_epi32(_mm_add_epi32(hi, bias), 14);
+		__m128i result = _mm_packs_epi32(lo, hi);
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(pTexels + i), _mm_packus_epi16(result, result));
+	}
+#endif
+	for (; i < count; i++)
+	{
+		unsigned x = pEndpoints0[i] * (64 - pWeights[i]) + pEndpoints1[i] * pWeights[i];
+		bool alpha = (i & 3) == 3;
+		pTexels[i] = uint8_t(((alpha ? 257 : rgbMultiplier) * x + (alpha ? 32 : rgbBias)) >> 14);
+	}
+}
+
+void decodeErrorBlock(uint8_t *pTexels, unsigned texelCount)
+{
+	for (unsigned i = 0; i < texelCount; i++)
+	{
+		pTexels[4 * i + 0] = 0xff;
+		pTexels[4 * i + 1] = 0;
+		pTexels[4 * i + 2] = 0xff;
+		pTexels[4 * i + 3] = 0xff;
+	}
+}
+
+void decodeVoidExtentBlock(const ASTCBits128 &block, uint8_t *pTexels, unsigned texelCount)
+{
+	// Void-Extent Blocks. The extents are only a hint to the encoder, but
+	// they still have to be valid. HDR colors are not valid in the LDR
+	// profile.
+	bool hdr = block.read(9, 1) != 0;
+	bool reserved = block.read(10, 2) != 3;
+	unsigned sLow = block.read(12, 13);
+	unsigned sHigh = block.read(25, 13);
+	unsigned tLow = block.read(38, 13);
+	unsigned tHigh = block.read(51, 13);
+	bool allOnes = sLow == 0x1fff && sHigh == 0x1fff && tLow == 0x1fff && tHigh == 0x1fff;
+
+	if (hdr || reserved || (!allOnes && (sLow >= sHigh || tLow >= tHigh)))
+	{
+		decodeErrorBlock(pTexels, texelCount);
+		return;
+	}
+
+	uint8_t color[4];
+	for (unsigned c = 0; c < 4; c++)
+		color[c] = uint8_t(block.read(64 + 16 * c, 16) >> 8);
+	for (unsigned i = 0; i < texelCount; i++)
+		memcpy(pTexels + 4 * i, color, sizeof(color));
+}
+
+/// Decodes a block into blockWidth * blockHeight RGBA8888 texels.
+void decodeBlock(const uint8_t *pBlock, unsigned blockWidth, unsigned blockHeight, bool srgb, uint8_t *pTexels)
+{
+	unsigned texelCount = blockWidth * blockHeight;
+
+	ASTCBits128 block = {};
+	for (unsigned i = 0; i < 8; i++)
+	{
+		block.lo |= uint64_t(pBlock[i]) << (8 * i);
+		block.hi |= uint64_t(pBlock[i + 8]) << (8 * i);
+	}
+
+	unsigned blockModeBits = block.read(0, 11);
+	if ((blockModeBits & 0x1ff) == 0x1fc)
+	{
+		decodeVoidExtentBlock(block, pTexels, texelCount);
+		return;
+	}
+
+	ASTCBlockMode mode;
+	if (!decodeASTCBlockMode(blockModeBits, &mode) || mode.xWeights > blockWidth || mode.yWeights > blockHeight)
+	{
+		decodeErrorBlock(pTexels, texelCount);
+		return;
+	}
+
+	unsigned partitionCount = block.read(11, 2) + 1;
+	if (partitionCount == 4 && mode.dualPlane)
+	{
+		decodeErrorBlock(pTexels, texelCount);
+		return;
+	}
+
+	unsigned planeWeightCount = mode.xWeights * mode.yWeights;
+	unsigned weightCount = planeWeightCount * (mode.dualPlane ? 2 : 1);
+	unsigned weightBits = getASTCISEBitCount(weightCount, mode.weightQuant);
+
+	// Color Endpoint Mode. With several partitions, the modes can differ, in
+	// which case the bits which do not fit next to the partition index are
+	// stored below the weights.
+	unsigned belowWeights = 128 - weightBits;
+	unsigned colorModes[ASTC_MAX_PARTITIONS];
+	unsigned colorStart;
+	unsigned partitionSeed = 0;
+
+	if (partitionCount == 1)
+	{
+		colorModes[0] = block.read(13, 4);
+		colorStart = 17;
+	}
+	else
+	{
+		partitionSeed = block.read(13, 10);
+		colorStart = 29;
+
+		unsigned encoded = block.read(23, 6);
+		if ((encoded & 3) == 0)
+		{
+			for (unsigned i = 0; i < partitionCount; i++)
+				colorModes[i] = encoded >> 2;
+		}
+		else
+		{
+			unsigned extraBits = 3 * partitionCount - 4;
+			belowWeights -= extraBits;
+			encoded |= block.read(belowWeights, extraBits) << 6;
+
+			unsigned baseClass = (encoded & 3) - 1;
+			for (unsigned i = 0; i < partitionCount; i++)
+			{
+				unsigned modeClass = baseClass + ((encoded >> (2 + i)) & 1);
+				colorModes[i] = (modeClass << 2) | ((encoded >> (2 + partitionCount + 2 * i)) & 3);
+			}
+		}
+	}
+
+	unsigned colorComponentSelector = 0;
+	if (mode.dualPlane)
+	{
+		belowWeights -= 2;
+		colorComponentSelector = block.read(belowWeights, 2);
+	}
+
+	unsigned colorValueCount = 0;
+	for (unsigned i = 0; i < partitionCount; i++)
+		colorValueCount += ((colorModes[i] >> 2) + 1) * 2;
+
+	if (colorValueCount > ASTC_MAX_COLOR_VALUES || belowWeights < colorStart)
+	{
+		decodeErrorBlock(pTexels, texelCount);
+		return;
+	}
+
+	// The color values use the largest range which fits in the remaining bits.
+	unsigned colorBits = belowWeights - colorStart;
+	unsigned colorQuant = ASTC_QUANT_COUNT;
+	while (colorQuant > 0 && getASTCISEBitCount(colorValueCount, colorQuant - 1) > colorBits)
+		colorQuant--;
+	if (colorQuant-- <= ASTC_QUANT_6)
+	{
+		decodeErrorBlock(pTexels, texelCount);
+		return;
+	}
+
+	uint8_t bits[ASTC_MAX_WEIGHTS];
+	uint8_t tritsQuints[ASTC_MAX_WEIGHTS];
+	uint8_t colorValues[ASTC_MAX_COLOR_VALUES];
+	decodeASTCISE(block, colorStart, colorValueCount, colorQuant, bits, tritsQuints);
+	for (unsigned i = 0; i < colorValueCount; i++)
+		colorValues[i] = unquantizeASTCColor(colorQuant, bits[i], tritsQuints[i]);
+
+	uint8_t endpoints[ASTC_MAX_PARTITIONS][2][4];
+	for (unsigned i = 0, value = 0; i < partitionCount; i++)
+	{
+		if (!decodeEndpoints(colorModes[i], colorValues + value, endpoints[i][0], endpoints[i][1]))
+		{
+			decodeErrorBlock(pTexels, texelCount);
+			return;
+		}
+		value += ((colorModes[i] >> 2) + 1) * 2;
+	}
+
+	// Weights are stored from the top of the block down, with their bits
+	// reversed.
+	decodeASTCISE(block.reversed(), 0, weightCount, mode.weightQuant, bits, tritsQuints);
+
+	// Pad with zero weights so the bilinear infill can read one past the grid.
+	uint8_t weights[2][ASTC_MAX_WEIGHTS + 16] = {};
+	for (unsigned i = 0; i < weightCount; i++)
+	{
+		unsigned plane = mode.dualPlane ? (i & 1) : 0;
+		unsigned index = mode.dualPlane ? (i >> 1) : i;
+		weights[plane][index] = unquantizeASTCWeight(mode.weightQuant, bits[i], tritsQuints[i]);
+	}
+
+	// Weight Infill, then gather the endpoints and weights of every texel
+	// component so they can be interpolated in one pass.
+	uint8_t texelEndpoints0[ASTC_MAX_TEXELS * 4];
+	uint8_t texelEndpoints1[ASTC_MAX_TEXELS * 4];
+	uint8_t texelWeights[ASTC_MAX_TEXELS * 4];
+
+	ASTCTexelInfill infill[ASTC_MAX_TEXELS];
+	computeASTCInfill(blockWidth, blockHeight, mode.xWeights, mode.yWeights, infill);
+	bool smallBlock = texelCount < 31;
+
+	for (unsigned t = 0; t < blockHeight; t++)
+	{
+		for (unsigned s = 0; s < blockWidth; s++)
+		{
+			unsigned texel = t * blockWidth + s;
+			const ASTCTexelInfill &texelInfill = infill[texel];
+			unsigned v0 = texelInfill.index;
+
+			uint8_t planeWeights[2];
+			for (unsigned plane = 0; plane < 2; plane++)
+			{
+				const uint8_t *pGrid = weights[plane];
+				planeWeights[plane] =
+				    uint8_t((pGrid[v0] * texelInfill.factors[0] + pGrid[v0 + 1] * texelInfill.factors[1] +
+				             pGrid[v0 + mode.xWeights] * texelInfill.factors[2] +
+				             pGrid[v0 + mode.xWeights + 1] * texelInfill.factors[3] + 8) >>
+				            4);
+			}
+
+			unsigned partition =
+			    partitionCount > 1 ? selectASTCPartition(partitionSeed, s, t, partitionCount, smallBlock) : 0;
+			memcpy(texelEndpoints0 + 4 * texel, endpoints[partition][0], 4);
+			memcpy(texelEndpoints1 + 4 * texel, endpoints[partition][1], 4);
+			for (unsigned c = 0; c < 4; c++)
+			{
+				bool secondPlane = mode.dualPlane && c == colorComponentSelector;
+				texelWeights[4 * texel + c] = planeWeights[secondPlane ? 1 : 0];
+			}
+		}
+	}
+
+	interpolateTexels(pTexels, texelEndpoints0, texelEndpoints1, texelWeights, texelCount * 4, srgb);
+}
+
+/// The 2D ASTC formats and their block footprints.
+const struct
+{
+	VkFormat unorm;
+	VkFormat srgb;
+	uint8_t width;
+	uint8_t height;
+} BlockSizes[] = {
+	{ VK_FORMAT_ASTC_4x4_UNORM_BLOCK, VK_FORMAT_ASTC_4x4_SRGB_BLOCK, 4, 4 },
+	{ VK_FORMAT_ASTC_5x4_UNORM_BLOCK, VK_FORMAT_ASTC_5x4_SRGB_BLOCK, 5, 4 },
+	{ VK_FORMAT_ASTC_5x5_UNORM_BLOCK, VK_FORMAT_ASTC_5x5_SRGB_BLOCK, 5, 5 },
+	{ VK_FORMAT_ASTC_6x5_UNORM_BLOCK, VK_FORMAT_ASTC_6x5_SRGB_BLOCK, 6, 5 },
+	{ VK_FORMAT_ASTC_6x6_UNORM_BLOCK, VK_FORMAT_ASTC_6x6_SRGB_BLOCK, 6, 6 },
+	{ VK_FORMAT_ASTC_8x5_UNORM_BLOCK, VK_FORMAT_ASTC_8x5_SRGB_BLOCK, 8, 5 },
+	{ VK_FORMAT_ASTC_8x6_UNORM_BLOCK, VK_FORMAT_ASTC_8x6_SRGB_BLOCK, 8, 6 },
+	{ VK_FORMAT_ASTC_8x8_UNORM_BLOCK, VK_FORMAT_ASTC_8x8_SRGB_BLOCK, 8, 8 },
+	{ VK_FORMAT_ASTC_10x5_UNORM_BLOCK, VK_FORMAT_ASTC_10x5_SRGB_BLOCK, 10, 5 },
+	{ VK_FORMAT_ASTC_10x6_UNORM_BLOCK, VK_FORMAT_ASTC_10x6_SRGB_BLOCK, 10, 6 },
+	{ VK_FORMAT_ASTC_10x8_UNORM_BLOCK, VK_FORMAT_ASTC_10x8_SRGB_BLOCK, 10, 8 },
+	{ VK_FORMAT_ASTC_10x10_UNORM_BLOCK, VK_FORMAT_ASTC_10x10_SRGB_BLOCK, 10, 10 },
+	{ VK_FORMAT_ASTC_12x10_UNORM_BLOCK, VK_FORMAT_ASTC_12x10_SRGB_BLOCK, 12, 10 },
+	{ VK_FORMAT_ASTC_12x12_UNORM_BLOCK, VK_FORMAT_ASTC_12x12_SRGB_BLOCK, 12, 12 },
+};
+}
+
+bool getASTCBlockSize(VkFormat format, unsigned *pBlockWidth, unsigned *pBlockHeight)
+{
+	for (auto &size : BlockSizes)
+	{
+		if (size.unorm == format || size.srgb == format)
+		{
+			*pBlockWidth = size.width;
+			*pBlockHeight = size.height;
+			return true;
+		}
+	}
+	return false;
+}
+
+Result decodeASTCToRgba8888(uint8_t *pDst, size_t rowPitch, const void *pPayload, size_t size, VkFormat format,
+                            unsigned width, unsigned height, ThreadPool *pPool)
+{
+	unsigned blockWidth, blockHeight;
+	if (!getASTCBlockSize(format, &blockWidth, &blockHeight))
+	{
+		LOGE("Format %d is not a 2D ASTC format.\n", int(format));
+		return RESULT_ERROR_GENERIC;
+	}
+
+	bool srgb = false;
+	for (auto &size : BlockSizes)
+		srgb |= size.srgb == format;
+
+	unsigned blocksX = (width + blockWidth - 1) / blockWidth;
+	unsigned blocksY = (height + blockHeight - 1) / blockHeight;
+	if (size < size_t(blocksX) * blocksY * 16)
+	{
+		LOGE("ASTC payload of %u x %u texels is truncated.\n", width, height);
+		return RESULT_ERROR_GENERIC;
+	}
+
+	const uint8_t *pBlocks = static_cast<const uint8_t *>(pPayload);
+	auto decodeRows = [=](unsigned, unsigned begin, unsigned end) {
+		uint8_t texels[ASTC_MAX_TEXELS * 4];
+		for (unsigned by = begin; by < end; by++)
+		{
+			for (unsigned bx = 0; bx < blocksX; bx++)
+			{
+				decodeBlock(pBlocks + 16 * (size_t(by) * blocksX + bx), blockWidth, blockHeight, srgb, texels);
+
+				// Blocks on the right and bottom edges can extend past the image.
+				unsigned x = bx * blockWidth;
+				unsigned y = by * blockHeight;
+				unsigned copyWidth = min(blockWidth, width - x);
+				unsigned copyHeight = min(blockHeight, height - y);
+				for (unsigned row = 0; row < copyHeight; row++)
+					memcpy(pDst + (y + row) * rowPitch + 4 * x, texels + 4 * row * blockWidth, 4 * copyWidth);
+			}
+		}
+	};
+
+	// Aim for a few thousand blocks per chunk so that the work stealing
+	// overhead stays small.
+	unsigned rowsPerChunk = max(4096 / blocksX, 1u);
+	if (pPool && blocksY > rowsPerChunk)
+		pPool->parallelFor(0, blocksY, rowsPerChunk, decodeRows);
+	else
+		decodeRows(0, 0, blocksY);
+
+	return RESULT_SUCCESS;
+}
+}
@@ -0,0 +1,67 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FRAMEWORK_ASTC_DECODER_HPP
+#define FRAMEWORK_ASTC_DECODER_HPP
+
+#include "common.hpp"
+#include "libvulkan-stub.h"
+#include <stddef.h>
+#include <stdint.h>
+
+namespace MaliSDK
+{
+class ThreadPool;
+
+/// @brief Gets the block footprint of a 2D ASTC format.
+/// @param format The ASTC format.
+/// @param[out] pBlockWidth The width of a block in texels.
+/// @param[out] pBlockHeight The height of a block in texels.
+/// @returns true if format is a 2D ASTC format.
+bool getASTCBlockSize(VkFormat format, unsigned *pBlockWidth, unsigned *pBlockHeight);
+
+/// @brief Decodes a 2D ASTC payload to VK_FORMAT_R8G8B8A8_UNORM on the CPU.
+///
+/// Implements the LDR profile with the decode_unorm8 decode mode of
+/// VK_EXT_astc_decode_mode, so the result matches what a GPU with ASTC
+/// support samples from a VK_FORMAT_ASTC_*_UNORM_BLOCK image with that
+/// decode mode. Blocks which are invalid in the LDR profile, including HDR
+/// blocks, decode to the error color, opaque magenta.
+///
+/// VK_FORMAT_ASTC_*_SRGB_BLOCK payloads use the sRGB endpoint expansion of
+/// the specification and decode to the sRGB encoded texels, which should be
+/// uploaded as VK_FORMAT_R8G8B8A8_SRGB.
+///
+/// If a thread pool is given, rows of blocks are decoded in parallel.
+///
+/// @param[out] pDst The decoded image.
+/// @param rowPitch The number of bytes between rows of pDst.
+/// @param pPayload The ASTC blocks, as returned by `loadASTCTextureFromAsset`.
+/// @param size The size of the payload in bytes.
+/// @param format The ASTC format of the payload.
+/// @param width The width of the image.
+/// @param height The height of the image.
+/// @param pPool The thread pool to decode on, or nullptr.
+/// @returns Error code
+Result decodeASTCToRgba8888(uint8_t *pDst, size_t rowPitch, const void *pPayload, size_t size, VkFormat format,
+                            unsigned width, unsigned height, ThreadPool *pPool = nullptr);
+}
+
+#endif
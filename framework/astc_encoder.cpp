@@ -0,0 +1,848 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "astc_encoder.hpp"
+#include "astc_block.hpp"
+#include "astc_decoder.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define ASTC_ENCODER_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ASTC_ENCODER_SSE2 1
+#endif
+
+using namespace std;
+
+namespace MaliSDK
+{
+namespace
+{
+/// An RGBA color in floating point. The encoder does most of its math on
+/// whole colors, which map onto a single SIMD register.
+struct Float4
+{
+#if defined(ASTC_ENCODER_NEON)
+	float32x4_t v;
+
+	Float4() = default;
+	explicit Float4(float32x4_t v)
+	    : v(v)
+	{
+	}
+	Float4(float r, float g, float b, float a)
+	{
+		const float values[4] = { r, g, b, a };
+		v = vld1q_f32(values);
+	}
+	static Float4 splat(float value)
+	{
+		return Float4(vdupq_n_f32(value));
+	}
+	void store(float *pValues) const
+	{
+		vst1q_f32(pValues, v);
+	}
+#elif defined(ASTC_ENCODER_SSE2)
+	__m128 v;
+
+	Float4() = default;
+	explicit Float4(__m128 v)
+	    : v(v)
+	{
+	}
+	Float4(float r, float g, float b, float a)
+	    : v(_mm_setr_ps(r, g, b, a))
+	{
+	}
+	static Float4 splat(float value)
+	{
+		return Float4(_mm_set1_ps(value));
+	}
+	void store(float *pValues) const
+	{
+		_mm_storeu_ps(pValues, v);
+	}
+#else
+	float v[4];
+
+	Float4() = default;
+	Float4(float r, float g, float b, float a)
+	    : v{ r, g, b, a }
+	{
+	}
+	static Float4 splat(float value)
+	{
+		return Float4(value, value, value, value);
+	}
+	void store(float *pValues) const
+	{
+		memcpy(pValues, v, sizeof(v));
+	}
+#endif
+};
+
+#if defined(ASTC_ENCODER_NEON)
+inline Float4 operator+(Float4 a, Float4 b)
+{
+	return Float4(vaddq_f32(a.v, b.v));
+}
+inline Float4 operator-(Float4 a, Float4 b)
+{
+	return Float4(vsubq_f32(a.v, b.v));
+}
+inline Float4 operator*(Float4 a, Float4 b)
+{
+	return Float4(vmulq_f32(a.v, b.v));
+}
+inline Float4 componentMin(Float4 a, Float4 b)
+{
+	return Float4(vminq_f32(a.v, b.v));
+}
+inline Float4 componentMax(Float4 a, Float4 b)
+{
+	return Float4(vmaxq_f32(a.v, b.v));
+}
+inline float dot(Float4 a, Float4 b)
+{
+	float32x4_t product = vmulq_f32(a.v, b.v);
+	float32x2_t sum = vadd_f32(vget_low_f32(product), vget_high_f32(product));
+	return vget_lane_f32(vpadd_f32(sum, sum), 0);
+}
+#elif defined(ASTC_ENCODER_SSE2)
+inline Float4 operator+(Float4 a, Float4 b)
+{
+	return Float4(_mm_add_ps(a.v, b.v));
+}
+inline Float4 operator-(Float4 a, Float4 b)
+{
+	return Float4(_mm_sub_ps(a.v, b.v));
+}
+inline Float4 operator*(Float4 a, Float4 b)
+{
+	return Float4(_mm_mul_ps(a.v, b.v));
+}
+inline Float4 componentMin(Float4 a, Float4 b)
+{
+	return Float4(_mm_min_ps(a.v, b.v));
+}
+inline Float4 componentMax(Float4 a, Float4 b)
+{
+	return Float4(_mm_max_ps(a.v, b.v));
+}
+inline float dot(Float4 a, Float4 b)
+{
+	__m128 product = _mm_mul_ps(a.v, b.v);
+	__m128 sum = _mm_add_ps(product, _mm_shuffle_ps(product, product, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtss_f32(sum);
+}
+#else
+inline Float4 operator+(Float4 a, Float4 b)
+{
+	return Float4(a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]);
+}
+inline Float4 operator-(Float4 a, Float4 b)
+{
+	return Float4(a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]);
+}
+inline Float4 operator*(Float4 a, Float4 b)
+{
+	return Float4(a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]);
+}
+inline Float4 componentMin(Float4 a, Float4 b)
+{
+	return Float4(std::min(a.v[0], b.v[0]), std::min(a.v[1], b.v[1]), std::min(a.v[2], b.v[2]),
+	              std::min(a.v[3], b.v[3]));
+}
+inline Float4 componentMax(Float4 a, Float4 b)
+{
+	return Float4(std::max(a.v[0], b.v[0]), std::max(a.v[1], b.v[1]), std::max(a.v[2], b.v[2]),
+	              std::max(a.v[3], b.v[3]));
+}
+inline float dot(Float4 a, Float4 b)
+{
+	return a.v[0] * b.v[0] + a.v[1] * b.v[1] + a.v[2] * b.v[2] + a.v[3] * b.v[3];
+}
+#endif
+
+inline Float4 operator*(Float4 a, float b)
+{
+	return a * Float4::splat(b);
+}
+
+inline Float4 clampUnorm8(Float4 value)
+{
+	return componentMin(componentMax(value, Float4::splat(0.0f)), Float4::splat(255.0f));
+}
+
+/// A value of a range, and what it unquantizes to.
+struct QuantizedValue
+{
+	uint8_t bits;
+	uint8_t tritQuint;
+	uint8_t value;
+};
+
+/// The nearest value of every range to every color value and weight.
+struct QuantizationTables
+{
+	QuantizedValue colors[ASTC_QUANT_COUNT][256];
+	QuantizedValue weights[ASTC_QUANT_32 + 1][65];
+
+	QuantizationTables()
+	{
+		for (unsigned quant = ASTC_QUANT_6; quant < ASTC_QUANT_COUNT; quant++)
+			build(quant, 256, colors[quant], unquantizeASTCColor);
+		for (unsigned quant = 0; quant <= ASTC_QUANT_32; quant++)
+			build(quant, 65, weights[quant], unquantizeASTCWeight);
+	}
+
+	static void build(unsigned quant, unsigned count, QuantizedValue *pTable,
+	                  uint8_t (*unquantize)(unsigned, unsigned, unsigned))
+	{
+		const ASTCQuantMode &mode = ASTCQuantModes[quant];
+		unsigned tritsQuints = mode.trits ? 3 : mode.quints ? 5 : 1;
+
+		for (unsigned target = 0; target < count; target++)
+		{
+			unsigned bestDistance = ~0u;
+			for (unsigned tritQuint = 0; tritQuint < tritsQuints; tritQuint++)
+			{
+				for (unsigned bits = 0; bits < (1u << mode.bits); bits++)
+				{
+					uint8_t value = unquantize(quant, bits, tritQuint);
+					unsigned distance = value > target ? value - target : target - value;
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						pTable[target].bits = uint8_t(bits);
+						pTable[target].tritQuint = uint8_t(tritQuint);
+						pTable[target].value = value;
+					}
+				}
+			}
+		}
+	}
+};
+
+const QuantizationTables &getQuantizationTables()
+{
+	static const QuantizationTables tables;
+	return tables;
+}
+
+unsigned getLevelCount(unsigned quant)
+{
+	const ASTCQuantMode &mode = ASTCQuantModes[quant];
+	return (mode.trits ? 3 : mode.quints ? 5 : 1) << mode.bits;
+}
+
+/// The color endpoint modes the encoder uses, from fewest to most color
+/// values.
+enum ColorClass
+{
+	COLOR_CLASS_LUMINANCE,
+	COLOR_CLASS_LUMINANCE_ALPHA,
+	COLOR_CLASS_RGB,
+	COLOR_CLASS_RGBA,
+	COLOR_CLASS_COUNT
+};
+
+const unsigned ColorEndpointModes[COLOR_CLASS_COUNT] = { 0, 4, 8, 12 };
+const unsigned ColorComponentCounts[COLOR_CLASS_COUNT] = { 3, 4, 3, 4 };
+
+/// Pads weight grids so the bilinear infill can read one past the grid.
+const unsigned PaddedWeights = ASTC_MAX_WEIGHTS + 16;
+
+/// A weight grid the blocks of a footprint can use.
+struct WeightGrid
+{
+	unsigned xWeights;
+	unsigned yWeights;
+	ASTCTexelInfill infill[ASTC_MAX_TEXELS];
+	/// For every grid weight, the reciprocal of the sum of the infill factors
+	/// which refer to it.
+	float reciprocalFactorSums[PaddedWeights];
+};
+
+/// A way to encode a block: a weight grid with a weight range, and the color
+/// range left over for the endpoints.
+struct Candidate
+{
+	unsigned blockMode;
+	unsigned grid;
+	unsigned weightQuant;
+	unsigned colorQuant;
+	/// The error quantizing the endpoints is expected to add, summed over the
+	/// texels of a block.
+	float colorError;
+};
+
+/// Everything the encoder needs to know about a block footprint.
+struct Footprint
+{
+	unsigned blockWidth;
+	unsigned blockHeight;
+	vector<WeightGrid> grids;
+	/// The candidates for every color class, ordered by grid.
+	vector<Candidate> candidates[COLOR_CLASS_COUNT];
+
+	Footprint(unsigned blockWidth, unsigned blockHeight)
+	    : blockWidth(blockWidth)
+	    , blockHeight(blockHeight)
+	{
+		unsigned texelCount = blockWidth * blockHeight;
+
+		for (unsigned blockMode = 0; blockMode < 2048; blockMode++)
+		{
+			ASTCBlockMode mode;
+			if ((blockMode & 0x1ff) == 0x1fc || !decodeASTCBlockMode(blockMode, &mode) || mode.dualPlane ||
+			    mode.xWeights > blockWidth || mode.yWeights > blockHeight)
+				continue;
+
+			unsigned grid = findGrid(mode.xWeights, mode.yWeights);
+			unsigned weightBits = getASTCISEBitCount(mode.xWeights * mode.yWeights, mode.weightQuant);
+			unsigned colorBits = 128 - 17 - weightBits;
+
+			for (unsigned colorClass = 0; colorClass < COLOR_CLASS_COUNT; colorClass++)
+			{
+				// The decoder picks the largest color range which fits.
+				unsigned colorValueCount = 2 * (colorClass + 1);
+				unsigned colorQuant = ASTC_QUANT_COUNT;
+				while (colorQuant > 0 && getASTCISEBitCount(colorValueCount, colorQuant - 1) > colorBits)
+					colorQuant--;
+				if (colorQuant-- <= ASTC_QUANT_6)
+					continue;
+
+				// A uniformly distributed rounding error has a variance of a
+				// twelfth of the step squared.
+				float step = 255.0f / (getLevelCount(colorQuant) - 1);
+				Candidate candidate = { blockMode, grid, mode.weightQuant, colorQuant,
+					                    texelCount * ColorComponentCounts[colorClass] * step * step / 12.0f };
+				addCandidate(candidates[colorClass], candidate);
+			}
+		}
+
+		for (auto &classCandidates : candidates)
+		{
+			sort(begin(classCandidates), end(classCandidates),
+			     [](const Candidate &a, const Candidate &b) { return a.grid < b.grid; });
+		}
+	}
+
+	unsigned findGrid(unsigned xWeights, unsigned yWeights)
+	{
+		for (unsigned i = 0; i < grids.size(); i++)
+			if (grids[i].xWeights == xWeights && grids[i].yWeights == yWeights)
+				return i;
+
+		WeightGrid grid = {};
+		grid.xWeights = xWeights;
+		grid.yWeights = yWeights;
+		computeASTCInfill(blockWidth, blockHeight, xWeights, yWeights, grid.infill);
+
+		float factorSums[PaddedWeights] = {};
+		for (unsigned i = 0; i < blockWidth * blockHeight; i++)
+		{
+			const ASTCTexelInfill &infill = grid.infill[i];
+			factorSums[infill.index] += infill.factors[0];
+			factorSums[infill.index + 1] += infill.factors[1];
+			factorSums[infill.index + xWeights] += infill.factors[2];
+			factorSums[infill.index + xWeights + 1] += infill.factors[3];
+		}
+		for (unsigned i = 0; i < PaddedWeights; i++)
+			grid.reciprocalFactorSums[i] = factorSums[i] > 0.0f ? 1.0f / factorSums[i] : 0.0f;
+
+		grids.push_back(grid);
+		return unsigned(grids.size() - 1);
+	}
+
+	static void addCandidate(vector<Candidate> &classCandidates, const Candidate &candidate)
+	{
+		// Several block modes describe the same grid and ranges. A candidate
+		// is also not worth trying if another one with the same grid has at
+		// least as many weight levels and color levels.
+		for (auto &other : classCandidates)
+		{
+			if (other.grid != candidate.grid)
+				continue;
+			if (other.weightQuant >= candidate.weightQuant && other.colorQuant >= candidate.colorQuant)
+				return;
+			if (candidate.weightQuant >= other.weightQuant && candidate.colorQuant >= other.colorQuant)
+			{
+				other = candidate;
+				// The replaced candidate may have dominated others too.
+				classCandidates.erase(remove_if(begin(classCandidates), end(classCandidates),
+				                                [&](const Candidate &c) {
+					                                return &c != &other && c.grid == candidate.grid &&
+					                                       candidate.weightQuant >= c.weightQuant &&
+					                                       candidate.colorQuant >= c.colorQuant;
+				                                }),
+				                      end(classCandidates));
+				return;
+			}
+		}
+		classCandidates.push_back(candidate);
+	}
+};
+
+/// Computes the weights of a grid which best reproduce the given texel
+/// weights, by averaging the texel weights each grid weight contributes to.
+void downsampleWeights(const WeightGrid &grid, const float *pTexelWeights, unsigned texelCount, float *pGridWeights)
+{
+	float sums[PaddedWeights] = {};
+	for (unsigned i = 0; i < texelCount; i++)
+	{
+		const ASTCTexelInfill &infill = grid.infill[i];
+		float weight = pTexelWeights[i];
+		sums[infill.index] += infill.factors[0] * weight;
+		sums[infill.index + 1] += infill.factors[1] * weight;
+		sums[infill.index + grid.xWeights] += infill.factors[2] * weight;
+		sums[infill.index + grid.xWeights + 1] += infill.factors[3] * weight;
+	}
+
+	for (unsigned i = 0; i < grid.xWeights * grid.yWeights; i++)
+		pGridWeights[i] = sums[i] * grid.reciprocalFactorSums[i];
+}
+
+/// Quantizes grid weights in [0, 1] to a weight range.
+void quantizeWeights(const float *pGridWeights, unsigned count, unsigned quant, const QuantizedValue **ppWeights)
+{
+	const QuantizedValue *pTable = getQuantizationTables().weights[quant];
+	for (unsigned i = 0; i < count; i++)
+		ppWeights[i] = &pTable[unsigned(max(min(pGridWeights[i], 1.0f), 0.0f) * 64.0f + 0.5f)];
+}
+
+/// Computes the texel weights the decoder infills from quantized grid
+/// weights, in [0, 64].
+void infillWeights(const WeightGrid &grid, const QuantizedValue *const *ppGridWeights, unsigned texelCount,
+                   unsigned *pTexelWeights)
+{
+	uint8_t weights[PaddedWeights] = {};
+	for (unsigned i = 0; i < grid.xWeights * grid.yWeights; i++)
+		weights[i] = ppGridWeights[i]->value;
+
+	for (unsigned i = 0; i < texelCount; i++)
+	{
+		const ASTCTexelInfill &infill = grid.infill[i];
+		unsigned v0 = infill.index;
+		pTexelWeights[i] = (weights[v0] * infill.factors[0] + weights[v0 + 1] * infill.factors[1] +
+		                    weights[v0 + grid.xWeights] * infill.factors[2] +
+		                    weights[v0 + grid.xWeights + 1] * infill.factors[3] + 8) >>
+		                   4;
+	}
+}
+
+/// Finds the direction in which the texels vary the most, with power
+/// iteration on their covariance matrix.
+Float4 computePrincipalAxis(const Float4 *pTexels, unsigned texelCount, Float4 mean)
+{
+	Float4 rows[4] = { Float4::splat(0.0f), Float4::splat(0.0f), Float4::splat(0.0f), Float4::splat(0.0f) };
+	for (unsigned i = 0; i < texelCount; i++)
+	{
+		Float4 offset = pTexels[i] - mean;
+		float components[4];
+		offset.store(components);
+		for (unsigned c = 0; c < 4; c++)
+			rows[c] = rows[c] + offset * components[c];
+	}
+
+	// Start from the row of the component with the largest variance, which
+	// cannot be orthogonal to the principal axis.
+	float variances[4];
+	for (unsigned c = 0; c < 4; c++)
+	{
+		float row[4];
+		rows[c].store(row);
+		variances[c] = row[c];
+	}
+	Float4 axis = rows[max_element(variances, variances + 4) - variances];
+
+	for (unsigned iteration = 0; iteration < 8; iteration++)
+	{
+		float length = dot(axis, axis);
+		if (length < 1e-12f)
+			return Float4::splat(0.5f);
+		axis = axis * (1.0f / sqrtf(length));
+
+		float components[4];
+		axis.store(components);
+		axis = rows[0] * components[0] + rows[1] * components[1] + rows[2] * components[2] + rows[3] * components[3];
+	}
+
+	float length = dot(axis, axis);
+	return length < 1e-12f ? Float4::splat(0.5f) : axis * (1.0f / sqrtf(length));
+}
+
+/// Computes where the texels lie on the segment between two endpoints, in
+/// [0, 1].
+void projectTexels(const Float4 *pTexels, unsigned texelCount, Float4 endpoint0, Float4 endpoint1, float *pWeights)
+{
+	Float4 direction = endpoint1 - endpoint0;
+	float length = dot(direction, direction);
+	float scale = length > 1e-6f ? 1.0f / length : 0.0f;
+	for (unsigned i = 0; i < texelCount; i++)
+		pWeights[i] = max(min(dot(pTexels[i] - endpoint0, direction) * scale, 1.0f), 0.0f);
+}
+
+/// Fits the endpoints which minimize the squared error for the given texel
+/// weights with least squares.
+void refineEndpoints(const Float4 *pTexels, const unsigned *pTexelWeights, unsigned texelCount, Float4 *pEndpoint0,
+                     Float4 *pEndpoint1)
+{
+	float a = 0.0f;
+	float b = 0.0f;
+	float c = 0.0f;
+	Float4 p = Float4::splat(0.0f);
+	Float4 q = Float4::splat(0.0f);
+	for (unsigned i = 0; i < texelCount; i++)
+	{
+		float w = pTexelWeights[i] * (1.0f / 64.0f);
+		a += (1.0f - w) * (1.0f - w);
+		b += (1.0f - w) * w;
+		c += w * w;
+		p = p + pTexels[i] * (1.0f - w);
+		q = q + pTexels[i] * w;
+	}
+
+	float determinant = a * c - b * b;
+	if (fabsf(determinant) < 1e-3f)
+		return;
+
+	float reciprocal = 1.0f / determinant;
+	*pEndpoint0 = clampUnorm8((p * c - q * b) * reciprocal);
+	*pEndpoint1 = clampUnorm8((q * a - p * b) * reciprocal);
+}
+
+/// Picks the candidate which is expected to encode the block with the least
+/// error, given the ideal weights of the texels.
+const Candidate *selectCandidate(const Footprint &footprint, unsigned colorClass, const float *pTexelWeights,
+                                 float segmentLength)
+{
+	unsigned texelCount = footprint.blockWidth * footprint.blockHeight;
+	float targets[ASTC_MAX_TEXELS];
+	for (unsigned i = 0; i < texelCount; i++)
+		targets[i] = pTexelWeights[i] * 64.0f;
+
+	// Weights are in [0, 64], so weight errors are scaled to color errors by
+	// the squared length of the segment divided by 64 squared.
+	float weightScale = segmentLength * (1.0f / 4096.0f);
+
+	const Candidate *pBest = nullptr;
+	float bestError = FLT_MAX;
+	unsigned currentGrid = ~0u;
+	float gridWeights[ASTC_MAX_WEIGHTS];
+
+	for (auto &candidate : footprint.candidates[colorClass])
+	{
+		const WeightGrid &grid = footprint.grids[candidate.grid];
+		unsigned weightCount = grid.xWeights * grid.yWeights;
+		if (candidate.grid != currentGrid)
+		{
+			downsampleWeights(grid, pTexelWeights, texelCount, gridWeights);
+			currentGrid = candidate.grid;
+		}
+
+		float error = candidate.colorError;
+		if (error >= bestError)
+			continue;
+
+		const QuantizedValue *quantized[ASTC_MAX_WEIGHTS];
+		unsigned weights[ASTC_MAX_TEXELS];
+		quantizeWeights(gridWeights, weightCount, candidate.weightQuant, quantized);
+		infillWeights(grid, quantized, texelCount, weights);
+
+		for (unsigned i = 0; i < texelCount && error < bestError; i++)
+		{
+			float difference = weights[i] - targets[i];
+			error += difference * difference * weightScale;
+		}
+
+		if (error < bestError)
+		{
+			bestError = error;
+			pBest = &candidate;
+		}
+	}
+
+	return pBest;
+}
+
+void storeBlock(const ASTCBits128 &block, uint8_t *pBlock)
+{
+	for (unsigned i = 0; i < 8; i++)
+	{
+		pBlock[i] = uint8_t(block.lo >> (8 * i));
+		pBlock[i + 8] = uint8_t(block.hi >> (8 * i));
+	}
+}
+
+void encodeVoidExtentBlock(const uint8_t *pColor, uint8_t *pBlock)
+{
+	// An LDR void extent block without extents, followed by the color as
+	// UNORM16.
+	ASTCBits128 block = { 0xfffffffffffffdfcull, 0 };
+	for (unsigned c = 0; c < 4; c++)
+		block.write(64 + 16 * c, 16, pColor[c] * 257u);
+	storeBlock(block, pBlock);
+}
+
+/// Encodes blockWidth * blockHeight RGBA8888 texels into a block.
+void encodeBlock(const Footprint &footprint, const uint8_t *pTexels, uint8_t *pBlock)
+{
+	unsigned texelCount = footprint.blockWidth * footprint.blockHeight;
+
+	bool uniform = true;
+	bool opaque = true;
+	bool luminance = true;
+	for (unsigned i = 0; i < texelCount; i++)
+	{
+		const uint8_t *pTexel = pTexels + 4 * i;
+		uniform = uniform && memcmp(pTexel, pTexels, 4) == 0;
+		opaque = opaque && pTexel[3] == 0xff;
+		luminance = luminance && pTexel[0] == pTexel[1] && pTexel[1] == pTexel[2];
+	}
+
+	if (uniform)
+	{
+		encodeVoidExtentBlock(pTexels, pBlock);
+		return;
+	}
+
+	unsigned colorClass = luminance ? (opaque ? COLOR_CLASS_LUMINANCE : COLOR_CLASS_LUMINANCE_ALPHA) :
+	                                  (opaque ? COLOR_CLASS_RGB : COLOR_CLASS_RGBA);
+
+	Float4 texels[ASTC_MAX_TEXELS];
+	Float4 mean = Float4::splat(0.0f);
+	for (unsigned i = 0; i < texelCount; i++)
+	{
+		const uint8_t *pTexel = pTexels + 4 * i;
+		texels[i] = Float4(pTexel[0], pTexel[1], pTexel[2], pTexel[3]);
+		mean = mean + texels[i];
+	}
+	mean = mean * (1.0f / texelCount);
+
+	// Start with the segment which spans the texels along the principal axis.
+	Float4 axis = computePrincipalAxis(texels, texelCount, mean);
+	float lowest = FLT_MAX;
+	float highest = -FLT_MAX;
+	for (unsigned i = 0; i < texelCount; i++)
+	{
+		float position = dot(texels[i] - mean, axis);
+		lowest = min(lowest, position);
+		highest = max(highest, position);
+	}
+
+	Float4 endpoint0 = clampUnorm8(mean + axis * lowest);
+	Float4 endpoint1 = clampUnorm8(mean + axis * highest);
+	float idealWeights[ASTC_MAX_TEXELS];
+	projectTexels(texels, texelCount, endpoint0, endpoint1, idealWeights);
+
+	Float4 direction = endpoint1 - endpoint0;
+	const Candidate *pCandidate = selectCandidate(footprint, colorClass, idealWeights, dot(direction, direction));
+	const WeightGrid &grid = footprint.grids[pCandidate->grid];
+	unsigned weightCount = grid.xWeights * grid.yWeights;
+
+	// Alternate between fitting endpoints to the weights the decoder will
+	// infill and fitting weights to the endpoints.
+	float gridWeights[ASTC_MAX_WEIGHTS];
+	const QuantizedValue *quantizedWeights[ASTC_MAX_WEIGHTS];
+	unsigned texelWeights[ASTC_MAX_TEXELS];
+	for (unsigned iteration = 0; iteration < 2; iteration++)
+	{
+		downsampleWeights(grid, idealWeights, texelCount, gridWeights);
+		quantizeWeights(gridWeights, weightCount, pCandidate->weightQuant, quantizedWeights);
+		infillWeights(grid, quantizedWeights, texelCount, texelWeights);
+		refineEndpoints(texels, texelWeights, texelCount, &endpoint0, &endpoint1);
+		projectTexels(texels, texelCount, endpoint0, endpoint1, idealWeights);
+	}
+
+	// Quantize the endpoints. The color values of each component are stored
+	// as pairs of the first and second endpoint.
+	float components[2][4];
+	endpoint0.store(components[0]);
+	endpoint1.store(components[1]);
+	if (colorClass == COLOR_CLASS_LUMINANCE || colorClass == COLOR_CLASS_LUMINANCE_ALPHA)
+	{
+		for (unsigned e = 0; e < 2; e++)
+		{
+			components[e][0] = (components[e][0] + components[e][1] + components[e][2]) * (1.0f / 3.0f);
+			components[e][1] = components[e][3];
+		}
+	}
+
+	const QuantizedValue *pColorTable = getQuantizationTables().colors[pCandidate->colorQuant];
+	unsigned colorValueCount = 2 * (colorClass + 1);
+	const QuantizedValue *colorValues[8];
+	for (unsigned i = 0; i < colorValueCount; i++)
+		colorValues[i] = &pColorTable[unsigned(components[i & 1][i >> 1] + 0.5f)];
+
+	// The RGB modes swap the endpoints and apply blue contraction if the
+	// second endpoint is darker than the first, so make sure it is not.
+	if (colorClass == COLOR_CLASS_RGB || colorClass == COLOR_CLASS_RGBA)
+	{
+		unsigned sum0 = colorValues[0]->value + colorValues[2]->value + colorValues[4]->value;
+		unsigned sum1 = colorValues[1]->value + colorValues[3]->value + colorValues[5]->value;
+		if (sum1 < sum0)
+			for (unsigned i = 0; i < colorValueCount; i += 2)
+				swap(colorValues[i], colorValues[i + 1]);
+	}
+
+	// Fit the final weights to the endpoints as they will be decoded.
+	Float4 decoded[2];
+	for (unsigned e = 0; e < 2; e++)
+	{
+		switch (colorClass)
+		{
+		case COLOR_CLASS_LUMINANCE:
+			decoded[e] = Float4(colorValues[e]->value, colorValues[e]->value, colorValues[e]->value, 255.0f);
+			break;
+		case COLOR_CLASS_LUMINANCE_ALPHA:
+			decoded[e] =
+			    Float4(colorValues[e]->value, colorValues[e]->value, colorValues[e]->value, colorValues[e + 2]->value);
+			break;
+		case COLOR_CLASS_RGB:
+			decoded[e] = Float4(colorValues[e]->value, colorValues[e + 2]->value, colorValues[e + 4]->value, 255.0f);
+			break;
+		default:
+			decoded[e] = Float4(colorValues[e]->value, colorValues[e + 2]->value, colorValues[e + 4]->value,
+			                    colorValues[e + 6]->value);
+			break;
+		}
+	}
+	projectTexels(texels, texelCount, decoded[0], decoded[1], idealWeights);
+	downsampleWeights(grid, idealWeights, texelCount, gridWeights);
+	quantizeWeights(gridWeights, weightCount, pCandidate->weightQuant, quantizedWeights);
+
+	// Single partition layout: block mode, partition count, color endpoint
+	// mode and the color values, with the weights at the top of the block.
+	uint8_t bits[ASTC_MAX_WEIGHTS];
+	uint8_t tritsQuints[ASTC_MAX_WEIGHTS];
+	ASTCBits128 block = {};
+	block.write(0, 11, pCandidate->blockMode);
+	block.write(13, 4, ColorEndpointModes[colorClass]);
+
+	for (unsigned i = 0; i < colorValueCount; i++)
+	{
+		bits[i] = colorValues[i]->bits;
+		tritsQuints[i] = colorValues[i]->tritQuint;
+	}
+	encodeASTCISE(&block, 17, colorValueCount, pCandidate->colorQuant, bits, tritsQuints);
+
+	for (unsigned i = 0; i < weightCount; i++)
+	{
+		bits[i] = quantizedWeights[i]->bits;
+		tritsQuints[i] = quantizedWeights[i]->tritQuint;
+	}
+	ASTCBits128 weights = {};
+	encodeASTCISE(&weights, 0, weightCount, pCandidate->weightQuant, bits, tritsQuints);
+	weights = weights.reversed();
+	block.lo |= weights.lo;
+	block.hi |= weights.hi;
+
+	storeBlock(block, pBlock);
+}
+}
+
+Result encodeASTCFromRgba8888(vector<uint8_t> *pBlocks, const uint8_t *pSrc, size_t rowPitch, unsigned width,
+                              unsigned height, VkFormat format, ThreadPool *pPool)
+{
+	unsigned blockWidth, blockHeight;
+	if (!getASTCBlockSize(format, &blockWidth, &blockHeight))
+	{
+		LOGE("Format %d is not a 2D ASTC format.\n", int(format));
+		return RESULT_ERROR_GENERIC;
+	}
+
+	unsigned blocksX = (width + blockWidth - 1) / blockWidth;
+	unsigned blocksY = (height + blockHeight - 1) / blockHeight;
+	pBlocks->resize(size_t(blocksX) * blocksY * 16);
+
+	// The tables are shared by all threads, so build them up front.
+	const Footprint footprint(blockWidth, blockHeight);
+	getQuantizationTables();
+
+	uint8_t *pOut = pBlocks->data();
+	auto encodeRows = [=, &footprint](unsigned, unsigned begin, unsigned end) {
+		uint8_t texels[ASTC_MAX_TEXELS * 4];
+		for (unsigned by = begin; by < end; by++)
+		{
+			for (unsigned bx = 0; bx < blocksX; bx++)
+			{
+				// Blocks on the right and bottom edges which extend past the
+				// image repeat the last row and column.
+				for (unsigned row = 0; row < blockHeight; row++)
+				{
+					unsigned y = min(by * blockHeight + row, height - 1);
+					for (unsigned column = 0; column < blockWidth; column++)
+					{
+						unsigned x = min(bx * blockWidth + column, width - 1);
+						memcpy(texels + 4 * (row * blockWidth + column), pSrc + y * rowPitch + 4 * x, 4);
+					}
+				}
+
+				encodeBlock(footprint, texels, pOut + 16 * (size_t(by) * blocksX + bx));
+			}
+		}
+	};
+
+	// Blocks take far longer to encode than to decode, so smaller chunks
+	// still amortize the work stealing.
+	unsigned rowsPerChunk = max(256 / blocksX, 1u);
+	if (pPool && blocksY > rowsPerChunk)
+		pPool->parallelFor(0, blocksY, rowsPerChunk, encodeRows);
+	else
+		encodeRows(0, 0, blocksY);
+
+	return RESULT_SUCCESS;
+}
+
+Result writeASTCFileHeader(uint8_t *pHeader, VkFormat format, unsigned width, unsigned height)
+{
+	unsigned blockWidth, blockHeight;
+	if (!getASTCBlockSize(format, &blockWidth, &blockHeight))
+	{
+		LOGE("Format %d is not a 2D ASTC format.\n", int(format));
+		return RESULT_ERROR_GENERIC;
+	}
+
+	static const uint32_t Magic = 0x5ca1ab13;
+	const unsigned depth = 1;
+	for (unsigned i = 0; i < 4; i++)
+		pHeader[i] = uint8_t(Magic >> (8 * i));
+	pHeader[4] = uint8_t(blockWidth);
+	pHeader[5] = uint8_t(blockHeight);
+	pHeader[6] = 1;
+	for (unsigned i = 0; i < 3; i++)
+	{
+		pHeader[7 + i] = uint8_t(width >> (8 * i));
+		pHeader[10 + i] = uint8_t(height >> (8 * i));
+		pHeader[13 + i] = uint8_t(depth >> (8 * i));
+	}
+	return RESULT_SUCCESS;
+}
+}
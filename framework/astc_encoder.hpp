@@ -0,0 +1,78 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FRAMEWORK_ASTC_ENCODER_HPP
+#define FRAMEWORK_ASTC_ENCODER_HPP
+
+#include "common.hpp"
+#include "libvulkan-stub.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace MaliSDK
+{
+class ThreadPool;
+
+/// @brief The version of the encoder. Changes whenever the encoder produces
+/// different blocks, so that cached encodings can be invalidated.
+#define ASTC_ENCODER_VERSION 1
+
+/// @brief The size of the header of .astc files.
+#define ASTC_FILE_HEADER_SIZE 16
+
+/// @brief Encodes a VK_FORMAT_R8G8B8A8_UNORM image to 2D ASTC on the CPU.
+///
+/// This is a fast encoder meant for preparing textures at build time or on
+/// first load, not a replacement for the reference encoder. Every block is
+/// encoded with a single partition and a single weight plane. Endpoints are
+/// fitted along the principal axis of the texels of the block and refined
+/// with least squares, and the weight grid and ranges are picked by the
+/// error they are estimated to cause. Uniform blocks are encoded as void
+/// extent blocks. Luminance and opaque blocks use the color endpoint modes
+/// without the unused components, which leaves more bits for the rest.
+///
+/// The texels are encoded as they are, so the same blocks serve UNORM and
+/// SRGB formats. If a thread pool is given, rows of blocks are encoded in
+/// parallel.
+///
+/// @param[out] pBlocks The ASTC blocks, in the layout returned by
+/// `loadASTCTextureFromAsset`.
+/// @param pSrc The image to encode.
+/// @param rowPitch The number of bytes between rows of pSrc.
+/// @param width The width of the image.
+/// @param height The height of the image.
+/// @param format The 2D ASTC format to encode to.
+/// @param pPool The thread pool to encode on, or nullptr.
+/// @returns Error code
+Result encodeASTCFromRgba8888(std::vector<uint8_t> *pBlocks, const uint8_t *pSrc, size_t rowPitch, unsigned width,
+                              unsigned height, VkFormat format, ThreadPool *pPool = nullptr);
+
+/// @brief Writes the header of a .astc file, as read by
+/// `loadASTCTextureFromAsset`.
+/// @param[out] pHeader ASTC_FILE_HEADER_SIZE bytes to write the header to.
+/// @param format The 2D ASTC format of the blocks which follow the header.
+/// @param width The width of the image.
+/// @param height The height of the image.
+/// @returns Error code
+Result writeASTCFileHeader(uint8_t *pHeader, VkFormat format, unsigned width, unsigned height);
+}
+
+#endif
@@ -0,0 +1,137 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FRAMEWORK_BOUNDED_QUEUE_HPP
+#define FRAMEWORK_BOUNDED_QUEUE_HPP
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+
+namespace MaliSDK
+{
+/// @brief A bounded, lock-free multi-producer multi-consumer FIFO queue.
+///
+/// The queue is a ring of Capacity cells, each tagged with a sequence number
+/// which tells producers and consumers whether the cell is ready for them.
+/// Pushing and popping never allocate memory and never block.
+///
+/// @tparam T The element type. Must be default constructible and movable.
+/// @tparam Capacity Number of elements. Must be a power of two.
+template <typename T, size_t Capacity>
+class BoundedQueue
+{
+public:
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two.");
+
+	/// @brief Constructor
+	BoundedQueue()
+	{
+		for (size_t i = 0; i < Capacity; i++)
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	BoundedQueue(const BoundedQueue &) = delete;
+	void operator=(const BoundedQueue &) = delete;
+
+	/// @brief Pushes an element to the back of the queue.
+	/// @param value The value to push. It is only moved from if the push
+	/// succeeds.
+	/// @returns false if the queue is full.
+	bool push(T &&value)
+	{
+		size_t pos = enqueuePos.load(std::memory_order_relaxed);
+		Cell *pCell;
+		for (;;)
+		{
+			pCell = &cells[pos & (Capacity - 1)];
+			size_t sequence = pCell->sequence.load(std::memory_order_acquire);
+			intptr_t diff = intptr_t(sequence) - intptr_t(pos);
+			if (diff == 0)
+			{
+				if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+				return false;
+			else
+				pos = enqueuePos.load(std::memory_order_relaxed);
+		}
+
+		pCell->data = std::move(value);
+		pCell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// @brief Pops an element from the front of the queue.
+	/// @param[out] pValue Receives the popped value.
+	/// @returns false if the queue is empty.
+	bool pop(T *pValue)
+	{
+		size_t pos = dequeuePos.load(std::memory_order_relaxed);
+		Cell *pCell;
+		for (;;)
+		{
+			pCell = &cells[pos & (Capacity - 1)];
+			size_t sequence = pCell->sequence.load(std::memory_order_acquire);
+			intptr_t diff = intptr_t(sequence) - intptr_t(pos + 1);
+			if (diff == 0)
+			{
+				if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+				return false;
+			else
+				pos = dequeuePos.load(std::memory_order_relaxed);
+		}
+
+		*pValue = std::move(pCell->data);
+		pCell->sequence.store(pos + Capacity, std::memory_order_release);
+		return true;
+	}
+
+	/// @brief Checks if the queue is empty.
+	/// The result is only a snapshot if other threads use the queue concurrently.
+	bool empty() const
+	{
+		return enqueuePos.load(std::memory_order_acquire) == dequeuePos.load(std::memory_order_acquire);
+	}
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		T data;
+	};
+
+	// Keep producers and consumers on separate cache lines.
+	// Padding is used rather than alignas, since over-aligned heap allocations
+	// are not supported before C++17.
+	Cell cells[Capacity];
+	char padding0[64];
+	std::atomic<size_t> enqueuePos{ 0 };
+	char padding1[64];
+	std::atomic<size_t> dequeuePos{ 0 };
+};
+}
+
+#endif
@@ -52,6 +52,13 @@ public:
 	/// state.
 	VkCommandBuffer requestCommandBuffer();
 
+	/// @brief Gets the number of command buffers requested since the last call
+	/// to @ref beginFrame.
+	unsigned getRequestedCount() const
+	{
+		return count;
+	}
+
 	/// @brief Begins the frame. When this is called,
 	/// all command buffers managed by this class are assumed to be recycleable.
 	void beginFrame();
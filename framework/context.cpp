@@ -20,27 +20,91 @@
 
 #include "context.hpp"
 #include "platform/platform.hpp"
+#include <algorithm>
+#include <atomic>
+#include <stdint.h>
 
 namespace MaliSDK
 {
-Context::PerFrame::PerFrame(VkDevice device, unsigned graphicsQueueIndex)
+// Threads which record secondary command buffers are bound to a slot, which
+// indexes the secondary command managers of every frame.
+// A set bit means the slot is free.
+static std::atomic<uint64_t> freeThreadSlots{ ~uint64_t(0) };
+
+namespace
+{
+struct ThreadSlot
+{
+	enum
+	{
+		Invalid = ~0u
+	};
+
+	unsigned index = Invalid;
+
+	~ThreadSlot()
+	{
+		if (index != Invalid)
+			freeThreadSlots.fetch_or(uint64_t(1) << index);
+	}
+};
+}
+
+static thread_local ThreadSlot threadSlot;
+
+static unsigned allocateThreadSlot()
+{
+	static_assert(Context::MaxRenderingThreads <= 64, "Thread slots are tracked in a 64-bit mask.");
+
+	uint64_t mask = freeThreadSlots.load();
+	while (mask != 0)
+	{
+		uint64_t bit = mask & (~mask + 1);
+		if (freeThreadSlots.compare_exchange_weak(mask, mask & ~bit))
+		{
+			unsigned index = 0;
+			while (bit >>= 1)
+				index++;
+			return index;
+		}
+	}
+
+	return ThreadSlot::Invalid;
+}
+
+Context::PerFrame::PerFrame(VkDevice device, DeviceMemoryAllocator *pAllocator, unsigned graphicsQueueIndex)
     : device(device)
+    , pAllocator(pAllocator)
     , fenceManager(device)
     , commandManager(device, VK_COMMAND_BUFFER_LEVEL_PRIMARY, graphicsQueueIndex)
+    , secondaryCommandManagers(MaxRenderingThreads)
     , queueIndex(graphicsQueueIndex)
 {
 }
 
 void Context::PerFrame::setSecondaryCommandManagersCount(unsigned count)
 {
-	secondaryCommandManagers.clear();
+	// Growing is safe at any time, since new command pools cannot be in use
+	// by the GPU. Shrinking is deferred to beginFrame.
+	secondaryCommandManagerCount = count;
 	for (unsigned i = 0; i < count; i++)
 	{
-		secondaryCommandManagers.emplace_back(
-		    new CommandBufferManager(device, VK_COMMAND_BUFFER_LEVEL_SECONDARY, queueIndex));
+		if (!secondaryCommandManagers[i])
+			secondaryCommandManagers[i].reset(
+			    new CommandBufferManager(device, VK_COMMAND_BUFFER_LEVEL_SECONDARY, queueIndex));
 	}
 }
 
+VkCommandBuffer Context::PerFrame::requestSecondaryCommandBuffer(unsigned threadIndex)
+{
+	// Only the thread which owns the index can touch this manager during the
+	// frame, so it can be created here without locking.
+	auto &pManager = secondaryCommandManagers[threadIndex];
+	if (!pManager)
+		pManager.reset(new CommandBufferManager(device, VK_COMMAND_BUFFER_LEVEL_SECONDARY, queueIndex));
+	return pManager->requestCommandBuffer();
+}
+
 VkPhysicalDevice Context::getPhysicalDevice() const
 {
 	return pPlatform->getPhysicalDevice();
@@ -53,27 +117,118 @@ VkSemaphore Context::PerFrame::setSwapchainAcquireSemaphore(VkSemaphore acquireS
 	return ret;
 }
 
-void Context::PerFrame::setSwapchainReleaseSemaphore(VkSemaphore releaseSemaphore)
+void Context::PerFrame::destroyDeferredResources()
 {
-	if (swapchainReleaseSemaphore != VK_NULL_HANDLE)
-		vkDestroySemaphore(device, swapchainReleaseSemaphore, nullptr);
-	swapchainReleaseSemaphore = releaseSemaphore;
+	// Destroy views before the resources they refer to, and resources before
+	// the memory bound to them.
+	for (auto &framebuffer : deferredFramebuffers)
+		vkDestroyFramebuffer(device, framebuffer, nullptr);
+	for (auto &view : deferredImageViews)
+		vkDestroyImageView(device, view, nullptr);
+	for (auto &image : deferredImages)
+		vkDestroyImage(device, image, nullptr);
+	for (auto &buffer : deferredBuffers)
+		vkDestroyBuffer(device, buffer, nullptr);
+	for (auto &memory : deferredMemory)
+		vkFreeMemory(device, memory, nullptr);
+	for (auto &allocation : deferredAllocations)
+		pAllocator->free(allocation);
+
+	deferredFramebuffers.clear();
+	deferredImageViews.clear();
+	deferredImages.clear();
+	deferredBuffers.clear();
+	deferredMemory.clear();
+	deferredAllocations.clear();
 }
 
 void Context::PerFrame::beginFrame()
 {
 	fenceManager.beginFrame();
+	destroyDeferredResources();
 	commandManager.beginFrame();
-	for (auto &pManager : secondaryCommandManagers)
-		pManager->beginFrame();
+
+	// All fences for this frame have been waited for, so command pools beyond
+	// the requested thread count which went unused for a full frame can be
+	// destroyed safely.
+	for (unsigned i = 0; i < secondaryCommandManagers.size(); i++)
+	{
+		auto &pManager = secondaryCommandManagers[i];
+		if (!pManager)
+			continue;
+
+		if (i >= secondaryCommandManagerCount && pManager->getRequestedCount() == 0)
+			pManager.reset();
+		else
+			pManager->beginFrame();
+	}
 }
 
 Context::PerFrame::~PerFrame()
 {
+	fenceManager.beginFrame();
+	destroyDeferredResources();
+
 	if (swapchainAcquireSemaphore != VK_NULL_HANDLE)
 		vkDestroySemaphore(device, swapchainAcquireSemaphore, nullptr);
-	if (swapchainReleaseSemaphore != VK_NULL_HANDLE)
-		vkDestroySemaphore(device, swapchainReleaseSemaphore, nullptr);
+}
+
+Context::~Context()
+{
+	destroySwapchainReleaseSemaphores();
+}
+
+void Context::destroySwapchainReleaseSemaphores()
+{
+	for (auto &semaphore : swapchainReleaseSemaphores)
+		if (semaphore != VK_NULL_HANDLE)
+			vkDestroySemaphore(device, semaphore, nullptr);
+	swapchainReleaseSemaphores.clear();
+}
+
+void Context::initPerFrame()
+{
+	// Every frame in flight has its own command pools and fence manager.
+	// This makes it very easy to keep track of when we can reset command buffers
+	// and such.
+	unsigned count = framesInFlight != 0 ? framesInFlight : pPlatform->getNumSwapchainImages();
+
+	// Destroying the frames waits for their fences, so all uploads they
+	// submitted have completed before the fences are gone.
+	UploadManager::Token uploadToken = 0;
+	for (auto &pFrame : perFrame)
+		uploadToken = std::max(uploadToken, pFrame->uploadToken);
+	perFrame.clear();
+	if (uploads)
+		uploads->beginFrame(uploadToken);
+	for (unsigned i = 0; i < count; i++)
+		perFrame.emplace_back(new PerFrame(device, allocator.get(), pPlatform->getGraphicsQueueIndex()));
+	frameIndex = 0;
+
+	// The GPU is idle at this point, so none of the uniform data is in use.
+	// The ring is only recreated if it is too small for the frames in flight,
+	// since descriptor sets refer to its buffer.
+	if (!uniformRing || uniformRing->getFrameCount() < count)
+		uniformRing.reset(new UniformRingBuffer(device, *allocator, pPlatform->getGpuProperties().limits, count));
+	else
+		uniformRing->reset();
+
+	setRenderingThreadCount(renderingThreadCount);
+}
+
+void Context::setFramesInFlight(unsigned count)
+{
+	framesInFlight = count;
+	if (!pPlatform)
+		return;
+
+	unsigned actualCount = count != 0 ? count : pPlatform->getNumSwapchainImages();
+	if (actualCount == perFrame.size())
+		return;
+
+	flush();
+	waitIdle();
+	initPerFrame();
 }
 
 void Context::waitIdle()
@@ -83,25 +238,72 @@ void Context::waitIdle()
 
 Result Context::onPlatformUpdate(Platform *pPlatform)
 {
+	// Pending command buffers belong to the per-frame command pools which are
+	// about to be destroyed.
+	if (!perFrame.empty())
+		flush();
+
+	VkDevice oldDevice = device;
 	device = pPlatform->getDevice();
 	queue = pPlatform->getGraphicsQueue();
 	this->pPlatform = pPlatform;
 
 	waitIdle();
 
-	// Initialize per-frame resources.
-	// Every swapchain image has its own command pool and fence manager.
-	// This makes it very easy to keep track of when we can reset command buffers
-	// and such.
-	perFrame.clear();
-	for (unsigned i = 0; i < pPlatform->getNumSwapchainImages(); i++)
-		perFrame.emplace_back(new PerFrame(device, pPlatform->getGraphicsQueueIndex()));
+	// The allocator outlives swapchain recreation, since the application keeps
+	// its resources.
+	if (!allocator || device != oldDevice)
+	{
+		perFrame.clear();
+		transientAttachments.reset();
+		pipelineCache.reset();
+		uploads.reset();
+		uniformRing.reset();
+		allocator.reset(new DeviceMemoryAllocator(device, pPlatform->getMemoryProperties(),
+		                                          pPlatform->getGpuProperties().limits));
+		uploads.reset(new UploadManager(device, *allocator, pPlatform->getGpuProperties().limits,
+		                                pPlatform->getGraphicsQueueIndex(), pPlatform->getTransferQueue(),
+		                                pPlatform->getTransferQueueIndex()));
+		transientAttachments.reset(new TransientAttachmentCache(device, *allocator));
+		pipelineCache.reset(new PipelineCache(device, pPlatform->getGpuProperties()));
+	}
 
-	setRenderingThreadCount(renderingThreadCount);
+	destroySwapchainReleaseSemaphores();
+	swapchainReleaseSemaphores.resize(pPlatform->getNumSwapchainImages(), VK_NULL_HANDLE);
+
+	initPerFrame();
 
 	return RESULT_SUCCESS;
 }
 
+void Context::setRenderingThreadCount(unsigned count)
+{
+	if (count > MaxRenderingThreads)
+	{
+		LOGE("Rendering thread count %u is larger than the maximum %u.\n", count, unsigned(MaxRenderingThreads));
+		count = MaxRenderingThreads;
+	}
+
+	for (auto &pFrame : perFrame)
+		pFrame->setSecondaryCommandManagersCount(count);
+	renderingThreadCount = count;
+}
+
+VkCommandBuffer Context::requestSecondaryCommandBuffer()
+{
+	if (threadSlot.index == ThreadSlot::Invalid)
+	{
+		threadSlot.index = allocateThreadSlot();
+		if (threadSlot.index == ThreadSlot::Invalid)
+		{
+			LOGE("Too many threads are recording secondary command buffers.\n");
+			return VK_NULL_HANDLE;
+		}
+	}
+
+	return perFrame[frameIndex]->requestSecondaryCommandBuffer(threadSlot.index);
+}
+
 void Context::submit(VkCommandBuffer cmd)
 {
 	submitCommandBuffer(cmd, VK_NULL_HANDLE, VK_NULL_HANDLE);
@@ -109,7 +311,7 @@ void Context::submit(VkCommandBuffer cmd)
 
 void Context::submitSwapchain(VkCommandBuffer cmd)
 {
-	// For the first frames, we will create a release semaphore.
+	// For the first frames, we will create a release semaphore per swapchain image.
 	// This can be reused every frame. Semaphores are reset when they have been
 	// successfully been waited on.
 	// If we aren't using acquire semaphores, we aren't using release semaphores
@@ -119,7 +321,7 @@ void Context::submitSwapchain(VkCommandBuffer cmd)
 		VkSemaphore releaseSemaphore;
 		VkSemaphoreCreateInfo semaphoreInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
 		VK_CHECK(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &releaseSemaphore));
-		perFrame[swapchainIndex]->setSwapchainReleaseSemaphore(releaseSemaphore);
+		swapchainReleaseSemaphores[swapchainIndex] = releaseSemaphore;
 	}
 
 	submitCommandBuffer(cmd, getSwapchainAcquireSemaphore(), getSwapchainReleaseSemaphore());
@@ -127,21 +329,88 @@ void Context::submitSwapchain(VkCommandBuffer cmd)
 
 void Context::submitCommandBuffer(VkCommandBuffer cmd, VkSemaphore acquireSemaphore, VkSemaphore releaseSemaphore)
 {
-	// All queue submissions get a fence that CPU will wait
-	// on for synchronization purposes.
-	VkFence fence = getFenceManager().requestClearedFence();
+	// Semaphores apply to every command buffer in a VkSubmitInfo, so a command
+	// buffer which waits for a semaphore starts a new batch, and a command
+	// buffer which signals a semaphore ends its batch. This way, unrelated
+	// work never waits for the swapchain, and work submitted after the
+	// swapchain command buffer is not part of what the release semaphore
+	// covers.
+	bool newBatch = pendingBatches.empty() || pendingBatches.back().signalSemaphore != VK_NULL_HANDLE ||
+	                acquireSemaphore != VK_NULL_HANDLE;
+
+	if (newBatch)
+	{
+		SubmitBatch batch = { acquireSemaphore, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_NULL_HANDLE,
+		                      unsigned(pendingCommandBuffers.size()), 0 };
+		pendingBatches.push_back(batch);
+	}
+
+	auto &batch = pendingBatches.back();
+	batch.signalSemaphore = releaseSemaphore;
+	batch.commandBufferCount++;
+	pendingCommandBuffers.push_back(cmd);
+}
+
+void Context::flush(VkFence fence)
+{
+	// Uploads go first, so command buffers in this flush can use the
+	// resources.
+	VkCommandBuffer uploadCmd;
+	VkSemaphore uploadSemaphore;
+	UploadManager::Token uploadToken = uploads->flush(&uploadCmd, &uploadSemaphore);
+	if (uploadCmd != VK_NULL_HANDLE)
+	{
+		// With a dedicated transfer queue, the command buffer acquires
+		// ownership once the copies have completed, before anything else runs.
+		pendingCommandBuffers.insert(pendingCommandBuffers.begin(), uploadCmd);
+		for (auto &batch : pendingBatches)
+			batch.firstCommandBuffer++;
+
+		if (uploadSemaphore == VK_NULL_HANDLE && !pendingBatches.empty() &&
+		    pendingBatches.front().waitSemaphore == VK_NULL_HANDLE)
+		{
+			pendingBatches.front().firstCommandBuffer = 0;
+			pendingBatches.front().commandBufferCount++;
+		}
+		else
+		{
+			SubmitBatch batch = { uploadSemaphore, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_NULL_HANDLE, 0, 1 };
+			pendingBatches.insert(pendingBatches.begin(), batch);
+		}
+	}
 
-	VkSubmitInfo info = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
-	info.commandBufferCount = 1;
-	info.pCommandBuffers = &cmd;
+	if (pendingBatches.empty() && fence == VK_NULL_HANDLE)
+		return;
 
-	const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	info.waitSemaphoreCount = acquireSemaphore != VK_NULL_HANDLE ? 1 : 0;
-	info.pWaitSemaphores = &acquireSemaphore;
-	info.pWaitDstStageMask = &waitStage;
-	info.signalSemaphoreCount = releaseSemaphore != VK_NULL_HANDLE ? 1 : 0;
-	info.pSignalSemaphores = &releaseSemaphore;
+	submitInfos.clear();
+	for (auto &batch : pendingBatches)
+	{
+		VkSubmitInfo info = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+		info.commandBufferCount = batch.commandBufferCount;
+		info.pCommandBuffers = pendingCommandBuffers.data() + batch.firstCommandBuffer;
+		info.waitSemaphoreCount = batch.waitSemaphore != VK_NULL_HANDLE ? 1 : 0;
+		info.pWaitSemaphores = &batch.waitSemaphore;
+		info.pWaitDstStageMask = &batch.waitStage;
+		info.signalSemaphoreCount = batch.signalSemaphore != VK_NULL_HANDLE ? 1 : 0;
+		info.pSignalSemaphores = &batch.signalSemaphore;
+		submitInfos.push_back(info);
+	}
+
+	// All queue submissions get a fence that CPU will wait
+	// on for synchronization purposes. One fence covers the entire flush.
+	if (fence != VK_NULL_HANDLE)
+		getFenceManager().addExternalFence(fence);
+	else
+		fence = getFenceManager().requestClearedFence();
+	VK_CHECK(vkQueueSubmit(queue, submitInfos.size(), submitInfos.data(), fence));
+
+	if (uploadCmd != VK_NULL_HANDLE)
+	{
+		uploads->setSubmissionFence(uploadToken, fence);
+		perFrame[frameIndex]->uploadToken = uploadToken;
+	}
 
-	VK_CHECK(vkQueueSubmit(queue, 1, &info, fence));
+	pendingBatches.clear();
+	pendingCommandBuffers.clear();
 }
 }
@@ -22,8 +22,13 @@
 #define FRAMEWORK_CONTEXT_HPP
 
 #include "command_buffer_manager.hpp"
+#include "device_memory_allocator.hpp"
 #include "fence_manager.hpp"
 #include "framework/common.hpp"
+#include "pipeline_cache.hpp"
+#include "transient_attachment_cache.hpp"
+#include "uniform_ring_buffer.hpp"
+#include "upload_manager.hpp"
 #include <memory>
 #include <vector>
 
@@ -36,6 +41,16 @@ class Platform;
 class Context
 {
 public:
+	/// @brief Destructor
+	~Context();
+
+	/// @brief The maximum number of threads which can record secondary command
+	/// buffers.
+	enum
+	{
+		MaxRenderingThreads = 64
+	};
+
 	/// @brief Called by the platform internally when platform either initializes
 	/// itself
 	/// or the swapchain has been recreated.
@@ -62,6 +77,53 @@ public:
 		return queue;
 	}
 
+	/// @brief Gets the device memory allocator, which should be used to
+	/// allocate memory for buffers and images.
+	/// @returns The allocator
+	DeviceMemoryAllocator &getAllocator()
+	{
+		return *allocator;
+	}
+
+	/// @brief Gets the uniform ring, which per-frame uniform data should be
+	/// allocated from.
+	///
+	/// Data allocated from the ring stays valid until the GPU has completed
+	/// the current frame. Every frame can allocate up to
+	/// `UniformRingBuffer::DefaultFrameSize` bytes.
+	/// @returns The uniform ring
+	UniformRingBuffer &getUniformRing()
+	{
+		return *uniformRing;
+	}
+
+	/// @brief Gets the upload manager, which should be used to copy initial
+	/// data into buffers and images.
+	///
+	/// Pending uploads are submitted by @ref flush as the first batch, so
+	/// command buffers submitted after an upload can use the resource.
+	/// @returns The upload manager
+	UploadManager &getUploadManager()
+	{
+		return *uploads;
+	}
+
+	/// @brief Gets the pipeline cache of the device, which persists across
+	/// runs and should be used to create all pipelines.
+	/// @returns The pipeline cache
+	PipelineCache &getPipelineCache()
+	{
+		return *pipelineCache;
+	}
+
+	/// @brief Gets the transient attachment cache, which attachments that
+	/// never leave a render pass should be requested from.
+	/// @returns The transient attachment cache
+	TransientAttachmentCache &getTransientAttachmentCache()
+	{
+		return *transientAttachments;
+	}
+
 	/// @brief Gets the current platform.
 	/// @returns A reference to the platform
 	Platform &getPlatform()
@@ -78,7 +140,7 @@ public:
 	/// @returns A reset primary command buffer
 	VkCommandBuffer requestPrimaryCommandBuffer()
 	{
-		return perFrame[swapchainIndex]->commandManager.requestCommandBuffer();
+		return perFrame[frameIndex]->commandManager.requestCommandBuffer();
 	}
 
 	/// @brief Requests a reset secondary command buffer, suitable for rendering
@@ -99,10 +161,36 @@ public:
 	/// @returns A reset secondary command buffer
 	VkCommandBuffer requestSecondaryCommandBuffer(unsigned threadIndex)
 	{
-		return perFrame[swapchainIndex]->secondaryCommandManagers[threadIndex]->requestCommandBuffer();
+		return perFrame[frameIndex]->requestSecondaryCommandBuffer(threadIndex);
 	}
 
+	/// @brief Requests a reset secondary command buffer from the command pool
+	/// owned by the calling thread.
+	///
+	/// The lifetime of this command buffer is only for the current frame.
+	/// It must be submitted in the same frame that the application obtains the
+	/// command buffer.
+	///
+	/// Every thread which calls this is bound to its own command pool through
+	/// thread-local storage the first time it calls, so any thread can record
+	/// in parallel without passing a thread index around. Command pools are
+	/// created on demand, so @ref setRenderingThreadCount is only a hint.
+	/// At most @ref MaxRenderingThreads threads can be bound at the same time.
+	/// Threads which exit give their command pools back to new threads.
+	///
+	/// This must not be mixed with @ref requestSecondaryCommandBuffer(unsigned)
+	/// in the same frame, since both index the same set of command pools.
+	///
+	/// @returns A reset secondary command buffer, or `VK_NULL_HANDLE` if too
+	/// many threads are bound.
+	VkCommandBuffer requestSecondaryCommandBuffer();
+
 	/// @brief Submit a command buffer to the queue.
+	///
+	/// The command buffer is not submitted right away, but is batched
+	/// together with other command buffers submitted this frame until @ref
+	/// flush is called. Command buffers execute in the order they were
+	/// submitted.
 	/// @param cmdBuffer The commandbuffer to submit.
 	void submit(VkCommandBuffer cmdBuffer);
 
@@ -114,11 +202,89 @@ public:
 	/// the `vkQueueSubmit` call depending on what was passed in to @ref
 	/// beginFrame by the platform.
 	///
+	/// Like @ref submit, the command buffer is batched until @ref flush is
+	/// called. The platform flushes before presenting.
+	///
 	/// @param cmdBuffer The commandbuffer to submit.
 	void submitSwapchain(VkCommandBuffer cmdBuffer);
 
+	/// @brief Submits all batched command buffers to the queue.
+	///
+	/// Pending uploads become the first batch. All batches are submitted with
+	/// a single `vkQueueSubmit` call and a single fence, which also retires the
+	/// uploads. With a dedicated transfer queue, the copies themselves are
+	/// submitted to that queue. Applications must flush before waiting for
+	/// submitted work on the CPU, e.g. with `vkQueueWaitIdle`.
+	///
+	/// @param fence An unsignalled fence owned by the caller, which is signalled
+	/// by the submission instead of a fence of the frame, or `VK_NULL_HANDLE`.
+	/// This lets the caller wait for the submission on another thread after
+	/// the frame has been recycled. The frame still waits for the fence, so it
+	/// must stay valid until the frame begins again or the Context is
+	/// destroyed, and may only be reset right before it is submitted again.
+	/// It is signalled even if nothing was batched.
+	void flush(VkFence fence = VK_NULL_HANDLE);
+
+	/// @brief Destroys a buffer once the GPU has completed the current frame.
+	///
+	/// The buffer must not be used by command buffers submitted in later
+	/// frames.
+	/// @param buffer The buffer to destroy.
+	void destroyBufferDeferred(VkBuffer buffer)
+	{
+		perFrame[frameIndex]->deferredBuffers.push_back(buffer);
+	}
+
+	/// @brief Destroys an image once the GPU has completed the current frame.
+	/// @param image The image to destroy.
+	void destroyImageDeferred(VkImage image)
+	{
+		perFrame[frameIndex]->deferredImages.push_back(image);
+	}
+
+	/// @brief Destroys an image view once the GPU has completed the current
+	/// frame.
+	/// @param view The image view to destroy.
+	void destroyImageViewDeferred(VkImageView view)
+	{
+		perFrame[frameIndex]->deferredImageViews.push_back(view);
+	}
+
+	/// @brief Destroys a framebuffer once the GPU has completed the current
+	/// frame.
+	/// @param framebuffer The framebuffer to destroy.
+	void destroyFramebufferDeferred(VkFramebuffer framebuffer)
+	{
+		perFrame[frameIndex]->deferredFramebuffers.push_back(framebuffer);
+	}
+
+	/// @brief Frees device memory once the GPU has completed the current
+	/// frame.
+	///
+	/// Memory is freed after all buffers and images queued in the same frame
+	/// have been destroyed.
+	/// @param memory The memory to free.
+	void freeMemoryDeferred(VkDeviceMemory memory)
+	{
+		perFrame[frameIndex]->deferredMemory.push_back(memory);
+	}
+
+	/// @brief Frees a device memory allocation once the GPU has completed the
+	/// current frame.
+	///
+	/// Allocations are freed after all buffers and images queued in the same
+	/// frame have been destroyed.
+	/// @param allocation The allocation to free.
+	void freeAllocationDeferred(const DeviceAllocation &allocation)
+	{
+		perFrame[frameIndex]->deferredAllocations.push_back(allocation);
+	}
+
 	/// @brief Called by the platform, begins a frame
 	///
+	/// Advances to the next slot in the frames-in-flight ring and waits for
+	/// the GPU to complete the frame which last used that slot.
+	///
 	/// @param index The swapchain index which will be rendered into this frame.
 	///
 	/// @param acquireSemaphore When submitting command buffers using @ref
@@ -127,33 +293,97 @@ public:
 	/// to wait for the swapchain to become ready before rendering begins on GPU.
 	/// May be `VK_NULL_HANDLE` in case no waiting is required by the platform.
 	///
-	/// @returns The old semaphore associated with this swapchain index.
+	/// @returns The old acquire semaphore associated with this frame slot,
+	/// which the GPU is done with.
 	VkSemaphore beginFrame(unsigned index, VkSemaphore acquireSemaphore)
 	{
+		// Work submitted outside of a frame, e.g. during initialization, has to
+		// be covered by the fences of the slot it was recorded in.
+		flush();
+		perFrame[frameIndex]->uniformRingPosition = uniformRing->getPosition();
+
 		swapchainIndex = index;
-		perFrame[swapchainIndex]->beginFrame();
-		return perFrame[swapchainIndex]->setSwapchainAcquireSemaphore(acquireSemaphore);
+		frameIndex = (frameIndex + 1) % perFrame.size();
+		perFrame[frameIndex]->beginFrame();
+		uniformRing->beginFrame(perFrame[frameIndex]->uniformRingPosition);
+		uploads->beginFrame(perFrame[frameIndex]->uploadToken);
+		transientAttachments->beginFrame(perFrame.size());
+		return perFrame[frameIndex]->setSwapchainAcquireSemaphore(acquireSemaphore);
+	}
+
+	/// @brief Sets the number of frames which can be in flight on the GPU
+	/// before @ref beginFrame waits for the GPU to catch up.
+	///
+	/// Per-frame resources such as command pools and fences are kept in a ring
+	/// of this size, independent of the number of swapchain images.
+	/// Fewer frames in flight reduce latency, more frames improve throughput
+	/// when CPU and GPU frame times vary.
+	/// This call is heavyweight if the count changes after initialization,
+	/// since it waits for the GPU to go idle.
+	/// It must not be called while a frame is being rendered, i.e. between
+	/// acquiring and presenting a swapchain image.
+	/// If the count grows after initialization, the uniform ring is recreated,
+	/// so descriptor sets which refer to its buffer must be updated.
+	/// @param count The number of frames in flight, or 0 to use one frame per
+	/// swapchain image, which is the default.
+	void setFramesInFlight(unsigned count);
+
+	/// @brief Gets the number of frames which can be in flight on the GPU.
+	/// @returns The size of the frames-in-flight ring.
+	unsigned getFramesInFlight() const
+	{
+		return perFrame.size();
+	}
+
+	/// @brief Gets the slot in the frames-in-flight ring used by the current
+	/// frame.
+	///
+	/// Resources which the CPU updates every frame can be indexed by this in
+	/// order to not overwrite data the GPU is still using.
+	/// @returns The current frame slot in range [0, @ref getFramesInFlight).
+	unsigned getFrameIndex() const
+	{
+		return frameIndex;
 	}
 
 	/// @brief Sets the number of worker threads which can use secondary command
 	/// buffers.
-	/// This call is blocking and will wait for all GPU work to complete before
-	/// resizing.
-	/// @param count The number of threads to support.
-	void setRenderingThreadCount(unsigned count)
+	/// Command pools for new threads are created right away. Command pools
+	/// which are no longer needed are destroyed once the GPU is done with the
+	/// frame they were last used in, so this call never waits for the GPU.
+	/// @param count The number of threads to support, at most
+	/// @ref MaxRenderingThreads.
+	void setRenderingThreadCount(unsigned count);
+
+	/// @brief Gets the time the CPU was blocked waiting for the GPU in the
+	/// current frame.
+	///
+	/// This includes waiting for the frame slot to become available in @ref
+	/// beginFrame. A consistently non-zero stall time means the application is
+	/// GPU bound.
+	/// @returns The stall time in seconds.
+	double getFrameStallTime() const
 	{
-		vkQueueWaitIdle(queue);
-		for (auto &pFrame : perFrame)
-			pFrame->setSecondaryCommandManagersCount(count);
-		renderingThreadCount = count;
+		return perFrame[frameIndex]->fenceManager.getStallTime();
 	}
 
-	/// @brief Gets the fence manager for the current swapchain image.
+	/// @brief Checks whether the GPU is done with the frame slot the next
+	/// frame will use, without blocking.
+	///
+	/// If this returns false, the next @ref beginFrame will block, so the
+	/// application may prefer to do other useful CPU work first.
+	/// @returns true if beginning the next frame will not wait for the GPU.
+	bool isNextFrameReady() const
+	{
+		return perFrame[(frameIndex + 1) % perFrame.size()]->fenceManager.isComplete();
+	}
+
+	/// @brief Gets the fence manager for the current frame.
 	/// Used by the platform internally.
 	/// @returns FenceManager
 	FenceManager &getFenceManager()
 	{
-		return perFrame[swapchainIndex]->fenceManager;
+		return perFrame[frameIndex]->fenceManager;
 	}
 
 	/// @brief Gets the acquire semaphore for the swapchain.
@@ -161,7 +391,7 @@ public:
 	/// @returns Semaphore.
 	const VkSemaphore &getSwapchainAcquireSemaphore() const
 	{
-		return perFrame[swapchainIndex]->swapchainAcquireSemaphore;
+		return perFrame[frameIndex]->swapchainAcquireSemaphore;
 	}
 
 	/// @brief Gets the release semaphore for the swapchain.
@@ -169,7 +399,7 @@ public:
 	/// @returns Semaphore.
 	const VkSemaphore &getSwapchainReleaseSemaphore() const
 	{
-		return perFrame[swapchainIndex]->swapchainReleaseSemaphore;
+		return swapchainReleaseSemaphores[swapchainIndex];
 	}
 
 private:
@@ -177,28 +407,77 @@ private:
 	VkDevice device = VK_NULL_HANDLE;
 	VkQueue queue = VK_NULL_HANDLE;
 	unsigned swapchainIndex = 0;
+	unsigned frameIndex = 0;
+	unsigned framesInFlight = 0;
 	unsigned renderingThreadCount = 0;
 
 	struct PerFrame
 	{
-		PerFrame(VkDevice device, unsigned graphicsQueueIndex);
+		PerFrame(VkDevice device, DeviceMemoryAllocator *pAllocator, unsigned graphicsQueueIndex);
 		~PerFrame();
 
 		void beginFrame();
 		VkSemaphore setSwapchainAcquireSemaphore(VkSemaphore acquireSemaphore);
-		void setSwapchainReleaseSemaphore(VkSemaphore releaseSemaphore);
 		void setSecondaryCommandManagersCount(unsigned count);
+		void destroyDeferredResources();
+		VkCommandBuffer requestSecondaryCommandBuffer(unsigned threadIndex);
 
 		VkDevice device = VK_NULL_HANDLE;
+		DeviceMemoryAllocator *pAllocator;
 		FenceManager fenceManager;
 		CommandBufferManager commandManager;
+		// Has room for MaxRenderingThreads managers which are created on demand,
+		// so the vector is never resized while worker threads are recording.
 		std::vector<std::unique_ptr<CommandBufferManager>> secondaryCommandManagers;
+		unsigned secondaryCommandManagerCount = 0;
 		VkSemaphore swapchainAcquireSemaphore = VK_NULL_HANDLE;
-		VkSemaphore swapchainReleaseSemaphore = VK_NULL_HANDLE;
 		unsigned queueIndex;
+		// The uniform ring position at the end of this frame.
+		uint64_t uniformRingPosition = 0;
+		// The newest upload submission flushed in this frame.
+		UploadManager::Token uploadToken = 0;
+
+		// Resources which are destroyed once the fences for this frame have
+		// signalled.
+		std::vector<VkFramebuffer> deferredFramebuffers;
+		std::vector<VkImageView> deferredImageViews;
+		std::vector<VkImage> deferredImages;
+		std::vector<VkBuffer> deferredBuffers;
+		std::vector<VkDeviceMemory> deferredMemory;
+		std::vector<DeviceAllocation> deferredAllocations;
 	};
+	// Declared before the per-frame data, since freeing deferred allocations
+	// during destruction needs the allocator.
+	std::unique_ptr<DeviceMemoryAllocator> allocator;
+	std::unique_ptr<UniformRingBuffer> uniformRing;
+	std::unique_ptr<UploadManager> uploads;
+	std::unique_ptr<TransientAttachmentCache> transientAttachments;
+	std::unique_ptr<PipelineCache> pipelineCache;
 	std::vector<std::unique_ptr<PerFrame>> perFrame;
 
+	// Release semaphores are waited on by the presentation engine, which is
+	// only guaranteed to be done with them once the swapchain image they were
+	// presented with is acquired again, so they are kept per swapchain image
+	// rather than per frame slot.
+	std::vector<VkSemaphore> swapchainReleaseSemaphores;
+
+	void initPerFrame();
+	void destroySwapchainReleaseSemaphores();
+
+	// A range of pending command buffers which share the same semaphores,
+	// i.e. one VkSubmitInfo.
+	struct SubmitBatch
+	{
+		VkSemaphore waitSemaphore;
+		VkPipelineStageFlags waitStage;
+		VkSemaphore signalSemaphore;
+		unsigned firstCommandBuffer;
+		unsigned commandBufferCount;
+	};
+	std::vector<VkCommandBuffer> pendingCommandBuffers;
+	std::vector<SubmitBatch> pendingBatches;
+	std::vector<VkSubmitInfo> submitInfos;
+
 	void submitCommandBuffer(VkCommandBuffer, VkSemaphore acquireSemaphore, VkSemaphore releaseSemaphore);
 	void waitIdle();
 };
@@ -0,0 +1,196 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "cpu_topology.hpp"
+#include <algorithm>
+#include <stdio.h>
+#include <thread>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+using namespace std;
+
+namespace MaliSDK
+{
+static vector<CpuInfo> getUniformTopology()
+{
+	vector<CpuInfo> topology;
+	unsigned count = max(1u, thread::hardware_concurrency());
+	for (unsigned i = 0; i < count; i++)
+		topology.push_back({ i, 1024, 0 });
+	return topology;
+}
+
+#ifdef __linux__
+static bool readSysfsValue(const char *pPath, unsigned *pValue)
+{
+	FILE *pFile = fopen(pPath, "r");
+	if (!pFile)
+		return false;
+
+	bool ret = fscanf(pFile, "%u", pValue) == 1;
+	fclose(pFile);
+	return ret;
+}
+
+static bool readCpuValue(unsigned cpu, const char *pName, unsigned *pValue)
+{
+	char path[256];
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/%s", cpu, pName);
+	return readSysfsValue(path, pValue);
+}
+
+// Parses CPU lists in the format "0-3,6,8-9".
+static vector<unsigned> readOnlineCpus()
+{
+	vector<unsigned> cpus;
+	FILE *pFile = fopen("/sys/devices/system/cpu/online", "r");
+	if (!pFile)
+		return cpus;
+
+	unsigned first, last;
+	while (fscanf(pFile, "%u", &first) == 1)
+	{
+		last = first;
+		int c = fgetc(pFile);
+		if (c == '-')
+		{
+			if (fscanf(pFile, "%u", &last) != 1)
+				break;
+			c = fgetc(pFile);
+		}
+
+		for (unsigned cpu = first; cpu <= last; cpu++)
+			cpus.push_back(cpu);
+
+		if (c != ',')
+			break;
+	}
+
+	fclose(pFile);
+	return cpus;
+}
+
+vector<CpuInfo> getCpuTopology()
+{
+	vector<CpuInfo> topology;
+	vector<unsigned> cpus = readOnlineCpus();
+
+	bool hasCapacity = true;
+	bool hasFrequency = true;
+	vector<unsigned> capacities(cpus.size(), 0);
+	vector<unsigned> frequencies(cpus.size(), 0);
+
+	for (unsigned i = 0; i < cpus.size(); i++)
+	{
+		CpuInfo info;
+		info.id = cpus[i];
+		info.capacity = 1024;
+
+		// Older kernels do not have cluster_id, but big.LITTLE clusters were
+		// exposed as separate packages.
+		if (!readCpuValue(info.id, "topology/cluster_id", &info.cluster) &&
+		    !readCpuValue(info.id, "topology/physical_package_id", &info.cluster))
+			info.cluster = 0;
+
+		hasCapacity = hasCapacity && readCpuValue(info.id, "cpu_capacity", &capacities[i]);
+		hasFrequency = hasFrequency && readCpuValue(info.id, "cpufreq/cpuinfo_max_freq", &frequencies[i]);
+		topology.push_back(info);
+	}
+
+	if (!hasCapacity && hasFrequency)
+		capacities = frequencies;
+
+	if (hasCapacity || hasFrequency)
+	{
+		unsigned maxCapacity = *max_element(begin(capacities), end(capacities));
+		if (maxCapacity != 0)
+			for (unsigned i = 0; i < topology.size(); i++)
+				topology[i].capacity = max(1u, unsigned(uint64_t(capacities[i]) * 1024 / maxCapacity));
+	}
+
+	if (topology.empty())
+		return getUniformTopology();
+
+	return topology;
+}
+
+Result setCurrentThreadAffinity(const vector<unsigned> &cpus)
+{
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (auto cpu : cpus)
+		if (cpu < CPU_SETSIZE)
+			CPU_SET(cpu, &set);
+
+	if (sched_setaffinity(0, sizeof(set), &set) != 0)
+	{
+		LOGE("Failed to set thread affinity.\n");
+		return RESULT_ERROR_GENERIC;
+	}
+
+	return RESULT_SUCCESS;
+}
+#else
+vector<CpuInfo> getCpuTopology()
+{
+	return getUniformTopology();
+}
+
+Result setCurrentThreadAffinity(const vector<unsigned> &)
+{
+	return RESULT_ERROR_GENERIC;
+}
+#endif
+
+vector<unsigned> getCpuSet(const vector<CpuInfo> &topology, CpuClass cpuClass)
+{
+	vector<unsigned> cpus;
+	if (topology.empty())
+		return cpus;
+
+	unsigned minCapacity = topology.front().capacity;
+	unsigned maxCapacity = topology.front().capacity;
+	for (auto &cpu : topology)
+	{
+		minCapacity = min(minCapacity, cpu.capacity);
+		maxCapacity = max(maxCapacity, cpu.capacity);
+	}
+
+	for (auto &cpu : topology)
+	{
+		bool selected = true;
+		if (minCapacity != maxCapacity)
+		{
+			if (cpuClass == CPU_CLASS_PERFORMANCE)
+				selected = cpu.capacity > minCapacity;
+			else if (cpuClass == CPU_CLASS_EFFICIENCY)
+				selected = cpu.capacity == minCapacity;
+		}
+
+		if (selected)
+			cpus.push_back(cpu.id);
+	}
+
+	return cpus;
+}
+}
@@ -0,0 +1,83 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FRAMEWORK_CPU_TOPOLOGY_HPP
+#define FRAMEWORK_CPU_TOPOLOGY_HPP
+
+#include "common.hpp"
+#include <vector>
+
+namespace MaliSDK
+{
+
+/// @brief Describes a logical CPU in the system.
+struct CpuInfo
+{
+	/// The logical CPU index used by the operating system.
+	unsigned id;
+
+	/// The relative performance of the CPU, normalized so that the fastest CPU
+	/// in the system has a capacity of 1024.
+	unsigned capacity;
+
+	/// The cluster the CPU belongs to. CPUs in the same cluster share a
+	/// microarchitecture and typically a last level cache.
+	unsigned cluster;
+};
+
+/// @brief Classes of CPUs which work can be placed on.
+enum CpuClass
+{
+	/// All online CPUs.
+	CPU_CLASS_ALL,
+
+	/// Every CPU except the slowest class of CPUs, e.g. the big cores of a
+	/// big.LITTLE system.
+	CPU_CLASS_PERFORMANCE,
+
+	/// The slowest class of CPUs, e.g. the LITTLE cores of a big.LITTLE system.
+	CPU_CLASS_EFFICIENCY
+};
+
+/// @brief Enumerates the online CPUs in the system.
+///
+/// On Linux and Android, capacity and cluster information is read from sysfs.
+/// If the kernel does not expose `cpu_capacity`, the maximum CPU frequency is
+/// used to estimate it. If no information is available, all CPUs are reported
+/// with equal capacity in a single cluster.
+/// @returns The CPUs, sorted by CPU index.
+std::vector<CpuInfo> getCpuTopology();
+
+/// @brief Selects the CPUs which belong to a CPU class.
+///
+/// On systems where all CPUs have the same capacity, every class contains all
+/// CPUs.
+/// @param topology The topology as returned by @ref getCpuTopology.
+/// @param cpuClass The class of CPUs to select.
+/// @returns The CPU indices in the class.
+std::vector<unsigned> getCpuSet(const std::vector<CpuInfo> &topology, CpuClass cpuClass);
+
+/// @brief Restricts the calling thread to run on a set of CPUs.
+/// @param cpus The CPU indices the thread may run on.
+/// @returns Error code
+Result setCurrentThreadAffinity(const std::vector<unsigned> &cpus);
+}
+
+#endif
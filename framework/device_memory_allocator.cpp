@@ -0,0 +1,309 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "device_memory_allocator.hpp"
+#include <algorithm>
+
+using namespace std;
+
+namespace MaliSDK
+{
+DeviceMemoryAllocator::DeviceMemoryAllocator(VkDevice device, const VkPhysicalDeviceMemoryProperties &memoryProperties,
+                                             const VkPhysicalDeviceLimits &limits)
+    : device(device)
+    , memoryProperties(memoryProperties)
+    , selector(memoryProperties)
+{
+	// Allocations are powers of two and aligned to their size, so making the
+	// smallest allocation at least as large as the atom size makes every host
+	// visible allocation flushable on its own.
+	minAllocationSize = 256;
+	while (minAllocationSize < limits.nonCoherentAtomSize)
+		minAllocationSize <<= 1;
+
+	// If linear and optimal resources need to be further apart than our
+	// allocation granularity, keep them in separate blocks altogether.
+	separateOptimalResources = limits.bufferImageGranularity > minAllocationSize;
+
+	// Don't let a single block take up a large part of small heaps.
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+	{
+		VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[i].heapIndex].size;
+		VkDeviceSize blockSize = DefaultBlockSize;
+		while (blockSize > 1024 * 1024 && blockSize * 8 > heapSize)
+			blockSize >>= 1;
+		blockSizes[i] = blockSize;
+	}
+}
+
+DeviceMemoryAllocator::~DeviceMemoryAllocator()
+{
+	if (allocationCount != 0)
+		LOGE("%u device memory allocations were not freed.\n", allocationCount);
+
+	for (auto &pool : pools)
+		for (auto &pBlock : pool.blocks)
+			vkFreeMemory(device, pBlock->memory, nullptr);
+}
+
+unsigned DeviceMemoryAllocator::getOrder(VkDeviceSize size) const
+{
+	unsigned order = 0;
+	while ((minAllocationSize << order) < size)
+		order++;
+	return order;
+}
+
+VkResult DeviceMemoryAllocator::allocateBlock(unsigned poolIndex, uint32_t memoryTypeIndex, VkDeviceSize size,
+                                              bool dedicated, Block **ppBlock)
+{
+	VkMemoryAllocateInfo info = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+	info.allocationSize = size;
+	info.memoryTypeIndex = memoryTypeIndex;
+
+	// The resources in the block are accounted for as they are allocated.
+	MemoryTagScope scope(MEMORY_TAG_ALLOCATOR_BLOCK);
+
+	VkDeviceMemory memory;
+	VkResult res = vkAllocateMemory(device, &info, nullptr, &memory);
+	if (res != VK_SUCCESS)
+		return res;
+
+	// Host visible memory is mapped once for the lifetime of the block, since
+	// a memory object cannot be mapped by several allocations at once.
+	void *pMapped = nullptr;
+	if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+	{
+		res = vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &pMapped);
+		if (res != VK_SUCCESS)
+		{
+			vkFreeMemory(device, memory, nullptr);
+			return res;
+		}
+	}
+
+	unique_ptr<Block> pBlock(new Block);
+	pBlock->memory = memory;
+	pBlock->pMapped = static_cast<uint8_t *>(pMapped);
+	pBlock->size = size;
+	pBlock->poolIndex = poolIndex;
+	pBlock->dedicated = dedicated;
+
+	if (!dedicated)
+	{
+		unsigned maxOrder = getOrder(size);
+		pBlock->freeLists.resize(maxOrder + 1);
+		pBlock->freeLists[maxOrder].insert(0);
+	}
+
+	*ppBlock = pBlock.get();
+	pools[poolIndex].blocks.push_back(move(pBlock));
+	blockCount++;
+	return VK_SUCCESS;
+}
+
+void DeviceMemoryAllocator::freeBlock(Block *pBlock)
+{
+	auto &blocks = pools[pBlock->poolIndex].blocks;
+	auto itr = find_if(begin(blocks), end(blocks), [pBlock](const unique_ptr<Block> &p) { return p.get() == pBlock; });
+
+	// Freeing memory implicitly unmaps it.
+	vkFreeMemory(device, pBlock->memory, nullptr);
+	blocks.erase(itr);
+	blockCount--;
+}
+
+bool DeviceMemoryAllocator::allocateFromBlock(Block &block, unsigned order, VkDeviceSize *pOffset)
+{
+	// Find the smallest free range which fits.
+	unsigned freeOrder = order;
+	while (freeOrder < block.freeLists.size() && block.freeLists[freeOrder].empty())
+		freeOrder++;
+
+	if (freeOrder >= block.freeLists.size())
+		return false;
+
+	auto itr = block.freeLists[freeOrder].begin();
+	VkDeviceSize offset = *itr;
+	block.freeLists[freeOrder].erase(itr);
+
+	// Split it in halves until it has the right size, and keep the upper
+	// halves around as free ranges.
+	while (freeOrder > order)
+	{
+		freeOrder--;
+		block.freeLists[freeOrder].insert(offset + (minAllocationSize << freeOrder));
+	}
+
+	*pOffset = offset;
+	return true;
+}
+
+void DeviceMemoryAllocator::freeToBlock(Block &block, VkDeviceSize offset, unsigned order)
+{
+	// Merge with the buddy range for as long as it is free as well.
+	while (order + 1 < block.freeLists.size())
+	{
+		VkDeviceSize buddy = offset ^ (minAllocationSize << order);
+		auto itr = block.freeLists[order].find(buddy);
+		if (itr == end(block.freeLists[order]))
+			break;
+
+		block.freeLists[order].erase(itr);
+		offset = min(offset, buddy);
+		order++;
+	}
+
+	block.freeLists[order].insert(offset);
+}
+
+VkResult DeviceMemoryAllocator::allocate(const VkMemoryRequirements &requirements, uint32_t memoryTypeIndex,
+                                         ResourceType type, DeviceAllocation *pAllocation)
+{
+	MemoryTag tag = MemoryTagScope::getCurrentTag();
+	if (tag == MEMORY_TAG_UNKNOWN)
+		tag = type == RESOURCE_OPTIMAL ? MEMORY_TAG_TEXTURE : MEMORY_TAG_BUFFER;
+
+	lock_guard<mutex> holder{ lock };
+
+	unsigned poolIndex = memoryTypeIndex * 2 + (separateOptimalResources && type == RESOURCE_OPTIMAL ? 1 : 0);
+	VkDeviceSize blockSize = blockSizes[memoryTypeIndex];
+	unsigned order = getOrder(max(requirements.size, requirements.alignment));
+	VkDeviceSize size = minAllocationSize << order;
+
+	Block *pBlock = nullptr;
+	VkDeviceSize offset = 0;
+
+	if (size > blockSize / 2)
+	{
+		// Large resources would waste too much of a block, give them their own
+		// memory object.
+		VkResult res = allocateBlock(poolIndex, memoryTypeIndex, requirements.size, true, &pBlock);
+		if (res != VK_SUCCESS)
+			return res;
+		size = requirements.size;
+	}
+	else
+	{
+		for (auto &pCandidate : pools[poolIndex].blocks)
+		{
+			if (!pCandidate->dedicated && allocateFromBlock(*pCandidate, order, &offset))
+			{
+				pBlock = pCandidate.get();
+				break;
+			}
+		}
+
+		if (!pBlock)
+		{
+			VkResult res = allocateBlock(poolIndex, memoryTypeIndex, blockSize, false, &pBlock);
+			if (res != VK_SUCCESS)
+				return res;
+			allocateFromBlock(*pBlock, order, &offset);
+		}
+	}
+
+	pBlock->allocationCount++;
+	allocationCount++;
+
+	pAllocation->memory = pBlock->memory;
+	pAllocation->offset = offset;
+	pAllocation->size = size;
+	pAllocation->pHostPointer = pBlock->pMapped ? pBlock->pMapped + offset : nullptr;
+	pAllocation->memoryTypeIndex = memoryTypeIndex;
+	pAllocation->pBlock = pBlock;
+	pAllocation->tag = tag;
+	MemoryBudgetTracker::get().recordAllocation(tag, size);
+	return VK_SUCCESS;
+}
+
+void DeviceMemoryAllocator::free(DeviceAllocation &allocation)
+{
+	if (!allocation.isValid())
+		return;
+
+	lock_guard<mutex> holder{ lock };
+
+	Block *pBlock = static_cast<Block *>(allocation.pBlock);
+	if (!pBlock->dedicated)
+		freeToBlock(*pBlock, allocation.offset, getOrder(allocation.size));
+
+	pBlock->allocationCount--;
+	allocationCount--;
+	MemoryBudgetTracker::get().recordFree(allocation.tag, allocation.size);
+
+	if (pBlock->allocationCount == 0)
+	{
+		// Keep one empty block around per pool, so allocating and freeing a
+		// single resource repeatedly does not hit vkAllocateMemory every time.
+		unsigned sharedBlocks = 0;
+		for (auto &pCandidate : pools[pBlock->poolIndex].blocks)
+			if (!pCandidate->dedicated)
+				sharedBlocks++;
+
+		if (pBlock->dedicated || sharedBlocks > 1)
+			freeBlock(pBlock);
+	}
+
+	allocation = DeviceAllocation();
+}
+
+bool DeviceMemoryAllocator::getMappedRange(const DeviceAllocation &allocation, VkMappedMemoryRange *pRange) const
+{
+	if (!allocation.isValid() || !allocation.pHostPointer)
+		return false;
+
+	if (memoryProperties.memoryTypes[allocation.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+		return false;
+
+	const Block *pBlock = static_cast<const Block *>(allocation.pBlock);
+	*pRange = { VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE };
+	pRange->memory = allocation.memory;
+	pRange->offset = allocation.offset;
+	pRange->size = pBlock->dedicated ? VK_WHOLE_SIZE : allocation.size;
+	return true;
+}
+
+void DeviceMemoryAllocator::flush(const DeviceAllocation &allocation) const
+{
+	VkMappedMemoryRange range;
+	if (getMappedRange(allocation, &range))
+		VK_CHECK(vkFlushMappedMemoryRanges(device, 1, &range));
+}
+
+void DeviceMemoryAllocator::invalidate(const DeviceAllocation &allocation) const
+{
+	VkMappedMemoryRange range;
+	if (getMappedRange(allocation, &range))
+		VK_CHECK(vkInvalidateMappedMemoryRanges(device, 1, &range));
+}
+
+unsigned DeviceMemoryAllocator::getAllocationCount() const
+{
+	lock_guard<mutex> holder{ lock };
+	return allocationCount;
+}
+
+unsigned DeviceMemoryAllocator::getBlockCount() const
+{
+	lock_guard<mutex> holder{ lock };
+	return blockCount;
+}
+}
@@ -0,0 +1,225 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FRAMEWORK_DEVICE_MEMORY_ALLOCATOR_HPP
+#define FRAMEWORK_DEVICE_MEMORY_ALLOCATOR_HPP
+
+#include "common.hpp"
+#include "memory_budget_tracker.hpp"
+#include "memory_type_selector.hpp"
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+namespace MaliSDK
+{
+/// @brief A range of device memory handed out by @ref DeviceMemoryAllocator.
+///
+/// Resources are bound to @ref memory at @ref offset. Several allocations
+/// typically share the same `VkDeviceMemory` object.
+struct DeviceAllocation
+{
+	/// The memory object the allocation lives in.
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+
+	/// The offset of the allocation in @ref memory.
+	VkDeviceSize offset = 0;
+
+	/// The size reserved for the allocation, which can be larger than
+	/// requested.
+	VkDeviceSize size = 0;
+
+	/// If the memory type is host visible, a pointer to the start of the
+	/// allocation, otherwise `nullptr`. Host visible memory stays mapped for
+	/// the lifetime of the allocation, so `vkMapMemory` must not be called on
+	/// @ref memory.
+	void *pHostPointer = nullptr;
+
+	/// The memory type the allocation was made from.
+	uint32_t memoryTypeIndex = 0;
+
+	/// What the memory is used for, as reported to @ref MemoryBudgetTracker.
+	MemoryTag tag = MEMORY_TAG_UNKNOWN;
+
+	/// Internal, identifies the memory block the allocation belongs to.
+	void *pBlock = nullptr;
+
+	/// @brief Checks if the allocation refers to memory.
+	/// @returns true if the allocation is valid.
+	bool isValid() const
+	{
+		return memory != VK_NULL_HANDLE;
+	}
+};
+
+/// @brief Sub-allocates device memory from large blocks.
+///
+/// Drivers limit the number of live `vkAllocateMemory` allocations and every
+/// allocation is expensive, so rather than allocating memory for every buffer
+/// and image, the allocator allocates large blocks per memory type and splits
+/// them up with a buddy allocator.
+///
+/// Every allocation is aligned to its power-of-two size, which satisfies the
+/// alignment in `VkMemoryRequirements` as well as `nonCoherentAtomSize`, so
+/// host visible allocations can be flushed and invalidated on their own.
+/// Linear resources (buffers and linearly tiled images) and optimally tiled
+/// images are placed in separate blocks when the device has a
+/// `bufferImageGranularity` larger than the smallest allocation, so they
+/// never share a page.
+/// Allocations larger than half a block get a dedicated memory object.
+///
+/// Every allocation is reported to @ref MemoryBudgetTracker under the tag of
+/// the current @ref MemoryTagScope, or as a texture or buffer depending on
+/// the resource type if there is no scope.
+///
+/// The allocator is thread-safe.
+class DeviceMemoryAllocator
+{
+public:
+	/// @brief Describes how a resource uses memory, which determines which
+	/// resources can share a page.
+	enum ResourceType
+	{
+		/// Buffers and images with VK_IMAGE_TILING_LINEAR.
+		RESOURCE_LINEAR,
+
+		/// Images with VK_IMAGE_TILING_OPTIMAL.
+		RESOURCE_OPTIMAL
+	};
+
+	/// @brief The largest block size the allocator uses.
+	enum
+	{
+		DefaultBlockSize = 64 * 1024 * 1024
+	};
+
+	/// @brief Constructor
+	/// @param device The Vulkan device
+	/// @param memoryProperties The memory properties of the physical device.
+	/// @param limits The limits of the physical device.
+	DeviceMemoryAllocator(VkDevice device, const VkPhysicalDeviceMemoryProperties &memoryProperties,
+	                      const VkPhysicalDeviceLimits &limits);
+
+	/// @brief Destructor. Frees all memory blocks.
+	/// All allocations should have been freed at this point.
+	~DeviceMemoryAllocator();
+
+	/// @brief Allocates memory for a resource.
+	/// @param requirements The memory requirements of the resource.
+	/// @param memoryTypeIndex The memory type to allocate from. It must be one
+	/// of the types in `requirements.memoryTypeBits`.
+	/// @param type How the resource uses memory.
+	/// @param[out] pAllocation The allocation.
+	/// @returns The result of the underlying `vkAllocateMemory` or
+	/// `vkMapMemory` call if a new block was needed, otherwise VK_SUCCESS.
+	VkResult allocate(const VkMemoryRequirements &requirements, uint32_t memoryTypeIndex, ResourceType type,
+	                  DeviceAllocation *pAllocation);
+
+	/// @brief Allocates memory for a resource from the memory type which
+	/// @ref getMemoryTypeSelector picks for a usage.
+	/// @param requirements The memory requirements of the resource.
+	/// @param usage How the resource is accessed.
+	/// @param type How the resource uses memory.
+	/// @param[out] pAllocation The allocation.
+	/// @returns The result of the underlying `vkAllocateMemory` or
+	/// `vkMapMemory` call if a new block was needed, otherwise VK_SUCCESS.
+	VkResult allocate(const VkMemoryRequirements &requirements, MemoryTypeSelector::Usage usage, ResourceType type,
+	                  DeviceAllocation *pAllocation)
+	{
+		return allocate(requirements, selector.find(requirements.memoryTypeBits, usage), type, pAllocation);
+	}
+
+	/// @brief Gets the memory type selector for the device.
+	/// @returns The memory type selector
+	const MemoryTypeSelector &getMemoryTypeSelector() const
+	{
+		return selector;
+	}
+
+	/// @brief Frees an allocation and resets it.
+	///
+	/// The GPU must be done with the memory. To free memory which might still
+	/// be in use, use `Context::freeAllocationDeferred`.
+	/// @param allocation The allocation to free. Freeing an invalid allocation
+	/// is a no-op.
+	void free(DeviceAllocation &allocation);
+
+	/// @brief Makes host writes to an allocation visible to the device.
+	/// Only needed for memory types without VK_MEMORY_PROPERTY_HOST_COHERENT_BIT.
+	/// @param allocation The allocation to flush.
+	void flush(const DeviceAllocation &allocation) const;
+
+	/// @brief Makes device writes to an allocation visible to the host.
+	/// Only needed for memory types without VK_MEMORY_PROPERTY_HOST_COHERENT_BIT.
+	/// @param allocation The allocation to invalidate.
+	void invalidate(const DeviceAllocation &allocation) const;
+
+	/// @brief Gets the number of live allocations handed out.
+	unsigned getAllocationCount() const;
+
+	/// @brief Gets the number of `VkDeviceMemory` objects currently allocated.
+	unsigned getBlockCount() const;
+
+private:
+	struct Block
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		uint8_t *pMapped = nullptr;
+		VkDeviceSize size = 0;
+		unsigned poolIndex = 0;
+		unsigned allocationCount = 0;
+		bool dedicated = false;
+
+		// Offsets of free ranges of size minAllocationSize << order, indexed by
+		// order.
+		std::vector<std::unordered_set<VkDeviceSize>> freeLists;
+	};
+
+	struct Pool
+	{
+		std::vector<std::unique_ptr<Block>> blocks;
+	};
+
+	VkDevice device;
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	MemoryTypeSelector selector;
+	VkDeviceSize minAllocationSize;
+	bool separateOptimalResources;
+
+	// Indexed by memory type index * 2 + resource type.
+	Pool pools[VK_MAX_MEMORY_TYPES * 2];
+	VkDeviceSize blockSizes[VK_MAX_MEMORY_TYPES];
+	unsigned allocationCount = 0;
+	unsigned blockCount = 0;
+
+	mutable std::mutex lock;
+
+	VkResult allocateBlock(unsigned poolIndex, uint32_t memoryTypeIndex, VkDeviceSize size, bool dedicated,
+	                       Block **ppBlock);
+	void freeBlock(Block *pBlock);
+	bool allocateFromBlock(Block &block, unsigned order, VkDeviceSize *pOffset);
+	void freeToBlock(Block &block, VkDeviceSize offset, unsigned order);
+	unsigned getOrder(VkDeviceSize size) const;
+	bool getMappedRange(const DeviceAllocation &allocation, VkMappedMemoryRange *pRange) const;
+};
+}
+
+#endif
@@ -19,6 +19,9 @@
  */
 
 #include "fence_manager.hpp"
+#include <chrono>
+
+using namespace std;
 
 namespace MaliSDK
 {
@@ -37,29 +40,60 @@ FenceManager::~FenceManager()
 
 void FenceManager::beginFrame()
 {
-	// If we have outstanding fences for this swapchain image, wait for them to
+	stallTime = 0.0;
+
+	// If we have outstanding fences for this frame slot, wait for them to
 	// complete first.
 	// Normally, this doesn't really block at all,
 	// since we're waiting for old frames to have been completed, but just in
-	// case.
-	if (count != 0)
+	// case. Polling first means we only measure a stall if there is one.
+	if (!activeFences.empty())
 	{
-		vkWaitForFences(device, count, fences.data(), true, UINT64_MAX);
-		vkResetFences(device, count, fences.data());
+		if (!isComplete())
+			wait(UINT64_MAX);
+		if (count != 0)
+			vkResetFences(device, count, fences.data());
 	}
 	count = 0;
+	activeFences.clear();
+}
+
+unsigned FenceManager::getCompletedFenceCount() const
+{
+	unsigned completed = 0;
+	while (completed < activeFences.size() && vkGetFenceStatus(device, activeFences[completed]) == VK_SUCCESS)
+		completed++;
+	return completed;
+}
+
+bool FenceManager::wait(uint64_t timeout)
+{
+	if (activeFences.empty())
+		return true;
+
+	auto start = chrono::steady_clock::now();
+	VkResult res = vkWaitForFences(device, activeFences.size(), activeFences.data(), true, timeout);
+	stallTime += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	return res == VK_SUCCESS;
 }
 
 VkFence FenceManager::requestClearedFence()
 {
-	if (count < fences.size())
-		return fences[count++];
+	if (count == fences.size())
+	{
+		VkFence fence;
+		VkFenceCreateInfo info = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+		VK_CHECK(vkCreateFence(device, &info, nullptr, &fence));
+		fences.push_back(fence);
+	}
 
-	VkFence fence;
-	VkFenceCreateInfo info = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
-	VK_CHECK(vkCreateFence(device, &info, nullptr, &fence));
-	fences.push_back(fence);
-	count++;
+	VkFence fence = fences[count++];
+	activeFences.push_back(fence);
 	return fence;
 }
+
+void FenceManager::addExternalFence(VkFence fence)
+{
+	activeFences.push_back(fence);
+}
 }
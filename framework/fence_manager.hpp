@@ -51,17 +51,60 @@ public:
 	/// We wait for fences which completes N frames earlier, so we do not stall,
 	/// waiting
 	/// for all GPU work to complete before this returns.
+	/// The time spent waiting is reported by @ref getStallTime.
 	void beginFrame();
 
+	/// @brief Checks how far the GPU has progressed without blocking.
+	///
+	/// Fences are signalled in submission order, so the result is the number
+	/// of submissions, counted from the first one, which have completed.
+	/// @returns The number of signalled fences, in range [0, @ref
+	/// getActiveFenceCount].
+	unsigned getCompletedFenceCount() const;
+
+	/// @brief Checks whether the GPU has completed all outstanding fences
+	/// without blocking.
+	/// @returns true if @ref beginFrame would not block.
+	bool isComplete() const
+	{
+		return getCompletedFenceCount() == activeFences.size();
+	}
+
+	/// @brief Waits for all outstanding fences with a timeout.
+	///
+	/// The time spent waiting is added to @ref getStallTime.
+	/// @param timeout The timeout in nanoseconds.
+	/// @returns true if all fences signalled, false if the timeout expired.
+	bool wait(uint64_t timeout);
+
+	/// @brief Gets the time the CPU spent blocked on fences since the last
+	/// call to @ref beginFrame started, including the wait in @ref beginFrame
+	/// itself.
+	/// @returns The stall time in seconds.
+	double getStallTime() const
+	{
+		return stallTime;
+	}
+
 	/// @brief Called internally by the Context whenever submissions to GPU
 	/// happens.
 	VkFence requestClearedFence();
 
+	/// @brief Tracks a fence which is owned by someone else, but signalled by
+	/// a submission of this frame.
+	///
+	/// The fence is waited for like the fences of the frame, but it is never
+	/// reset or destroyed here. The owner must keep it alive until the next
+	/// @ref beginFrame, or until the manager is destroyed, and may only reset it
+	/// right before submitting it again.
+	/// @param fence The fence.
+	void addExternalFence(VkFence fence);
+
 	/// @brief Gets the number of fences which are inFlight on the GPU.
 	/// @returns The number of fences which can be waited for.
 	unsigned getActiveFenceCount() const
 	{
-		return count;
+		return activeFences.size();
 	}
 
 	/// @brief Gets an array for the fences which are inFlight on the GPU.
@@ -69,13 +112,17 @@ public:
 	/// number of fences.
 	VkFence *getActiveFences()
 	{
-		return fences.data();
+		return activeFences.data();
 	}
 
 private:
 	VkDevice device = VK_NULL_HANDLE;
+	// Fences owned by the manager, the first count of which are in flight.
 	std::vector<VkFence> fences;
 	unsigned count = 0;
+	// All fences in flight, including external ones, in submission order.
+	std::vector<VkFence> activeFences;
+	double stallTime = 0.0;
 };
 }
 
@@ -0,0 +1,139 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FRAMEWORK_INLINE_FUNCTION_HPP
+#define FRAMEWORK_INLINE_FUNCTION_HPP
+
+#include <new>
+#include <stddef.h>
+#include <type_traits>
+#include <utility>
+
+namespace MaliSDK
+{
+template <typename Signature, size_t Capacity>
+class InlineFunction;
+
+/// @brief A move-only function object with fixed inline storage.
+///
+/// Unlike `std::function`, this never allocates memory. Function objects which
+/// do not fit in Capacity bytes are rejected at compile time.
+/// This makes it suitable for submitting work in hot paths, e.g. to the
+/// @ref ThreadPool every frame.
+template <typename R, typename... Args, size_t Capacity>
+class InlineFunction<R(Args...), Capacity>
+{
+public:
+	/// @brief Constructs an empty function object.
+	InlineFunction() = default;
+
+	/// @brief Constructs a function object from a callable.
+	/// @param func The callable. Must fit in Capacity bytes.
+	template <typename Func, typename = typename std::enable_if<
+	                             !std::is_same<typename std::decay<Func>::type, InlineFunction>::value>::type>
+	InlineFunction(Func &&func)
+	{
+		typedef typename std::decay<Func>::type Stored;
+		static_assert(sizeof(Stored) <= Capacity, "Function object is too large for InlineFunction.");
+		static_assert(alignof(Stored) <= alignof(Storage), "Function object is over-aligned for InlineFunction.");
+
+		new (&storage) Stored(std::forward<Func>(func));
+		pInvoke = &invoke<Stored>;
+		pManage = &manage<Stored>;
+	}
+
+	/// @brief Move constructor.
+	InlineFunction(InlineFunction &&other)
+	{
+		*this = std::move(other);
+	}
+
+	/// @brief Move assignment. Leaves other empty.
+	InlineFunction &operator=(InlineFunction &&other)
+	{
+		if (this != &other)
+		{
+			reset();
+			if (other.pManage)
+			{
+				other.pManage(&storage, &other.storage);
+				pInvoke = other.pInvoke;
+				pManage = other.pManage;
+				other.reset();
+			}
+		}
+		return *this;
+	}
+
+	InlineFunction(const InlineFunction &) = delete;
+	void operator=(const InlineFunction &) = delete;
+
+	/// @brief Destructor
+	~InlineFunction()
+	{
+		reset();
+	}
+
+	/// @brief Destroys the held callable, if any.
+	void reset()
+	{
+		if (pManage)
+			pManage(nullptr, &storage);
+		pInvoke = nullptr;
+		pManage = nullptr;
+	}
+
+	/// @brief Returns true if a callable is held.
+	explicit operator bool() const
+	{
+		return pInvoke != nullptr;
+	}
+
+	/// @brief Calls the held callable.
+	R operator()(Args... args)
+	{
+		return pInvoke(&storage, std::forward<Args>(args)...);
+	}
+
+private:
+	typedef typename std::aligned_storage<Capacity>::type Storage;
+	Storage storage;
+	R (*pInvoke)(void *, Args...) = nullptr;
+	// Moves src into dst if dst is not null, otherwise destroys src.
+	void (*pManage)(void *, void *) = nullptr;
+
+	template <typename Stored>
+	static R invoke(void *pStorage, Args... args)
+	{
+		return (*static_cast<Stored *>(pStorage))(std::forward<Args>(args)...);
+	}
+
+	template <typename Stored>
+	static void manage(void *pDst, void *pSrc)
+	{
+		if (pDst)
+			new (pDst) Stored(std::move(*static_cast<Stored *>(pSrc)));
+		else
+			static_cast<Stored *>(pSrc)->~Stored();
+	}
+};
+}
+
+#endif
@@ -0,0 +1,280 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "ktx2_texture.hpp"
+#include "astc_decoder.hpp"
+#include "platform/os.hpp"
+#include <algorithm>
+#include <string.h>
+
+using namespace std;
+
+namespace MaliSDK
+{
+namespace
+{
+/// The header of a KTX2 file, which is followed by the level index. Like
+/// all platforms the SDK runs on, KTX2 is little endian, so the header is
+/// read as it is.
+struct KTX2Header
+{
+	uint8_t identifier[12];
+	uint32_t vkFormat;
+	uint32_t typeSize;
+	uint32_t pixelWidth;
+	uint32_t pixelHeight;
+	uint32_t pixelDepth;
+	uint32_t layerCount;
+	uint32_t faceCount;
+	uint32_t levelCount;
+	uint32_t supercompressionScheme;
+	uint32_t dfdByteOffset;
+	uint32_t dfdByteLength;
+	uint32_t kvdByteOffset;
+	uint32_t kvdByteLength;
+	uint64_t sgdByteOffset;
+	uint64_t sgdByteLength;
+};
+static_assert(sizeof(KTX2Header) == 80, "Unexpected KTX2 header size.");
+
+/// Where a mip level is stored in a KTX2 file.
+struct KTX2LevelIndex
+{
+	uint64_t byteOffset;
+	uint64_t byteLength;
+	uint64_t uncompressedByteLength;
+};
+static_assert(sizeof(KTX2LevelIndex) == 24, "Unexpected KTX2 level index size.");
+
+/// Formats with the same block size are consecutive in VkFormat.
+struct FormatRange
+{
+	VkFormat first;
+	VkFormat last;
+	uint8_t blockWidth;
+	uint8_t blockHeight;
+	uint8_t blockSize;
+};
+
+const FormatRange FormatRanges[] = {
+	{ VK_FORMAT_R4G4_UNORM_PACK8, VK_FORMAT_R4G4_UNORM_PACK8, 1, 1, 1 },
+	{ VK_FORMAT_R4G4B4A4_UNORM_PACK16, VK_FORMAT_A1R5G5B5_UNORM_PACK16, 1, 1, 2 },
+	{ VK_FORMAT_R8_UNORM, VK_FORMAT_R8_SRGB, 1, 1, 1 },
+	{ VK_FORMAT_R8G8_UNORM, VK_FORMAT_R8G8_SRGB, 1, 1, 2 },
+	{ VK_FORMAT_R8G8B8_UNORM, VK_FORMAT_B8G8R8_SRGB, 1, 1, 3 },
+	{ VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_A2B10G10R10_SINT_PACK32, 1, 1, 4 },
+	{ VK_FORMAT_R16_UNORM, VK_FORMAT_R16_SFLOAT, 1, 1, 2 },
+	{ VK_FORMAT_R16G16_UNORM, VK_FORMAT_R16G16_SFLOAT, 1, 1, 4 },
+	{ VK_FORMAT_R16G16B16_UNORM, VK_FORMAT_R16G16B16_SFLOAT, 1, 1, 6 },
+	{ VK_FORMAT_R16G16B16A16_UNORM, VK_FORMAT_R16G16B16A16_SFLOAT, 1, 1, 8 },
+	{ VK_FORMAT_R32_UINT, VK_FORMAT_R32_SFLOAT, 1, 1, 4 },
+	{ VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32_SFLOAT, 1, 1, 8 },
+	{ VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32_SFLOAT, 1, 1, 12 },
+	{ VK_FORMAT_R32G32B32A32_UINT, VK_FORMAT_R32G32B32A32_SFLOAT, 1, 1, 16 },
+	{ VK_FORMAT_R64_UINT, VK_FORMAT_R64_SFLOAT, 1, 1, 8 },
+	{ VK_FORMAT_R64G64_UINT, VK_FORMAT_R64G64_SFLOAT, 1, 1, 16 },
+	{ VK_FORMAT_R64G64B64_UINT, VK_FORMAT_R64G64B64_SFLOAT, 1, 1, 24 },
+	{ VK_FORMAT_R64G64B64A64_UINT, VK_FORMAT_R64G64B64A64_SFLOAT, 1, 1, 32 },
+	{ VK_FORMAT_B10G11R11_UFLOAT_PACK32, VK_FORMAT_E5B9G9R9_UFLOAT_PACK32, 1, 1, 4 },
+	{ VK_FORMAT_BC1_RGB_UNORM_BLOCK, VK_FORMAT_BC1_RGBA_SRGB_BLOCK, 4, 4, 8 },
+	{ VK_FORMAT_BC2_UNORM_BLOCK, VK_FORMAT_BC3_SRGB_BLOCK, 4, 4, 16 },
+	{ VK_FORMAT_BC4_UNORM_BLOCK, VK_FORMAT_BC4_SNORM_BLOCK, 4, 4, 8 },
+	{ VK_FORMAT_BC5_UNORM_BLOCK, VK_FORMAT_BC7_SRGB_BLOCK, 4, 4, 16 },
+	{ VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK, 4, 4, 8 },
+	{ VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK, 4, 4, 16 },
+	{ VK_FORMAT_EAC_R11_UNORM_BLOCK, VK_FORMAT_EAC_R11_SNORM_BLOCK, 4, 4, 8 },
+	{ VK_FORMAT_EAC_R11G11_UNORM_BLOCK, VK_FORMAT_EAC_R11G11_SNORM_BLOCK, 4, 4, 16 },
+};
+}
+
+bool getFormatBlockInfo(VkFormat format, unsigned *pBlockWidth, unsigned *pBlockHeight, unsigned *pBlockSize)
+{
+	if (getASTCBlockSize(format, pBlockWidth, pBlockHeight))
+	{
+		*pBlockSize = 16;
+		return true;
+	}
+
+	for (auto &range : FormatRanges)
+	{
+		if (format >= range.first && format <= range.last)
+		{
+			*pBlockWidth = range.blockWidth;
+			*pBlockHeight = range.blockHeight;
+			*pBlockSize = range.blockSize;
+			return true;
+		}
+	}
+	return false;
+}
+
+Result loadKTX2TextureFromAsset(const char *pPath, KTX2Texture *pTexture)
+{
+	AssetData file;
+	if (FAILED(OS::getAssetManager().mapBinaryFile(pPath, &file)))
+	{
+		LOGE("Failed to read KTX2 texture: %s.\n", pPath);
+		return RESULT_ERROR_IO;
+	}
+
+	static const uint8_t Identifier[12] = { 0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n' };
+	KTX2Header header;
+	if (file.getSize() < sizeof(header) || memcmp(file.getData(), Identifier, sizeof(Identifier)) != 0)
+	{
+		LOGE("Texture %s is not KTX2.\n", pPath);
+		return RESULT_ERROR_GENERIC;
+	}
+	memcpy(&header, file.getData(), sizeof(header));
+
+	if (header.supercompressionScheme != 0)
+	{
+		LOGE("KTX2 texture %s is supercompressed, which is not supported.\n", pPath);
+		return RESULT_ERROR_GENERIC;
+	}
+
+	VkFormat format = VkFormat(header.vkFormat);
+	unsigned blockWidth, blockHeight, blockSize;
+	if (!getFormatBlockInfo(format, &blockWidth, &blockHeight, &blockSize))
+	{
+		LOGE("KTX2 texture %s has unsupported format %u.\n", pPath, header.vkFormat);
+		return RESULT_ERROR_GENERIC;
+	}
+
+	// Dimensions which are zero are not used, e.g. a pixelDepth of zero means
+	// the texture is not 3D. Cube maps are square and Vulkan has no 3D arrays.
+	bool is1D = header.pixelHeight == 0;
+	bool is3D = header.pixelDepth != 0;
+	bool isArray = header.layerCount != 0;
+	bool isCube = header.faceCount == 6;
+	if (header.pixelWidth == 0 || (is1D && is3D) || (is3D && isArray) || (header.faceCount != 1 && !isCube) ||
+	    (isCube && (header.pixelWidth != header.pixelHeight || is3D)) || (is1D && blockHeight != 1))
+	{
+		LOGE("KTX2 texture %s has invalid dimensions.\n", pPath);
+		return RESULT_ERROR_GENERIC;
+	}
+
+	unsigned width = header.pixelWidth;
+	unsigned height = max(header.pixelHeight, 1u);
+	unsigned depth = max(header.pixelDepth, 1u);
+	unsigned layers = max(header.layerCount, 1u) * header.faceCount;
+
+	// A level count of zero asks the loader to generate the mip chain, which
+	// is what KTX2 files are meant to avoid, so only the first level is used.
+	unsigned levels = max(header.levelCount, 1u);
+	unsigned maxLevels = 1;
+	while ((max(max(width, height), depth) >> maxLevels) != 0)
+		maxLevels++;
+	if (levels > maxLevels)
+	{
+		LOGE("KTX2 texture %s has more mip levels than its size allows.\n", pPath);
+		return RESULT_ERROR_GENERIC;
+	}
+
+	if (file.getSize() < sizeof(header) + levels * sizeof(KTX2LevelIndex))
+	{
+		LOGE("KTX2 texture %s is truncated.\n", pPath);
+		return RESULT_ERROR_GENERIC;
+	}
+
+	vector<KTX2LevelIndex> levelIndex(levels);
+	memcpy(levelIndex.data(), static_cast<const uint8_t *>(file.getData()) + sizeof(header),
+	       levels * sizeof(KTX2LevelIndex));
+
+	// The smallest level is stored first. The data of the texture is
+	// everything from the first level to the end of the last one.
+	uint64_t dataBegin = UINT64_MAX;
+	uint64_t dataEnd = 0;
+	for (auto &level : levelIndex)
+	{
+		if (level.byteOffset > file.getSize() || level.byteLength > file.getSize() - level.byteOffset)
+		{
+			LOGE("KTX2 texture %s is truncated.\n", pPath);
+			return RESULT_ERROR_GENERIC;
+		}
+		dataBegin = min(dataBegin, level.byteOffset);
+		dataEnd = max(dataEnd, level.byteOffset + level.byteLength);
+	}
+
+	// Within a level, the images of all layers and faces are tightly packed
+	// in the order Vulkan numbers array layers in, so one copy covers them.
+	vector<VkBufferImageCopy> regions(levels);
+	for (unsigned level = 0; level < levels; level++)
+	{
+		unsigned levelWidth = max(width >> level, 1u);
+		unsigned levelHeight = max(height >> level, 1u);
+		unsigned levelDepth = max(depth >> level, 1u);
+		uint64_t blocks = uint64_t((levelWidth + blockWidth - 1) / blockWidth) *
+		                  ((levelHeight + blockHeight - 1) / blockHeight) * levelDepth;
+		if (levelIndex[level].byteLength != blocks * blockSize * layers)
+		{
+			LOGE("Mip level %u of KTX2 texture %s has the wrong size.\n", level, pPath);
+			return RESULT_ERROR_GENERIC;
+		}
+
+		// Copies need offsets which are multiples of the block size and of 4.
+		uint64_t offset = levelIndex[level].byteOffset - dataBegin;
+		if (offset % 4 != 0 || offset % blockSize != 0)
+		{
+			LOGE("Mip level %u of KTX2 texture %s is not aligned.\n", level, pPath);
+			return RESULT_ERROR_GENERIC;
+		}
+
+		VkBufferImageCopy &region = regions[level];
+		region.bufferOffset = offset;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = level;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = layers;
+		region.imageExtent.width = levelWidth;
+		region.imageExtent.height = levelHeight;
+		region.imageExtent.depth = levelDepth;
+	}
+
+	pTexture->format = format;
+	pTexture->blockSize = blockSize;
+	if (is3D)
+	{
+		pTexture->imageType = VK_IMAGE_TYPE_3D;
+		pTexture->viewType = VK_IMAGE_VIEW_TYPE_3D;
+	}
+	else if (is1D)
+	{
+		pTexture->imageType = VK_IMAGE_TYPE_1D;
+		pTexture->viewType = isArray ? VK_IMAGE_VIEW_TYPE_1D_ARRAY : VK_IMAGE_VIEW_TYPE_1D;
+	}
+	else
+	{
+		pTexture->imageType = VK_IMAGE_TYPE_2D;
+		if (isCube)
+			pTexture->viewType = isArray ? VK_IMAGE_VIEW_TYPE_CUBE_ARRAY : VK_IMAGE_VIEW_TYPE_CUBE;
+		else
+			pTexture->viewType = isArray ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+	}
+	pTexture->flags = isCube ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
+	pTexture->extent.width = width;
+	pTexture->extent.height = height;
+	pTexture->extent.depth = depth;
+	pTexture->mipLevels = levels;
+	pTexture->arrayLayers = layers;
+	pTexture->data = file.getSubData(dataBegin, dataEnd - dataBegin);
+	pTexture->regions = move(regions);
+	return RESULT_SUCCESS;
+}
+}
@@ -0,0 +1,111 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FRAMEWORK_KTX2_TEXTURE_HPP
+#define FRAMEWORK_KTX2_TEXTURE_HPP
+
+#include "common.hpp"
+#include "libvulkan-stub.h"
+#include "platform/asset_manager.hpp"
+#include <vector>
+
+namespace MaliSDK
+{
+/// @brief A texture loaded from a KTX2 container with all of its mip levels,
+/// array layers and cube faces.
+///
+/// The texel data is a view of the asset and the regions describe where
+/// every subresource lies in it, so the whole texture is uploaded with one
+/// call:
+///
+/// @code
+/// uploads.uploadImage(image, texture.getSubresourceRange(), layout, texture.data.getData(),
+///                     texture.data.getSize(), texture.regions.data(), texture.regions.size(),
+///                     texture.blockSize);
+/// @endcode
+struct KTX2Texture
+{
+	/// The format of the texture. Any uncompressed color format, or a BC,
+	/// ETC2, EAC or ASTC block format.
+	VkFormat format = VK_FORMAT_UNDEFINED;
+
+	/// The size of a texel, or of a block of texels for compressed formats,
+	/// in bytes.
+	unsigned blockSize = 0;
+
+	/// The image type, which follows from the dimensions of the texture.
+	VkImageType imageType = VK_IMAGE_TYPE_2D;
+
+	/// The view type which covers all layers and faces of the texture.
+	VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D;
+
+	/// VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT for cube maps.
+	VkImageCreateFlags flags = 0;
+
+	/// The size of the first mip level.
+	VkExtent3D extent = {};
+
+	/// The number of mip levels.
+	unsigned mipLevels = 0;
+
+	/// The number of array layers of the image. Cube maps have six layers,
+	/// one for every face, for each layer of the texture.
+	unsigned arrayLayers = 0;
+
+	/// The texel data of all mip levels.
+	AssetData data;
+
+	/// One copy for every mip level, which covers all of its layers. The
+	/// buffer offsets are relative to the start of @ref data.
+	std::vector<VkBufferImageCopy> regions;
+
+	/// @brief Gets the subresources of the texture.
+	/// @returns All mip levels and array layers.
+	VkImageSubresourceRange getSubresourceRange() const
+	{
+		return { VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, arrayLayers };
+	}
+};
+
+/// @brief Gets the size of the texel blocks of a format.
+/// @param format A color format.
+/// @param[out] pBlockWidth The width of a block in texels, 1 for
+/// uncompressed formats.
+/// @param[out] pBlockHeight The height of a block in texels.
+/// @param[out] pBlockSize The size of a block in bytes.
+/// @returns false if the format is not supported.
+bool getFormatBlockInfo(VkFormat format, unsigned *pBlockWidth, unsigned *pBlockHeight, unsigned *pBlockSize);
+
+/// @brief Loads a texture from a KTX2 container in assets without copying
+/// the texel data.
+///
+/// KTX2 files with a full mip chain, texture arrays and cube maps can be
+/// created offline, e.g. with `toktx` from KTX-Software, so that none of it
+/// has to be generated at startup. Textures which do not specify their
+/// number of mip levels get one level. Supercompressed files, and Basis
+/// Universal files which need transcoding, are not supported.
+///
+/// @param pPath Path to the texture.
+/// @param[out] pTexture The loaded texture.
+/// @returns Error code
+Result loadKTX2TextureFromAsset(const char *pPath, KTX2Texture *pTexture);
+}
+
+#endif
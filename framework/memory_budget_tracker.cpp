@@ -0,0 +1,241 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "memory_budget_tracker.hpp"
+
+using namespace std;
+
+namespace MaliSDK
+{
+static thread_local MemoryTag currentTag = MEMORY_TAG_UNKNOWN;
+
+const char *getMemoryTagName(MemoryTag tag)
+{
+	switch (tag)
+	{
+	case MEMORY_TAG_TEXTURE:
+		return "texture";
+	case MEMORY_TAG_BUFFER:
+		return "buffer";
+	case MEMORY_TAG_ATTACHMENT:
+		return "attachment";
+	case MEMORY_TAG_SWAPCHAIN:
+		return "swapchain";
+	case MEMORY_TAG_STAGING:
+		return "staging";
+	case MEMORY_TAG_UNIFORM:
+		return "uniform";
+	case MEMORY_TAG_ALLOCATOR_BLOCK:
+		return "allocator block";
+	default:
+		return "unknown";
+	}
+}
+
+MemoryTagScope::MemoryTagScope(MemoryTag tag)
+    : previous(currentTag)
+{
+	currentTag = tag;
+}
+
+MemoryTagScope::~MemoryTagScope()
+{
+	currentTag = previous;
+}
+
+MemoryTag MemoryTagScope::getCurrentTag()
+{
+	return currentTag;
+}
+
+MemoryBudgetTracker &MemoryBudgetTracker::get()
+{
+	static MemoryBudgetTracker tracker;
+	return tracker;
+}
+
+void MemoryBudgetTracker::install(const VkPhysicalDeviceMemoryProperties &properties)
+{
+	lock_guard<mutex> holder{ lock };
+
+	// Hooking twice would make the hooks call themselves. If the device symbols
+	// were reloaded since the last call, the hooks are gone and are installed
+	// again.
+	if (vulkanSymbolWrapper_vkAllocateMemory == allocateMemory)
+		return;
+
+	memoryProperties = properties;
+	for (uint32_t i = 0; i < VK_MAX_MEMORY_HEAPS; i++)
+	{
+		heaps[i] = {};
+		heaps[i].size = i < memoryProperties.memoryHeapCount ? memoryProperties.memoryHeaps[i].size : 0;
+		heapWarned[i] = false;
+	}
+	for (auto &tag : tags)
+		tag = {};
+	objects.clear();
+
+	pfnAllocateMemory = vulkanSymbolWrapper_vkAllocateMemory;
+	pfnFreeMemory = vulkanSymbolWrapper_vkFreeMemory;
+	vulkanSymbolWrapper_vkAllocateMemory = allocateMemory;
+	vulkanSymbolWrapper_vkFreeMemory = freeMemory;
+}
+
+void MemoryBudgetTracker::uninstall()
+{
+	lock_guard<mutex> holder{ lock };
+	if (!pfnAllocateMemory)
+		return;
+
+	vulkanSymbolWrapper_vkAllocateMemory = pfnAllocateMemory;
+	vulkanSymbolWrapper_vkFreeMemory = pfnFreeMemory;
+	pfnAllocateMemory = nullptr;
+	pfnFreeMemory = nullptr;
+}
+
+void MemoryBudgetTracker::addToTag(MemoryTag tag, VkDeviceSize size)
+{
+	TagStats &stats = tags[tag];
+	stats.allocated += size;
+	stats.allocationCount++;
+	if (stats.allocated > stats.peak)
+		stats.peak = stats.allocated;
+}
+
+void MemoryBudgetTracker::removeFromTag(MemoryTag tag, VkDeviceSize size)
+{
+	TagStats &stats = tags[tag];
+	stats.allocated -= size;
+	stats.allocationCount--;
+}
+
+void MemoryBudgetTracker::recordAllocation(MemoryTag tag, VkDeviceSize size)
+{
+	lock_guard<mutex> holder{ lock };
+	addToTag(tag, size);
+}
+
+void MemoryBudgetTracker::recordFree(MemoryTag tag, VkDeviceSize size)
+{
+	lock_guard<mutex> holder{ lock };
+	removeFromTag(tag, size);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL MemoryBudgetTracker::allocateMemory(VkDevice device,
+                                                                   const VkMemoryAllocateInfo *pAllocateInfo,
+                                                                   const VkAllocationCallbacks *pAllocator,
+                                                                   VkDeviceMemory *pMemory)
+{
+	MemoryBudgetTracker &tracker = get();
+	VkResult res = tracker.pfnAllocateMemory(device, pAllocateInfo, pAllocator, pMemory);
+
+	uint32_t heapIndex = tracker.memoryProperties.memoryTypes[pAllocateInfo->memoryTypeIndex].heapIndex;
+	VkDeviceSize size = pAllocateInfo->allocationSize;
+
+	lock_guard<mutex> holder{ tracker.lock };
+	HeapStats &heap = tracker.heaps[heapIndex];
+
+	if (res != VK_SUCCESS)
+	{
+		LOGE("Failed to allocate %u KiB from heap %u with %u KiB allocated.\n", unsigned(size / 1024), heapIndex,
+		     unsigned(heap.allocated / 1024));
+		return res;
+	}
+
+	MemoryObject object = { size, heapIndex, currentTag };
+	tracker.objects[*pMemory] = object;
+	tracker.addToTag(object.tag, size);
+
+	heap.allocated += size;
+	heap.objectCount++;
+	if (heap.allocated > heap.peak)
+		heap.peak = heap.allocated;
+
+	// Heaps are typically shared with the rest of the system, so running
+	// close to their size is likely to fail or to cause paging.
+	if (!tracker.heapWarned[heapIndex] && heap.allocated > heap.size / 4 * 3)
+	{
+		LOGI("Heap %u has %u of %u MiB allocated.\n", heapIndex, unsigned(heap.allocated >> 20),
+		     unsigned(heap.size >> 20));
+		tracker.heapWarned[heapIndex] = true;
+	}
+
+	return res;
+}
+
+VKAPI_ATTR void VKAPI_CALL MemoryBudgetTracker::freeMemory(VkDevice device, VkDeviceMemory memory,
+                                                           const VkAllocationCallbacks *pAllocator)
+{
+	MemoryBudgetTracker &tracker = get();
+	tracker.pfnFreeMemory(device, memory, pAllocator);
+
+	if (memory == VK_NULL_HANDLE)
+		return;
+
+	lock_guard<mutex> holder{ tracker.lock };
+	auto itr = tracker.objects.find(memory);
+	if (itr == end(tracker.objects))
+		return;
+
+	const MemoryObject &object = itr->second;
+	HeapStats &heap = tracker.heaps[object.heapIndex];
+	heap.allocated -= object.size;
+	heap.objectCount--;
+	tracker.removeFromTag(object.tag, object.size);
+	tracker.objects.erase(itr);
+}
+
+MemoryBudgetTracker::HeapStats MemoryBudgetTracker::getHeapStats(uint32_t heapIndex) const
+{
+	lock_guard<mutex> holder{ lock };
+	return heaps[heapIndex];
+}
+
+MemoryBudgetTracker::TagStats MemoryBudgetTracker::getTagStats(MemoryTag tag) const
+{
+	lock_guard<mutex> holder{ lock };
+	return tags[tag];
+}
+
+void MemoryBudgetTracker::report() const
+{
+	lock_guard<mutex> holder{ lock };
+
+	LOGI("Device memory usage per heap:\n");
+	for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+	{
+		const HeapStats &heap = heaps[i];
+		LOGI("  Heap %u%s: %u KiB in %u objects, peak %u KiB (%.1f%% of %u MiB).\n", i,
+		     (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? " (device local)" : "",
+		     unsigned(heap.allocated / 1024), heap.objectCount, unsigned(heap.peak / 1024),
+		     heap.size ? 100.0 * double(heap.peak) / double(heap.size) : 0.0, unsigned(heap.size >> 20));
+	}
+
+	LOGI("Device memory usage per tag:\n");
+	for (unsigned i = 0; i < MEMORY_TAG_COUNT; i++)
+	{
+		const TagStats &tag = tags[i];
+		if (tag.peak == 0)
+			continue;
+		LOGI("  %s: %u KiB in %u allocations, peak %u KiB.\n", getMemoryTagName(MemoryTag(i)),
+		     unsigned(tag.allocated / 1024), tag.allocationCount, unsigned(tag.peak / 1024));
+	}
+}
+}
@@ -0,0 +1,207 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FRAMEWORK_MEMORY_BUDGET_TRACKER_HPP
+#define FRAMEWORK_MEMORY_BUDGET_TRACKER_HPP
+
+#include "framework/common.hpp"
+#include <mutex>
+#include <unordered_map>
+
+namespace MaliSDK
+{
+/// @brief What device memory is used for.
+enum MemoryTag
+{
+	/// Memory which nobody said what it is for.
+	MEMORY_TAG_UNKNOWN,
+
+	/// Optimally tiled images, such as textures.
+	MEMORY_TAG_TEXTURE,
+
+	/// Buffers and linearly tiled images.
+	MEMORY_TAG_BUFFER,
+
+	/// Attachments which only live during a render pass.
+	MEMORY_TAG_ATTACHMENT,
+
+	/// Swapchain images which are allocated by the application.
+	MEMORY_TAG_SWAPCHAIN,
+
+	/// Staging memory for uploads.
+	MEMORY_TAG_STAGING,
+
+	/// Uniform data which is rewritten every frame.
+	MEMORY_TAG_UNIFORM,
+
+	/// Memory blocks allocated by @ref DeviceMemoryAllocator. The resources
+	/// in them are accounted for under their own tags.
+	MEMORY_TAG_ALLOCATOR_BLOCK,
+
+	MEMORY_TAG_COUNT
+};
+
+/// @brief Gets a human readable name of a tag.
+/// @param tag The tag.
+/// @returns The name
+const char *getMemoryTagName(MemoryTag tag);
+
+/// @brief Sets the tag which memory allocated on the current thread is
+/// attributed to, for as long as the scope lives. Scopes nest.
+class MemoryTagScope
+{
+public:
+	/// @brief Constructor
+	/// @param tag The tag to attribute memory to.
+	MemoryTagScope(MemoryTag tag);
+
+	/// @brief Destructor. Restores the previous tag.
+	~MemoryTagScope();
+
+	/// @brief Gets the tag of the innermost scope on the current thread.
+	/// @returns The tag, MEMORY_TAG_UNKNOWN if there is no scope.
+	static MemoryTag getCurrentTag();
+
+private:
+	MemoryTag previous;
+
+	MemoryTagScope(const MemoryTagScope &) = delete;
+	MemoryTagScope &operator=(const MemoryTagScope &) = delete;
+};
+
+/// @brief Tracks how much device memory is allocated per heap and what it is
+/// used for.
+///
+/// Once installed, every `vkAllocateMemory` and `vkFreeMemory` call goes
+/// through the tracker, which replaces the loader's
+/// `vulkanSymbolWrapper_vkAllocateMemory` and
+/// `vulkanSymbolWrapper_vkFreeMemory` function pointers. Memory objects are
+/// accounted for per heap and compared against `memoryHeaps[].size`, and
+/// a warning is logged the first time a heap gets close to its size.
+///
+/// Since most resources are sub-allocated from large memory blocks,
+/// @ref DeviceMemoryAllocator also reports every sub-allocation, which is
+/// attributed to the tag of the current @ref MemoryTagScope. Without a scope,
+/// optimally tiled images count as textures and everything else as buffers.
+///
+/// Swapchain images created by `vkCreateSwapchainKHR` are allocated by the
+/// driver and are not visible to the tracker.
+///
+/// The tracker is thread-safe.
+class MemoryBudgetTracker
+{
+public:
+	/// @brief Memory usage of a heap.
+	struct HeapStats
+	{
+		/// The size of the heap.
+		VkDeviceSize size;
+
+		/// The memory currently allocated from the heap.
+		VkDeviceSize allocated;
+
+		/// The largest amount of memory which was allocated at once.
+		VkDeviceSize peak;
+
+		/// The number of live memory objects.
+		unsigned objectCount;
+	};
+
+	/// @brief Memory usage of a tag.
+	struct TagStats
+	{
+		/// The memory currently used.
+		VkDeviceSize allocated;
+
+		/// The largest amount of memory which was used at once.
+		VkDeviceSize peak;
+
+		/// The number of live allocations.
+		unsigned allocationCount;
+	};
+
+	/// @brief Gets the tracker.
+	/// @returns The tracker
+	static MemoryBudgetTracker &get();
+
+	/// @brief Starts tracking. Must be called after the device symbols have
+	/// been loaded, since loading them replaces the hooks.
+	/// Does nothing if the tracker is already installed.
+	/// @param memoryProperties The memory properties of the physical device.
+	void install(const VkPhysicalDeviceMemoryProperties &memoryProperties);
+
+	/// @brief Stops tracking and restores the original function pointers.
+	/// The statistics are kept until the next call to @ref install.
+	void uninstall();
+
+	/// @brief Records a sub-allocation. Called by @ref DeviceMemoryAllocator.
+	/// @param tag The tag to attribute the memory to.
+	/// @param size The size of the sub-allocation.
+	void recordAllocation(MemoryTag tag, VkDeviceSize size);
+
+	/// @brief Records that a sub-allocation was freed. Called by
+	/// @ref DeviceMemoryAllocator.
+	/// @param tag The tag the memory was attributed to.
+	/// @param size The size of the sub-allocation.
+	void recordFree(MemoryTag tag, VkDeviceSize size);
+
+	/// @brief Gets the memory usage of a heap.
+	/// @param heapIndex The index of the heap.
+	/// @returns The statistics
+	HeapStats getHeapStats(uint32_t heapIndex) const;
+
+	/// @brief Gets the memory usage of a tag.
+	/// @param tag The tag.
+	/// @returns The statistics
+	TagStats getTagStats(MemoryTag tag) const;
+
+	/// @brief Logs the current and peak memory usage per heap and per tag.
+	void report() const;
+
+private:
+	struct MemoryObject
+	{
+		VkDeviceSize size;
+		uint32_t heapIndex;
+		MemoryTag tag;
+	};
+
+	VkPhysicalDeviceMemoryProperties memoryProperties = {};
+	HeapStats heaps[VK_MAX_MEMORY_HEAPS] = {};
+	TagStats tags[MEMORY_TAG_COUNT] = {};
+	bool heapWarned[VK_MAX_MEMORY_HEAPS] = {};
+	std::unordered_map<VkDeviceMemory, MemoryObject> objects;
+	PFN_vkAllocateMemory pfnAllocateMemory = nullptr;
+	PFN_vkFreeMemory pfnFreeMemory = nullptr;
+	mutable std::mutex lock;
+
+	MemoryBudgetTracker() = default;
+	void addToTag(MemoryTag tag, VkDeviceSize size);
+	void removeFromTag(MemoryTag tag, VkDeviceSize size);
+
+	static VKAPI_ATTR VkResult VKAPI_CALL allocateMemory(VkDevice device, const VkMemoryAllocateInfo *pAllocateInfo,
+	                                                     const VkAllocationCallbacks *pAllocator,
+	                                                     VkDeviceMemory *pMemory);
+	static VKAPI_ATTR void VKAPI_CALL freeMemory(VkDevice device, VkDeviceMemory memory,
+	                                             const VkAllocationCallbacks *pAllocator);
+};
+}
+
+#endif
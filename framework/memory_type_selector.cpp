@@ -0,0 +1,105 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "memory_type_selector.hpp"
+
+namespace MaliSDK
+{
+MemoryTypeSelector::MemoryTypeSelector(const VkPhysicalDeviceMemoryProperties &memoryProperties)
+    : memoryProperties(memoryProperties)
+{
+	for (uint32_t flags = 0; flags <= CoreFlagMask; flags++)
+	{
+		typesWithFlags[flags] = 0;
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+			if ((memoryProperties.memoryTypes[i].propertyFlags & flags) == flags)
+				typesWithFlags[flags] |= 1u << i;
+	}
+}
+
+uint32_t MemoryTypeSelector::getTypesWithFlags(VkMemoryPropertyFlags flags) const
+{
+	if ((flags & ~VkMemoryPropertyFlags(CoreFlagMask)) == 0)
+		return typesWithFlags[flags];
+
+	// Flags from extensions are rare enough that they are not worth a table.
+	uint32_t types = 0;
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+		if ((memoryProperties.memoryTypes[i].propertyFlags & flags) == flags)
+			types |= 1u << i;
+	return types;
+}
+
+uint32_t MemoryTypeSelector::find(uint32_t typeBits, VkMemoryPropertyFlags required,
+                                  VkMemoryPropertyFlags preferred) const
+{
+	uint32_t types = typeBits & getTypesWithFlags(required | preferred);
+	if (types == 0)
+		types = typeBits & getTypesWithFlags(required);
+
+	if (types == 0)
+		return VK_MAX_MEMORY_TYPES;
+
+	uint32_t index = 0;
+	while ((types & (1u << index)) == 0)
+		index++;
+	return index;
+}
+
+uint32_t MemoryTypeSelector::find(uint32_t typeBits, Usage usage) const
+{
+	uint32_t index = VK_MAX_MEMORY_TYPES;
+	switch (usage)
+	{
+	case USAGE_UPLOAD:
+		index = find(typeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		break;
+
+	case USAGE_READBACK:
+		// Cached memory greatly accelerates reading on the CPU.
+		index = find(typeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+		break;
+
+	case USAGE_DEVICE_LOCAL:
+		index = find(typeBits, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		break;
+
+	case USAGE_TRANSIENT:
+		// Lazily allocated memory is not actually allocated until it is used,
+		// which is never for attachments which are not stored. Desktop
+		// systems usually do not have it, so fall back to device local.
+		index = find(typeBits, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		if (index == VK_MAX_MEMORY_TYPES)
+			index = find(typeBits, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		break;
+
+	default:
+		break;
+	}
+
+	if (index == VK_MAX_MEMORY_TYPES)
+	{
+		LOGE("Failed to obtain suitable memory type.\n");
+		abort();
+	}
+
+	return index;
+}
+}
@@ -0,0 +1,112 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FRAMEWORK_MEMORY_TYPE_SELECTOR_HPP
+#define FRAMEWORK_MEMORY_TYPE_SELECTOR_HPP
+
+#include "framework/common.hpp"
+
+namespace MaliSDK
+{
+/// @brief Picks memory types for resources.
+///
+/// The selector is built once from the memory properties of the physical
+/// device. For every combination of the core memory property flags, it
+/// precomputes the mask of memory types which have all of them, so a query is
+/// a couple of mask operations instead of a scan over the memory types.
+///
+/// When several memory types qualify, the one with the lowest index is used,
+/// since Vulkan orders memory types by preference.
+class MemoryTypeSelector
+{
+public:
+	/// @brief Describes how a resource is accessed.
+	enum Usage
+	{
+		/// Written by the CPU and read by the GPU, such as vertex buffers,
+		/// uniform buffers and staging buffers. The memory is host visible and
+		/// coherent.
+		USAGE_UPLOAD,
+
+		/// Written by the GPU and read by the CPU. The memory is host visible
+		/// and preferably cached. It is not necessarily coherent, so it must be
+		/// invalidated before reading.
+		USAGE_READBACK,
+
+		/// Only accessed by the GPU. The memory is device local if possible.
+		USAGE_DEVICE_LOCAL,
+
+		/// Attachments which only live in tile memory. The memory is lazily
+		/// allocated if possible, otherwise device local.
+		USAGE_TRANSIENT,
+
+		USAGE_COUNT
+	};
+
+	/// @brief Constructor
+	/// @param memoryProperties The memory properties of the physical device.
+	MemoryTypeSelector(const VkPhysicalDeviceMemoryProperties &memoryProperties);
+
+	/// @brief Finds a memory type.
+	/// @param typeBits The memory types the resource supports, from
+	/// `VkMemoryRequirements::memoryTypeBits`.
+	/// @param required The property flags the memory type must have.
+	/// @param preferred Additional property flags which are used if a memory
+	/// type has them.
+	/// @returns The memory type index, or VK_MAX_MEMORY_TYPES if no memory type
+	/// has the required flags.
+	uint32_t find(uint32_t typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred = 0) const;
+
+	/// @brief Finds a memory type for a usage.
+	///
+	/// Vulkan guarantees that a memory type exists for all usages, so this
+	/// aborts if none is found.
+	/// @param typeBits The memory types the resource supports, from
+	/// `VkMemoryRequirements::memoryTypeBits`.
+	/// @param usage How the resource is accessed.
+	/// @returns The memory type index.
+	uint32_t find(uint32_t typeBits, Usage usage) const;
+
+	/// @brief Gets the property flags of a memory type.
+	/// @param memoryTypeIndex The memory type index.
+	/// @returns The property flags
+	VkMemoryPropertyFlags getPropertyFlags(uint32_t memoryTypeIndex) const
+	{
+		return memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+	}
+
+private:
+	enum
+	{
+		// DEVICE_LOCAL, HOST_VISIBLE, HOST_COHERENT, HOST_CACHED and
+		// LAZILY_ALLOCATED.
+		CoreFlagMask = 0x1f
+	};
+
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+
+	// The memory types which have all flags of the index.
+	uint32_t typesWithFlags[CoreFlagMask + 1];
+
+	uint32_t getTypesWithFlags(VkMemoryPropertyFlags flags) const;
+};
+}
+
+#endif
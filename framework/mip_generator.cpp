@@ -0,0 +1,526 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "mip_generator.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MIP_GENERATOR_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIP_GENERATOR_SSE2 1
+#endif
+
+using namespace std;
+
+namespace MaliSDK
+{
+namespace
+{
+/// The radius of the Kaiser filter, in texels of the level being generated.
+const double KaiserRadius = 3.0;
+
+/// The shape parameter of the Kaiser window. Higher values trade sharpness
+/// for less ringing.
+const double KaiserAlpha = 4.0;
+
+/// The number of steps in the table which converts linear values to sRGB.
+/// The steps must be finer than the smallest distance between two sRGB
+/// rounding thresholds in linear space, (1 / 255) / 12.92, so that every
+/// step contains at most one threshold.
+const unsigned SrgbEncodeSteps = 4096;
+
+/// The number of texels of the next level which are filtered by a single
+/// work item.
+const unsigned TexelsPerStrip = 16384;
+
+const double Pi = 3.14159265358979323846;
+
+/// Tables which convert between sRGB and linear values.
+struct SrgbTables
+{
+	/// The linear value of every 8-bit sRGB value.
+	float toLinear[256];
+
+	/// The sRGB value which linear value i / SrgbEncodeSteps rounds to.
+	uint8_t fromLinear[SrgbEncodeSteps + 1];
+
+	/// thresholds[v] is the smallest linear value which rounds to sRGB value
+	/// v, or beyond the range of linear values for v = 0 and v = 256.
+	float thresholds[257];
+
+	SrgbTables()
+	{
+		for (unsigned v = 0; v < 256; v++)
+			toLinear[v] = float(srgbToLinear(v / 255.0));
+
+		thresholds[0] = -FLT_MAX;
+		for (unsigned v = 1; v < 256; v++)
+			thresholds[v] = float(srgbToLinear((v - 0.5) / 255.0));
+		thresholds[256] = FLT_MAX;
+
+		unsigned value = 0;
+		for (unsigned i = 0; i <= SrgbEncodeSteps; i++)
+		{
+			float linear = float(i) / SrgbEncodeSteps;
+			while (linear >= thresholds[value + 1])
+				value++;
+			fromLinear[i] = uint8_t(value);
+		}
+	}
+
+	static double srgbToLinear(double value)
+	{
+		return value <= 0.04045 ? value / 12.92 : pow((value + 0.055) / 1.055, 2.4);
+	}
+
+	/// Converts a linear value to sRGB, rounded to nearest in sRGB space.
+	uint8_t encode(float linear) const
+	{
+		linear = min(max(linear, 0.0f), 1.0f);
+		unsigned value = fromLinear[unsigned(linear * SrgbEncodeSteps)];
+		return uint8_t(linear >= thresholds[value + 1] ? value + 1 : value);
+	}
+};
+
+const SrgbTables &getSrgbTables()
+{
+	static const SrgbTables tables;
+	return tables;
+}
+
+/// A source texel and its weight in a texel of the next level.
+struct FilterTap
+{
+	unsigned index;
+	float weight;
+};
+
+/// The taps of a separable filter for every texel along one axis of the next
+/// level. Levels which are not exactly half the size of the previous level
+/// need different weights for every texel.
+struct FilterKernel
+{
+	/// The taps of texel i are taps[offsets[i]] to taps[offsets[i + 1] - 1].
+	vector<unsigned> offsets;
+	vector<FilterTap> taps;
+};
+
+double besselI0(double x)
+{
+	double sum = 1.0;
+	double term = 1.0;
+	for (unsigned k = 1; k < 64 && term > sum * 1e-12; k++)
+	{
+		double factor = x / (2.0 * k);
+		term *= factor * factor;
+		sum += term;
+	}
+	return sum;
+}
+
+/// Evaluates the Kaiser windowed sinc at a distance in texels of the next
+/// level.
+double kaiserFilter(double x)
+{
+	if (fabs(x) >= KaiserRadius)
+		return 0.0;
+
+	double sinc = x == 0.0 ? 1.0 : sin(Pi * x) / (Pi * x);
+	double t = x / KaiserRadius;
+	return sinc * besselI0(KaiserAlpha * sqrt(1.0 - t * t)) / besselI0(KaiserAlpha);
+}
+
+unsigned applyAddressMode(int index, unsigned size, VkSamplerAddressMode addressMode)
+{
+	int period = int(size);
+	switch (addressMode)
+	{
+	case VK_SAMPLER_ADDRESS_MODE_REPEAT:
+		index %= period;
+		return unsigned(index < 0 ? index + period : index);
+
+	case VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT:
+		index %= 2 * period;
+		if (index < 0)
+			index += 2 * period;
+		return unsigned(index < period ? index : 2 * period - 1 - index);
+
+	default:
+		return unsigned(min(max(index, 0), period - 1));
+	}
+}
+
+void buildFilterKernel(FilterKernel *pKernel, unsigned srcSize, unsigned dstSize, MipFilter filter,
+                       VkSamplerAddressMode addressMode)
+{
+	double scale = double(srcSize) / dstSize;
+	pKernel->offsets.clear();
+	pKernel->taps.clear();
+
+	for (unsigned i = 0; i < dstSize; i++)
+	{
+		size_t first = pKernel->taps.size();
+		pKernel->offsets.push_back(unsigned(first));
+
+		double sum = 0.0;
+		auto addTap = [&](int index, double weight) {
+			FilterTap tap = { applyAddressMode(index, srcSize, addressMode), float(weight) };
+			pKernel->taps.push_back(tap);
+			sum += weight;
+		};
+
+		if (filter == MIP_FILTER_BOX)
+		{
+			// Weight every source texel by how much of it the texel covers.
+			double begin = i * scale;
+			double end = (i + 1) * scale;
+			for (int j = int(floor(begin)); j < int(ceil(end)); j++)
+			{
+				double weight = min(end, j + 1.0) - max(begin, double(j));
+				if (weight > 1e-6)
+					addTap(j, weight);
+			}
+		}
+		else
+		{
+			// Sample the filter at the centers of the source texels. The filter
+			// is stretched by the scale so that it cuts off at the frequencies
+			// the next level can represent.
+			double center = (i + 0.5) * scale;
+			double radius = KaiserRadius * scale;
+			for (int j = int(floor(center - radius)); j <= int(ceil(center + radius)); j++)
+			{
+				double weight = kaiserFilter((j + 0.5 - center) / scale);
+				if (weight != 0.0)
+					addTap(j, weight);
+			}
+		}
+
+		for (size_t t = first; t < pKernel->taps.size(); t++)
+			pKernel->taps[t].weight = float(pKernel->taps[t].weight / sum);
+	}
+
+	pKernel->offsets.push_back(unsigned(pKernel->taps.size()));
+}
+
+/// Converts a row of 8-bit texels to linear floating point.
+void convertRowToFloat(float *pDst, const uint8_t *pSrc, unsigned width, bool srgb)
+{
+	size_t count = size_t(width) * 4;
+	size_t i = 0;
+
+	if (srgb)
+	{
+		const SrgbTables &tables = getSrgbTables();
+		for (; i < count; i += 4)
+		{
+			pDst[i + 0] = tables.toLinear[pSrc[i + 0]];
+			pDst[i + 1] = tables.toLinear[pSrc[i + 1]];
+			pDst[i + 2] = tables.toLinear[pSrc[i + 2]];
+			pDst[i + 3] = pSrc[i + 3] * (1.0f / 255.0f);
+		}
+		return;
+	}
+
+#if defined(MIP_GENERATOR_NEON)
+	const float32x4_t scale = vdupq_n_f32(1.0f / 255.0f);
+	for (; i + 8 <= count; i += 8)
+	{
+		uint16x8_t values = vmovl_u8(vld1_u8(pSrc + i));
+		vst1q_f32(pDst + i + 0, vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(values))), scale));
+		vst1q_f32(pDst + i + 4, vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(values))), scale));
+	}
+#elif defined(MIP_GENERATOR_SSE2)
+	const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= count; i += 16)
+	{
+		__m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc + i));
+		__m128i lo = _mm_unpacklo_epi8(values, zero);
+		__m128i hi = _mm_unpackhi_epi8(values, zero);
+		_mm_storeu_ps(pDst + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+		_mm_storeu_ps(pDst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+		_mm_storeu_ps(pDst + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+		_mm_storeu_ps(pDst + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+	}
+#endif
+	for (; i < count; i++)
+		pDst[i] = pSrc[i] * (1.0f / 255.0f);
+}
+
+/// Converts a row of linear floating point texels to 8 bits, rounded to
+/// nearest.
+void convertRowFromFloat(uint8_t *pDst, const float *pSrc, unsigned width, bool srgb)
+{
+	size_t count = size_t(width) * 4;
+	size_t i = 0;
+
+	if (srgb)
+	{
+		const SrgbTables &tables = getSrgbTables();
+		for (; i < count; i += 4)
+		{
+			pDst[i + 0] = tables.encode(pSrc[i + 0]);
+			pDst[i + 1] = tables.encode(pSrc[i + 1]);
+			pDst[i + 2] = tables.encode(pSrc[i + 2]);
+			pDst[i + 3] = uint8_t(min(max(pSrc[i + 3], 0.0f), 1.0f) * 255.0f + 0.5f);
+		}
+		return;
+	}
+
+#if defined(MIP_GENERATOR_NEON)
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+	const float32x4_t one = vdupq_n_f32(1.0f);
+	const float32x4_t scale = vdupq_n_f32(255.0f);
+	const float32x4_t half = vdupq_n_f32(0.5f);
+	for (; i + 8 <= count; i += 8)
+	{
+		float32x4_t lo = vminq_f32(vmaxq_f32(vld1q_f32(pSrc + i + 0), zero), one);
+		float32x4_t hi = vminq_f32(vmaxq_f32(vld1q_f32(pSrc + i + 4), zero), one);
+		uint16x4_t lo16 = vmovn_u32(vcvtq_u32_f32(vmlaq_f32(half, lo, scale)));
+		uint16x4_t hi16 = vmovn_u32(vcvtq_u32_f32(vmlaq_f32(half, hi, scale)));
+		vst1_u8(pDst + i, vmovn_u16(vcombine_u16(lo16, hi16)));
+	}
+#elif defined(MIP_GENERATOR_SSE2)
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 scale = _mm_set1_ps(255.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	for (; i + 16 <= count; i += 16)
+	{
+		__m128i values[4];
+		for (unsigned j = 0; j < 4; j++)
+		{
+			__m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(pSrc + i + 4 * j), zero), one);
+			values[j] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, scale), half));
+		}
+		__m128i lo = _mm_packs_epi32(values[0], values[1]);
+		__m128i hi = _mm_packs_epi32(values[2], values[3]);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(pDst + i), _mm_packus_epi16(lo, hi));
+	}
+#endif
+	for (; i < count; i++)
+		pDst[i] = uint8_t(min(max(pSrc[i], 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+/// Sets pDst to pSrc * weight, or adds pSrc * weight to pDst if accumulate
+/// is set.
+void weightRow(float *pDst, const float *pSrc, float weight, size_t count, bool accumulate)
+{
+	size_t i = 0;
+#if defined(MIP_GENERATOR_NEON)
+	const float32x4_t w = vdupq_n_f32(weight);
+	for (; i + 8 <= count; i += 8)
+	{
+		float32x4_t lo = vmulq_f32(vld1q_f32(pSrc + i + 0), w);
+		float32x4_t hi = vmulq_f32(vld1q_f32(pSrc + i + 4), w);
+		if (accumulate)
+		{
+			lo = vaddq_f32(lo, vld1q_f32(pDst + i + 0));
+			hi = vaddq_f32(hi, vld1q_f32(pDst + i + 4));
+		}
+		vst1q_f32(pDst + i + 0, lo);
+		vst1q_f32(pDst + i + 4, hi);
+	}
+#elif defined(MIP_GENERATOR_SSE2)
+	const __m128 w = _mm_set1_ps(weight);
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128 lo = _mm_mul_ps(_mm_loadu_ps(pSrc + i + 0), w);
+		__m128 hi = _mm_mul_ps(_mm_loadu_ps(pSrc + i + 4), w);
+		if (accumulate)
+		{
+			lo = _mm_add_ps(lo, _mm_loadu_ps(pDst + i + 0));
+			hi = _mm_add_ps(hi, _mm_loadu_ps(pDst + i + 4));
+		}
+		_mm_storeu_ps(pDst + i + 0, lo);
+		_mm_storeu_ps(pDst + i + 4, hi);
+	}
+#endif
+	for (; i < count; i++)
+		pDst[i] = accumulate ? pDst[i] + pSrc[i] * weight : pSrc[i] * weight;
+}
+
+/// Filters a row of texels horizontally. Every texel is four floats, which
+/// fill a SIMD register.
+void filterRow(float *pDst, const float *pSrc, const FilterKernel &kernel, unsigned width)
+{
+	const FilterTap *pTaps = kernel.taps.data();
+	for (unsigned x = 0; x < width; x++)
+	{
+		unsigned begin = kernel.offsets[x];
+		unsigned end = kernel.offsets[x + 1];
+#if defined(MIP_GENERATOR_NEON)
+		float32x4_t sum = vdupq_n_f32(0.0f);
+		for (unsigned t = begin; t < end; t++)
+			sum = vmlaq_n_f32(sum, vld1q_f32(pSrc + 4 * pTaps[t].index), pTaps[t].weight);
+		vst1q_f32(pDst + 4 * x, sum);
+#elif defined(MIP_GENERATOR_SSE2)
+		__m128 sum = _mm_setzero_ps();
+		for (unsigned t = begin; t < end; t++)
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(pSrc + 4 * pTaps[t].index), _mm_set1_ps(pTaps[t].weight)));
+		_mm_storeu_ps(pDst + 4 * x, sum);
+#else
+		float sum[4] = {};
+		for (unsigned t = begin; t < end; t++)
+			for (unsigned c = 0; c < 4; c++)
+				sum[c] += pSrc[4 * pTaps[t].index + c] * pTaps[t].weight;
+		memcpy(pDst + 4 * x, sum, sizeof(sum));
+#endif
+	}
+}
+
+/// Calls func(threadIndex, begin, end) for strips of rows, in parallel if a
+/// thread pool is given and there is enough work.
+template <typename Func>
+void forEachStrip(ThreadPool *pPool, unsigned width, unsigned height, const Func &func)
+{
+	unsigned rowsPerStrip = max(TexelsPerStrip / width, 1u);
+	if (pPool && height > rowsPerStrip)
+		pPool->parallelFor(0, height, rowsPerStrip, func);
+	else
+		func(0, 0, height);
+}
+}
+
+unsigned getMipLevelCount(unsigned width, unsigned height)
+{
+	unsigned levels = 0;
+	while (width || height)
+	{
+		width >>= 1;
+		height >>= 1;
+		levels++;
+	}
+	return levels;
+}
+
+Result generateMipChainRgba8888(vector<uint8_t> *pMipChain, vector<VkBufferImageCopy> *pRegions, const uint8_t *pSrc,
+                                size_t rowPitch, unsigned width, unsigned height, VkFormat format, MipFilter filter,
+                                VkSamplerAddressMode addressMode, unsigned mipLevels, ThreadPool *pPool)
+{
+	if (format != VK_FORMAT_R8G8B8A8_UNORM && format != VK_FORMAT_R8G8B8A8_SRGB)
+	{
+		LOGE("Cannot generate mip levels for format %d.\n", int(format));
+		return RESULT_ERROR_GENERIC;
+	}
+
+	if (addressMode != VK_SAMPLER_ADDRESS_MODE_REPEAT && addressMode != VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT &&
+	    addressMode != VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE)
+	{
+		LOGE("Cannot generate mip levels with address mode %d.\n", int(addressMode));
+		return RESULT_ERROR_GENERIC;
+	}
+
+	unsigned levelCount = getMipLevelCount(width, height);
+	if (width == 0 || height == 0 || mipLevels > levelCount)
+	{
+		LOGE("Cannot generate %u mip levels for a %ux%u image.\n", mipLevels, width, height);
+		return RESULT_ERROR_GENERIC;
+	}
+	if (mipLevels != 0)
+		levelCount = mipLevels;
+
+	// Lay out all levels for a single upload.
+	pRegions->resize(levelCount);
+	size_t size = 0;
+	for (unsigned level = 0; level < levelCount; level++)
+	{
+		VkBufferImageCopy &region = (*pRegions)[level];
+		region = {};
+		region.bufferOffset = size;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = level;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent.width = max(width >> level, 1u);
+		region.imageExtent.height = max(height >> level, 1u);
+		region.imageExtent.depth = 1;
+		size += size_t(region.imageExtent.width) * region.imageExtent.height * 4;
+	}
+
+	pMipChain->resize(size);
+	uint8_t *pChain = pMipChain->data();
+	size_t levelPitch = size_t(width) * 4;
+	for (unsigned y = 0; y < height; y++)
+		memcpy(pChain + y * levelPitch, pSrc + y * rowPitch, levelPitch);
+
+	if (levelCount == 1)
+		return RESULT_SUCCESS;
+
+	// Build the tables before the threads need them.
+	bool srgb = format == VK_FORMAT_R8G8B8A8_SRGB;
+	if (srgb)
+		getSrgbTables();
+
+	vector<float> level(size_t(width) * height * 4);
+	vector<float> nextLevel;
+	float *pLevel = level.data();
+	forEachStrip(pPool, width, height, [=](unsigned, unsigned begin, unsigned end) {
+		for (unsigned y = begin; y < end; y++)
+			convertRowToFloat(pLevel + y * levelPitch, pSrc + y * rowPitch, width, srgb);
+	});
+
+	FilterKernel horizontal;
+	FilterKernel vertical;
+	for (unsigned i = 1; i < levelCount; i++)
+	{
+		const VkExtent3D &srcExtent = (*pRegions)[i - 1].imageExtent;
+		const VkExtent3D &dstExtent = (*pRegions)[i].imageExtent;
+		buildFilterKernel(&horizontal, srcExtent.width, dstExtent.width, filter, addressMode);
+		buildFilterKernel(&vertical, srcExtent.height, dstExtent.height, filter, addressMode);
+
+		nextLevel.resize(size_t(dstExtent.width) * dstExtent.height * 4);
+		const float *pSrcLevel = level.data();
+		float *pDstLevel = nextLevel.data();
+		uint8_t *pOut = pChain + (*pRegions)[i].bufferOffset;
+		size_t srcPitch = size_t(srcExtent.width) * 4;
+		size_t dstPitch = size_t(dstExtent.width) * 4;
+
+		// Filter vertically into a row of the size of the previous level, then
+		// horizontally into the next level. Every row only depends on the
+		// previous level, so strips of rows can be filtered independently.
+		forEachStrip(pPool, dstExtent.width, dstExtent.height, [&](unsigned, unsigned begin, unsigned end) {
+			vector<float> row(srcPitch);
+			for (unsigned y = begin; y < end; y++)
+			{
+				for (unsigned t = vertical.offsets[y]; t < vertical.offsets[y + 1]; t++)
+				{
+					const FilterTap &tap = vertical.taps[t];
+					weightRow(row.data(), pSrcLevel + tap.index * srcPitch, tap.weight, srcPitch,
+					          t != vertical.offsets[y]);
+				}
+
+				filterRow(pDstLevel + y * dstPitch, row.data(), horizontal, dstExtent.width);
+				convertRowFromFloat(pOut + y * dstPitch, pDstLevel + y * dstPitch, dstExtent.width, srgb);
+			}
+		});
+
+		swap(level, nextLevel);
+	}
+
+	return RESULT_SUCCESS;
+}
+}
@@ -0,0 +1,90 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FRAMEWORK_MIP_GENERATOR_HPP
+#define FRAMEWORK_MIP_GENERATOR_HPP
+
+#include "common.hpp"
+#include "libvulkan-stub.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace MaliSDK
+{
+class ThreadPool;
+
+/// @brief The filters which can be used to downsample mip levels.
+enum MipFilter
+{
+	/// Averages the texels each texel of the next level covers. Cheap, but
+	/// lets through some aliasing and blurs more than needed.
+	MIP_FILTER_BOX,
+
+	/// A Kaiser windowed sinc with a radius of three texels of the next level.
+	/// Keeps the levels sharper and suppresses aliasing, at the cost of more
+	/// taps and slight ringing on hard edges.
+	MIP_FILTER_KAISER
+};
+
+/// @brief Gets the number of levels of a full mip chain.
+/// @param width The width of the first level.
+/// @param height The height of the first level.
+/// @returns The number of levels down to 1x1.
+unsigned getMipLevelCount(unsigned width, unsigned height);
+
+/// @brief Generates a mip chain for a VK_FORMAT_R8G8B8A8 image on the CPU.
+///
+/// Every level is filtered from the previous one, which is kept in floating
+/// point so that rounding errors do not accumulate down the chain. Levels
+/// are half the size of the previous level, rounded down, and the filter
+/// footprint follows the exact ratio between the sizes, so odd and other
+/// non-power-of-two sizes are filtered correctly. For SRGB formats, the
+/// color components are filtered in linear space and alpha is always
+/// filtered as it is.
+///
+/// The filter uses NEON or SSE2 where available. If a thread pool is given,
+/// strips of rows of every level are filtered in parallel.
+///
+/// @param[out] pMipChain All levels, starting with a copy of the image and
+/// tightly packed one after the other.
+/// @param[out] pRegions One region per level into pMipChain, which can be
+/// passed to `UploadManager::uploadImage` to upload the chain at once.
+/// @param pSrc The first level.
+/// @param rowPitch The number of bytes between rows of pSrc.
+/// @param width The width of the first level.
+/// @param height The height of the first level.
+/// @param format VK_FORMAT_R8G8B8A8_UNORM or VK_FORMAT_R8G8B8A8_SRGB.
+/// @param filter The filter to downsample with.
+/// @param addressMode How texels outside the image are sampled by the
+/// filter, VK_SAMPLER_ADDRESS_MODE_REPEAT for tiling textures, or
+/// VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE.
+/// @param mipLevels The number of levels to generate, including the first,
+/// or 0 for a full mip chain.
+/// @param pPool The thread pool to filter on, or nullptr.
+/// @returns Error code
+Result generateMipChainRgba8888(std::vector<uint8_t> *pMipChain, std::vector<VkBufferImageCopy> *pRegions,
+                                const uint8_t *pSrc, size_t rowPitch, unsigned width, unsigned height,
+                                VkFormat format, MipFilter filter,
+                                VkSamplerAddressMode addressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                                unsigned mipLevels = 0, ThreadPool *pPool = nullptr);
+}
+
+#endif
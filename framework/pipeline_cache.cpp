@@ -0,0 +1,167 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "pipeline_cache.hpp"
+#include "assets.hpp"
+#include "platform/os.hpp"
+#include <stdio.h>
+#include <string.h>
+
+using namespace std;
+
+namespace MaliSDK
+{
+/// The header of a saved pipeline cache, which is followed by the data
+/// returned by vkGetPipelineCacheData.
+struct PipelineCacheFileHeader
+{
+	char magic[4];
+	uint32_t driverVersion;
+	uint64_t dataSize;
+	uint64_t hash;
+};
+
+static const char PipelineCacheMagic[4] = { 'M', 'P', 'S', 'O' };
+static const uint64_t HashSeed = 0xcbf29ce484222325ull;
+
+PipelineCache::PipelineCache(VkDevice device, const VkPhysicalDeviceProperties &properties)
+    : device(device)
+    , properties(properties)
+{
+	// The cache directory can be shared by several applications, which would
+	// otherwise keep replacing each other's pipelines.
+	path = OS::getCacheDirectory();
+	if (!path.empty())
+	{
+		string application = OS::getApplicationName();
+		if (!application.empty())
+			application += "-";
+
+		char ids[32];
+		snprintf(ids, sizeof(ids), "%08x-%08x.bin", properties.vendorID, properties.deviceID);
+		path += "/pipeline-cache-" + application + ids;
+	}
+
+	// Saved caches are read from the file system, not from assets.
+	AssetManager fileSystem;
+	AssetData file;
+	const uint8_t *pData = nullptr;
+	size_t size = 0;
+	if (!path.empty() && SUCCEEDED(fileSystem.mapBinaryFile(path.c_str(), &file)))
+	{
+		PipelineCacheFileHeader header = {};
+		const uint8_t *pFile = static_cast<const uint8_t *>(file.getData());
+		if (file.getSize() >= sizeof(header))
+		{
+			memcpy(&header, pFile, sizeof(header));
+			pData = pFile + sizeof(header);
+			size = file.getSize() - sizeof(header);
+		}
+
+		if (!pData || memcmp(header.magic, PipelineCacheMagic, sizeof(header.magic)) != 0 ||
+		    header.driverVersion != properties.driverVersion || header.dataSize != size ||
+		    header.hash != hashData(HashSeed, pData, size) || !isCompatible(pData, size))
+		{
+			LOGI("Ignoring stale or corrupted pipeline cache: %s.\n", path.c_str());
+			pData = nullptr;
+			size = 0;
+		}
+	}
+
+	VkPipelineCacheCreateInfo info = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+	info.initialDataSize = size;
+	info.pInitialData = pData;
+	if (size != 0 && vkCreatePipelineCache(device, &info, nullptr, &cache) != VK_SUCCESS)
+	{
+		LOGE("The driver rejected the pipeline cache: %s.\n", path.c_str());
+		cache = VK_NULL_HANDLE;
+		size = 0;
+	}
+
+	if (cache == VK_NULL_HANDLE)
+	{
+		info.initialDataSize = 0;
+		info.pInitialData = nullptr;
+		VK_CHECK(vkCreatePipelineCache(device, &info, nullptr, &cache));
+	}
+	else
+		LOGI("Loaded %u bytes of pipeline cache.\n", unsigned(size));
+
+	savedSize = size;
+}
+
+PipelineCache::~PipelineCache()
+{
+	save();
+	vkDestroyPipelineCache(device, cache, nullptr);
+}
+
+bool PipelineCache::isCompatible(const uint8_t *pData, size_t size) const
+{
+	// The data starts with a VK_PIPELINE_CACHE_HEADER_VERSION_ONE header:
+	// header size, header version, vendor ID, device ID and cache UUID.
+	uint32_t header[4];
+	if (size < sizeof(header) + VK_UUID_SIZE)
+		return false;
+
+	memcpy(header, pData, sizeof(header));
+	return header[0] >= sizeof(header) + VK_UUID_SIZE && header[0] <= size &&
+	       header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE && header[2] == properties.vendorID &&
+	       header[3] == properties.deviceID &&
+	       memcmp(pData + sizeof(header), properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+Result PipelineCache::save()
+{
+	if (path.empty())
+		return RESULT_SUCCESS;
+
+	size_t size = 0;
+	VK_CHECK(vkGetPipelineCacheData(device, cache, &size, nullptr));
+
+	// Caches only grow as pipelines are added.
+	if (size == savedSize)
+		return RESULT_SUCCESS;
+
+	PipelineCacheFileHeader header = {};
+	vector<uint8_t> file(sizeof(header) + size);
+	VkResult res = vkGetPipelineCacheData(device, cache, &size, file.data() + sizeof(header));
+	if (res != VK_SUCCESS && res != VK_INCOMPLETE)
+	{
+		LOGE("Failed to get pipeline cache data.\n");
+		return RESULT_ERROR_GENERIC;
+	}
+	file.resize(sizeof(header) + size);
+
+	memcpy(header.magic, PipelineCacheMagic, sizeof(header.magic));
+	header.driverVersion = properties.driverVersion;
+	header.dataSize = size;
+	header.hash = hashData(HashSeed, file.data() + sizeof(header), size);
+	memcpy(file.data(), &header, sizeof(header));
+
+	Result result = writeCacheFile(path.c_str(), file.data(), file.size());
+	if (SUCCEEDED(result))
+	{
+		LOGI("Saved %u bytes of pipeline cache.\n", unsigned(size));
+		savedSize = size;
+	}
+	return result;
+}
+}
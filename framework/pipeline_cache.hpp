@@ -0,0 +1,86 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FRAMEWORK_PIPELINE_CACHE_HPP
+#define FRAMEWORK_PIPELINE_CACHE_HPP
+
+#include "framework/common.hpp"
+#include <string>
+#include <vector>
+
+namespace MaliSDK
+{
+/// @brief A VkPipelineCache which persists across runs.
+///
+/// Compiling pipelines is the largest part of the startup time of most
+/// applications, and drivers can skip most of it for pipelines they find in
+/// the cache. The cache is loaded from the cache directory of the platform
+/// when it is created and saved back when it is destroyed, in a file per
+/// application, vendor and device ID.
+///
+/// Saved data is only passed back to the driver if its header matches the
+/// vendor ID, device ID and pipeline cache UUID of the device, and if the
+/// driver version and the checksum of the data match what was saved. Data
+/// from another driver, or a truncated or corrupted file, is ignored and
+/// the cache starts out empty. Without a cache directory, the cache only
+/// lives as long as the object.
+class PipelineCache
+{
+public:
+	/// @brief Constructor
+	/// @param device The Vulkan device.
+	/// @param properties The properties of the physical device of the device.
+	PipelineCache(VkDevice device, const VkPhysicalDeviceProperties &properties);
+
+	/// @brief Destructor. Saves and destroys the cache.
+	~PipelineCache();
+
+	/// @brief Gets the pipeline cache, to be passed to
+	/// `vkCreateGraphicsPipelines` and `vkCreateComputePipelines`.
+	/// @returns The pipeline cache.
+	VkPipelineCache getCache() const
+	{
+		return cache;
+	}
+
+	/// @brief Saves the cache to the cache directory if pipelines were added
+	/// since it was loaded or last saved.
+	///
+	/// This happens when the cache is destroyed, but applications which may
+	/// be killed without shutting down, e.g. on Android, can save as soon as
+	/// their pipelines are created.
+	/// @returns Error code
+	Result save();
+
+private:
+	VkDevice device;
+	VkPipelineCache cache = VK_NULL_HANDLE;
+	VkPhysicalDeviceProperties properties;
+	std::string path;
+
+	/// The size of the data which was last loaded or saved, to skip saving
+	/// an unchanged cache.
+	size_t savedSize = 0;
+
+	bool isCompatible(const uint8_t *pData, size_t size) const;
+};
+}
+
+#endif
@@ -0,0 +1,234 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "pixel_conversion.hpp"
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PIXEL_CONVERSION_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PIXEL_CONVERSION_SSE2 1
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define PIXEL_CONVERSION_SSSE3 1
+#endif
+#endif
+
+namespace MaliSDK
+{
+// x * a / 255, rounded to nearest, without a division.
+static inline uint8_t multiplyUnorm8(unsigned x, unsigned a)
+{
+	unsigned t = x * a + 128;
+	return uint8_t((t + (t >> 8)) >> 8);
+}
+
+static void convertGreyToRgba8888(uint8_t *pDst, const uint8_t *pSrc, size_t count)
+{
+	size_t i = 0;
+#if defined(PIXEL_CONVERSION_NEON)
+	for (; i + 16 <= count; i += 16)
+	{
+		uint8x16x4_t rgba;
+		rgba.val[0] = vld1q_u8(pSrc + i);
+		rgba.val[1] = rgba.val[0];
+		rgba.val[2] = rgba.val[0];
+		rgba.val[3] = vdupq_n_u8(0xff);
+		vst4q_u8(pDst + 4 * i, rgba);
+	}
+#elif defined(PIXEL_CONVERSION_SSE2)
+	const __m128i opaque = _mm_set1_epi8(char(0xff));
+	for (; i + 16 <= count; i += 16)
+	{
+		__m128i grey = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc + i));
+		__m128i gg0 = _mm_unpacklo_epi8(grey, grey);
+		__m128i gg1 = _mm_unpackhi_epi8(grey, grey);
+		__m128i ga0 = _mm_unpacklo_epi8(grey, opaque);
+		__m128i ga1 = _mm_unpackhi_epi8(grey, opaque);
+		__m128i *pOut = reinterpret_cast<__m128i *>(pDst + 4 * i);
+		_mm_storeu_si128(pOut + 0, _mm_unpacklo_epi16(gg0, ga0));
+		_mm_storeu_si128(pOut + 1, _mm_unpackhi_epi16(gg0, ga0));
+		_mm_storeu_si128(pOut + 2, _mm_unpacklo_epi16(gg1, ga1));
+		_mm_storeu_si128(pOut + 3, _mm_unpackhi_epi16(gg1, ga1));
+	}
+#endif
+	for (; i < count; i++)
+	{
+		uint8_t grey = pSrc[i];
+		pDst[4 * i + 0] = grey;
+		pDst[4 * i + 1] = grey;
+		pDst[4 * i + 2] = grey;
+		pDst[4 * i + 3] = 0xff;
+	}
+}
+
+static void convertGreyAlphaToRgba8888(uint8_t *pDst, const uint8_t *pSrc, size_t count)
+{
+	size_t i = 0;
+#if defined(PIXEL_CONVERSION_NEON)
+	for (; i + 16 <= count; i += 16)
+	{
+		uint8x16x2_t ga = vld2q_u8(pSrc + 2 * i);
+		uint8x16x4_t rgba;
+		rgba.val[0] = ga.val[0];
+		rgba.val[1] = ga.val[0];
+		rgba.val[2] = ga.val[0];
+		rgba.val[3] = ga.val[1];
+		vst4q_u8(pDst + 4 * i, rgba);
+	}
+#elif defined(PIXEL_CONVERSION_SSE2)
+	for (; i + 8 <= count; i += 8)
+	{
+		// Every 16-bit lane holds a grey and alpha pair.
+		__m128i ga = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc + 2 * i));
+		__m128i grey = _mm_and_si128(ga, _mm_set1_epi16(0xff));
+		__m128i gg = _mm_or_si128(grey, _mm_slli_epi16(grey, 8));
+		__m128i *pOut = reinterpret_cast<__m128i *>(pDst + 4 * i);
+		_mm_storeu_si128(pOut + 0, _mm_unpacklo_epi16(gg, ga));
+		_mm_storeu_si128(pOut + 1, _mm_unpackhi_epi16(gg, ga));
+	}
+#endif
+	for (; i < count; i++)
+	{
+		uint8_t grey = pSrc[2 * i + 0];
+		pDst[4 * i + 0] = grey;
+		pDst[4 * i + 1] = grey;
+		pDst[4 * i + 2] = grey;
+		pDst[4 * i + 3] = pSrc[2 * i + 1];
+	}
+}
+
+static void convertRgbToRgba8888(uint8_t *pDst, const uint8_t *pSrc, size_t count)
+{
+	size_t i = 0;
+#if defined(PIXEL_CONVERSION_NEON)
+	for (; i + 16 <= count; i += 16)
+	{
+		uint8x16x3_t rgb = vld3q_u8(pSrc + 3 * i);
+		uint8x16x4_t rgba;
+		rgba.val[0] = rgb.val[0];
+		rgba.val[1] = rgb.val[1];
+		rgba.val[2] = rgb.val[2];
+		rgba.val[3] = vdupq_n_u8(0xff);
+		vst4q_u8(pDst + 4 * i, rgba);
+	}
+#elif defined(PIXEL_CONVERSION_SSSE3)
+	// Spread four RGB triplets over four RGBA pixels, then set alpha. The
+	// last load reads 16 bytes starting at pixel i + 12, so stop early enough
+	// not to read past the end of the source.
+	const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	const __m128i opaque = _mm_set1_epi32(int(0xff000000u));
+	for (; i + 18 <= count; i += 16)
+	{
+		const uint8_t *pIn = pSrc + 3 * i;
+		__m128i *pOut = reinterpret_cast<__m128i *>(pDst + 4 * i);
+		for (unsigned j = 0; j < 4; j++)
+		{
+			__m128i rgb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pIn + 12 * j));
+			_mm_storeu_si128(pOut + j, _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), opaque));
+		}
+	}
+#endif
+	for (; i < count; i++)
+	{
+		pDst[4 * i + 0] = pSrc[3 * i + 0];
+		pDst[4 * i + 1] = pSrc[3 * i + 1];
+		pDst[4 * i + 2] = pSrc[3 * i + 2];
+		pDst[4 * i + 3] = 0xff;
+	}
+}
+
+void convertToRgba8888(uint8_t *pDst, const uint8_t *pSrc, size_t count, unsigned components)
+{
+	switch (components)
+	{
+	case 1:
+		convertGreyToRgba8888(pDst, pSrc, count);
+		break;
+
+	case 2:
+		convertGreyAlphaToRgba8888(pDst, pSrc, count);
+		break;
+
+	case 3:
+		convertRgbToRgba8888(pDst, pSrc, count);
+		break;
+
+	case 4:
+		memcpy(pDst, pSrc, count * 4);
+		break;
+	}
+}
+
+void premultiplyRgba8888(uint8_t *pPixels, size_t count)
+{
+	size_t i = 0;
+#if defined(PIXEL_CONVERSION_NEON)
+	for (; i + 16 <= count; i += 16)
+	{
+		uint8x16x4_t rgba = vld4q_u8(pPixels + 4 * i);
+		uint8x8_t alphaLo = vget_low_u8(rgba.val[3]);
+		uint8x8_t alphaHi = vget_high_u8(rgba.val[3]);
+		for (unsigned c = 0; c < 3; c++)
+		{
+			// (x + ((x + 128) >> 8) + 128) >> 8 is x / 255 rounded to nearest.
+			uint16x8_t lo = vmull_u8(vget_low_u8(rgba.val[c]), alphaLo);
+			uint16x8_t hi = vmull_u8(vget_high_u8(rgba.val[c]), alphaHi);
+			rgba.val[c] = vcombine_u8(vraddhn_u16(lo, vrshrq_n_u16(lo, 8)), vraddhn_u16(hi, vrshrq_n_u16(hi, 8)));
+		}
+		vst4q_u8(pPixels + 4 * i, rgba);
+	}
+#elif defined(PIXEL_CONVERSION_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bias = _mm_set1_epi16(128);
+	const __m128i alphaMask = _mm_set1_epi32(int(0xff000000u));
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i *pIo = reinterpret_cast<__m128i *>(pPixels + 4 * i);
+		__m128i rgba = _mm_loadu_si128(pIo);
+
+		// Broadcast alpha to the color components, and multiply alpha by 255
+		// so that it is left unchanged.
+		__m128i alpha = _mm_srli_epi32(rgba, 24);
+		__m128i factor = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 8));
+		factor = _mm_or_si128(factor, _mm_slli_epi32(alpha, 16));
+		factor = _mm_or_si128(factor, alphaMask);
+
+		__m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(rgba, zero), _mm_unpacklo_epi8(factor, zero));
+		__m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(rgba, zero), _mm_unpackhi_epi8(factor, zero));
+		lo = _mm_add_epi16(lo, bias);
+		hi = _mm_add_epi16(hi, bias);
+		lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+		hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+		_mm_storeu_si128(pIo, _mm_packus_epi16(lo, hi));
+	}
+#endif
+	for (; i < count; i++)
+	{
+		uint8_t *pPixel = pPixels + 4 * i;
+		unsigned alpha = pPixel[3];
+		pPixel[0] = multiplyUnorm8(pPixel[0], alpha);
+		pPixel[1] = multiplyUnorm8(pPixel[1], alpha);
+		pPixel[2] = multiplyUnorm8(pPixel[2], alpha);
+	}
+}
+}
@@ -0,0 +1,48 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FRAMEWORK_PIXEL_CONVERSION_HPP
+#define FRAMEWORK_PIXEL_CONVERSION_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace MaliSDK
+{
+/// @brief Expands 8-bit pixels to VK_FORMAT_R8G8B8A8_UNORM.
+///
+/// Uses NEON or SSE2 where available.
+/// @param[out] pDst The converted pixels, 4 bytes per pixel.
+/// @param pSrc The source pixels. Must not overlap pDst.
+/// @param count The number of pixels.
+/// @param components The number of components in the source: 1 for grey,
+/// 2 for grey and alpha, 3 for RGB and 4 for RGBA.
+void convertToRgba8888(uint8_t *pDst, const uint8_t *pSrc, size_t count, unsigned components);
+
+/// @brief Multiplies the color components of VK_FORMAT_R8G8B8A8_UNORM pixels
+/// by their alpha component in place, rounding to nearest.
+///
+/// Uses NEON or SSE2 where available.
+/// @param[in,out] pPixels The pixels, 4 bytes per pixel.
+/// @param count The number of pixels.
+void premultiplyRgba8888(uint8_t *pPixels, size_t count);
+}
+
+#endif
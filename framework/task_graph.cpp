@@ -0,0 +1,171 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "task_graph.hpp"
+#include <utility>
+
+using namespace std;
+
+namespace MaliSDK
+{
+TaskGraph::TaskGraph(ThreadPool &pool)
+    : pool(pool)
+{
+}
+
+TaskGraph::~TaskGraph()
+{
+	wait();
+}
+
+TaskGraph::TaskHandle TaskGraph::addTask(std::function<void(unsigned)> func)
+{
+	nodes.emplace_back(new Node);
+	nodes.back()->func = move(func);
+	needsValidation = true;
+	return nodes.size() - 1;
+}
+
+void TaskGraph::addDependency(TaskHandle task, TaskHandle dependency)
+{
+	nodes[dependency]->successors.push_back(task);
+	nodes[task]->dependencyCount++;
+	needsValidation = true;
+}
+
+void TaskGraph::clear()
+{
+	wait();
+	nodes.clear();
+	needsValidation = true;
+}
+
+Result TaskGraph::run()
+{
+	wait();
+	if (nodes.empty())
+		return RESULT_SUCCESS;
+
+	// A task on a cycle would never become ready, and wait() would never return.
+	if (needsValidation)
+	{
+		if (hasCycle())
+		{
+			LOGE("Task graph dependencies form a cycle.\n");
+			return RESULT_ERROR_GENERIC;
+		}
+		needsValidation = false;
+	}
+
+	// Reset all counters before any task can start, since a task which completes
+	// early will decrement the counters of its successors.
+	vector<TaskHandle> roots;
+	for (unsigned i = 0; i < nodes.size(); i++)
+	{
+		nodes[i]->pendingDependencies = nodes[i]->dependencyCount;
+		if (nodes[i]->dependencyCount == 0)
+			roots.push_back(i);
+	}
+
+	done = false;
+	remaining = nodes.size();
+
+	for (auto root : roots)
+		schedule(root);
+
+	return RESULT_SUCCESS;
+}
+
+bool TaskGraph::hasCycle() const
+{
+	// Remove tasks without unfinished dependencies one by one, like the graph
+	// would run on a single thread. Any task which is left is on a cycle or
+	// depends on one.
+	vector<unsigned> counts(nodes.size());
+	vector<TaskHandle> ready;
+	for (unsigned i = 0; i < nodes.size(); i++)
+	{
+		counts[i] = nodes[i]->dependencyCount;
+		if (counts[i] == 0)
+			ready.push_back(i);
+	}
+
+	unsigned visited = 0;
+	while (!ready.empty())
+	{
+		TaskHandle task = ready.back();
+		ready.pop_back();
+		visited++;
+
+		for (auto successor : nodes[task]->successors)
+			if (--counts[successor] == 0)
+				ready.push_back(successor);
+	}
+
+	return visited != nodes.size();
+}
+
+void TaskGraph::wait()
+{
+	unique_lock<mutex> holder{ lock };
+	cond.wait(holder, [this] { return done; });
+}
+
+void TaskGraph::schedule(TaskHandle task)
+{
+	// Without worker threads, this runs the task on the calling thread.
+	pool.pushWork([this, task](unsigned threadIndex) { execute(threadIndex, task); });
+}
+
+void TaskGraph::execute(unsigned threadIndex, TaskHandle task)
+{
+	while (task != ~0u)
+	{
+		Node &node = *nodes[task];
+		node.func(threadIndex);
+
+		// Release our successors. The first one which becomes ready is run as a
+		// continuation on this thread, the rest go through the thread pool.
+		TaskHandle continuation = ~0u;
+		for (auto successor : node.successors)
+		{
+			if (nodes[successor]->pendingDependencies.fetch_sub(1) == 1)
+			{
+				if (continuation == ~0u)
+					continuation = successor;
+				else
+					schedule(successor);
+			}
+		}
+
+		// If this was the last task, the graph can be destroyed as soon as we
+		// notify, so do not touch any members afterwards.
+		if (remaining.fetch_sub(1) == 1)
+		{
+			lock_guard<mutex> holder{ lock };
+			done = true;
+			cond.notify_all();
+			return;
+		}
+
+		task = continuation;
+	}
+}
+}
@@ -0,0 +1,127 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FRAMEWORK_TASK_GRAPH_HPP
+#define FRAMEWORK_TASK_GRAPH_HPP
+
+#include "common.hpp"
+#include "thread_pool.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace MaliSDK
+{
+/// @brief A graph of tasks with dependencies which runs on a @ref ThreadPool.
+///
+/// Rather than pushing work to the thread pool and waiting for the entire pool
+/// to go idle between every stage of a frame, tasks declare which other tasks
+/// they depend on. Every task keeps a counter of unfinished dependencies, and
+/// when a task completes, it decrements the counters of the tasks which depend
+/// on it. Tasks whose counters reach zero are scheduled immediately, and one
+/// of them continues directly on the thread which completed the task.
+/// This way, independent stages overlap without a full barrier between them.
+///
+/// The graph is built once and can be run many times, e.g. once per frame.
+/// The graph is not modified while running, so tasks must be added before
+/// @ref run is called.
+class TaskGraph
+{
+public:
+	/// @brief Identifies a task in the graph.
+	typedef unsigned TaskHandle;
+
+	/// @brief Constructor
+	/// @param pool The thread pool which will execute the tasks.
+	TaskGraph(ThreadPool &pool);
+
+	/// @brief Destructor. Waits for the graph to complete if it is running.
+	~TaskGraph();
+
+	/// @brief Adds a task to the graph.
+	/// @param func The function object to execute. The index of the worker
+	/// thread executing the task is passed in.
+	/// @returns A handle to the new task.
+	TaskHandle addTask(std::function<void(unsigned)> func);
+
+	/// @brief Declares that a task cannot start before another task has
+	/// completed.
+	///
+	/// The dependencies must not form a cycle, or @ref run will fail.
+	/// @param task The task which must wait.
+	/// @param dependency The task which must complete first.
+	void addDependency(TaskHandle task, TaskHandle dependency);
+
+	/// @brief Removes all tasks from the graph.
+	/// Must not be called while the graph is running.
+	void clear();
+
+	/// @brief Gets the number of tasks in the graph.
+	unsigned getTaskCount() const
+	{
+		return nodes.size();
+	}
+
+	/// @brief Starts executing the graph on the thread pool.
+	/// This call does not block. Use @ref wait to wait for completion.
+	/// @returns Error code. Fails if the dependencies form a cycle.
+	Result run();
+
+	/// @brief Checks if all tasks from the last @ref run have completed.
+	/// @returns true if the graph has completed.
+	bool isComplete() const
+	{
+		return remaining.load() == 0;
+	}
+
+	/// @brief Waits for all tasks from the last @ref run to complete.
+	void wait();
+
+private:
+	struct Node
+	{
+		std::function<void(unsigned)> func;
+		std::vector<TaskHandle> successors;
+		unsigned dependencyCount = 0;
+		std::atomic<unsigned> pendingDependencies{ 0 };
+	};
+
+	ThreadPool &pool;
+	std::vector<std::unique_ptr<Node>> nodes;
+
+	std::atomic<unsigned> remaining{ 0 };
+	std::mutex lock;
+	std::condition_variable cond;
+	bool done = true;
+
+	// Set when tasks or dependencies change, so the graph is only checked for
+	// cycles once rather than on every run.
+	bool needsValidation = true;
+
+	bool hasCycle() const;
+	void schedule(TaskHandle task);
+	void execute(unsigned threadIndex, TaskHandle task);
+};
+}
+
+#endif
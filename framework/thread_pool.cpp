@@ -21,82 +21,397 @@
 #include "thread_pool.hpp"
 #include <utility>
 
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
 using namespace std;
 
 namespace MaliSDK
 {
-void ThreadPool::setWorkerThreadCount(unsigned workerThreadCount)
+// The pool and the index of the worker thread, if the current thread is one.
+static thread_local ThreadPool *pCurrentPool = nullptr;
+static thread_local unsigned currentThreadIndex = 0;
+
+// Hints to the CPU that we are in a spin loop, so it can save power and
+// give resources to a sibling hyperthread.
+static inline void cpuRelax()
 {
-	workerThreads.clear();
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+	_mm_pause();
+#elif defined(__aarch64__) || (defined(__arm__) && defined(__ARM_ARCH) && __ARM_ARCH >= 7)
+	__asm__ __volatile__("yield" ::: "memory");
+#endif
+}
+
+ThreadPool::~ThreadPool()
+{
+	stopWorkers();
+}
+
+void ThreadPool::setWorkerThreadCount(unsigned workerThreadCount, CpuClass cpuClass)
+{
+	stopWorkers();
+
+	// Only pin the workers if that actually restricts them to a subset of the
+	// CPUs, so that homogeneous systems behave as if no class was requested.
+	workerAffinity.clear();
+	if (cpuClass != CPU_CLASS_ALL)
+	{
+		vector<CpuInfo> topology = getCpuTopology();
+		vector<unsigned> cpus = getCpuSet(topology, cpuClass);
+		if (cpus.size() < topology.size())
+			workerAffinity = move(cpus);
+	}
+
 	for (unsigned i = 0; i < workerThreadCount; i++)
 		workerThreads.emplace_back(new Worker);
+
+	// Workers can steal from each other, so only start the threads once every
+	// worker has been created.
+	for (unsigned i = 0; i < workerThreadCount; i++)
+		workerThreads[i]->workerThread = thread(&ThreadPool::threadEntry, this, i);
 }
 
-void ThreadPool::pushWorkToThread(unsigned threadIndex, std::function<void()> func)
+unsigned ThreadPool::getCpuCount(CpuClass cpuClass)
 {
-	workerThreads[threadIndex]->pushWork(move(func));
+	return getCpuSet(getCpuTopology(), cpuClass).size();
 }
 
-void ThreadPool::waitIdle()
+void ThreadPool::setWaitPolicy(WaitPolicy policy, unsigned spinIterations)
 {
-	for (auto &worker : workerThreads)
-		worker->waitIdle();
+	spinCount = policy == WAIT_POLICY_SPIN_THEN_PARK ? spinIterations : 0;
+}
+
+ThreadPool::Statistics ThreadPool::getStatistics() const
+{
+	Statistics statistics;
+	statistics.spinIterations = spinIterations.load(memory_order_relaxed);
+	statistics.spinHits = spinHits.load(memory_order_relaxed);
+	statistics.parks = parks.load(memory_order_relaxed);
+	statistics.wakeups = wakeups.load(memory_order_relaxed);
+	return statistics;
 }
 
-ThreadPool::Worker::Worker()
+void ThreadPool::resetStatistics()
 {
-	workerThread = thread(&ThreadPool::Worker::threadEntry, this);
+	spinIterations = 0;
+	spinHits = 0;
+	parks = 0;
+	wakeups = 0;
 }
 
-ThreadPool::Worker::~Worker()
+template <typename Pred>
+bool ThreadPool::spinUntil(const Pred &pred)
 {
-	if (workerThread.joinable())
+	unsigned count = spinCount.load(memory_order_relaxed);
+	if (count == 0)
+		return false;
+
+	unsigned i;
+	for (i = 0; i < count; i++)
 	{
-		waitIdle();
+		if (pred())
+			break;
 
-		lock.lock();
-		threadIsAlive = false;
-		cond.notify_one();
-		lock.unlock();
+		// If there are more threads than CPU cores, the thread we are waiting for
+		// might need our core, so give it up every now and then.
+		if ((i & 255) == 255)
+			this_thread::yield();
+		else
+			cpuRelax();
+	}
 
-		workerThread.join();
+	// Only touch the shared counters once per spin phase.
+	spinIterations.fetch_add(i, memory_order_relaxed);
+	if (i < count)
+	{
+		spinHits.fetch_add(1, memory_order_relaxed);
+		return true;
 	}
+	else
+		return false;
 }
 
-void ThreadPool::Worker::pushWork(std::function<void()> func)
+void ThreadPool::stopWorkers()
 {
-	lock_guard<mutex> holder{ lock };
-	workQueue.push(move(func));
-	cond.notify_one();
+	waitIdle();
+
+	for (auto &worker : workerThreads)
+	{
+		lock_guard<mutex> holder{ worker->lock };
+		worker->threadIsAlive = false;
+		worker->cond.notify_one();
+	}
+
+	for (auto &worker : workerThreads)
+		if (worker->workerThread.joinable())
+			worker->workerThread.join();
+
+	workerThreads.clear();
+	sleepingCount = 0;
 }
 
-void ThreadPool::Worker::waitIdle()
+void ThreadPool::pushPinnedWork(unsigned threadIndex, Work work)
 {
-	unique_lock<mutex> holder{ lock };
-	cond.wait(holder, [this] { return workQueue.empty(); });
+	outstandingWork++;
+
+	// If the queue is full, make sure the worker is awake to drain it. A worker
+	// which pushes to its own queue has to drain it itself, oldest work first.
+	Worker &worker = *workerThreads[threadIndex];
+	bool isOwnQueue = getCurrentThreadIndex() == threadIndex;
+	while (!worker.pinnedQueue.push(move(work)))
+	{
+		Work queued;
+		if (isOwnQueue && worker.pinnedQueue.pop(&queued))
+			runWork(threadIndex, queued);
+		else
+		{
+			wakeWorker(worker);
+			this_thread::yield();
+		}
+	}
+
+	wakeWorker(worker);
 }
 
-void ThreadPool::Worker::threadEntry()
+void ThreadPool::pushStealableWork(unsigned threadIndex, Work work)
 {
+	outstandingWork++;
+
+	// Prefer the requested worker, but any worker with room in its queue will do.
+	unsigned numWorkers = workerThreads.size();
+	unsigned target = threadIndex;
 	for (;;)
 	{
-		function<void()> *pWork = nullptr;
+		unsigned i;
+		for (i = 0; i < numWorkers; i++)
 		{
-			unique_lock<mutex> holder{ lock };
-			cond.wait(holder, [this] { return !workQueue.empty() || !threadIsAlive; });
-			if (!threadIsAlive)
+			target = (threadIndex + i) % numWorkers;
+			if (workerThreads[target]->stealableQueue.push(move(work)))
 				break;
+		}
+
+		if (i < numWorkers)
+			break;
 
-			pWork = &workQueue.front();
+		// Every queue is full. Make room by running queued work ourselves, since
+		// the workers might be waiting for room to push nested work as well.
+		Work queued;
+		unsigned currentIndex = getCurrentThreadIndex();
+		if (popStealableWork(currentIndex, &queued))
+			runWork(currentIndex, queued);
+		else
+		{
+			wakeAnyWorker();
+			this_thread::yield();
 		}
+	}
+
+	// If the owner is already busy, wake up another worker so it can steal the work.
+	if (!wakeWorker(*workerThreads[target]))
+		wakeAnyWorker();
+}
+
+bool ThreadPool::wakeWorker(Worker &worker)
+{
+	// Pairs with the fence in threadEntry. Either we observe that the worker is
+	// going to sleep, or the worker observes the work we just pushed.
+	atomic_thread_fence(memory_order_seq_cst);
+	if (!worker.sleeping.load(memory_order_relaxed))
+		return false;
 
-		(*pWork)();
+	lock_guard<mutex> holder{ worker.lock };
+	if (!worker.sleeping)
+		return false;
 
+	worker.sleeping = false;
+	sleepingCount--;
+	worker.cond.notify_one();
+	wakeups.fetch_add(1, memory_order_relaxed);
+	return true;
+}
+
+void ThreadPool::wakeAnyWorker()
+{
+	atomic_thread_fence(memory_order_seq_cst);
+	if (sleepingCount.load(memory_order_relaxed) == 0)
+		return;
+
+	for (auto &worker : workerThreads)
+		if (wakeWorker(*worker))
+			return;
+}
+
+void ThreadPool::waitIdle()
+{
+	if (outstandingWork == 0)
+		return;
+
+	if (spinUntil([this] { return outstandingWork.load(memory_order_acquire) == 0; }))
+		return;
+
+	unique_lock<mutex> holder{ idleLock };
+	if (outstandingWork != 0)
+		parks.fetch_add(1, memory_order_relaxed);
+	idleCond.wait(holder, [this] { return outstandingWork == 0; });
+}
+
+unsigned ThreadPool::getCurrentThreadIndex()
+{
+	return pCurrentPool == this ? currentThreadIndex : unsigned(workerThreads.size());
+}
+
+void ThreadPool::runWork(unsigned threadIndex, Work &work)
+{
+	work(threadIndex);
+
+	// Make sure captured state is released before anyone waiting on us is
+	// told that the work has completed.
+	work.reset();
+	completeWork();
+}
+
+void ThreadPool::waitForCompletion(Completion &completion)
+{
+	// Rather than sitting idle while our chunks are queued, run them, or
+	// whatever else is queued, ourselves. This also means a worker thread
+	// waiting here will run the chunks nobody else gets to.
+	unsigned threadIndex = getCurrentThreadIndex();
+	Work work;
+	while (!completion.isDone())
+	{
+		if (popStealableWork(threadIndex, &work))
+		{
+			runWork(threadIndex, work);
+			continue;
+		}
+
+		// The remaining chunks are running on other threads. They might push
+		// more work if they are waiting themselves, so keep an eye on the queues.
+		if (spinUntil([&] { return completion.isDone() || hasStealableWork(); }))
+			continue;
+
+		// Parking is fine, since every chunk we are waiting for is running on
+		// a thread which will complete it, and any work it waits for in turn.
+		if (!completion.isDone())
+			parks.fetch_add(1, memory_order_relaxed);
+		break;
+	}
+
+	// Even if we observe completion, we still have to go through wait(), since
+	// the last thread might still be about to signal.
+	completion.wait();
+}
+
+void ThreadPool::completeWork()
+{
+	if (outstandingWork.fetch_sub(1) == 1)
+	{
+		lock_guard<mutex> holder{ idleLock };
+		idleCond.notify_all();
+	}
+}
+
+ThreadPool::Completion::Completion(unsigned count)
+    : remaining(count)
+{
+}
+
+void ThreadPool::Completion::signal()
+{
+	if (remaining.fetch_sub(1) == 1)
+	{
+		lock_guard<mutex> holder{ lock };
+		done = true;
+		cond.notify_one();
+	}
+}
+
+void ThreadPool::Completion::wait()
+{
+	unique_lock<mutex> holder{ lock };
+	cond.wait(holder, [this] { return done; });
+}
+
+bool ThreadPool::hasWork(unsigned threadIndex)
+{
+	return !workerThreads[threadIndex]->pinnedQueue.empty() || hasStealableWork();
+}
+
+bool ThreadPool::hasStealableWork()
+{
+	for (auto &worker : workerThreads)
+		if (!worker->stealableQueue.empty())
+			return true;
+
+	return false;
+}
+
+bool ThreadPool::popStealableWork(unsigned threadIndex, Work *pWork)
+{
+	if (threadIndex < workerThreads.size() && workerThreads[threadIndex]->stealableQueue.pop(pWork))
+		return true;
+
+	return stealWork(threadIndex, pWork);
+}
+
+bool ThreadPool::stealWork(unsigned threadIndex, Work *pWork)
+{
+	// Threads which are not workers have an index past the last worker, and
+	// can steal from every worker.
+	unsigned numWorkers = workerThreads.size();
+	for (unsigned i = 0; i < numWorkers; i++)
+	{
+		unsigned victim = (threadIndex + 1 + i) % numWorkers;
+		if (victim != threadIndex && workerThreads[victim]->stealableQueue.pop(pWork))
+			return true;
+	}
+
+	return false;
+}
+
+void ThreadPool::threadEntry(unsigned threadIndex)
+{
+	Worker &worker = *workerThreads[threadIndex];
+	Work work;
+
+	if (!workerAffinity.empty())
+		setCurrentThreadAffinity(workerAffinity);
+
+	pCurrentPool = this;
+	currentThreadIndex = threadIndex;
+
+	while (worker.threadIsAlive)
+	{
+		// Pinned work has priority since nobody else can run it.
+		if (worker.pinnedQueue.pop(&work) || popStealableWork(threadIndex, &work))
 		{
-			lock_guard<mutex> holder{ lock };
-			workQueue.pop();
-			cond.notify_one();
+			runWork(threadIndex, work);
+			continue;
 		}
+
+		// Out of work. Spin for a while in case more work arrives soon,
+		// which is much cheaper than going to sleep and being woken up again.
+		if (spinUntil([&] { return hasWork(threadIndex) || !worker.threadIsAlive; }))
+			continue;
+
+		// Go to sleep.
+		unique_lock<mutex> holder{ worker.lock };
+		worker.sleeping = true;
+		sleepingCount++;
+
+		// Pairs with the fence in wakeWorker.
+		atomic_thread_fence(memory_order_seq_cst);
+		if (hasWork(threadIndex) || !worker.threadIsAlive)
+		{
+			worker.sleeping = false;
+			sleepingCount--;
+			continue;
+		}
+
+		parks.fetch_add(1, memory_order_relaxed);
+		worker.cond.wait(holder, [&worker] { return !worker.sleeping || !worker.threadIsAlive; });
 	}
 }
 }
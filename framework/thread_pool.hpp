@@ -21,32 +21,128 @@
 #ifndef FRAMEWORK_THREAD_POOL_HPP
 #define FRAMEWORK_THREAD_POOL_HPP
 
+#include "bounded_queue.hpp"
+#include "cpu_topology.hpp"
+#include "inline_function.hpp"
+#include <atomic>
 #include <condition_variable>
-#include <functional>
 #include <memory>
 #include <mutex>
-#include <queue>
+#include <stdint.h>
 #include <thread>
+#include <utility>
+#include <vector>
 
 namespace MaliSDK
 {
 
 /// @brief Implements a simple thread pool which can be used to submit rendering
-/// work to multiple
-/// threads. It does not aim to distribute chunks of work dynamically to
-/// threads, but API users
-/// must submit work to particular worker threads.
+/// work to multiple threads.
+///
+/// Work can either be pinned to a particular worker thread with
+/// @ref pushWorkToThread, or be pushed with @ref pushWork or @ref parallelFor.
+/// The latter is placed in per-worker queues, and idle workers will steal work
+/// from busy workers so that uneven workloads are balanced dynamically.
+/// Both the owner and thieves take work from the front of a queue, so work
+/// pushed to a worker starts in submission order. A thread which waits in
+/// @ref parallelFor steals work as well, so it can be called from any thread,
+/// including worker threads of the same pool.
+///
+/// Work is stored in fixed-size @ref InlineFunction objects in lock-free
+/// queues, so submitting work does not allocate memory, and does not lock
+/// any mutexes unless a worker thread is asleep and needs to be woken up.
+/// With @ref WAIT_POLICY_SPIN_THEN_PARK, threads spin for a while before
+/// going to sleep, which avoids most sleep/wake round trips when work arrives
+/// at a high rate.
 class ThreadPool
 {
 public:
+	/// @brief Describes how worker threads and waiting threads behave when there
+	/// is nothing to do.
+	enum WaitPolicy
+	{
+		/// Go to sleep on a condition variable right away.
+		WAIT_POLICY_PARK,
+
+		/// Spin for a bounded number of iterations before going to sleep.
+		WAIT_POLICY_SPIN_THEN_PARK
+	};
+
+	/// @brief The default number of spin iterations for
+	/// WAIT_POLICY_SPIN_THEN_PARK.
+	enum
+	{
+		DefaultSpinIterations = 4096
+	};
+
+	/// @brief Counters which describe how threads in the pool have waited.
+	struct Statistics
+	{
+		/// Total number of iterations spent spinning.
+		uint64_t spinIterations;
+		/// Number of times spinning found work or completion before parking.
+		uint64_t spinHits;
+		/// Number of times a thread went to sleep.
+		uint64_t parks;
+		/// Number of times a sleeping worker thread had to be woken up.
+		uint64_t wakeups;
+	};
+
+	/// @brief The type-erased work item stored in the worker queues.
+	/// Function objects (including lambda captures) must fit in 48 bytes.
+	typedef InlineFunction<void(unsigned), 48> Work;
+
+	/// @brief The maximum number of work items which can be queued per worker
+	/// thread. If a queue is full, submission will wait until there is room.
+	/// A worker which pushes to its own full queue runs queued work instead.
+	enum
+	{
+		QueueSize = 256
+	};
+
+	/// @brief Destructor
+	~ThreadPool();
+
 	/// @brief Sets the number of worker threads to spawn.
 	///
 	/// This call is heavyweight and should not be called more than once during
 	/// initialization.
 	/// To get a platform specific optimal count to use, use
-	/// `MaliSDK::OS::getNumberOfCpuThreads`.
+	/// `MaliSDK::OS::getNumberOfCpuThreads`, or @ref getCpuCount to only count
+	/// the CPUs of a particular class.
+	///
+	/// On systems with CPUs of different capacity, such as big.LITTLE, the
+	/// workers can be restricted to a class of CPUs. CPU_CLASS_PERFORMANCE is
+	/// intended for latency sensitive work like command buffer recording, and
+	/// CPU_CLASS_EFFICIENCY for background work. With CPU_CLASS_ALL, the
+	/// workers are not pinned and the OS scheduler decides where they run.
 	/// @param workerThreadCount The number of worker threads.
-	void setWorkerThreadCount(unsigned workerThreadCount);
+	/// @param cpuClass The class of CPUs the worker threads may run on.
+	void setWorkerThreadCount(unsigned workerThreadCount, CpuClass cpuClass = CPU_CLASS_ALL);
+
+	/// @brief Gets the number of CPUs in a CPU class.
+	/// @param cpuClass The class of CPUs to count.
+	/// @returns The number of CPUs.
+	static unsigned getCpuCount(CpuClass cpuClass);
+
+	/// @brief Sets how threads wait when there is nothing to do.
+	///
+	/// Spinning trades CPU time and power for lower latency, and is mostly
+	/// useful when small jobs are submitted at a high rate, e.g. every frame.
+	/// The policy applies both to worker threads and to threads waiting in
+	/// @ref waitIdle and @ref parallelFor.
+	/// @param policy The wait policy.
+	/// @param spinIterations The number of iterations to spin before parking
+	/// with WAIT_POLICY_SPIN_THEN_PARK.
+	void setWaitPolicy(WaitPolicy policy, unsigned spinIterations = DefaultSpinIterations);
+
+	/// @brief Gets the wait counters accumulated since the last call to
+	/// @ref resetStatistics.
+	/// @returns The counters.
+	Statistics getStatistics() const;
+
+	/// @brief Resets all wait counters to zero.
+	void resetStatistics();
 
 	/// @brief Gets the current number of worker threads.
 	unsigned getWorkerThreadCount() const
@@ -59,34 +155,174 @@ public:
 	/// @param func A generic function object which will be executed by the
 	/// thread.
 	/// Using C++11 lambdas is the intended way to create these objects.
-	void pushWorkToThread(unsigned threadIndex, std::function<void()> func);
+	template <typename Func>
+	void pushWorkToThread(unsigned threadIndex, Func &&func)
+	{
+		pushPinnedWork(threadIndex,
+		               Work(IgnoreThreadIndex<typename std::decay<Func>::type>{ std::forward<Func>(func) }));
+	}
+
+	/// @brief Pushes a bundle of work which can be executed by any worker thread.
+	///
+	/// If the pool has no worker threads, the work is executed right away on
+	/// the calling thread with a thread index of 0.
+	/// @param func A function object which will be executed by a worker thread.
+	/// The index of the worker thread which executes the work is passed in.
+	/// Work can also be stolen by a thread waiting in @ref parallelFor which
+	/// is not a worker thread, in which case the index is
+	/// @ref getWorkerThreadCount.
+	template <typename Func>
+	void pushWork(Func &&func)
+	{
+		unsigned numWorkers = workerThreads.size();
+		if (numWorkers == 0)
+		{
+			func(0u);
+			return;
+		}
+
+		pushStealableWork(nextWorker++ % numWorkers, Work(std::forward<Func>(func)));
+	}
+
+	/// @brief Splits the range [begin, end) into chunks of at most grain
+	/// elements and distributes them over the worker threads.
+	///
+	/// Idle workers will steal chunks from busy ones, so a few expensive chunks
+	/// do not hold back the rest of the pool.
+	/// This call blocks until all chunks have completed. While it waits, the
+	/// calling thread runs chunks and other stealable work itself, so calling
+	/// this from a worker thread of the same pool does not deadlock.
+	/// The calling thread runs work with its own thread index if it is a
+	/// worker thread of the pool, and with @ref getWorkerThreadCount otherwise,
+	/// so per-thread state must have room for getWorkerThreadCount() + 1
+	/// threads.
+	/// @param begin The first index of the range.
+	/// @param end One past the last index of the range.
+	/// @param grain The maximum number of indices processed by a single chunk.
+	/// @param func Function object called as func(threadIndex, chunkBegin,
+	/// chunkEnd) for every chunk.
+	template <typename Func>
+	void parallelFor(unsigned begin, unsigned end, unsigned grain, const Func &func)
+	{
+		if (begin >= end)
+			return;
+		if (grain == 0)
+			grain = 1;
+
+		unsigned numWorkers = workerThreads.size();
+		if (numWorkers == 0)
+		{
+			func(0, begin, end);
+			return;
+		}
+
+		unsigned numChunks = (end - begin + grain - 1) / grain;
+		Completion completion(numChunks);
+
+		// Distribute the chunks evenly up front. Workers which run out of chunks
+		// will steal from the others.
+		unsigned firstWorker = nextWorker++;
+		for (unsigned i = 0; i < numChunks; i++)
+		{
+			unsigned chunkBegin = begin + i * grain;
+			unsigned chunkEnd = end - chunkBegin > grain ? chunkBegin + grain : end;
+			Completion *pCompletion = &completion;
+			const Func *pFunc = &func;
+
+			pushStealableWork((firstWorker + i) % numWorkers, Work([=](unsigned threadIndex) {
+				                  (*pFunc)(threadIndex, chunkBegin, chunkEnd);
+				                  pCompletion->signal();
+				              }));
+		}
+
+		waitForCompletion(completion);
+	}
 
 	/// @brief Waits for all worker threads to complete all work they have been
 	/// assigned.
 	void waitIdle();
 
 private:
-	class Worker
+	template <typename Func>
+	struct IgnoreThreadIndex
 	{
-	public:
-		Worker();
-		~Worker();
+		Func func;
+		void operator()(unsigned)
+		{
+			func();
+		}
+	};
 
-		void pushWork(std::function<void()> func);
-		void waitIdle();
+	/// Tracks completion of a fixed number of work items.
+	class Completion
+	{
+	public:
+		Completion(unsigned count);
+		void signal();
+		void wait();
+		bool isDone() const
+		{
+			return remaining.load() == 0;
+		}
 
 	private:
-		std::thread workerThread;
+		std::atomic<unsigned> remaining;
 		std::mutex lock;
 		std::condition_variable cond;
+		bool done = false;
+	};
 
-		std::queue<std::function<void()>> workQueue;
-		bool threadIsAlive = true;
+	struct Worker
+	{
+		std::thread workerThread;
+
+		// Work which can only run on this thread.
+		BoundedQueue<Work, QueueSize> pinnedQueue;
+		// Work which is owned by this thread, but can be stolen by other threads.
+		// The owner and thieves both pop from the front.
+		BoundedQueue<Work, QueueSize> stealableQueue;
 
-		void threadEntry();
+		// Only used when the worker goes to sleep.
+		std::mutex lock;
+		std::condition_variable cond;
+		std::atomic<bool> sleeping{ false };
+		std::atomic<bool> threadIsAlive{ true };
 	};
 
 	std::vector<std::unique_ptr<Worker>> workerThreads;
+
+	// The CPUs worker threads are pinned to, or empty if they are not pinned.
+	std::vector<unsigned> workerAffinity;
+
+	std::atomic<unsigned> outstandingWork{ 0 };
+	std::mutex idleLock;
+	std::condition_variable idleCond;
+
+	std::atomic<unsigned> sleepingCount{ 0 };
+	std::atomic<unsigned> nextWorker{ 0 };
+
+	std::atomic<unsigned> spinCount{ 0 };
+	std::atomic<uint64_t> spinIterations{ 0 };
+	std::atomic<uint64_t> spinHits{ 0 };
+	std::atomic<uint64_t> parks{ 0 };
+	std::atomic<uint64_t> wakeups{ 0 };
+
+	void pushPinnedWork(unsigned threadIndex, Work work);
+	void pushStealableWork(unsigned threadIndex, Work work);
+	bool wakeWorker(Worker &worker);
+	void wakeAnyWorker();
+	bool hasWork(unsigned threadIndex);
+	bool hasStealableWork();
+	bool stealWork(unsigned threadIndex, Work *pWork);
+	bool popStealableWork(unsigned threadIndex, Work *pWork);
+	unsigned getCurrentThreadIndex();
+	void runWork(unsigned threadIndex, Work &work);
+	void completeWork();
+	void waitForCompletion(Completion &completion);
+	template <typename Pred>
+	bool spinUntil(const Pred &pred);
+	void stopWorkers();
+	void threadEntry(unsigned threadIndex);
 };
 }
 
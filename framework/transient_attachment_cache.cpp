@@ -0,0 +1,202 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "transient_attachment_cache.hpp"
+
+using namespace std;
+
+namespace MaliSDK
+{
+static VkImageAspectFlags getAspectMask(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_D16_UNORM:
+	case VK_FORMAT_X8_D24_UNORM_PACK32:
+	case VK_FORMAT_D32_SFLOAT:
+		return VK_IMAGE_ASPECT_DEPTH_BIT;
+
+	case VK_FORMAT_S8_UINT:
+		return VK_IMAGE_ASPECT_STENCIL_BIT;
+
+	case VK_FORMAT_D16_UNORM_S8_UINT:
+	case VK_FORMAT_D24_UNORM_S8_UINT:
+	case VK_FORMAT_D32_SFLOAT_S8_UINT:
+		return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+
+	default:
+		return VK_IMAGE_ASPECT_COLOR_BIT;
+	}
+}
+
+TransientAttachmentCache::TransientAttachmentCache(VkDevice device, DeviceMemoryAllocator &allocator)
+    : device(device)
+    , allocator(allocator)
+{
+}
+
+TransientAttachmentCache::~TransientAttachmentCache()
+{
+	for (auto &entry : entries)
+	{
+		if (entry.refCount != 0)
+			LOGE("Transient attachment was not released.\n");
+		destroyEntry(entry);
+	}
+}
+
+void TransientAttachmentCache::createEntry(Entry &entry)
+{
+	VkImageCreateInfo info = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+	info.imageType = VK_IMAGE_TYPE_2D;
+	info.format = entry.format;
+	info.extent.width = entry.width;
+	info.extent.height = entry.height;
+	info.extent.depth = 1;
+	info.mipLevels = 1;
+	info.arrayLayers = 1;
+	info.samples = entry.samples;
+	info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	info.tiling = VK_IMAGE_TILING_OPTIMAL;
+	info.usage = entry.usage;
+	info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	VK_CHECK(vkCreateImage(device, &info, nullptr, &entry.attachment.image));
+
+	// Prefer lazily allocated memory, which is not committed unless it is
+	// actually needed. On tile-based GPUs, it never is.
+	VkMemoryRequirements memReqs;
+	vkGetImageMemoryRequirements(device, entry.attachment.image, &memReqs);
+	MemoryTagScope scope(MEMORY_TAG_ATTACHMENT);
+	VK_CHECK(allocator.allocate(memReqs, MemoryTypeSelector::USAGE_TRANSIENT, DeviceMemoryAllocator::RESOURCE_OPTIMAL,
+	                            &entry.allocation));
+	VK_CHECK(vkBindImageMemory(device, entry.attachment.image, entry.allocation.memory, entry.allocation.offset));
+
+	entry.size = memReqs.size;
+	entry.lazilyAllocated = (allocator.getMemoryTypeSelector().getPropertyFlags(entry.allocation.memoryTypeIndex) &
+	                         VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0;
+
+	VkImageViewCreateInfo viewInfo = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+	viewInfo.image = entry.attachment.image;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = entry.format;
+	viewInfo.components.r = VK_COMPONENT_SWIZZLE_R;
+	viewInfo.components.g = VK_COMPONENT_SWIZZLE_G;
+	viewInfo.components.b = VK_COMPONENT_SWIZZLE_B;
+	viewInfo.components.a = VK_COMPONENT_SWIZZLE_A;
+	viewInfo.subresourceRange.aspectMask = getAspectMask(entry.format);
+	viewInfo.subresourceRange.levelCount = 1;
+	viewInfo.subresourceRange.layerCount = 1;
+	VK_CHECK(vkCreateImageView(device, &viewInfo, nullptr, &entry.attachment.view));
+
+	LOGI("Created %ux%u transient attachment with %u samples, %u KiB %s.\n", entry.width, entry.height,
+	     unsigned(entry.samples), unsigned(entry.size / 1024),
+	     entry.lazilyAllocated ? "lazily allocated" : "allocated");
+}
+
+void TransientAttachmentCache::destroyEntry(Entry &entry)
+{
+	vkDestroyImageView(device, entry.attachment.view, nullptr);
+	vkDestroyImage(device, entry.attachment.image, nullptr);
+	allocator.free(entry.allocation);
+}
+
+TransientAttachment TransientAttachmentCache::request(VkFormat format, unsigned width, unsigned height,
+                                                      VkSampleCountFlagBits samples, VkImageUsageFlags usage,
+                                                      unsigned index)
+{
+	usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+	for (auto &entry : entries)
+	{
+		if (entry.format == format && entry.width == width && entry.height == height && entry.samples == samples &&
+		    entry.usage == usage && entry.index == index)
+		{
+			entry.refCount++;
+			return entry.attachment;
+		}
+	}
+
+	Entry entry;
+	entry.format = format;
+	entry.width = width;
+	entry.height = height;
+	entry.samples = samples;
+	entry.usage = usage;
+	entry.index = index;
+	entry.refCount = 1;
+	entry.releaseFrame = 0;
+	createEntry(entry);
+
+	entries.push_back(entry);
+	return entry.attachment;
+}
+
+void TransientAttachmentCache::release(const TransientAttachment &attachment)
+{
+	for (auto &entry : entries)
+	{
+		if (entry.attachment.image == attachment.image)
+		{
+			if (entry.refCount == 0)
+				LOGE("Transient attachment was released too many times.\n");
+			else if (--entry.refCount == 0)
+				entry.releaseFrame = frame;
+			return;
+		}
+	}
+
+	LOGE("Released transient attachment which does not belong to the cache.\n");
+}
+
+void TransientAttachmentCache::beginFrame(unsigned framesInFlight)
+{
+	frame++;
+
+	// The frame an attachment was released in has completed once
+	// framesInFlight new frames have begun.
+	auto itr = entries.begin();
+	while (itr != entries.end())
+	{
+		if (itr->refCount == 0 && frame - itr->releaseFrame >= framesInFlight)
+		{
+			destroyEntry(*itr);
+			itr = entries.erase(itr);
+		}
+		else
+			++itr;
+	}
+}
+
+TransientAttachmentCache::Stats TransientAttachmentCache::getStats() const
+{
+	Stats stats = {};
+	for (auto &entry : entries)
+	{
+		stats.attachmentCount++;
+		stats.requestCount += entry.refCount;
+		stats.totalBytes += entry.size;
+		if (entry.lazilyAllocated)
+			stats.lazilyAllocatedBytes += entry.size;
+		if (entry.refCount > 1)
+			stats.sharedBytes += (entry.refCount - 1) * entry.size;
+	}
+	return stats;
+}
+}
@@ -0,0 +1,156 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FRAMEWORK_TRANSIENT_ATTACHMENT_CACHE_HPP
+#define FRAMEWORK_TRANSIENT_ATTACHMENT_CACHE_HPP
+
+#include "device_memory_allocator.hpp"
+#include "framework/common.hpp"
+#include <vector>
+
+namespace MaliSDK
+{
+/// @brief An image which only lives during a render pass.
+struct TransientAttachment
+{
+	/// The image.
+	VkImage image = VK_NULL_HANDLE;
+
+	/// A view of all aspects of the image, to be used in a framebuffer.
+	VkImageView view = VK_NULL_HANDLE;
+};
+
+/// @brief Creates and shares attachments whose contents never leave a render
+/// pass, such as depth buffers and multisampled color attachments which are
+/// resolved.
+///
+/// On tile-based GPUs such attachments only ever live in tile memory, so
+/// they are created with VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT and backed by
+/// lazily allocated memory if the device has such a memory type. This memory
+/// is never committed unless the driver has to spill the tile buffer.
+///
+/// Attachments are cached by format, extent, sample count and usage.
+/// Render passes which request the same attachment share it, since the
+/// contents are discarded at the end of every render pass anyway. A render
+/// pass which needs two attachments with identical properties requests them
+/// with different indices.
+///
+/// Attachments which are no longer referenced are destroyed once the GPU is
+/// done with the frames they might have been used in.
+class TransientAttachmentCache
+{
+public:
+	/// @brief Describes the memory used by the cache.
+	struct Stats
+	{
+		/// The number of attachments which are currently allocated.
+		unsigned attachmentCount;
+
+		/// The number of outstanding requests, which can be more than
+		/// attachmentCount since requests share attachments.
+		unsigned requestCount;
+
+		/// The total memory size of the attachments.
+		VkDeviceSize totalBytes;
+
+		/// The memory size of the attachments which are backed by lazily
+		/// allocated memory, which normally never gets committed.
+		VkDeviceSize lazilyAllocatedBytes;
+
+		/// The memory size sharing saves compared to allocating an attachment
+		/// for every request.
+		VkDeviceSize sharedBytes;
+	};
+
+	/// @brief Constructor
+	/// @param device The Vulkan device.
+	/// @param allocator The allocator to get memory from.
+	TransientAttachmentCache(VkDevice device, DeviceMemoryAllocator &allocator);
+
+	/// @brief Destructor. The GPU must be done with all attachments.
+	~TransientAttachmentCache();
+
+	/// @brief Requests an attachment.
+	///
+	/// Every request must be matched by a call to @ref release.
+	/// The contents of the attachment are undefined at the start of every
+	/// render pass, so render passes must not load or store it.
+	/// @param format The format of the attachment.
+	/// @param width The width of the attachment.
+	/// @param height The height of the attachment.
+	/// @param samples The sample count of the attachment.
+	/// @param usage The attachment usage, e.g.
+	/// VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT. Only attachment usages are
+	/// allowed. VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT is added implicitly.
+	/// @param index Distinguishes attachments with identical properties which
+	/// are used at the same time.
+	/// @returns The attachment
+	TransientAttachment request(VkFormat format, unsigned width, unsigned height, VkSampleCountFlagBits samples,
+	                            VkImageUsageFlags usage, unsigned index = 0);
+
+	/// @brief Releases an attachment obtained from @ref request.
+	///
+	/// The attachment may still be in use by the GPU.
+	/// @param attachment The attachment to release.
+	void release(const TransientAttachment &attachment);
+
+	/// @brief Called by the Context at the start of a frame. Destroys
+	/// attachments which were released at least framesInFlight frames ago and
+	/// have not been requested again since.
+	/// @param framesInFlight The number of frames which can be in flight on
+	/// the GPU.
+	void beginFrame(unsigned framesInFlight);
+
+	/// @brief Gets statistics about the memory used by the cache.
+	/// @returns The statistics
+	Stats getStats() const;
+
+private:
+	struct Entry
+	{
+		VkFormat format;
+		unsigned width;
+		unsigned height;
+		VkSampleCountFlagBits samples;
+		VkImageUsageFlags usage;
+		unsigned index;
+
+		TransientAttachment attachment;
+		DeviceAllocation allocation;
+		VkDeviceSize size;
+		bool lazilyAllocated;
+		unsigned refCount;
+		uint64_t releaseFrame;
+	};
+
+	VkDevice device;
+	DeviceMemoryAllocator &allocator;
+
+	// There are only a handful of attachments, so they are looked up
+	// linearly.
+	std::vector<Entry> entries;
+	uint64_t frame = 0;
+
+	void createEntry(Entry &entry);
+	void destroyEntry(Entry &entry);
+};
+}
+
+#endif
@@ -0,0 +1,115 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "uniform_ring_buffer.hpp"
+#include <algorithm>
+
+using namespace std;
+
+namespace MaliSDK
+{
+UniformRingBuffer::UniformRingBuffer(VkDevice device, DeviceMemoryAllocator &allocator,
+                                     const VkPhysicalDeviceLimits &limits, unsigned frameCount, VkDeviceSize frameSize)
+    : device(device)
+    , allocator(allocator)
+    , frameCount(frameCount)
+{
+	// Offsets are aligned to a power of two, so keeping the sizes a multiple
+	// of the alignment means that wrapping around keeps offsets aligned.
+	alignment = max(limits.minUniformBufferOffsetAlignment, VkDeviceSize(16));
+	this->frameSize = (frameSize + alignment - 1) & ~(alignment - 1);
+
+	// Data is retired one frame at a time, so at most frameCount frames are
+	// live at once. Live data can straddle the end of the buffer once, which
+	// wastes less than one allocation, so one more frame covers that.
+	size = VkDeviceSize(frameCount + 1) * this->frameSize;
+
+	VkBufferCreateInfo info = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+	info.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+	info.size = this->size;
+	VK_CHECK(vkCreateBuffer(device, &info, nullptr, &buffer));
+
+	VkMemoryRequirements memReqs;
+	vkGetBufferMemoryRequirements(device, buffer, &memReqs);
+
+	// Upload memory is coherent, so writes never need to be flushed.
+	MemoryTagScope scope(MEMORY_TAG_UNIFORM);
+	VK_CHECK(allocator.allocate(memReqs, MemoryTypeSelector::USAGE_UPLOAD, DeviceMemoryAllocator::RESOURCE_LINEAR,
+	                            &allocation));
+	VK_CHECK(vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset));
+}
+
+UniformRingBuffer::~UniformRingBuffer()
+{
+	vkDestroyBuffer(device, buffer, nullptr);
+	allocator.free(allocation);
+}
+
+void *UniformRingBuffer::allocate(VkDeviceSize allocationSize, uint32_t *pOffset)
+{
+	lock_guard<mutex> holder{ lock };
+
+	uint64_t begin = (head + alignment - 1) & ~uint64_t(alignment - 1);
+
+	// Ranges must be contiguous in the buffer, so skip to the start of the
+	// buffer if the range would straddle the end.
+	VkDeviceSize offset = begin % size;
+	if (offset + allocationSize > size)
+	{
+		begin += size - offset;
+		offset = 0;
+	}
+
+	// Staying within the budget of the frame is what guarantees the ring has
+	// room, so treat it like any other broken invariant.
+	VkDeviceSize alignedSize = (allocationSize + alignment - 1) & ~(alignment - 1);
+	if (frameUsed + alignedSize > frameSize || begin + allocationSize - tail > size)
+	{
+		LOGE("Uniform ring allocation of %u bytes exceeds the budget of %u bytes per frame.\n",
+		     unsigned(allocationSize), unsigned(frameSize));
+		abort();
+	}
+
+	frameUsed += alignedSize;
+	head = begin + allocationSize;
+	*pOffset = uint32_t(offset);
+	return static_cast<uint8_t *>(allocation.pHostPointer) + offset;
+}
+
+uint64_t UniformRingBuffer::getPosition() const
+{
+	lock_guard<mutex> holder{ lock };
+	return head;
+}
+
+void UniformRingBuffer::beginFrame(uint64_t retirePosition)
+{
+	lock_guard<mutex> holder{ lock };
+	tail = max(tail, retirePosition);
+	frameUsed = 0;
+}
+
+void UniformRingBuffer::reset()
+{
+	lock_guard<mutex> holder{ lock };
+	tail = head;
+	frameUsed = 0;
+}
+}
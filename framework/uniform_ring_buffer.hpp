@@ -0,0 +1,138 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FRAMEWORK_UNIFORM_RING_BUFFER_HPP
+#define FRAMEWORK_UNIFORM_RING_BUFFER_HPP
+
+#include "device_memory_allocator.hpp"
+#include "framework/common.hpp"
+#include <mutex>
+
+namespace MaliSDK
+{
+/// @brief A persistently mapped uniform buffer which hands out short-lived
+/// sub-ranges.
+///
+/// Uniform data which changes every frame is written into the ring instead of
+/// into per-frame buffers which are mapped and unmapped every time. The ring
+/// is a single VkBuffer, so it is bound once with a
+/// VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC descriptor and the offset
+/// returned by @ref allocate is passed as a dynamic offset to
+/// `vkCmdBindDescriptorSets`.
+///
+/// The @ref Context marks the end of every frame in the ring and retires the
+/// data once the fences of that frame have signalled, so data written for a
+/// frame stays valid until the GPU has completed it.
+///
+/// The ring is sized for a number of frames in flight which each allocate at
+/// most a fixed amount of data, so as long as every frame stays within that
+/// budget, the ring is never full and @ref allocate always succeeds.
+///
+/// Allocation is thread-safe.
+class UniformRingBuffer
+{
+public:
+	/// @brief The default number of bytes a frame can allocate.
+	enum
+	{
+		DefaultFrameSize = 256 * 1024
+	};
+
+	/// @brief Constructor
+	/// @param device The Vulkan device.
+	/// @param allocator The allocator to get memory from.
+	/// @param limits The limits of the physical device.
+	/// @param frameCount The number of frames in flight.
+	/// @param frameSize The number of bytes a frame can allocate, including
+	/// alignment.
+	UniformRingBuffer(VkDevice device, DeviceMemoryAllocator &allocator, const VkPhysicalDeviceLimits &limits,
+	                  unsigned frameCount, VkDeviceSize frameSize = DefaultFrameSize);
+
+	/// @brief Destructor. The GPU must be done with the ring.
+	~UniformRingBuffer();
+
+	/// @brief Allocates a range of uniform data.
+	///
+	/// The range is aligned to `minUniformBufferOffsetAlignment`. Allocating
+	/// more than @ref getFrameSize bytes in a frame is a programming error,
+	/// and aborts.
+	/// @param size The number of bytes to allocate.
+	/// @param[out] pOffset The offset of the range in the buffer returned by
+	/// @ref getBuffer, to be used as a dynamic offset.
+	/// @returns A pointer which the data for the range must be written to.
+	void *allocate(VkDeviceSize size, uint32_t *pOffset);
+
+	/// @brief Gets the buffer all ranges are allocated from.
+	/// @returns The buffer
+	VkBuffer getBuffer() const
+	{
+		return buffer;
+	}
+
+	/// @brief Gets the number of frames in flight the ring was sized for.
+	/// @returns The number of frames
+	unsigned getFrameCount() const
+	{
+		return frameCount;
+	}
+
+	/// @brief Gets the number of bytes a frame can allocate.
+	/// @returns The budget of a frame in bytes
+	VkDeviceSize getFrameSize() const
+	{
+		return frameSize;
+	}
+
+	/// @brief Gets the position which the next allocation starts from.
+	///
+	/// The position increases monotonically and is passed to @ref retire.
+	/// @returns The current position
+	uint64_t getPosition() const;
+
+	/// @brief Begins a frame, and makes the ring reuse all data allocated
+	/// before a position.
+	/// @param retirePosition A value from @ref getPosition. The GPU must be
+	/// done with all data allocated before it.
+	void beginFrame(uint64_t retirePosition);
+
+	/// @brief Makes the ring reuse all data. The GPU must be idle.
+	void reset();
+
+private:
+	VkDevice device;
+	DeviceMemoryAllocator &allocator;
+	VkBuffer buffer = VK_NULL_HANDLE;
+	DeviceAllocation allocation;
+	VkDeviceSize size;
+	VkDeviceSize alignment;
+	unsigned frameCount;
+	VkDeviceSize frameSize;
+	// The number of bytes allocated in the current frame.
+	VkDeviceSize frameUsed = 0;
+
+	// Positions are counted in bytes since the ring was created, so a range
+	// starts at position % size in the buffer.
+	uint64_t head = 0;
+	uint64_t tail = 0;
+	mutable std::mutex lock;
+};
+}
+
+#endif
@@ -0,0 +1,432 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "upload_manager.hpp"
+#include <algorithm>
+#include <string.h>
+
+using namespace std;
+
+namespace MaliSDK
+{
+namespace
+{
+VkDeviceSize leastCommonMultiple(VkDeviceSize a, VkDeviceSize b)
+{
+	VkDeviceSize x = a, y = b;
+	while (y != 0)
+	{
+		VkDeviceSize remainder = x % y;
+		x = y;
+		y = remainder;
+	}
+	return a / x * b;
+}
+}
+
+UploadManager::UploadManager(VkDevice device, DeviceMemoryAllocator &allocator, const VkPhysicalDeviceLimits &limits,
+                             unsigned graphicsQueueIndex, VkQueue transferQueue, unsigned transferQueueIndex,
+                             VkDeviceSize stagingSize)
+    : device(device)
+    , allocator(allocator)
+    , graphicsQueueIndex(graphicsQueueIndex)
+    , transferQueue(transferQueue)
+    , transferQueueIndex(transferQueueIndex)
+{
+	// Copies to images additionally need offsets which are multiples of the
+	// texel block size, which is handled per upload.
+	alignment = max(limits.optimalBufferCopyOffsetAlignment, VkDeviceSize(4));
+	this->stagingSize = (stagingSize + alignment - 1) & ~(alignment - 1);
+
+	VkCommandPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	poolInfo.queueFamilyIndex = transferQueueIndex;
+	VK_CHECK(vkCreateCommandPool(device, &poolInfo, nullptr, &transferPool));
+
+	// Acquiring ownership has to happen on the graphics queue.
+	if (usesTransferQueue())
+	{
+		poolInfo.queueFamilyIndex = graphicsQueueIndex;
+		VK_CHECK(vkCreateCommandPool(device, &poolInfo, nullptr, &graphicsPool));
+	}
+
+	VkBufferCreateInfo info = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+	info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	info.size = this->stagingSize;
+	VK_CHECK(vkCreateBuffer(device, &info, nullptr, &stagingBuffer));
+
+	VkMemoryRequirements memReqs;
+	vkGetBufferMemoryRequirements(device, stagingBuffer, &memReqs);
+
+	// Upload memory is coherent, so writes never need to be flushed.
+	MemoryTagScope scope(MEMORY_TAG_STAGING);
+	VK_CHECK(allocator.allocate(memReqs, MemoryTypeSelector::USAGE_UPLOAD, DeviceMemoryAllocator::RESOURCE_LINEAR,
+	                            &stagingAllocation));
+	VK_CHECK(vkBindBufferMemory(device, stagingBuffer, stagingAllocation.memory, stagingAllocation.offset));
+
+	pending.token = 1;
+}
+
+UploadManager::~UploadManager()
+{
+	lock_guard<mutex> holder{ lock };
+
+	// The Context has waited for all of its fences before destroying us.
+	if (!submitted.empty())
+		retire(submitted.back().token);
+	destroyDedicatedStaging(pending.dedicatedStaging);
+
+	for (auto &semaphore : freeSemaphores)
+		vkDestroySemaphore(device, semaphore, nullptr);
+
+	// Destroying the pools frees all command buffers allocated from them.
+	vkDestroyCommandPool(device, transferPool, nullptr);
+	if (graphicsPool != VK_NULL_HANDLE)
+		vkDestroyCommandPool(device, graphicsPool, nullptr);
+
+	vkDestroyBuffer(device, stagingBuffer, nullptr);
+	allocator.free(stagingAllocation);
+}
+
+VkCommandBuffer UploadManager::requestCommandBuffer(VkCommandPool pool, vector<VkCommandBuffer> &freeCmds)
+{
+	VkCommandBuffer cmd;
+	if (freeCmds.empty())
+	{
+		VkCommandBufferAllocateInfo info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+		info.commandPool = pool;
+		info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		info.commandBufferCount = 1;
+		VK_CHECK(vkAllocateCommandBuffers(device, &info, &cmd));
+	}
+	else
+	{
+		cmd = freeCmds.back();
+		freeCmds.pop_back();
+	}
+
+	// The pool allows resetting individual command buffers, so beginning one
+	// resets it implicitly.
+	VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	VK_CHECK(vkBeginCommandBuffer(cmd, &beginInfo));
+	return cmd;
+}
+
+VkCommandBuffer UploadManager::beginUpload()
+{
+	if (pending.transferCmd == VK_NULL_HANDLE)
+		pending.transferCmd = requestCommandBuffer(transferPool, freeTransferCmds);
+	return pending.transferCmd;
+}
+
+VkDeviceSize UploadManager::allocateStaging(VkDeviceSize size, VkDeviceSize rangeAlignment, VkBuffer *pBuffer,
+                                            void **ppData)
+{
+	if (size <= stagingSize)
+	{
+		// The alignment need not be a power of two, nor divide the size of the
+		// ring, so align the offset in the buffer rather than the position.
+		VkDeviceSize offset = head % stagingSize;
+		VkDeviceSize alignedOffset = (offset + rangeAlignment - 1) / rangeAlignment * rangeAlignment;
+		uint64_t begin = head + (alignedOffset - offset);
+		offset = alignedOffset;
+
+		// Ranges must be contiguous in the buffer, so skip to the start of the
+		// buffer if the range would straddle the end.
+		if (offset + size > stagingSize)
+		{
+			begin += stagingSize - offset;
+			offset = 0;
+		}
+
+		// The space of completed submissions is reclaimed by beginFrame.
+		if (begin + size - tail <= stagingSize)
+		{
+			head = begin + size;
+			*pBuffer = stagingBuffer;
+			*ppData = static_cast<uint8_t *>(stagingAllocation.pHostPointer) + offset;
+			return offset;
+		}
+	}
+
+	// Uploads never wait for the GPU, so data which does not fit in the ring
+	// gets a staging buffer of its own, which is destroyed once the submission
+	// completes.
+	DedicatedStaging staging;
+	VkBufferCreateInfo info = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+	info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	info.size = size;
+	VK_CHECK(vkCreateBuffer(device, &info, nullptr, &staging.buffer));
+
+	VkMemoryRequirements memReqs;
+	vkGetBufferMemoryRequirements(device, staging.buffer, &memReqs);
+	MemoryTagScope scope(MEMORY_TAG_STAGING);
+	VK_CHECK(allocator.allocate(memReqs, MemoryTypeSelector::USAGE_UPLOAD, DeviceMemoryAllocator::RESOURCE_LINEAR,
+	                            &staging.allocation));
+	VK_CHECK(vkBindBufferMemory(device, staging.buffer, staging.allocation.memory, staging.allocation.offset));
+
+	pending.dedicatedStaging.push_back(staging);
+	*pBuffer = staging.buffer;
+	*ppData = staging.allocation.pHostPointer;
+	return 0;
+}
+
+void UploadManager::destroyDedicatedStaging(vector<DedicatedStaging> &staging)
+{
+	for (auto &buffer : staging)
+	{
+		vkDestroyBuffer(device, buffer.buffer, nullptr);
+		allocator.free(buffer.allocation);
+	}
+	staging.clear();
+}
+
+UploadManager::Token UploadManager::uploadBuffer(VkBuffer buffer, VkDeviceSize offset, const void *pData,
+                                                 VkDeviceSize size)
+{
+	lock_guard<mutex> holder{ lock };
+
+	VkBuffer srcBuffer;
+	void *pStaging;
+	VkDeviceSize srcOffset = allocateStaging(size, alignment, &srcBuffer, &pStaging);
+	memcpy(pStaging, pData, size);
+
+	VkCommandBuffer cmd = beginUpload();
+	VkBufferCopy region = { srcOffset, offset, size };
+	vkCmdCopyBuffer(cmd, srcBuffer, buffer, 1, &region);
+
+	// Access masks and queue families are filled in by flush.
+	VkBufferMemoryBarrier barrier = { VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+	barrier.buffer = buffer;
+	barrier.offset = offset;
+	barrier.size = size;
+	pendingBufferBarriers.push_back(barrier);
+
+	return pending.token;
+}
+
+UploadManager::Token UploadManager::uploadImage(VkImage image, const VkImageSubresourceRange &range,
+                                                VkImageLayout finalLayout, const void *pData, VkDeviceSize size,
+                                                const VkBufferImageCopy *pRegions, unsigned regionCount,
+                                                VkDeviceSize texelBlockSize)
+{
+	lock_guard<mutex> holder{ lock };
+
+	// Buffer offsets of copies to images must be multiples of the texel block
+	// size and of 4, which the base alignment already is. With 3, 6, 12 and
+	// 24 byte texels, the result is not a power of two.
+	VkDeviceSize rangeAlignment = leastCommonMultiple(alignment, max(texelBlockSize, VkDeviceSize(1)));
+
+	VkBuffer srcBuffer;
+	void *pStaging;
+	VkDeviceSize srcOffset = allocateStaging(size, rangeAlignment, &srcBuffer, &pStaging);
+	memcpy(pStaging, pData, size);
+
+	VkCommandBuffer cmd = beginUpload();
+
+	// Transition the uninitialized subresources into a TRANSFER_DST_OPTIMAL
+	// layout. The previous contents are discarded, so ownership does not have
+	// to be transferred to the transfer queue first.
+	VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange = range;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+	                     nullptr, 1, &barrier);
+
+	regions.assign(pRegions, pRegions + regionCount);
+	for (auto &region : regions)
+		region.bufferOffset += srcOffset;
+	vkCmdCopyBufferToImage(cmd, srcBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, regions.size(),
+	                       regions.data());
+
+	// Access masks and queue families are filled in by flush.
+	barrier.dstAccessMask = 0;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = finalLayout;
+	pendingImageBarriers.push_back(barrier);
+
+	return pending.token;
+}
+
+UploadManager::Token UploadManager::flush(VkCommandBuffer *pCmd, VkSemaphore *pWaitSemaphore)
+{
+	lock_guard<mutex> holder{ lock };
+
+	*pCmd = VK_NULL_HANDLE;
+	*pWaitSemaphore = VK_NULL_HANDLE;
+	if (pending.transferCmd == VK_NULL_HANDLE)
+		return pending.token - 1;
+
+	static const VkAccessFlags dstAccess = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+	bool transferOwnership = usesTransferQueue();
+
+	// With a single queue, one barrier makes the copies visible to all later
+	// commands. With a dedicated transfer queue, the barrier releases ownership
+	// to the graphics queue family, and an identical barrier on the graphics
+	// queue acquires it.
+	for (auto &barrier : pendingBufferBarriers)
+	{
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = transferOwnership ? 0 : dstAccess;
+		barrier.srcQueueFamilyIndex = transferOwnership ? transferQueueIndex : VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = transferOwnership ? graphicsQueueIndex : VK_QUEUE_FAMILY_IGNORED;
+	}
+
+	for (auto &barrier : pendingImageBarriers)
+	{
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = transferOwnership ? 0 : dstAccess;
+		barrier.srcQueueFamilyIndex = transferOwnership ? transferQueueIndex : VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = transferOwnership ? graphicsQueueIndex : VK_QUEUE_FAMILY_IGNORED;
+	}
+
+	vkCmdPipelineBarrier(
+	    pending.transferCmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+	    transferOwnership ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr,
+	    pendingBufferBarriers.size(), pendingBufferBarriers.data(), pendingImageBarriers.size(),
+	    pendingImageBarriers.data());
+	VK_CHECK(vkEndCommandBuffer(pending.transferCmd));
+
+	if (transferOwnership)
+	{
+		for (auto &barrier : pendingBufferBarriers)
+		{
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = dstAccess;
+		}
+
+		for (auto &barrier : pendingImageBarriers)
+		{
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = dstAccess;
+		}
+
+		pending.graphicsCmd = requestCommandBuffer(graphicsPool, freeGraphicsCmds);
+		vkCmdPipelineBarrier(pending.graphicsCmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+		                     VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, pendingBufferBarriers.size(),
+		                     pendingBufferBarriers.data(), pendingImageBarriers.size(), pendingImageBarriers.data());
+		VK_CHECK(vkEndCommandBuffer(pending.graphicsCmd));
+
+		if (freeSemaphores.empty())
+		{
+			VkSemaphoreCreateInfo info = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+			VK_CHECK(vkCreateSemaphore(device, &info, nullptr, &pending.semaphore));
+		}
+		else
+		{
+			pending.semaphore = freeSemaphores.back();
+			freeSemaphores.pop_back();
+		}
+
+		// The copies complete before the acquire on the graphics queue, so the
+		// fence of the graphics queue submission covers both.
+		VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &pending.transferCmd;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &pending.semaphore;
+		VK_CHECK(vkQueueSubmit(transferQueue, 1, &submitInfo, VK_NULL_HANDLE));
+
+		*pCmd = pending.graphicsCmd;
+		*pWaitSemaphore = pending.semaphore;
+	}
+	else
+		*pCmd = pending.transferCmd;
+
+	Token token = pending.token;
+	pending.stagingEnd = head;
+	submitted.push_back(move(pending));
+
+	pending = Submission();
+	pending.token = token + 1;
+	pendingBufferBarriers.clear();
+	pendingImageBarriers.clear();
+	return token;
+}
+
+void UploadManager::setSubmissionFence(Token token, VkFence fence)
+{
+	lock_guard<mutex> holder{ lock };
+	for (auto &submission : submitted)
+		if (submission.token == token)
+			submission.fence = fence;
+}
+
+void UploadManager::beginFrame(Token token)
+{
+	lock_guard<mutex> holder{ lock };
+	retire(token);
+}
+
+void UploadManager::retire(Token token)
+{
+	unsigned count = 0;
+	while (count < submitted.size() && submitted[count].token <= token)
+	{
+		auto &submission = submitted[count];
+		tail = submission.stagingEnd;
+		completedToken = submission.token;
+
+		destroyDedicatedStaging(submission.dedicatedStaging);
+		freeTransferCmds.push_back(submission.transferCmd);
+		if (submission.graphicsCmd != VK_NULL_HANDLE)
+			freeGraphicsCmds.push_back(submission.graphicsCmd);
+		if (submission.semaphore != VK_NULL_HANDLE)
+			freeSemaphores.push_back(submission.semaphore);
+		count++;
+	}
+
+	submitted.erase(submitted.begin(), submitted.begin() + count);
+}
+
+bool UploadManager::isComplete(Token token)
+{
+	lock_guard<mutex> holder{ lock };
+	return token <= completedToken;
+}
+
+void UploadManager::wait(Token token)
+{
+	lock_guard<mutex> holder{ lock };
+
+	if (token >= pending.token)
+	{
+		LOGE("Uploads must be flushed by the Context before waiting for them.\n");
+		abort();
+	}
+
+	for (auto &submission : submitted)
+	{
+		if (submission.token >= token)
+		{
+			VK_CHECK(vkWaitForFences(device, 1, &submission.fence, true, UINT64_MAX));
+			retire(submission.token);
+			break;
+		}
+	}
+}
+}
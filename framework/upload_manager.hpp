@@ -0,0 +1,233 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FRAMEWORK_UPLOAD_MANAGER_HPP
+#define FRAMEWORK_UPLOAD_MANAGER_HPP
+
+#include "device_memory_allocator.hpp"
+#include "framework/common.hpp"
+#include <mutex>
+#include <vector>
+
+namespace MaliSDK
+{
+/// @brief Copies data from the CPU into buffers and images through a
+/// persistently mapped staging ring.
+///
+/// Rather than creating a staging buffer, recording a command buffer and
+/// submitting it for every resource, uploads are written into one staging
+/// buffer and the copies are recorded into one command buffer until @ref
+/// flush is called. Every upload returns a token which can be polled with
+/// @ref isComplete instead of waiting for the queue to go idle.
+/// Uploads never wait for the GPU either. If the staging ring is full, the
+/// data gets a staging buffer of its own.
+///
+/// The @ref Context submits pending uploads as the first batch of its own
+/// `vkQueueSubmit`, with the fence of that flush, so a resource can be used by
+/// command buffers submitted after the upload without any further
+/// synchronization, and uploads cost no submission or fence of their own.
+/// Staging memory is reclaimed when the Context begins a frame which reuses
+/// the frame slot of the flush, like the @ref UniformRingBuffer.
+///
+/// If the device has a queue family dedicated to transfers, the copies run on
+/// that queue, and ownership of the resources is transferred to the graphics
+/// queue family when the copies complete.
+///
+/// Recording uploads and @ref isComplete are thread-safe. @ref flush, @ref
+/// setSubmissionFence, @ref beginFrame and @ref wait are called on the thread
+/// which flushes the Context.
+class UploadManager
+{
+public:
+	/// @brief Identifies the submission an upload is part of.
+	/// Tokens increase monotonically.
+	typedef uint64_t Token;
+
+	/// @brief The default size of the staging ring in bytes.
+	enum
+	{
+		DefaultStagingSize = 8 * 1024 * 1024
+	};
+
+	/// @brief Constructor
+	/// @param device The Vulkan device.
+	/// @param allocator The allocator to get memory from.
+	/// @param limits The limits of the physical device.
+	/// @param graphicsQueueIndex The queue family of the queue which uses the
+	/// uploaded resources, and which the Context submits uploads to.
+	/// @param transferQueue The queue to run copies on. May be the graphics
+	/// queue.
+	/// @param transferQueueIndex The queue family of transferQueue.
+	/// @param stagingSize The size of the staging ring in bytes.
+	UploadManager(VkDevice device, DeviceMemoryAllocator &allocator, const VkPhysicalDeviceLimits &limits,
+	              unsigned graphicsQueueIndex, VkQueue transferQueue, unsigned transferQueueIndex,
+	              VkDeviceSize stagingSize = DefaultStagingSize);
+
+	/// @brief Destructor. All submitted uploads must have completed.
+	/// Pending uploads which were never flushed are discarded.
+	~UploadManager();
+
+	/// @brief Uploads data to a buffer.
+	///
+	/// The buffer must have been created with VK_BUFFER_USAGE_TRANSFER_DST_BIT
+	/// and must not be in use by the GPU. If a dedicated transfer queue is used,
+	/// the contents of the buffer outside of the range are undefined afterwards.
+	/// @param buffer The buffer to upload to.
+	/// @param offset The offset in the buffer to write to.
+	/// @param pData The data to upload, which is copied before this returns.
+	/// @param size The size of the data in bytes.
+	/// @returns The token of the submission the upload is part of.
+	Token uploadBuffer(VkBuffer buffer, VkDeviceSize offset, const void *pData, VkDeviceSize size);
+
+	/// @brief Uploads data to an image.
+	///
+	/// The subresources in range are transitioned from
+	/// VK_IMAGE_LAYOUT_UNDEFINED, so any previous contents are discarded, and
+	/// end up in finalLayout once the upload has completed.
+	/// The image must have been created with VK_IMAGE_USAGE_TRANSFER_DST_BIT
+	/// and must not be in use by the GPU.
+	/// @param image The image to upload to.
+	/// @param range The subresources which the regions copy to.
+	/// @param finalLayout The layout of the subresources after the upload.
+	/// @param pData The data to upload, which is copied before this returns.
+	/// @param size The size of the data in bytes.
+	/// @param pRegions The copies to perform. The `bufferOffset` of each region
+	/// is relative to pData and must be a multiple of texelBlockSize and of 4.
+	/// @param regionCount The number of regions.
+	/// @param texelBlockSize The size of a texel, or of a block of texels for
+	/// compressed formats, of the image format in bytes. The data is staged
+	/// at an offset which is a multiple of it, of 4 and of the optimal copy
+	/// offset alignment of the device.
+	/// @returns The token of the submission the upload is part of.
+	Token uploadImage(VkImage image, const VkImageSubresourceRange &range, VkImageLayout finalLayout,
+	                  const void *pData, VkDeviceSize size, const VkBufferImageCopy *pRegions,
+	                  unsigned regionCount, VkDeviceSize texelBlockSize);
+
+	/// @brief Ends recording of all pending uploads, so they can be submitted
+	/// to the graphics queue ahead of other command buffers.
+	///
+	/// With a dedicated transfer queue, the copies are submitted to it here,
+	/// and the returned command buffer acquires ownership of the resources.
+	/// Called by the @ref Context, which then calls @ref setSubmissionFence.
+	/// @param[out] pCmd The command buffer to submit, or `VK_NULL_HANDLE` if
+	/// there was nothing to flush.
+	/// @param[out] pWaitSemaphore The semaphore the command buffer must wait
+	/// for, or `VK_NULL_HANDLE`.
+	/// @returns The token of the submission, which is the newest token handed
+	/// out. If there was nothing to flush, the previous token is returned.
+	Token flush(VkCommandBuffer *pCmd, VkSemaphore *pWaitSemaphore);
+
+	/// @brief Sets the fence which signals when a flushed submission has
+	/// completed. The fence is owned by the caller.
+	/// @param token The token returned by @ref flush.
+	/// @param fence The fence the command buffer was submitted with.
+	void setSubmissionFence(Token token, VkFence fence);
+
+	/// @brief Called by the @ref Context when a frame begins, after the GPU
+	/// has completed a submission, and before its fence is reset.
+	/// Reclaims the staging memory of that submission and all earlier ones.
+	/// @param token The newest token the GPU has completed.
+	void beginFrame(Token token);
+
+	/// @brief Checks whether the GPU has completed a submission without
+	/// blocking. Completion is detected by @ref beginFrame.
+	/// @param token A token returned by an upload or @ref flush.
+	/// @returns true if the uploads with this token have completed.
+	bool isComplete(Token token);
+
+	/// @brief Waits for the GPU to complete a submission.
+	/// The uploads must have been flushed by the Context.
+	/// @param token A token returned by an upload or @ref flush.
+	void wait(Token token);
+
+	/// @brief Checks whether there is a dedicated transfer queue.
+	/// @returns true if copies run on a queue other than the graphics queue.
+	bool usesTransferQueue() const
+	{
+		return transferQueueIndex != graphicsQueueIndex;
+	}
+
+private:
+	VkDevice device;
+	DeviceMemoryAllocator &allocator;
+	unsigned graphicsQueueIndex;
+	VkQueue transferQueue;
+	unsigned transferQueueIndex;
+
+	VkCommandPool transferPool = VK_NULL_HANDLE;
+	VkCommandPool graphicsPool = VK_NULL_HANDLE;
+
+	VkBuffer stagingBuffer = VK_NULL_HANDLE;
+	DeviceAllocation stagingAllocation;
+	VkDeviceSize stagingSize;
+
+	// The optimal copy offset alignment, which every staging range is
+	// aligned to.
+	VkDeviceSize alignment;
+
+	// Positions are counted in bytes since the ring was created, so a range
+	// starts at position % stagingSize in the buffer.
+	uint64_t head = 0;
+	uint64_t tail = 0;
+
+	// Staging buffers for uploads which do not fit in the ring.
+	struct DedicatedStaging
+	{
+		VkBuffer buffer;
+		DeviceAllocation allocation;
+	};
+
+	struct Submission
+	{
+		Token token = 0;
+		VkCommandBuffer transferCmd = VK_NULL_HANDLE;
+		VkCommandBuffer graphicsCmd = VK_NULL_HANDLE;
+		VkSemaphore semaphore = VK_NULL_HANDLE;
+		VkFence fence = VK_NULL_HANDLE;
+		uint64_t stagingEnd = 0;
+		std::vector<DedicatedStaging> dedicatedStaging;
+	};
+
+	// The submission uploads are currently recorded into.
+	Submission pending;
+	std::vector<VkBufferMemoryBarrier> pendingBufferBarriers;
+	std::vector<VkImageMemoryBarrier> pendingImageBarriers;
+	std::vector<VkBufferImageCopy> regions;
+
+	// Submitted in order, so they complete in order. The fences belong to
+	// the Context.
+	std::vector<Submission> submitted;
+	Token completedToken = 0;
+
+	std::vector<VkCommandBuffer> freeTransferCmds;
+	std::vector<VkCommandBuffer> freeGraphicsCmds;
+	std::vector<VkSemaphore> freeSemaphores;
+
+	std::mutex lock;
+
+	VkCommandBuffer beginUpload();
+	VkDeviceSize allocateStaging(VkDeviceSize size, VkDeviceSize rangeAlignment, VkBuffer *pBuffer, void **ppData);
+	void retire(Token token);
+	void destroyDedicatedStaging(std::vector<DedicatedStaging> &staging);
+	VkCommandBuffer requestCommandBuffer(VkCommandPool pool, std::vector<VkCommandBuffer> &freeCmds);
+};
+}
+
+#endif
@@ -19,6 +19,10 @@
  */
 
 #include "android.hpp"
+#include "platform/asset_pack_manager.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
 using namespace std;
 
 namespace MaliSDK
@@ -53,12 +57,19 @@ VkSurfaceKHR AndroidPlatform::createSurface()
 	return surface;
 }
 
-AssetManager &MaliSDK::OS::getAssetManager()
+static AndroidAssetManager &getAndroidAssetManager()
 {
 	static AndroidAssetManager manager;
 	return manager;
 }
 
+AssetManager &MaliSDK::OS::getAssetManager()
+{
+	// Assets are read from the pack if the APK contains one.
+	static AssetPackManager manager(getAndroidAssetManager(), "assets.pack");
+	return manager;
+}
+
 double MaliSDK::OS::getCurrentTime()
 {
 	timespec ts;
@@ -71,6 +82,49 @@ double MaliSDK::OS::getCurrentTime()
 	return ts.tv_sec + ts.tv_nsec * 1e-9;
 }
 
+static string &getAndroidCacheDirectory()
+{
+	static string directory;
+	return directory;
+}
+
+string MaliSDK::OS::getCacheDirectory()
+{
+	return getAndroidCacheDirectory();
+}
+
+string MaliSDK::OS::getApplicationName()
+{
+	// Every sample is its own APK with its own cache directory.
+	return string();
+}
+
+bool MaliSDK::OS::writeFileAtomically(const char *pPath, const void *pData, size_t size)
+{
+	// mkstemp() picks a name which no other thread or process is using.
+	string temporary = string(pPath) + ".XXXXXX";
+	int fd = mkstemp(&temporary[0]);
+	if (fd < 0)
+		return false;
+
+	FILE *pFile = fdopen(fd, "wb");
+	if (!pFile)
+	{
+		close(fd);
+		remove(temporary.c_str());
+		return false;
+	}
+
+	bool written = fwrite(pData, 1, size, pFile) == size;
+	written = fclose(pFile) == 0 && written;
+	if (!written || rename(temporary.c_str(), pPath) != 0)
+	{
+		remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
+
 unsigned MaliSDK::OS::getNumberOfCpuThreads()
 {
 	unsigned count = android_getCpuCount();
@@ -214,9 +268,12 @@ void android_main(android_app *state)
 	engine.pApp = state;
 
 	auto &platform = static_cast<AndroidPlatform &>(Platform::get());
-	static_cast<AndroidAssetManager &>(OS::getAssetManager()).setAssetManager(state->activity->assetManager);
+	getAndroidAssetManager().setAssetManager(state->activity->assetManager);
+	if (state->activity->internalDataPath)
+		getAndroidCacheDirectory() = state->activity->internalDataPath;
 
 	unsigned frameCount = 0;
+	double stallTime = 0.0;
 	double startTime = OS::getCurrentTime();
 
 	for (;;)
@@ -263,11 +320,14 @@ void android_main(android_app *state)
 				break;
 
 			frameCount++;
+			stallTime += platform.getContext().getFrameStallTime();
 			if (frameCount == 100)
 			{
 				double endTime = OS::getCurrentTime();
 				LOGI("FPS: %.3f\n", frameCount / (endTime - startTime));
+				LOGI("GPU stall: %.3f ms/frame\n", 1000.0 * stallTime / frameCount);
 				frameCount = 0;
+				stallTime = 0.0;
 				startTime = endTime;
 			}
 		}
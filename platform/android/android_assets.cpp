@@ -24,6 +24,11 @@ using namespace std;
 
 namespace MaliSDK
 {
+static void closeAsset(void *pAsset)
+{
+	AAsset_close(static_cast<AAsset *>(pAsset));
+}
+
 Result AndroidAssetManager::readBinaryFile(const char *pPath, void **ppData, size_t *pSize)
 {
 	if (!pManager)
@@ -62,4 +67,31 @@ Result AndroidAssetManager::readBinaryFile(const char *pPath, void **ppData, siz
 		return RESULT_ERROR_IO;
 	}
 }
+
+Result AndroidAssetManager::mapBinaryFile(const char *pPath, AssetData *pData)
+{
+	if (!pManager)
+	{
+		LOGE("Asset manager does not exist.");
+		return RESULT_ERROR_GENERIC;
+	}
+
+	AAsset *asset = AAssetManager_open(pManager, pPath, AASSET_MODE_BUFFER);
+	if (!asset)
+	{
+		LOGE("AAssetManager_open() failed to load file: %s.", pPath);
+		return RESULT_ERROR_IO;
+	}
+
+	const void *buffer = AAsset_getBuffer(asset);
+	if (!buffer)
+	{
+		LOGE("Failed to obtain buffer for asset: %s.", pPath);
+		AAsset_close(asset);
+		return RESULT_ERROR_IO;
+	}
+
+	*pData = AssetData(buffer, AAsset_getLength(asset), shared_ptr<void>(asset, closeAsset));
+	return RESULT_SUCCESS;
+}
 }
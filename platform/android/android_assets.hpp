@@ -40,6 +40,13 @@ public:
 	/// @returns Error code
 	virtual Result readBinaryFile(const char *pPath, void **ppData, size_t *pSize) override;
 
+	/// @brief Gets a view of an asset. The asset stays open for as long as
+	/// the view exists, so uncompressed assets are used in place.
+	/// @param pPath The path of the asset.
+	/// @param[out] pData The contents of the asset.
+	/// @returns Error code
+	virtual Result mapBinaryFile(const char *pPath, AssetData *pData) override;
+
 	/// @brief Sets the asset manager to use. Called from platform.
 	/// @param pAssetManager The asset manager.
 	void setAssetManager(AAssetManager *pAssetManager)
@@ -45,7 +45,7 @@ Result AssetManager::readBinaryFile(const char *pPath, void **pData, size_t *pSi
 	*pSize = len;
 	if (fread(*pData, 1, *pSize, file) != *pSize)
 	{
-		free(pData);
+		free(*pData);
 		fclose(file);
 		return RESULT_ERROR_IO;
 	}
@@ -53,4 +53,16 @@ Result AssetManager::readBinaryFile(const char *pPath, void **pData, size_t *pSi
 	fclose(file);
 	return RESULT_SUCCESS;
 }
+
+Result AssetManager::mapBinaryFile(const char *pPath, AssetData *pData)
+{
+	void *pBlob;
+	size_t size;
+	Result res = readBinaryFile(pPath, &pBlob, &size);
+	if (FAILED(res))
+		return res;
+
+	*pData = AssetData(pBlob, size, shared_ptr<void>(pBlob, free));
+	return RESULT_SUCCESS;
+}
 }
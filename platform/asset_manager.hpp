@@ -22,6 +22,7 @@
 #define PLATFORM_ASSET_MANAGER_HPP
 
 #include "framework/common.hpp"
+#include <memory>
 #include <stddef.h>
 #include <stdint.h>
 #include <vector>
@@ -29,6 +30,58 @@
 namespace MaliSDK
 {
 
+/// @brief A read-only view of the contents of an asset.
+///
+/// The view keeps whatever backs the data alive, e.g. a memory mapping of the
+/// file, so the data can be consumed in place without copying it. Copies of
+/// a view share the backing storage, which is released with the last copy.
+class AssetData
+{
+public:
+	/// @brief Constructs an empty view.
+	AssetData() = default;
+
+	/// @brief Constructor
+	/// @param pData The start of the data.
+	/// @param size The size of the data.
+	/// @param handle Keeps the data alive while the view exists.
+	AssetData(const void *pData, size_t size, std::shared_ptr<void> handle)
+	    : pData(pData)
+	    , size(size)
+	    , handle(std::move(handle))
+	{
+	}
+
+	/// @brief Gets the data.
+	/// @returns A pointer to the start of the data.
+	const void *getData() const
+	{
+		return pData;
+	}
+
+	/// @brief Gets the size of the data.
+	/// @returns The size in bytes
+	size_t getSize() const
+	{
+		return size;
+	}
+
+	/// @brief Gets a view of part of the data, which shares the backing
+	/// storage with this view.
+	/// @param offset The offset of the part.
+	/// @param partSize The size of the part.
+	/// @returns The view
+	AssetData getSubData(size_t offset, size_t partSize) const
+	{
+		return AssetData(static_cast<const uint8_t *>(pData) + offset, partSize, handle);
+	}
+
+private:
+	const void *pData = nullptr;
+	size_t size = 0;
+	std::shared_ptr<void> handle;
+};
+
 /// @brief The asset manager reads data from a platform specific location.
 /// This class is used internally to load binary data from disk.
 class AssetManager
@@ -36,6 +89,15 @@ class AssetManager
 public:
 	virtual ~AssetManager() = default;
 
+	/// @brief Gets a view of the contents of an asset without copying it.
+	///
+	/// Platforms which can map assets into memory do so. The default
+	/// implementation reads the asset with @ref readBinaryFile.
+	/// @param pPath The path of the asset.
+	/// @param[out] pData The contents of the asset.
+	/// @returns Error code
+	virtual Result mapBinaryFile(const char *pPath, AssetData *pData);
+
 	/// @brief Reads a binary file into typed container.
 	/// @param[out] pOutput Output vector to write data into.
 	/// The vector will be cleared before adding any data to the container.
@@ -44,17 +106,16 @@ public:
 	template <typename T>
 	inline Result readBinaryFile(std::vector<T> *pOutput, const char *pPath)
 	{
-		void *pData;
-		size_t size;
-		Result error = readBinaryFile(pPath, &pData, &size);
+		AssetData data;
+		Result error = mapBinaryFile(pPath, &data);
 		if (error != RESULT_SUCCESS)
 			return error;
 
-		size_t numElements = size / sizeof(T);
+		const T *pElements = static_cast<const T *>(data.getData());
+		size_t numElements = data.getSize() / sizeof(T);
 
 		pOutput->clear();
-		pOutput->insert(end(*pOutput), reinterpret_cast<T *>(pData), reinterpret_cast<T *>(pData) + numElements);
-		free(pData);
+		pOutput->insert(end(*pOutput), pElements, pElements + numElements);
 		return RESULT_SUCCESS;
 	}
 
@@ -0,0 +1,159 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "asset_pack_manager.hpp"
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace std;
+
+namespace MaliSDK
+{
+AssetPackManager::AssetPackManager(AssetManager &fallback, const char *pPackPath)
+    : fallback(fallback)
+    , packPath(pPackPath)
+{
+}
+
+void AssetPackManager::open()
+{
+	AssetData data;
+	if (FAILED(fallback.mapBinaryFile(packPath.c_str(), &data)))
+		return;
+
+	const uint8_t *pBase = static_cast<const uint8_t *>(data.getData());
+	size_t size = data.getSize();
+
+	AssetPackHeader header;
+	if (size < sizeof(header))
+	{
+		LOGE("Asset pack %s is truncated.\n", packPath.c_str());
+		return;
+	}
+	memcpy(&header, pBase, sizeof(header));
+
+	if (header.magic != ASSET_PACK_MAGIC || header.version != ASSET_PACK_VERSION)
+	{
+		LOGE("%s is not a supported asset pack.\n", packPath.c_str());
+		return;
+	}
+
+	size_t indexSize = size_t(header.entryCount) * sizeof(AssetPackEntry);
+	if (size - sizeof(header) < indexSize || size - sizeof(header) - indexSize < header.namesSize)
+	{
+		LOGE("Asset pack %s is truncated.\n", packPath.c_str());
+		return;
+	}
+
+	// The pack is not necessarily aligned when it lives inside another
+	// archive, so copy the index rather than reading it in place.
+	vector<AssetPackEntry> index(header.entryCount);
+	if (indexSize)
+		memcpy(index.data(), pBase + sizeof(header), indexSize);
+
+	// Uncompressed entries are mapped with their size, so it must match what
+	// is stored in the pack.
+	for (auto &entry : index)
+	{
+		bool compressed = (entry.flags & ASSET_PACK_ENTRY_COMPRESSED) != 0;
+		if (entry.offset > size || entry.storedSize > size - entry.offset ||
+		    (!compressed && entry.size != entry.storedSize) ||
+		    uint64_t(entry.nameOffset) + entry.nameLength > header.namesSize)
+		{
+			LOGE("Asset pack %s is corrupt.\n", packPath.c_str());
+			return;
+		}
+	}
+
+	pack = move(data);
+	entries = move(index);
+	pNames = reinterpret_cast<const char *>(pBase + sizeof(header) + indexSize);
+	LOGI("Opened asset pack %s with %u assets.\n", packPath.c_str(), unsigned(entries.size()));
+}
+
+const AssetPackEntry *AssetPackManager::find(const char *pPath) const
+{
+	size_t length = strlen(pPath);
+	uint64_t hash = hashAssetName(pPath, length);
+
+	auto itr = lower_bound(begin(entries), end(entries), hash,
+	                       [](const AssetPackEntry &entry, uint64_t hash) { return entry.nameHash < hash; });
+
+	// Names are compared as well, in case hashes collide.
+	for (; itr != end(entries) && itr->nameHash == hash; ++itr)
+		if (itr->nameLength == length && memcmp(pNames + itr->nameOffset, pPath, length) == 0)
+			return &*itr;
+
+	return nullptr;
+}
+
+Result AssetPackManager::mapBinaryFile(const char *pPath, AssetData *pData)
+{
+	call_once(openFlag, [this]() { open(); });
+
+	const AssetPackEntry *pEntry = find(pPath);
+	if (!pEntry)
+		return fallback.mapBinaryFile(pPath, pData);
+
+	if (!(pEntry->flags & ASSET_PACK_ENTRY_COMPRESSED))
+	{
+		*pData = pack.getSubData(size_t(pEntry->offset), size_t(pEntry->size));
+		return RESULT_SUCCESS;
+	}
+
+	size_t size = size_t(pEntry->size);
+	void *pDecompressed = malloc(size ? size : 1);
+	if (!pDecompressed)
+		return RESULT_ERROR_OUT_OF_MEMORY;
+
+	const uint8_t *pStored = static_cast<const uint8_t *>(pack.getData()) + pEntry->offset;
+	if (!decompressAssetData(pStored, size_t(pEntry->storedSize), static_cast<uint8_t *>(pDecompressed), size))
+	{
+		LOGE("Failed to decompress asset: %s.\n", pPath);
+		free(pDecompressed);
+		return RESULT_ERROR_IO;
+	}
+
+	*pData = AssetData(pDecompressed, size, shared_ptr<void>(pDecompressed, free));
+	return RESULT_SUCCESS;
+}
+
+Result AssetPackManager::readBinaryFile(const char *pPath, void **ppData, size_t *pSize)
+{
+	call_once(openFlag, [this]() { open(); });
+
+	if (!find(pPath))
+		return fallback.readBinaryFile(pPath, ppData, pSize);
+
+	AssetData data;
+	Result res = mapBinaryFile(pPath, &data);
+	if (FAILED(res))
+		return res;
+
+	*ppData = malloc(data.getSize() ? data.getSize() : 1);
+	if (!*ppData)
+		return RESULT_ERROR_OUT_OF_MEMORY;
+
+	memcpy(*ppData, data.getData(), data.getSize());
+	*pSize = data.getSize();
+	return RESULT_SUCCESS;
+}
+}
@@ -0,0 +1,79 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLATFORM_ASSET_PACK_MANAGER_HPP
+#define PLATFORM_ASSET_PACK_MANAGER_HPP
+
+#include "asset_manager.hpp"
+#include "framework/asset_pack.hpp"
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace MaliSDK
+{
+/// @brief An asset manager which reads assets from an asset pack.
+///
+/// The pack itself is mapped through another asset manager, so it is memory
+/// mapped where that manager supports it. Assets are looked up with a binary
+/// search over the index, and uncompressed assets are returned as views into
+/// the pack without copying them.
+///
+/// Assets which are not in the pack, or all assets if there is no pack, are
+/// read through the other asset manager, so samples work both with packs and
+/// with loose files. The pack is opened on first use.
+class AssetPackManager : public AssetManager
+{
+public:
+	/// @brief Constructor
+	/// @param fallback The asset manager used to map the pack and to read
+	/// assets which are not in it.
+	/// @param pPackPath The path of the pack, relative to the assets.
+	AssetPackManager(AssetManager &fallback, const char *pPackPath);
+
+	/// @brief Reads a binary file as a raw blob.
+	/// @param pPath The path of the asset.
+	/// @param[out] ppData allocated output data. Must be freed with `free()`.
+	/// @param[out] pSize The size of the allocated data.
+	/// @returns Error code
+	virtual Result readBinaryFile(const char *pPath, void **ppData, size_t *pSize) override;
+
+	/// @brief Gets a view of an asset. Compressed assets are decompressed into
+	/// memory owned by the view.
+	/// @param pPath The path of the asset.
+	/// @param[out] pData The contents of the asset.
+	/// @returns Error code
+	virtual Result mapBinaryFile(const char *pPath, AssetData *pData) override;
+
+private:
+	AssetManager &fallback;
+	std::string packPath;
+	std::once_flag openFlag;
+
+	AssetData pack;
+	std::vector<AssetPackEntry> entries;
+	const char *pNames = nullptr;
+
+	void open();
+	const AssetPackEntry *find(const char *pPath) const;
+};
+}
+
+#endif
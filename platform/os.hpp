@@ -22,6 +22,8 @@
 #define PLATFORM_OS_HPP
 
 #include "asset_manager.hpp"
+#include <stddef.h>
+#include <string>
 
 namespace MaliSDK
 {
@@ -39,6 +41,27 @@ AssetManager &getAssetManager();
 /// @brief Returns number of threads the CPU supports executing concurrently.
 /// @returns Number of CPU threads.
 unsigned getNumberOfCpuThreads();
+
+/// @brief Gets a writable directory where data can be cached between runs,
+/// such as textures which are compressed on first load. The platform may
+/// delete the contents at any time.
+/// @returns The path of the directory, or an empty string if there is none.
+std::string getCacheDirectory();
+
+/// @brief Gets the name of the running application, which keeps data of
+/// different applications apart in a shared cache directory.
+/// @returns The name, or an empty string if the cache directory is already
+/// private to the application, or the name is unknown.
+std::string getApplicationName();
+
+/// @brief Writes a file under a unique temporary name and renames it to its
+/// path when it is complete, so concurrent or interrupted writers, also in
+/// other processes, never leave a partial file behind.
+/// @param pPath The path of the file.
+/// @param pData The contents of the file.
+/// @param size The size of the contents in bytes.
+/// @returns True if the file was written.
+bool writeFileAtomically(const char *pPath, const void *pData, size_t size);
 }
 }
 
@@ -21,12 +21,19 @@
 #include "framework/application.hpp"
 
 #include "framework/common.hpp"
+#include "platform/asset_pack_manager.hpp"
 #include "platform/os.hpp"
 #include "platform/platform.hpp"
 
 #include "linux.hpp"
+#include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 using namespace std;
@@ -74,9 +81,51 @@ Result LinuxAssetManager::readBinaryFile(const char *pPath, void **ppData, size_
 	return AssetManager::readBinaryFile(fullpath.c_str(), ppData, pSize);
 }
 
+Result LinuxAssetManager::mapBinaryFile(const char *pPath, AssetData *pData)
+{
+	auto fullpath = basePath + "/assets/" + pPath;
+	int fd = open(fullpath.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return RESULT_ERROR_IO;
+
+	struct stat s;
+	if (fstat(fd, &s) < 0)
+	{
+		close(fd);
+		return RESULT_ERROR_IO;
+	}
+
+	// Empty files cannot be mapped.
+	size_t size = s.st_size;
+	if (size == 0)
+	{
+		close(fd);
+		*pData = AssetData();
+		return RESULT_SUCCESS;
+	}
+
+	// The mapping stays valid after the file is closed.
+	void *pMapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (pMapped == MAP_FAILED)
+	{
+		LOGE("Failed to map asset: %s.\n", pPath);
+		return RESULT_ERROR_IO;
+	}
+
+	// Assets are typically consumed front to back.
+	madvise(pMapped, size, MADV_SEQUENTIAL);
+
+	*pData = AssetData(pMapped, size, shared_ptr<void>(pMapped, [size](void *p) { munmap(p, size); }));
+	return RESULT_SUCCESS;
+}
+
 AssetManager &OS::getAssetManager()
 {
-	static LinuxAssetManager manager;
+	// Assets are read from the pack if the build created one, and from loose
+	// files otherwise.
+	static LinuxAssetManager looseFiles;
+	static AssetPackManager manager(looseFiles, "assets.pack");
 	return manager;
 }
 
@@ -106,6 +155,76 @@ unsigned OS::getNumberOfCpuThreads()
 		return 1;
 	}
 }
+
+string OS::getCacheDirectory()
+{
+	static const string directory = []() -> string {
+		// Follow the XDG base directory specification.
+		string path;
+		const char *pCacheHome = getenv("XDG_CACHE_HOME");
+		const char *pHome = getenv("HOME");
+		if (pCacheHome && *pCacheHome)
+			path = pCacheHome;
+		else if (pHome && *pHome)
+			path = string(pHome) + "/.cache";
+		else
+		{
+			LOGE("Neither XDG_CACHE_HOME nor HOME is set, not caching data.\n");
+			return string();
+		}
+
+		mkdir(path.c_str(), 0700);
+		path += "/mali-vulkan-sdk";
+		if (mkdir(path.c_str(), 0700) < 0 && errno != EEXIST)
+		{
+			LOGE("Failed to create cache directory: %s.\n", path.c_str());
+			return string();
+		}
+		return path;
+	}();
+	return directory;
+}
+
+string OS::getApplicationName()
+{
+	static const string name = []() -> string {
+		char path[PATH_MAX];
+		ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+		if (length <= 0)
+			return string();
+
+		path[length] = '\0';
+		const char *pName = strrchr(path, '/');
+		return pName ? pName + 1 : path;
+	}();
+	return name;
+}
+
+bool OS::writeFileAtomically(const char *pPath, const void *pData, size_t size)
+{
+	// mkstemp() picks a name which no other thread or process is using.
+	string temporary = string(pPath) + ".XXXXXX";
+	int fd = mkstemp(&temporary[0]);
+	if (fd < 0)
+		return false;
+
+	FILE *pFile = fdopen(fd, "wb");
+	if (!pFile)
+	{
+		close(fd);
+		remove(temporary.c_str());
+		return false;
+	}
+
+	bool written = fwrite(pData, 1, size, pFile) == size;
+	written = fclose(pFile) == 0 && written;
+	if (!written || rename(temporary.c_str(), pPath) != 0)
+	{
+		remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
 }
 
 using namespace MaliSDK;
@@ -144,6 +263,7 @@ int main(int argc, char **argv)
 	app->updateSwapchain(images, dim);
 
 	unsigned frameCount = 0;
+	double stallTime = 0.0;
 	double startTime = OS::getCurrentTime();
 
 	unsigned maxFrameCount = 0;
@@ -179,11 +299,14 @@ int main(int argc, char **argv)
 			break;
 
 		frameCount++;
+		stallTime += platform.getContext().getFrameStallTime();
 		if (frameCount == 100)
 		{
 			double endTime = OS::getCurrentTime();
 			LOGI("FPS: %.3f\n", frameCount / (endTime - startTime));
+			LOGI("GPU stall: %.3f ms/frame\n", 1000.0 * stallTime / frameCount);
 			frameCount = 0;
+			stallTime = 0.0;
 			startTime = endTime;
 		}
 
@@ -45,6 +45,13 @@ public:
 	/// @returns Error code
 	virtual Result readBinaryFile(const char *pPath, void **ppData, size_t *pSize) override;
 
+	/// @brief Maps an asset into memory with `mmap()`. Pages are only read
+	/// from disk when they are accessed, and the data is never copied.
+	/// @param pPath The path of the asset.
+	/// @param[out] pData The contents of the asset.
+	/// @returns Error code
+	virtual Result mapBinaryFile(const char *pPath, AssetData *pData) override;
+
 private:
 	std::string basePath;
 };
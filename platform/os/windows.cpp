@@ -6,6 +6,9 @@
 
 #include "asset_manager.hpp"
 #include "platform/os.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
 
 // Stub implementation.
 
@@ -25,6 +28,38 @@ double OS::getCurrentTime()
 {
 	return 0.0;
 }
+
+std::string OS::getCacheDirectory()
+{
+	return std::string();
+}
+
+std::string OS::getApplicationName()
+{
+	return std::string();
+}
+
+bool OS::writeFileAtomically(const char *pPath, const void *pData, size_t size)
+{
+	// _mktemp_s() only picks an unused name, so the file is created with "x"
+	// to fail instead of sharing it if another writer picks the same name.
+	std::string temporary = std::string(pPath) + ".XXXXXX";
+	if (_mktemp_s(&temporary[0], temporary.size() + 1) != 0)
+		return false;
+
+	FILE *pFile = fopen(temporary.c_str(), "wbx");
+	if (!pFile)
+		return false;
+
+	bool written = fwrite(pData, 1, size, pFile) == size;
+	written = fclose(pFile) == 0 && written;
+	if (!written || !MoveFileExA(temporary.c_str(), pPath, MOVEFILE_REPLACE_EXISTING))
+	{
+		remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
 }
 
 int main()
@@ -190,6 +190,21 @@ public:
 		return graphicsQueueIndex;
 	}
 
+	/// @brief Gets the Vulkan queue dedicated to transfers.
+	/// @returns Vulkan queue. This is the graphics queue if the device has no
+	/// queue family dedicated to transfers.
+	inline VkQueue getTransferQueue() const
+	{
+		return transferQueue;
+	}
+
+	/// @brief Gets the queue family index of the transfer queue.
+	/// @returns Vulkan queue family index.
+	inline unsigned getTransferQueueIndex() const
+	{
+		return transferQueueIndex;
+	}
+
 	/// @brief Gets the current Vulkan GPU properties.
 	/// @returns GPU properties.
 	inline const VkPhysicalDeviceProperties &getGpuProperties() const
@@ -221,6 +236,9 @@ protected:
 	/// The Vulkan device queue.
 	VkQueue queue = VK_NULL_HANDLE;
 
+	/// The Vulkan queue which uploads are submitted to.
+	VkQueue transferQueue = VK_NULL_HANDLE;
+
 	/// The Vulkan context.
 	Context *pContext = nullptr;
 
@@ -236,6 +254,9 @@ protected:
 	/// The queue family index where graphics work will be submitted.
 	unsigned graphicsQueueIndex;
 
+	/// The queue family index where uploads will be submitted.
+	unsigned transferQueueIndex;
+
 	/// List of external layers to load.
 	std::vector<std::string> externalLayers;
 
@@ -244,6 +265,28 @@ protected:
 	/// User-data for external debug callback.
 	void *pExternalDebugCallbackUserData = nullptr;
 
+	/// @brief Helper function to find a queue family dedicated to transfers.
+	///
+	/// Such queue families usually map to DMA engines which can copy data
+	/// while the graphics queue is busy rendering. Copies to images must be
+	/// possible at any granularity, since uploads write arbitrary regions.
+	/// @returns The queue family index, or @ref graphicsQueueIndex if there is
+	/// no such queue family.
+	inline unsigned findTransferQueueIndex() const
+	{
+		for (unsigned i = 0; i < queueProperties.size(); i++)
+		{
+			const VkQueueFamilyProperties &props = queueProperties[i];
+			const VkExtent3D &granularity = props.minImageTransferGranularity;
+			if ((props.queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+			    !(props.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) && props.queueCount > 0 &&
+			    granularity.width == 1 && granularity.height == 1 && granularity.depth == 1)
+				return i;
+		}
+
+		return graphicsQueueIndex;
+	}
+
 	/// @brief Helper function to add external layers to a list of active ones.
 	/// @param activeLayers List of active layers to be used.
 	/// @param supportedLayers List of supported layers.
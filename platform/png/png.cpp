@@ -69,42 +69,6 @@ static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(VkDebugReportFlagsEXT flags,
 	}
 }
 
-uint32_t PNGPlatform::findMemoryTypeFromRequirements(uint32_t deviceRequirements, uint32_t hostRequirements)
-{
-	const VkPhysicalDeviceMemoryProperties &props = memoryProperties;
-	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++)
-	{
-		if (deviceRequirements & (1u << i))
-		{
-			if ((props.memoryTypes[i].propertyFlags & hostRequirements) == hostRequirements)
-			{
-				return i;
-			}
-		}
-	}
-
-	LOGE("Failed to obtain suitable memory type.\n");
-	abort();
-}
-
-uint32_t PNGPlatform::findMemoryTypeFromRequirementsFallback(uint32_t deviceRequirements, uint32_t hostRequirements,
-                                                             uint32_t hostRequirementsFallback)
-{
-	const VkPhysicalDeviceMemoryProperties &props = memoryProperties;
-	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++)
-	{
-		if (deviceRequirements & (1u << i))
-		{
-			if ((props.memoryTypes[i].propertyFlags & hostRequirements) == hostRequirements)
-			{
-				return i;
-			}
-		}
-	}
-
-	return findMemoryTypeFromRequirements(deviceRequirements, hostRequirementsFallback);
-}
-
 Platform &Platform::get()
 {
 	// Not initialized until first call to Platform::get().
@@ -147,8 +111,13 @@ Result PNGPlatform::initialize()
 void PNGPlatform::terminate()
 {
 	// Don't release anything until the GPU is completely idle.
+	// Report memory usage while the context and the swapchain still hold
+	// their memory, so the current usage is meaningful next to the peaks.
 	if (device)
+	{
 		vkDeviceWaitIdle(device);
+		MemoryBudgetTracker::get().report();
+	}
 
 	// Make sure we delete the PNG swapchain before tearing down the buffers.
 	delete pngSwapchain;
@@ -158,17 +127,18 @@ void PNGPlatform::terminate()
 		if (image != VK_NULL_HANDLE)
 			vkDestroyImage(device, image, nullptr);
 
+	// The memory comes from the allocator of the context, so it is freed
+	// before the context goes away. There is only memory once the context
+	// has been set up.
 	for (auto &memory : swapchainMemory)
-		if (memory != VK_NULL_HANDLE)
-			vkFreeMemory(device, memory, nullptr);
+		pContext->getAllocator().free(memory);
 
 	for (auto &buffer : swapchainReadback)
 		if (buffer != VK_NULL_HANDLE)
 			vkDestroyBuffer(device, buffer, nullptr);
 
 	for (auto &memory : swapchainReadbackMemory)
-		if (memory != VK_NULL_HANDLE)
-			vkFreeMemory(device, memory, nullptr);
+		pContext->getAllocator().free(memory);
 
 	// Make sure we tear down the context before destroying the device since
 	// context
@@ -176,8 +146,16 @@ void PNGPlatform::terminate()
 	delete pContext;
 	pContext = nullptr;
 
+	// The frames of the context wait for the readback fences, so they go after it.
+	for (auto &fence : swapchainReadbackFences)
+		if (fence != VK_NULL_HANDLE)
+			vkDestroyFence(device, fence, nullptr);
+
 	if (device)
+	{
+		MemoryBudgetTracker::get().uninstall();
 		vkDestroyDevice(device, nullptr);
+	}
 
 	if (debug_callback)
 	{
@@ -192,6 +170,7 @@ void PNGPlatform::terminate()
 	swapchainMemory.clear();
 	swapchainReadback.clear();
 	swapchainReadbackMemory.clear();
+	swapchainReadbackFences.clear();
 	device = VK_NULL_HANDLE;
 	debug_callback = VK_NULL_HANDLE;
 	instance = VK_NULL_HANDLE;
@@ -285,16 +264,22 @@ Result PNGPlatform::presentImage(unsigned index)
 	                       1, &region);
 
 	VK_CHECK(vkEndCommandBuffer(cmd));
-	pContext->submit(cmd);
 
-	// For the PNG swapchain, we rely on keeping track of all the queue
-	// submissions we made,
-	// wait for their fences to hit in a separate thread, then we can do
-	// multithreaded PNG encoding.
-	unsigned numFences = pContext->getFenceManager().getActiveFenceCount();
-	VkFence *fences = pContext->getFenceManager().getActiveFences();
-	pngSwapchain->present(index, device, swapchainReadbackMemory[index], swapchainDimensions.width,
-	                      swapchainDimensions.height, numFences, fences, swapchainCoherent);
+	// The readback is batched together with the rendering for this frame,
+	// so the whole frame goes to the GPU in a single queue submission.
+	//
+	// The PNG thread waits for the readback before it encodes the image. The
+	// fences of the context belong to a frame slot, which is reset and reused
+	// after getFramesInFlight() frames, possibly before the thread gets to
+	// them. Instead, the submission signals a fence of this image. The image is
+	// only acquired again after the thread is done with it, so the fence can
+	// be reset then.
+	VkFence fence = swapchainReadbackFences[index];
+	VK_CHECK(vkResetFences(device, 1, &fence));
+	pContext->submit(cmd);
+	pContext->flush(fence);
+	pngSwapchain->present(index, device, &pContext->getAllocator(), swapchainReadbackMemory[index],
+	                      swapchainDimensions.width, swapchainDimensions.height, fence);
 	return RESULT_SUCCESS;
 }
 
@@ -473,15 +458,27 @@ Result PNGPlatform::initVulkan(const SwapchainDimensions &swapchain)
 	}
 
 	static const float one = 1.0f;
-	VkDeviceQueueCreateInfo queueInfo = { VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO };
-	queueInfo.queueFamilyIndex = graphicsQueueIndex;
-	queueInfo.queueCount = 1;
-	queueInfo.pQueuePriorities = &one;
+	VkDeviceQueueCreateInfo queueInfo[2] = {};
+	queueInfo[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+	queueInfo[0].queueFamilyIndex = graphicsQueueIndex;
+	queueInfo[0].queueCount = 1;
+	queueInfo[0].pQueuePriorities = &one;
+
+	// Uploads use a separate queue if there is a queue family dedicated to
+	// transfers.
+	transferQueueIndex = findTransferQueueIndex();
+	unsigned queueInfoCount = 1;
+	if (transferQueueIndex != graphicsQueueIndex)
+	{
+		queueInfo[1] = queueInfo[0];
+		queueInfo[1].queueFamilyIndex = transferQueueIndex;
+		queueInfoCount++;
+	}
 
 	VkPhysicalDeviceFeatures features = { false };
 	VkDeviceCreateInfo deviceInfo = { VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
-	deviceInfo.queueCreateInfoCount = 1;
-	deviceInfo.pQueueCreateInfos = &queueInfo;
+	deviceInfo.queueCreateInfoCount = queueInfoCount;
+	deviceInfo.pQueueCreateInfos = queueInfo;
 	deviceInfo.pEnabledFeatures = &features;
 
 #if ENABLE_VALIDATION_LAYERS
@@ -500,15 +497,30 @@ Result PNGPlatform::initVulkan(const SwapchainDimensions &swapchain)
 		return RESULT_ERROR_GENERIC;
 	}
 
+	MemoryBudgetTracker::get().install(memoryProperties);
+
 	vkGetDeviceQueue(device, graphicsQueueIndex, 0, &queue);
+	vkGetDeviceQueue(device, transferQueueIndex, 0, &transferQueue);
 
 	swapchainDimensions = swapchain;
 	swapchainDimensions.format = VK_FORMAT_R8G8B8A8_UNORM;
 	swapchainImages.resize(pngSwapchain->getNumImages());
+
+	// The context only needs the number of swapchain images, so it can be set
+	// up before the images exist. The images and readback buffers are then
+	// sub-allocated from the allocator of the context, which the application
+	// uses as well, so they share blocks with everything else.
+	Result res = pContext->onPlatformUpdate(this);
+	if (FAILED(res))
+		return RESULT_ERROR_GENERIC;
+
 	swapchainMemory.resize(pngSwapchain->getNumImages());
 	swapchainReadback.resize(pngSwapchain->getNumImages());
 	swapchainReadbackMemory.resize(pngSwapchain->getNumImages());
+	swapchainReadbackFences.resize(pngSwapchain->getNumImages());
 
+	DeviceMemoryAllocator &allocator = pContext->getAllocator();
+	MemoryTagScope scope(MEMORY_TAG_SWAPCHAIN);
 	for (unsigned i = 0; i < pngSwapchain->getNumImages(); i++)
 	{
 		VkImageCreateInfo image = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
@@ -531,12 +543,9 @@ Result PNGPlatform::initVulkan(const SwapchainDimensions &swapchain)
 		VkMemoryRequirements memReqs;
 		vkGetImageMemoryRequirements(device, swapchainImages[i], &memReqs);
 
-		VkMemoryAllocateInfo alloc = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-		alloc.allocationSize = memReqs.size;
-		alloc.memoryTypeIndex =
-		    findMemoryTypeFromRequirements(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-		VK_CHECK(vkAllocateMemory(device, &alloc, nullptr, &swapchainMemory[i]));
-		vkBindImageMemory(device, swapchainImages[i], swapchainMemory[i], 0);
+		VK_CHECK(allocator.allocate(memReqs, MemoryTypeSelector::USAGE_DEVICE_LOCAL,
+		                            DeviceMemoryAllocator::RESOURCE_OPTIMAL, &swapchainMemory[i]));
+		vkBindImageMemory(device, swapchainImages[i], swapchainMemory[i].memory, swapchainMemory[i].offset);
 
 		// Create a buffer which we will read back from.
 		VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
@@ -547,26 +556,17 @@ Result PNGPlatform::initVulkan(const SwapchainDimensions &swapchain)
 		VK_CHECK(vkCreateBuffer(device, &bufferInfo, nullptr, &swapchainReadback[i]));
 		vkGetBufferMemoryRequirements(device, swapchainReadback[i], &memReqs);
 
-		alloc.allocationSize = memReqs.size;
-		// Try to use CACHED_BIT if available, since this will greatly accelerate
-		// readbacks.
-		alloc.memoryTypeIndex = findMemoryTypeFromRequirementsFallback(
-		    memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
-		    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-		VK_CHECK(vkAllocateMemory(device, &alloc, nullptr, &swapchainReadbackMemory[i]));
-
-		// Figure out if we have incoherent memory. If so, we need to do cache
-		// control manually.
-		// This will be the same for every iteration.
-		swapchainCoherent = (memoryProperties.memoryTypes[alloc.memoryTypeIndex].propertyFlags &
-		                     VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
-
-		vkBindBufferMemory(device, swapchainReadback[i], swapchainReadbackMemory[i], 0);
-	}
+		// Readback memory is cached if available, since this will greatly
+		// accelerate readbacks. If the memory is incoherent, the allocator takes
+		// care of cache control.
+		VK_CHECK(allocator.allocate(memReqs, MemoryTypeSelector::USAGE_READBACK,
+		                            DeviceMemoryAllocator::RESOURCE_LINEAR, &swapchainReadbackMemory[i]));
+		vkBindBufferMemory(device, swapchainReadback[i], swapchainReadbackMemory[i].memory,
+		                   swapchainReadbackMemory[i].offset);
 
-	Result res = pContext->onPlatformUpdate(this);
-	if (FAILED(res))
-		return RESULT_ERROR_GENERIC;
+		VkFenceCreateInfo fenceInfo = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+		VK_CHECK(vkCreateFence(device, &fenceInfo, nullptr, &swapchainReadbackFences[i]));
+	}
 
 	return RESULT_SUCCESS;
 }
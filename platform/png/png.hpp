@@ -88,16 +88,16 @@ private:
 
 	SwapchainDimensions swapchainDimensions;
 	std::vector<VkImage> swapchainImages;
-	std::vector<VkDeviceMemory> swapchainMemory;
+	std::vector<DeviceAllocation> swapchainMemory;
 	std::vector<VkBuffer> swapchainReadback;
-	std::vector<VkDeviceMemory> swapchainReadbackMemory;
-	bool swapchainCoherent = false;
+	std::vector<DeviceAllocation> swapchainReadbackMemory;
 
-	Result initVulkan(const SwapchainDimensions &dimensions);
+	// Signalled when the readback of a swapchain image has completed. Unlike
+	// the fences of the context, these stay valid until the PNG thread is done
+	// with the image.
+	std::vector<VkFence> swapchainReadbackFences;
 
-	uint32_t findMemoryTypeFromRequirements(uint32_t deviceRequirements, uint32_t hostRequirements);
-	uint32_t findMemoryTypeFromRequirementsFallback(uint32_t deviceRequirements, uint32_t hostRequirements,
-	                                                uint32_t hostRequirementsFallback);
+	Result initVulkan(const SwapchainDimensions &dimensions);
 
 	void imageMemoryBarrier(VkCommandBuffer cmd, VkImage image, VkAccessFlags srcAccessMask,
 	                        VkAccessFlags dstAccessMask, VkPipelineStageFlags srcStageMask,
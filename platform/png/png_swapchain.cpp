@@ -58,11 +58,11 @@ PNGSwapchain::~PNGSwapchain()
 	join();
 }
 
-void PNGSwapchain::present(unsigned index, VkDevice device, VkDeviceMemory memory, unsigned width, unsigned height,
-                           unsigned numFences, VkFence *fences, bool coherent)
+void PNGSwapchain::present(unsigned index, VkDevice device, const DeviceMemoryAllocator *pAllocator,
+                           const DeviceAllocation &memory, unsigned width, unsigned height, VkFence fence)
 {
 	lock_guard<mutex> l{ lock };
-	ready.push({ device, memory, fences, numFences, index, width, height, coherent });
+	ready.push({ device, pAllocator, memory, fence, index, width, height });
 	cond.notify_all();
 }
 
@@ -83,21 +83,11 @@ void PNGSwapchain::dump(const Command &cmd, unsigned sequenceCount)
 
 	LOGI("Writing PNG file to: \"%s\".\n", path.c_str());
 
-	void *pSrc = nullptr;
-	VK_CHECK(vkMapMemory(cmd.device, cmd.memory, 0, cmd.width * cmd.height * 4, 0, &pSrc));
+	// The readback memory is persistently mapped. If it is incoherent, this
+	// invalidates the CPU caches before copying.
+	cmd.pAllocator->invalidate(cmd.memory);
 
-	// If our memory is incoherent, make sure that we invalidate the CPU caches
-	// before copying.
-	if (!cmd.coherent)
-	{
-		VkMappedMemoryRange range = { VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE };
-		range.memory = cmd.memory;
-		range.size = VK_WHOLE_SIZE;
-		VK_CHECK(vkInvalidateMappedMemoryRanges(cmd.device, 1, &range));
-	}
-
-	int ret = stbi_write_png(path.c_str(), cmd.width, cmd.height, 4, pSrc, cmd.width * 4);
-	vkUnmapMemory(cmd.device, cmd.memory);
+	int ret = stbi_write_png(path.c_str(), cmd.width, cmd.height, 4, cmd.memory.pHostPointer, cmd.width * 4);
 
 	if (ret != 0)
 		LOGI("Wrote PNG file: \"%s\".\n", path.c_str());
@@ -136,7 +126,7 @@ void PNGSwapchain::threadEntry()
 			ready.pop();
 		}
 
-		vkWaitForFences(command.device, command.numFences, command.fences, true, UINT64_MAX);
+		vkWaitForFences(command.device, 1, &command.fence, true, UINT64_MAX);
 		unsigned nextVacant = displayed;
 
 		dump(command, sequenceCount++);
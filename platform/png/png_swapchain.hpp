@@ -29,6 +29,7 @@
 #include <thread>
 
 #include "framework/common.hpp"
+#include "framework/device_memory_allocator.hpp"
 
 namespace MaliSDK
 {
@@ -60,17 +61,16 @@ public:
 	/// @brief Dump image for a swapchain index to disk.
 	/// @param index Index to present.
 	/// @param device Vulkan device.
-	/// @param memory The VkDeviceMemory associated with the swapchain image. The
-	/// memory must be tightly packed in VK_FORMAT_R8G8B8A8_UNORM format.
+	/// @param pAllocator The allocator the readback memory was allocated from.
+	/// @param memory The host visible allocation the swapchain image was read
+	/// back into. The memory must be tightly packed in VK_FORMAT_R8G8B8A8_UNORM
+	/// format.
 	/// @param width The width of the swapchain image.
 	/// @param height The height of the swapchain image.
-	/// @param numFences The number of VkFences to wait on before dumping the
-	/// texture.
-	/// @param[in] fences Fences to wait for.
-	/// @param coherent If the swapchain memory is coherent, i.e. does not need to
-	/// invalidate caches.
-	void present(unsigned index, VkDevice device, VkDeviceMemory memory, unsigned width, unsigned height,
-	             unsigned numFences, VkFence *fences, bool coherent);
+	/// @param fence The fence to wait on before dumping the texture. It must
+	/// not be reset or destroyed until the image is acquired again.
+	void present(unsigned index, VkDevice device, const DeviceMemoryAllocator *pAllocator,
+	             const DeviceAllocation &memory, unsigned width, unsigned height, VkFence fence);
 
 	/// @brief Acquire a new swapchain index.
 	/// When acquire returns the image is ready to be presented into, so no
@@ -86,13 +86,12 @@ private:
 	struct Command
 	{
 		VkDevice device;
-		VkDeviceMemory memory;
-		VkFence *fences;
-		unsigned numFences;
+		const DeviceMemoryAllocator *pAllocator;
+		DeviceAllocation memory;
+		VkFence fence;
 		unsigned index;
 		unsigned width;
 		unsigned height;
-		bool coherent;
 	};
 
 	std::queue<unsigned> vacant;
@@ -406,15 +406,27 @@ Result WSIPlatform::initVulkan(const SwapchainDimensions &swapchain,
 	}
 
 	static const float one = 1.0f;
-	VkDeviceQueueCreateInfo queueInfo = { VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO };
-	queueInfo.queueFamilyIndex = graphicsQueueIndex;
-	queueInfo.queueCount = 1;
-	queueInfo.pQueuePriorities = &one;
+	VkDeviceQueueCreateInfo queueInfo[2] = {};
+	queueInfo[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+	queueInfo[0].queueFamilyIndex = graphicsQueueIndex;
+	queueInfo[0].queueCount = 1;
+	queueInfo[0].pQueuePriorities = &one;
+
+	// Uploads use a separate queue if there is a queue family dedicated to
+	// transfers.
+	transferQueueIndex = findTransferQueueIndex();
+	unsigned queueInfoCount = 1;
+	if (transferQueueIndex != graphicsQueueIndex)
+	{
+		queueInfo[1] = queueInfo[0];
+		queueInfo[1].queueFamilyIndex = transferQueueIndex;
+		queueInfoCount++;
+	}
 
 	VkPhysicalDeviceFeatures features = { false };
 	VkDeviceCreateInfo deviceInfo = { VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
-	deviceInfo.queueCreateInfoCount = 1;
-	deviceInfo.pQueueCreateInfos = &queueInfo;
+	deviceInfo.queueCreateInfoCount = queueInfoCount;
+	deviceInfo.pQueueCreateInfos = queueInfo;
 	if (useDeviceExtensions)
 	{
 		deviceInfo.enabledExtensionCount = requiredDeviceExtensions.size();
@@ -446,7 +458,10 @@ Result WSIPlatform::initVulkan(const SwapchainDimensions &swapchain,
 		return RESULT_ERROR_GENERIC;
 	}
 
+	MemoryBudgetTracker::get().install(memoryProperties);
+
 	vkGetDeviceQueue(device, graphicsQueueIndex, 0, &queue);
+	vkGetDeviceQueue(device, transferQueueIndex, 0, &transferQueue);
 
 	Result res = initSwapchain(swapchain);
 	if (res != RESULT_SUCCESS)
@@ -500,6 +515,8 @@ void WSIPlatform::terminate()
 
 	if (device)
 	{
+		MemoryBudgetTracker::get().report();
+		MemoryBudgetTracker::get().uninstall();
 		vkDestroyDevice(device, nullptr);
 		device = VK_NULL_HANDLE;
 	}
@@ -727,6 +744,10 @@ Result WSIPlatform::acquireNextImage(unsigned *image)
 
 Result WSIPlatform::presentImage(unsigned index)
 {
+	// Submit everything the application has batched up this frame, which
+	// includes the command buffer which signals the release semaphore.
+	pContext->flush();
+
 	VkResult result;
 	VkPresentInfoKHR present = { VK_STRUCTURE_TYPE_PRESENT_INFO_KHR };
 	present.swapchainCount = 1;
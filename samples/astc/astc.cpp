@@ -49,7 +49,7 @@ struct Buffer
 	VkBuffer buffer;
 
 	// Buffer objects are backed by device memory.
-	VkDeviceMemory memory;
+	DeviceAllocation allocation;
 };
 
 struct Texture
@@ -61,7 +61,7 @@ struct Texture
 	VkImageView view;
 
 	// Memory for the texture.
-	VkDeviceMemory memory;
+	DeviceAllocation allocation;
 
 	// Images have layouts, stores the current layout used.
 	VkImageLayout layout;
@@ -73,10 +73,9 @@ struct Texture
 };
 
 // We have one PerFrame struct for every swapchain image.
-// Every swapchain image will have its own uniform buffer and descriptor sets.
+// Every swapchain image will have its own descriptor sets.
 struct PerFrame
 {
-	Buffer uniformBuffer;
 	// Have one descriptor set for each ASTC block size we're demonstrating.
 	VkDescriptorSet descriptorSets[4];
 	VkDescriptorPool descriptorPool;
@@ -126,12 +125,12 @@ private:
 	Texture texture8x8;
 	Texture texture12x12;
 
+	// Whether the device can sample ASTC textures. If not, a PNG fallback is used instead.
+	bool supportsASTC = false;
+
 	Buffer createBuffer(const void *pInitial, size_t size, VkFlags usage);
 	Texture createASTCTextureFromAssetOrFallback(const char *pPath, const char *pFallbackPath);
 
-	uint32_t findMemoryTypeFromRequirements(uint32_t deviceRequirements, uint32_t hostRequirements);
-	uint32_t findMemoryTypeFromRequirementsWithFallback(uint32_t deviceRequirements, uint32_t hostRequirements);
-
 	void initRenderPass(VkFormat format);
 	void termBackbuffers();
 
@@ -142,88 +141,38 @@ private:
 	void initPipeline();
 	void initPipelineLayout();
 
-	void imageMemoryBarrier(VkCommandBuffer cmd, VkImage image, VkAccessFlags srcAccessMask,
-	                        VkAccessFlags dstAccessMask, VkPipelineStageFlags srcStageMask,
-	                        VkPipelineStageFlags dstStageMask, VkImageLayout oldLayout, VkImageLayout newLayout);
-
 	float accumulatedTime = 0.0f;
 };
 
-// To create a buffer, both the device and application have requirements from the buffer object.
-// Vulkan exposes the different types of buffers the device can allocate, and we have to find a suitable one.
-// deviceRequirements is a bitmask expressing which memory types can be used for a buffer object.
-// The different memory types' properties must match with what the application wants.
-uint32_t ASTC::findMemoryTypeFromRequirements(uint32_t deviceRequirements, uint32_t hostRequirements)
-{
-	const VkPhysicalDeviceMemoryProperties &props = pContext->getPlatform().getMemoryProperties();
-	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++)
-	{
-		if (deviceRequirements & (1u << i))
-		{
-			if ((props.memoryTypes[i].propertyFlags & hostRequirements) == hostRequirements)
-			{
-				return i;
-			}
-		}
-	}
-
-	LOGE("Failed to obtain suitable memory type.\n");
-	abort();
-}
-
-uint32_t ASTC::findMemoryTypeFromRequirementsWithFallback(uint32_t deviceRequirements, uint32_t hostRequirements)
-{
-	const VkPhysicalDeviceMemoryProperties &props = pContext->getPlatform().getMemoryProperties();
-	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++)
-	{
-		if (deviceRequirements & (1u << i))
-		{
-			if ((props.memoryTypes[i].propertyFlags & hostRequirements) == hostRequirements)
-			{
-				return i;
-			}
-		}
-	}
-
-	// If we cannot find the particular memory type we're looking for, just pick
-	// the first one available.
-	if (hostRequirements != 0)
-		return findMemoryTypeFromRequirements(deviceRequirements, 0);
-	else
-	{
-		LOGE("Failed to obtain suitable memory type.\n");
-		abort();
-	}
-}
-
 Texture ASTC::createASTCTextureFromAssetOrFallback(const char *pPath, const char *pFallbackPath)
 {
-	// We want to first create a staging buffer.
+	// We want to first load the texture data.
 	//
-	// We will then copy this buffer into an optimally tiled texture with vkCmdCopyBufferToImage.
+	// We will then copy it into an optimally tiled texture with vkCmdCopyBufferToImage.
 	// The layout of such a texture is not specified as it is highly GPU-dependent and optimized for
 	// utilizing texture caches better.
 	unsigned width, height;
 	VkFormat format;
-	vector<uint8_t> buffer;
 
-	// Check if the device supports ASTC textures.
-	VkFormatProperties properties;
-	vkGetPhysicalDeviceFormatProperties(pContext->getPhysicalDevice(), VK_FORMAT_ASTC_4x4_UNORM_BLOCK, &properties);
-	bool supportsASTC = (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+	// The ASTC payload is used straight from the asset, so it is never copied
+	// before it is uploaded. The PNG fallback has to be decoded into a buffer.
+	AssetData astcPayload;
+	vector<uint8_t> buffer;
+	const void *pPixels;
+	size_t pixelSize;
 
 	if (supportsASTC)
 	{
-		LOGI("Device supports ASTC, loading ASTC texture!\n");
-		if (FAILED(loadASTCTextureFromAsset(pPath, &buffer, &width, &height, &format)))
+		if (FAILED(loadASTCTextureFromAsset(pPath, &astcPayload, &width, &height, &format)))
 		{
 			LOGE("Failed to load texture from asset.\n");
 			abort();
 		}
+		pPixels = astcPayload.getData();
+		pixelSize = astcPayload.getSize();
 	}
 	else
 	{
-		LOGE("Device does not support ASTC, falling back to PNG texture!\n");
 		if (FAILED(loadRgba8888TextureFromAsset(pFallbackPath, &buffer, &width, &height)))
 		{
 			LOGE("Failed to load fallback texture from asset.\n");
@@ -240,14 +189,14 @@ Texture ASTC::createASTCTextureFromAssetOrFallback(const char *pPath, const char
 
 		for (int ybegin = 0, yend = int(height) - 1; ybegin < yend; ybegin++, yend--)
 			flipLine(buffer.data() + 4 * width * ybegin, buffer.data() + 4 * width * yend, width * 4);
+
+		pPixels = buffer.data();
+		pixelSize = buffer.size();
 	}
 
 	VkDevice device = pContext->getDevice();
 	VkImage image;
-	VkDeviceMemory memory;
-
-	// Copy commands such as vkCmdCopyBufferToImage will need TRANSFER_SRC_BIT.
-	Buffer stagingBuffer = createBuffer(buffer.data(), buffer.size(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+	DeviceAllocation allocation;
 
 	// We will transition the actual texture into a proper layout before
 	// transfering any data, so leave it as undefined.
@@ -272,20 +221,17 @@ Texture ASTC::createASTCTextureFromAssetOrFallback(const char *pPath, const char
 	VkMemoryRequirements memReqs;
 	vkGetImageMemoryRequirements(device, image, &memReqs);
 
-	VkMemoryAllocateInfo alloc = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-	alloc.allocationSize = memReqs.size;
 	// If a device local memory type exists, we should use that.
 	// DEVICE_LOCAL implies that the device has the fastest possible access to
 	// this resource, which is clearly what we want here.
 	// On integrated GPUs such as Mali, memory types are generally *both*
 	// DEVICE_LOCAL and HOST_VISIBLE at the same time,
 	// since the GPU can directly access the same memory as the CPU can.
-	alloc.memoryTypeIndex =
-	    findMemoryTypeFromRequirementsWithFallback(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-	VK_CHECK(vkAllocateMemory(device, &alloc, nullptr, &memory));
+	VK_CHECK(pContext->getAllocator().allocate(memReqs, MemoryTypeSelector::USAGE_DEVICE_LOCAL,
+	                                           DeviceMemoryAllocator::RESOURCE_OPTIMAL, &allocation));
 
 	// Bind the newly allocated memory to the image.
-	vkBindImageMemory(device, image, memory, 0);
+	vkBindImageMemory(device, image, allocation.memory, allocation.offset);
 
 	// Create an image view for the new texture.
 	// Note that CreateImageView must happen after BindImageMemory.
@@ -304,23 +250,11 @@ Texture ASTC::createASTCTextureFromAssetOrFallback(const char *pPath, const char
 	VkImageView view;
 	VK_CHECK(vkCreateImageView(device, &viewInfo, nullptr, &view));
 
-	// Now we need to transfer the staging texture into the real texture.
-	// For this we will need a command buffer.
-	VkCommandBuffer cmd = pContext->requestPrimaryCommandBuffer();
-
-	// We will only submit this once before it's recycled.
-	VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
-	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-	vkBeginCommandBuffer(cmd, &beginInfo);
-
-	// Transition the uninitialized texture into a TRANSFER_DST_OPTIMAL layout.
-	// We do not need to wait for anything to make the transition, so use
-	// TOP_OF_PIPE_BIT as the srcStageMask.
-	imageMemoryBarrier(cmd, image, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-	                   VK_PIPELINE_STAGE_TRANSFER_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
+	// Now we need to transfer the pixels into the real texture.
+	// The upload manager copies them into its persistent staging ring and batches the copy with all other uploads.
+	// Pending uploads are submitted together right before the next command buffers we submit, so we need
+	// neither a staging buffer nor a command buffer of our own.
 	VkBufferImageCopy region = {};
-	region.bufferOffset = 0;
 	region.bufferRowLength = 0;
 	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	region.imageSubresource.layerCount = 1;
@@ -328,24 +262,11 @@ Texture ASTC::createASTCTextureFromAssetOrFallback(const char *pPath, const char
 	region.imageExtent.height = height;
 	region.imageExtent.depth = 1;
 
-	// Copy the buffer to our optimally tiled image.
-	vkCmdCopyBufferToImage(cmd, stagingBuffer.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-	// Wait for all transfers to complete before we let any fragment shading begin.
-	imageMemoryBarrier(cmd, image, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
-	                   VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-	                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-	VK_CHECK(vkEndCommandBuffer(cmd));
-	pContext->submit(cmd);
-
-	// We want to free the staging buffer and memory right away, so wait for GPU
-	// complete the transfer.
-	vkQueueWaitIdle(pContext->getGraphicsQueue());
-
-	// Now it's safe to free the temporary resources.
-	vkFreeMemory(device, stagingBuffer.memory, nullptr);
-	vkDestroyBuffer(device, stagingBuffer.buffer, nullptr);
+	// The texture is transitioned into a TRANSFER_DST_OPTIMAL layout for the copy, and into a
+	// SHADER_READ_ONLY_OPTIMAL layout once the copy has completed.
+	VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+	pContext->getUploadManager().uploadImage(image, range, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, pPixels, pixelSize,
+	                                         &region, 1, supportsASTC ? 16 : 4);
 
 	// Finally, create a sampler.
 	VkSamplerCreateInfo samplerInfo = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
@@ -365,31 +286,11 @@ Texture ASTC::createASTCTextureFromAssetOrFallback(const char *pPath, const char
 	VK_CHECK(vkCreateSampler(device, &samplerInfo, nullptr, &sampler));
 
 	Texture ret = {
-		image, view, memory, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, sampler, width, height,
+		image, view, allocation, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, sampler, width, height,
 	};
 	return ret;
 }
 
-void ASTC::imageMemoryBarrier(VkCommandBuffer cmd, VkImage image, VkAccessFlags srcAccessMask,
-                              VkAccessFlags dstAccessMask, VkPipelineStageFlags srcStageMask,
-                              VkPipelineStageFlags dstStageMask, VkImageLayout oldLayout, VkImageLayout newLayout)
-{
-	VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-
-	barrier.srcAccessMask = srcAccessMask;
-	barrier.dstAccessMask = dstAccessMask;
-	barrier.oldLayout = oldLayout;
-	barrier.newLayout = newLayout;
-	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.image = image;
-	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	barrier.subresourceRange.levelCount = 1;
-	barrier.subresourceRange.layerCount = 1;
-
-	vkCmdPipelineBarrier(cmd, srcStageMask, dstStageMask, false, 0, nullptr, 0, nullptr, 1, &barrier);
-}
-
 Buffer ASTC::createBuffer(const void *pInitialData, size_t size, VkFlags usage)
 {
 	Buffer buffer;
@@ -405,26 +306,17 @@ Buffer ASTC::createBuffer(const void *pInitialData, size_t size, VkFlags usage)
 	VkMemoryRequirements memReqs;
 	vkGetBufferMemoryRequirements(device, buffer.buffer, &memReqs);
 
-	VkMemoryAllocateInfo alloc = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-	alloc.allocationSize = memReqs.size;
-
-	// We want host visible and coherent memory to simplify things.
-	alloc.memoryTypeIndex = findMemoryTypeFromRequirements(
-	    memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-	VK_CHECK(vkAllocateMemory(device, &alloc, nullptr, &buffer.memory));
+	// Sub-allocate host visible and coherent memory to simplify things.
+	VK_CHECK(pContext->getAllocator().allocate(memReqs, MemoryTypeSelector::USAGE_UPLOAD,
+	                                           DeviceMemoryAllocator::RESOURCE_LINEAR, &buffer.allocation));
 
 	// Buffers are not backed by memory, so bind our memory explicitly to the buffer.
-	vkBindBufferMemory(device, buffer.buffer, buffer.memory, 0);
+	vkBindBufferMemory(device, buffer.buffer, buffer.allocation.memory, buffer.allocation.offset);
 
-	// Map the memory and dump data in there.
+	// Host visible memory is persistently mapped by the allocator, so dump the
+	// data straight in there.
 	if (pInitialData)
-	{
-		void *pData;
-		VK_CHECK(vkMapMemory(device, buffer.memory, 0, size, 0, &pData));
-		memcpy(pData, pInitialData, size);
-		vkUnmapMemory(device, buffer.memory);
-	}
+		memcpy(buffer.allocation.pHostPointer, pInitialData, size);
 
 	return buffer;
 }
@@ -515,7 +407,7 @@ void ASTC::initPipelineLayout()
 
 	// In our vertex shader, we have one uniform buffer with layout(set = 0, binding = 1).
 	bindings[1].binding = 1;
-	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	bindings[1].descriptorCount = 1;
 	bindings[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
@@ -652,15 +544,24 @@ bool ASTC::initialize(Context *pContext)
 	// Initialize the pipeline layout.
 	initPipelineLayout();
 
+	// Check if the device supports ASTC textures.
+	VkFormatProperties properties;
+	vkGetPhysicalDeviceFormatProperties(pContext->getPhysicalDevice(), VK_FORMAT_ASTC_4x4_UNORM_BLOCK, &properties);
+	supportsASTC = (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+
+	if (supportsASTC)
+		LOGI("Device supports ASTC, loading ASTC textures!\n");
+	else
+		LOGE("Device does not support ASTC, falling back to PNG textures!\n");
+
 	// Load textures.
 	texture4x4 = createASTCTextureFromAssetOrFallback("textures/icon-astc-4x4.astc", "textures/icon-fallback.png");
 	texture6x6 = createASTCTextureFromAssetOrFallback("textures/icon-astc-6x6.astc", "textures/icon-fallback.png");
 	texture8x8 = createASTCTextureFromAssetOrFallback("textures/icon-astc-8x8.astc", "textures/icon-fallback.png");
 	texture12x12 = createASTCTextureFromAssetOrFallback("textures/icon-astc-12x12.astc", "textures/icon-fallback.png");
 
-	// Create a pipeline cache (although we'll only create one pipeline).
-	VkPipelineCacheCreateInfo pipelineCacheInfo = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
-	VK_CHECK(vkCreatePipelineCache(pContext->getDevice(), &pipelineCacheInfo, nullptr, &pipelineCache));
+	// Use the pipeline cache of the context, which is saved between runs.
+	pipelineCache = pContext->getPipelineCache().getCache();
 
 	return true;
 }
@@ -703,10 +604,9 @@ void ASTC::render(unsigned swapchainIndex, float deltaTime)
 	VkDeviceSize offset = 0;
 	vkCmdBindVertexBuffers(cmd, 0, 1, &vertexBuffer.buffer, &offset);
 
-	// Update the uniform buffers memory.
-	mat4 *pMatrix = nullptr;
-	VK_CHECK(vkMapMemory(pContext->getDevice(), frame.uniformBuffer.memory, 0, sizeof(mat4), 0,
-	                     reinterpret_cast<void **>(&pMatrix)));
+	// Allocate this frame's uniform data from the uniform ring.
+	uint32_t uniformOffset;
+	mat4 *pMatrix = static_cast<mat4 *>(pContext->getUniformRing().allocate(sizeof(mat4), &uniformOffset));
 
 	float aspect = float(width) / height;
 	float textureAspect = float(texture4x4.width) / texture4x4.height;
@@ -724,7 +624,6 @@ void ASTC::render(unsigned swapchainIndex, float deltaTime)
 
 	// Fix up the projection matrix so it matches what Vulkan expects.
 	*pMatrix = vulkanStyleProjection(proj) * model;
-	vkUnmapMemory(pContext->getDevice(), frame.uniformBuffer.memory);
 
 	// Draw four viewports each with their own ASTC texture.
 	for (unsigned i = 0; i < 4; i++)
@@ -751,9 +650,9 @@ void ASTC::render(unsigned swapchainIndex, float deltaTime)
 		scissor.extent.height = unsigned(vp.height);
 		vkCmdSetScissor(cmd, 0, 1, &scissor);
 
-		// Bind the descriptor set.
-		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frame.descriptorSets[i], 0,
-		                        nullptr);
+		// Bind the descriptor set, with the uniform data at a dynamic offset.
+		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frame.descriptorSets[i], 1,
+		                        &uniformOffset);
 
 		// Draw a quad with one instance.
 		vkCmdDraw(cmd, 4, 1, 0, 0);
@@ -796,8 +695,6 @@ void ASTC::termPerFrame()
 
 	for (auto &frame : perFrame)
 	{
-		vkFreeMemory(device, frame.uniformBuffer.memory, nullptr);
-		vkDestroyBuffer(device, frame.uniformBuffer.buffer, nullptr);
 		vkDestroyDescriptorPool(device, frame.descriptorPool, nullptr);
 	}
 	perFrame.clear();
@@ -812,14 +709,14 @@ void ASTC::terminate()
 
 	// Vertex buffer
 	vkDestroyBuffer(device, vertexBuffer.buffer, nullptr);
-	vkFreeMemory(device, vertexBuffer.memory, nullptr);
+	pContext->getAllocator().free(vertexBuffer.allocation);
 
 	// Texture
-	const auto destroyImage = [device](const Texture &texture) {
+	const auto destroyImage = [this, device](Texture &texture) {
 		vkDestroyImageView(device, texture.view, nullptr);
 		vkDestroyImage(device, texture.image, nullptr);
 		vkDestroySampler(device, texture.sampler, nullptr);
-		vkFreeMemory(device, texture.memory, nullptr);
+		pContext->getAllocator().free(texture.allocation);
 	};
 	destroyImage(texture4x4);
 	destroyImage(texture6x6);
@@ -830,7 +727,6 @@ void ASTC::terminate()
 	termPerFrame();
 	termBackbuffers();
 
-	vkDestroyPipelineCache(device, pipelineCache, nullptr);
 	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
 	vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
 }
@@ -841,15 +737,15 @@ void ASTC::initPerFrame(unsigned numBackbuffers)
 
 	for (unsigned i = 0; i < numBackbuffers; i++)
 	{
-		// Create one uniform buffer per swapchain frame. We will update the uniform
-		// buffer every frame and we don't want to stomp on a uniform buffer already in flight.
+		// The uniform data is allocated from the context's uniform ring every
+		// frame and bound with a dynamic offset, so the descriptor set always
+		// points at the ring buffer.
 		PerFrame frame;
-		frame.uniformBuffer = createBuffer(nullptr, sizeof(mat4), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
 
 		// Allocate descriptor set from a pool.
 		// We'll need 4 of each type in total.
 		static const VkDescriptorPoolSize poolSizes[2] = {
-			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 4 }, { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4 },
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 4 }, { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4 },
 		};
 
 		VkDescriptorPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
@@ -873,7 +769,7 @@ void ASTC::initPerFrame(unsigned numBackbuffers)
 			{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET }, { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET },
 		};
 
-		VkDescriptorBufferInfo bufferInfo = { frame.uniformBuffer.buffer, 0, sizeof(mat4) };
+		VkDescriptorBufferInfo bufferInfo = { pContext->getUniformRing().getBuffer(), 0, sizeof(mat4) };
 		VkDescriptorImageInfo imageInfos[4] = {
 			{ texture4x4.sampler, texture4x4.view, texture4x4.layout },
 			{ texture6x6.sampler, texture6x6.view, texture6x6.layout },
@@ -893,7 +789,7 @@ void ASTC::initPerFrame(unsigned numBackbuffers)
 			writes[1].dstSet = frame.descriptorSets[i];
 			writes[1].dstBinding = 1;
 			writes[1].descriptorCount = 1;
-			writes[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			writes[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 			writes[1].pBufferInfo = &bufferInfo;
 
 			vkUpdateDescriptorSets(device, 2, writes, 0, nullptr);
@@ -53,7 +53,7 @@ struct Buffer
 	VkBuffer buffer;
 
 	// Buffer objects are backed by device memory.
-	VkDeviceMemory memory;
+	DeviceAllocation allocation;
 
 	// Size of the buffer.
 	VkDeviceSize size;
@@ -68,7 +68,7 @@ struct Texture
 	VkImageView view;
 
 	// Memory for the texture.
-	VkDeviceMemory memory;
+	DeviceAllocation allocation;
 
 	// Images have layouts, stores the current layout used.
 	VkImageLayout layout;
@@ -124,9 +124,6 @@ private:
 
 	Buffer createBuffer(const void *pInitial, size_t size, VkFlags usage);
 
-	uint32_t findMemoryTypeFromRequirements(uint32_t deviceRequirements, uint32_t hostRequirements);
-	uint32_t findMemoryTypeFromRequirementsWithFallback(uint32_t deviceRequirements, uint32_t hostRequirements);
-
 	void initRenderPass(VkFormat format);
 	void termBackbuffers();
 
@@ -147,58 +144,6 @@ private:
 	float accumulatedTime = 0.0f;
 };
 
-// To create a buffer, both the device and application have requirements from
-// the buffer object.
-// Vulkan exposes the different types of buffers the device can allocate, and we
-// have to find a suitable one.
-// deviceRequirements is a bitmask expressing which memory types can be used for
-// a buffer object.
-// The different memory types' properties must match with what the application
-// wants.
-uint32_t BasicCompute::findMemoryTypeFromRequirements(uint32_t deviceRequirements, uint32_t hostRequirements)
-{
-	const VkPhysicalDeviceMemoryProperties &props = pContext->getPlatform().getMemoryProperties();
-	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++)
-	{
-		if (deviceRequirements & (1u << i))
-		{
-			if ((props.memoryTypes[i].propertyFlags & hostRequirements) == hostRequirements)
-			{
-				return i;
-			}
-		}
-	}
-
-	LOGE("Failed to obtain suitable memory type.\n");
-	abort();
-}
-
-uint32_t BasicCompute::findMemoryTypeFromRequirementsWithFallback(uint32_t deviceRequirements,
-                                                                  uint32_t hostRequirements)
-{
-	const VkPhysicalDeviceMemoryProperties &props = pContext->getPlatform().getMemoryProperties();
-	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++)
-	{
-		if (deviceRequirements & (1u << i))
-		{
-			if ((props.memoryTypes[i].propertyFlags & hostRequirements) == hostRequirements)
-			{
-				return i;
-			}
-		}
-	}
-
-	// If we cannot find the particular memory type we're looking for, just pick
-	// the first one available.
-	if (hostRequirements != 0)
-		return findMemoryTypeFromRequirements(deviceRequirements, 0);
-	else
-	{
-		LOGE("Failed to obtain suitable memory type.\n");
-		abort();
-	}
-}
-
 void BasicCompute::memoryBarrier(VkCommandBuffer cmd, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask,
                                  VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask)
 {
@@ -227,27 +172,18 @@ Buffer BasicCompute::createBuffer(const void *pInitialData, size_t size, VkFlags
 	VkMemoryRequirements memReqs;
 	vkGetBufferMemoryRequirements(device, buffer.buffer, &memReqs);
 
-	VkMemoryAllocateInfo alloc = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-	alloc.allocationSize = memReqs.size;
-
-	// We want host visible and coherent memory to simplify things.
-	alloc.memoryTypeIndex = findMemoryTypeFromRequirements(
-	    memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-	VK_CHECK(vkAllocateMemory(device, &alloc, nullptr, &buffer.memory));
+	// Sub-allocate host visible and coherent memory to simplify things.
+	VK_CHECK(pContext->getAllocator().allocate(memReqs, MemoryTypeSelector::USAGE_UPLOAD,
+	                                           DeviceMemoryAllocator::RESOURCE_LINEAR, &buffer.allocation));
 
 	// Buffers are not backed by memory, so bind our memory explicitly to the
 	// buffer.
-	vkBindBufferMemory(device, buffer.buffer, buffer.memory, 0);
+	vkBindBufferMemory(device, buffer.buffer, buffer.allocation.memory, buffer.allocation.offset);
 
-	// Map the memory and dump data in there.
+	// Host visible memory is persistently mapped by the allocator, so dump the
+	// data straight in there.
 	if (pInitialData)
-	{
-		void *pData;
-		VK_CHECK(vkMapMemory(device, buffer.memory, 0, size, 0, &pData));
-		memcpy(pData, pInitialData, size);
-		vkUnmapMemory(device, buffer.memory);
-	}
+		memcpy(buffer.allocation.pHostPointer, pInitialData, size);
 
 	buffer.size = size;
 	return buffer;
@@ -544,9 +480,8 @@ bool BasicCompute::initialize(Context *pContext)
 	// which depends on the backbuffer format which we do not know yet.
 	initComputePipeline();
 
-	// Create a pipeline cache (although we'll only create one pipeline).
-	VkPipelineCacheCreateInfo pipelineCacheInfo = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
-	VK_CHECK(vkCreatePipelineCache(pContext->getDevice(), &pipelineCacheInfo, nullptr, &pipelineCache));
+	// Use the pipeline cache of the context, which is saved between runs.
+	pipelineCache = pContext->getPipelineCache().getCache();
 
 	return true;
 }
@@ -676,9 +611,9 @@ void BasicCompute::destroyBuffer(Buffer *pBuffer)
 	VkDevice device = pContext->getDevice();
 
 	vkDestroyBuffer(device, pBuffer->buffer, nullptr);
-	vkFreeMemory(device, pBuffer->memory, nullptr);
+	pContext->getAllocator().free(pBuffer->allocation);
 
-	memset(pBuffer, 0, sizeof(*pBuffer));
+	*pBuffer = Buffer();
 }
 
 void BasicCompute::destroyPipeline(Pipeline *pPipeline)
@@ -700,9 +635,6 @@ void BasicCompute::terminate()
 {
 	vkDeviceWaitIdle(pContext->getDevice());
 
-	// Teardown.
-	VkDevice device = pContext->getDevice();
-
 	// Vertex buffers
 	destroyBuffer(&positionBuffer);
 	destroyBuffer(&velocityBuffer);
@@ -712,7 +644,6 @@ void BasicCompute::terminate()
 	termBackbuffers();
 
 	destroyPipeline(&computePipeline);
-	vkDestroyPipelineCache(device, pipelineCache, nullptr);
 }
 
 void BasicCompute::initComputeDescriptorSet()
@@ -49,7 +49,7 @@ struct Buffer
 	VkBuffer buffer;
 
 	// Buffer objects are backed by device memory.
-	VkDeviceMemory memory;
+	DeviceAllocation allocation;
 };
 
 struct Vertex
@@ -92,7 +92,6 @@ private:
 
 	// Helper function to create a buffer.
 	Buffer createBuffer(const void *pInitial, size_t size, VkFlags usage);
-	uint32_t findMemoryTypeFromRequirements(uint32_t deviceRequirements, uint32_t hostRequirements);
 
 	void initRenderPass(VkFormat format);
 	void termBackbuffers();
@@ -101,32 +100,6 @@ private:
 	void initPipeline();
 };
 
-// To create a buffer, both the device and application have requirements from
-// the buffer object.
-// Vulkan exposes the different types of buffers the device can allocate, and we
-// have to find a suitable one.
-// deviceRequirements is a bitmask expressing which memory types can be used for
-// a buffer object.
-// The different memory types' properties must match with what the application
-// wants.
-uint32_t HelloTriangle::findMemoryTypeFromRequirements(uint32_t deviceRequirements, uint32_t hostRequirements)
-{
-	const VkPhysicalDeviceMemoryProperties &props = pContext->getPlatform().getMemoryProperties();
-	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++)
-	{
-		if (deviceRequirements & (1u << i))
-		{
-			if ((props.memoryTypes[i].propertyFlags & hostRequirements) == hostRequirements)
-			{
-				return i;
-			}
-		}
-	}
-
-	LOGE("Failed to obtain suitable memory type.\n");
-	abort();
-}
-
 Buffer HelloTriangle::createBuffer(const void *pInitialData, size_t size, VkFlags usage)
 {
 	Buffer buffer;
@@ -142,28 +115,18 @@ Buffer HelloTriangle::createBuffer(const void *pInitialData, size_t size, VkFlag
 	VkMemoryRequirements memReqs;
 	vkGetBufferMemoryRequirements(device, buffer.buffer, &memReqs);
 
-	VkMemoryAllocateInfo alloc = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-	alloc.allocationSize = memReqs.size;
-
-	// We want host visible and coherent memory to simplify things.
-	alloc.memoryTypeIndex = findMemoryTypeFromRequirements(
-	    memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-	// Allocate memory.
-	VK_CHECK(vkAllocateMemory(device, &alloc, nullptr, &buffer.memory));
+	// Sub-allocate host visible and coherent memory to simplify things.
+	VK_CHECK(pContext->getAllocator().allocate(memReqs, MemoryTypeSelector::USAGE_UPLOAD,
+	                                           DeviceMemoryAllocator::RESOURCE_LINEAR, &buffer.allocation));
 
 	// Buffers are not backed by memory, so bind our memory explicitly to the
 	// buffer.
-	vkBindBufferMemory(device, buffer.buffer, buffer.memory, 0);
+	vkBindBufferMemory(device, buffer.buffer, buffer.allocation.memory, buffer.allocation.offset);
 
-	// Map the memory and dump data in there.
+	// Host visible memory is persistently mapped by the allocator, so dump the
+	// data straight in there.
 	if (pInitialData)
-	{
-		void *pData;
-		VK_CHECK(vkMapMemory(device, buffer.memory, 0, size, 0, &pData));
-		memcpy(pData, pInitialData, size);
-		vkUnmapMemory(device, buffer.memory);
-	}
+		memcpy(buffer.allocation.pHostPointer, pInitialData, size);
 
 	return buffer;
 }
@@ -388,9 +351,8 @@ bool HelloTriangle::initialize(Context *pContext)
 	// Create the vertex buffer.
 	initVertexBuffer();
 
-	// Create a pipeline cache (although we'll only create one pipeline).
-	VkPipelineCacheCreateInfo pipelineCacheInfo = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
-	VK_CHECK(vkCreatePipelineCache(pContext->getDevice(), &pipelineCacheInfo, nullptr, &pipelineCache));
+	// Use the pipeline cache of the context, which is saved between runs.
+	pipelineCache = pContext->getPipelineCache().getCache();
 
 	return true;
 }
@@ -492,11 +454,10 @@ void HelloTriangle::terminate()
 
 	// Final teardown.
 	VkDevice device = pContext->getDevice();
-	vkFreeMemory(device, vertexBuffer.memory, nullptr);
+	pContext->getAllocator().free(vertexBuffer.allocation);
 	vkDestroyBuffer(device, vertexBuffer.buffer, nullptr);
 
 	termBackbuffers();
-	vkDestroyPipelineCache(device, pipelineCache, nullptr);
 }
 
 void HelloTriangle::updateSwapchain(const vector<VkImage> &newBackbuffers, const Platform::SwapchainDimensions &dim)
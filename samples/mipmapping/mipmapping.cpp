@@ -19,6 +19,7 @@
  */
 
 #include "framework/application.hpp"
+#include "framework/asset_loader.hpp"
 #include "framework/assets.hpp"
 #include "framework/common.hpp"
 #include "framework/context.hpp"
@@ -50,7 +51,7 @@ struct Buffer
 	VkBuffer buffer;
 
 	// Buffer objects are backed by device memory.
-	VkDeviceMemory memory;
+	DeviceAllocation allocation;
 };
 
 struct Texture
@@ -62,7 +63,7 @@ struct Texture
 	VkImageView view;
 
 	// Memory for the texture.
-	VkDeviceMemory memory;
+	DeviceAllocation allocation;
 
 	// Images have layouts, stores the current layout used.
 	VkImageLayout layout;
@@ -75,12 +76,9 @@ struct Texture
 
 struct MipLevel
 {
-	// The raw, uncompressed data for the image.
+	// The raw, uncompressed data for the image, to be copied into a level of the texture.
 	vector<uint8_t> buffer;
 
-	// The buffer to be copied into a level of the texture.
-	Buffer stagingBuffer;
-
 	unsigned width, height;
 };
 
@@ -97,10 +95,9 @@ struct UniformBufferData
 };
 
 // We have one PerFrame struct for every swapchain image.
-// Every swapchain image will have its own uniform buffer and descriptor set.
+// Every swapchain image will have its own descriptor set.
 struct PerFrame
 {
-	Buffer uniformBuffer;
 	VkDescriptorSet descriptorSet;
 	VkDescriptorPool descriptorPool;
 };
@@ -152,12 +149,10 @@ private:
 	Texture labelTexture;
 
 	Buffer createBuffer(const void *pInitial, size_t size, VkFlags usage);
-	Texture createMipmappedTextureFromAssets(const vector<const char *> pPaths, bool generateMipLevels = false);
+	Texture createMipmappedTextureFromAssets(AssetLoader &loader, const vector<AssetLoader::TextureHandle> &sources,
+	                                         bool generateMipLevels = false);
 	void createQuad(vector<Vertex> &vertexData, vector<uint16_t> &indexData, unsigned &baseIndex, vec2 topLeft, vec2 bottomRight);
 
-	uint32_t findMemoryTypeFromRequirements(uint32_t deviceRequirements, uint32_t hostRequirements);
-	uint32_t findMemoryTypeFromRequirementsWithFallback(uint32_t deviceRequirements, uint32_t hostRequirements);
-
 	void initRenderPass(VkFormat format);
 	void termBackbuffers();
 
@@ -176,59 +171,15 @@ private:
 	float accumulatedTime = 0.0f;
 };
 
-// To create a buffer, both the device and application have requirements from the buffer object.
-// Vulkan exposes the different types of buffers the device can allocate, and we have to find a suitable one.
-// deviceRequirements is a bitmask expressing which memory types can be used for a buffer object.
-// The different memory types' properties must match with what the application wants.
-uint32_t Mipmapping::findMemoryTypeFromRequirements(uint32_t deviceRequirements, uint32_t hostRequirements)
-{
-	const VkPhysicalDeviceMemoryProperties &props = pContext->getPlatform().getMemoryProperties();
-	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++)
-	{
-		if (deviceRequirements & (1u << i))
-		{
-			if ((props.memoryTypes[i].propertyFlags & hostRequirements) == hostRequirements)
-			{
-				return i;
-			}
-		}
-	}
-
-	LOGE("Failed to obtain suitable memory type.\n");
-	abort();
-}
-
-uint32_t Mipmapping::findMemoryTypeFromRequirementsWithFallback(uint32_t deviceRequirements,
-                                                                uint32_t hostRequirements)
-{
-	const VkPhysicalDeviceMemoryProperties &props = pContext->getPlatform().getMemoryProperties();
-	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++)
-	{
-		if (deviceRequirements & (1u << i))
-		{
-			if ((props.memoryTypes[i].propertyFlags & hostRequirements) == hostRequirements)
-			{
-				return i;
-			}
-		}
-	}
-
-	// If we cannot find the particular memory type we're looking for, just pick the first one available.
-	if (hostRequirements != 0)
-		return findMemoryTypeFromRequirements(deviceRequirements, 0);
-	else
-	{
-		LOGE("Failed to obtain suitable memory type.\n");
-		abort();
-	}
-}
-
-Texture Mipmapping::createMipmappedTextureFromAssets(const vector<const char *> pPaths, bool generateMipLevels)
+Texture Mipmapping::createMipmappedTextureFromAssets(AssetLoader &loader,
+                                                     const vector<AssetLoader::TextureHandle> &sources,
+                                                     bool generateMipLevels)
 {
-	// We first create a vector of staging buffers, containing the images loaded from each path.
+	// We first wait for the images to be loaded. They are decoded on worker threads, so by the time
+	// we get here, most of them are usually ready.
 	//
 	// We will then create a mipmapped texture, depending on the value of generateMipLevels:
-	// - if generateMipLevels is true, we will generate mip levels based on the first path specified,
+	// - if generateMipLevels is true, we will generate mip levels based on the first source specified,
 	//   using vkCmdBlitImage;
 	// - if generateMipLevels is false, we will copy each buffer into a mip level of an optimally tiled
 	//   texture with vkCmdCopyBufferToImage.
@@ -238,20 +189,21 @@ Texture Mipmapping::createMipmappedTextureFromAssets(const vector<const char *>
 	vector<MipLevel> mipLevels;
 	unsigned mipLevelCount;
 
-	for (auto &pPath : pPaths)
+	for (auto &source : sources)
 	{
-		MipLevel mipLevel;
-
-		if (FAILED(loadRgba8888TextureFromAsset(pPath, &mipLevel.buffer, &mipLevel.width, &mipLevel.height)))
+		loader.wait(source);
+		if (FAILED(source->getResult()))
 		{
-			LOGE("Failed to load texture from asset.\n");
+			LOGE("Failed to load texture from asset %s.\n", source->getPath().c_str());
 			abort();
 		}
 
-		// Copy commands such as vkCmdCopyBufferToImage will need TRANSFER_SRC_BIT.
-		mipLevel.stagingBuffer = createBuffer(mipLevel.buffer.data(), mipLevel.width * mipLevel.height * 4, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
-
-		mipLevels.push_back(mipLevel);
+		LoadedTexture &texture = source->getValue();
+		MipLevel mipLevel;
+		mipLevel.buffer = move(texture.buffer);
+		mipLevel.width = texture.width;
+		mipLevel.height = texture.height;
+		mipLevels.push_back(move(mipLevel));
 	}
 
 	if (generateMipLevels)
@@ -267,7 +219,7 @@ Texture Mipmapping::createMipmappedTextureFromAssets(const vector<const char *>
 
 	VkDevice device = pContext->getDevice();
 	VkImage image;
-	VkDeviceMemory memory;
+	DeviceAllocation allocation;
 
 	// We will transition the actual texture into a proper layout before transfering any data, so leave it as undefined.
 	VkImageCreateInfo info = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
@@ -291,19 +243,16 @@ Texture Mipmapping::createMipmappedTextureFromAssets(const vector<const char *>
 	VkMemoryRequirements memReqs;
 	vkGetImageMemoryRequirements(device, image, &memReqs);
 
-	VkMemoryAllocateInfo alloc = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-	alloc.allocationSize = memReqs.size;
 	// If a device local memory type exists, we should use that.
 	// DEVICE_LOCAL implies that the device has the fastest possible access to this resource, which
 	// is clearly what we want here.
 	// On integrated GPUs such as Mali, memory types are generally *both* DEVICE_LOCAL and HOST_VISIBLE at the same time,
 	// since the GPU can directly access the same memory as the CPU can.
-	alloc.memoryTypeIndex =
-		findMemoryTypeFromRequirementsWithFallback(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-	VK_CHECK(vkAllocateMemory(device, &alloc, nullptr, &memory));
+	VK_CHECK(pContext->getAllocator().allocate(memReqs, MemoryTypeSelector::USAGE_DEVICE_LOCAL,
+	                                           DeviceMemoryAllocator::RESOURCE_OPTIMAL, &allocation));
 
 	// Bind the newly allocated memory to the image.
-	vkBindImageMemory(device, image, memory, 0);
+	vkBindImageMemory(device, image, allocation.memory, allocation.offset);
 
 	// Create an image view for the new texture.
 	// Note that CreateImageView must happen after BindImageMemory.
@@ -322,42 +271,50 @@ Texture Mipmapping::createMipmappedTextureFromAssets(const vector<const char *>
 	VkImageView view;
 	VK_CHECK(vkCreateImageView(device, &viewInfo, nullptr, &view));
 
-	// Now we need to transfer the staging textures into the real texture.
-	// For this we will need a command buffer.
-	VkCommandBuffer cmd = pContext->requestPrimaryCommandBuffer();
+	// Now we need to transfer the images into the real texture.
+	// The upload manager copies them into its persistent staging ring and batches the copies with all other uploads.
+	// Pending uploads are submitted together right before the next command buffers we submit, so we need
+	// neither staging buffers nor, unless we generate mip levels, a command buffer of our own.
+	UploadManager &uploads = pContext->getUploadManager();
 
-	// We will only submit this once before it's recycled.
-	VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
-	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-	vkBeginCommandBuffer(cmd, &beginInfo);
+	// When generating mip levels, the first level is the source of the first blit, so it ends up in a
+	// TRANSFER_SRC_OPTIMAL layout. Otherwise, every level can be sampled once its copy has completed.
+	unsigned uploadedLevelCount = generateMipLevels ? 1 : mipLevelCount;
+	VkImageLayout uploadLayout = generateMipLevels && mipLevelCount > 1 ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL :
+	                                                                      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-	// Transition the uninitialized texture into a TRANSFER_DST_OPTIMAL layout.
-	// We do not need to wait for anything to make the transition, so use TOP_OF_PIPE_BIT as the srcStageMask.
-	imageMemoryBarrier(cmd, image, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-	                   VK_PIPELINE_STAGE_TRANSFER_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-	                   0, mipLevelCount);
-
-	VkBufferImageCopy region = {};
-	region.bufferOffset = 0;
-	region.bufferRowLength = mipLevels[0].width;
-	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	region.imageSubresource.mipLevel = 0;
-	region.imageSubresource.layerCount = 1;
-	region.imageExtent.width = mipLevels[0].width;
-	region.imageExtent.height = mipLevels[0].height;
-	region.imageExtent.depth = 1;
-
-	// Copy the buffer for the first mip level to our optimally tiled image.
-	vkCmdCopyBufferToImage(cmd, mipLevels[0].stagingBuffer.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+	for (unsigned i = 0; i < uploadedLevelCount; i++)
+	{
+		VkBufferImageCopy region = {};
+		region.bufferRowLength = mipLevels[i].width;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = i;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent.width = mipLevels[i].width;
+		region.imageExtent.height = mipLevels[i].height;
+		region.imageExtent.depth = 1;
+
+		// Copy each image to the appropriate mip level of our optimally tiled image.
+		VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, i, 1, 0, 1 };
+		uploads.uploadImage(image, range, uploadLayout, mipLevels[i].buffer.data(), mipLevels[i].buffer.size(),
+		                    &region, 1, 4);
+	}
 
-	if (generateMipLevels)
+	if (generateMipLevels && mipLevelCount > 1)
 	{
-		// Transition first mip level into a TRANSFER_SRC_OPTIMAL layout.
-		// We need to wait for first CopyBuffer to complete before we can transition away from TRANSFER_DST_OPTIMAL,
-		// so use VK_PIPELINE_STAGE_TRANSFER_BIT as the srcStageMask.
-		imageMemoryBarrier(cmd, image, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-		                   VK_PIPELINE_STAGE_TRANSFER_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-		                   0, 1);
+		// Blits need a graphics queue, so generating mip levels needs a command buffer.
+		VkCommandBuffer cmd = pContext->requestPrimaryCommandBuffer();
+
+		// We will only submit this once before it's recycled.
+		VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(cmd, &beginInfo);
+
+		// Transition the uninitialized mip levels into a TRANSFER_DST_OPTIMAL layout.
+		// We do not need to wait for anything to make the transition, so use TOP_OF_PIPE_BIT as the srcStageMask.
+		imageMemoryBarrier(cmd, image, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+		                   VK_PIPELINE_STAGE_TRANSFER_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
+		                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, mipLevelCount - 1);
 
 		for (unsigned i = 1; i < mipLevelCount; i++)
 		{
@@ -398,43 +355,9 @@ Texture Mipmapping::createMipmappedTextureFromAssets(const vector<const char *>
 				                   i, 1);
 			}
 		}
-	}
-	else
-	{
-		for (unsigned i = 1; i < mipLevelCount; i++)
-		{
-			VkBufferImageCopy region = {};
-			region.bufferOffset = 0;
-			region.bufferRowLength = mipLevels[i].width;
-			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			region.imageSubresource.mipLevel = i;
-			region.imageSubresource.layerCount = 1;
-			region.imageExtent.width = mipLevels[i].width;
-			region.imageExtent.height = mipLevels[i].height;
-			region.imageExtent.depth = 1;
-
-			// Copy each staging buffer to the appropriate mip level of our optimally tiled image.
-			vkCmdCopyBufferToImage(cmd, mipLevels[i].stagingBuffer.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-		}
 
-		// Wait for all transfers to complete before we let any fragment shading begin.
-		imageMemoryBarrier(cmd, image, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
-		                   VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-		                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-		                   0, mipLevelCount);
-	}
-
-	VK_CHECK(vkEndCommandBuffer(cmd));
-	pContext->submit(cmd);
-
-	// We want to free the staging buffer and memory right away, so wait for the GPU to complete the transfer.
-	vkQueueWaitIdle(pContext->getGraphicsQueue());
-
-	for (auto &mipLevel : mipLevels)
-	{
-		// Now it's safe to free the temporary resources.
-		vkFreeMemory(device, mipLevel.stagingBuffer.memory, nullptr);
-		vkDestroyBuffer(device, mipLevel.stagingBuffer.buffer, nullptr);
+		VK_CHECK(vkEndCommandBuffer(cmd));
+		pContext->submit(cmd);
 	}
 
 	// Finally, create a sampler.
@@ -455,7 +378,8 @@ Texture Mipmapping::createMipmappedTextureFromAssets(const vector<const char *>
 	VK_CHECK(vkCreateSampler(device, &samplerInfo, nullptr, &sampler));
 
 	Texture ret = {
-		image, view, memory, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, sampler, mipLevels[0].width, mipLevels[0].height,
+		image, view, allocation, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, sampler, mipLevels[0].width,
+		mipLevels[0].height,
 	};
 	return ret;
 }
@@ -497,26 +421,17 @@ Buffer Mipmapping::createBuffer(const void *pInitialData, size_t size, VkFlags u
 	VkMemoryRequirements memReqs;
 	vkGetBufferMemoryRequirements(device, buffer.buffer, &memReqs);
 
-	VkMemoryAllocateInfo alloc = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-	alloc.allocationSize = memReqs.size;
-
-	// We want host visible and coherent memory to simplify things.
-	alloc.memoryTypeIndex = findMemoryTypeFromRequirements(
-		memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-	VK_CHECK(vkAllocateMemory(device, &alloc, nullptr, &buffer.memory));
+	// Sub-allocate host visible and coherent memory to simplify things.
+	VK_CHECK(pContext->getAllocator().allocate(memReqs, MemoryTypeSelector::USAGE_UPLOAD,
+	                                           DeviceMemoryAllocator::RESOURCE_LINEAR, &buffer.allocation));
 
 	// Buffers are not backed by memory, so bind our memory explicitly to the buffer.
-	vkBindBufferMemory(device, buffer.buffer, buffer.memory, 0);
+	vkBindBufferMemory(device, buffer.buffer, buffer.allocation.memory, buffer.allocation.offset);
 
-	// Map the memory and dump data in there.
+	// Host visible memory is persistently mapped by the allocator, so dump the
+	// data straight in there.
 	if (pInitialData)
-	{
-		void *pData;
-		VK_CHECK(vkMapMemory(device, buffer.memory, 0, size, 0, &pData));
-		memcpy(pData, pInitialData, size);
-		vkUnmapMemory(device, buffer.memory);
-	}
+		memcpy(buffer.allocation.pHostPointer, pInitialData, size);
 
 	return buffer;
 }
@@ -640,7 +555,7 @@ void Mipmapping::initPipelineLayout()
 
 	// In our vertex shader, we have one uniform buffer with layout(set = 0, binding = 2).
 	bindings[2].binding = 2;
-	bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	bindings[2].descriptorCount = 1;
 	bindings[2].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
@@ -785,22 +700,35 @@ bool Mipmapping::initialize(Context *pContext)
 	// Initialize the pipeline layout.
 	initPipelineLayout();
 
-	// Load texture with pre-generated mipmaps.
+	// Start loading all textures up front. Decoding PNGs is by far the most expensive part of
+	// initialization, and every image can be decoded independently on a worker thread.
+	// We wait for the textures right away, so use every CPU we have.
+	// The pool only lives until the textures have been created.
+	ThreadPool loaderThreads;
+	loaderThreads.setWorkerThreadCount(ThreadPool::getCpuCount(CPU_CLASS_ALL));
+	AssetLoader loader(loaderThreads);
+
 	vector<char const *> pPaths = { "textures/T_Speaker_512.png", "textures/T_Speaker_256.png", "textures/T_Speaker_128.png",
 	                                "textures/T_Speaker_64.png",  "textures/T_Speaker_32.png",  "textures/T_Speaker_16.png",
 	                                "textures/T_Speaker_8.png",   "textures/T_Speaker_4.png",   "textures/T_Speaker_2.png",
 	                                "textures/T_Speaker_1.png" };
-	textures[0] = createMipmappedTextureFromAssets(pPaths, false);
+	vector<AssetLoader::TextureHandle> speakerLevels;
+	for (auto pPath : pPaths)
+		speakerLevels.push_back(loader.loadRgba8888Texture(pPath));
+	AssetLoader::TextureHandle pedestal = loader.loadRgba8888Texture("textures/T_Pedestal_512.png");
+	AssetLoader::TextureHandle labels = loader.loadRgba8888Texture("textures/labels.png");
+
+	// Load texture with pre-generated mipmaps.
+	textures[0] = createMipmappedTextureFromAssets(loader, speakerLevels, false);
 
 	// Load texture and generate mipmaps.
-	textures[1] = createMipmappedTextureFromAssets({ "textures/T_Pedestal_512.png" }, true);
+	textures[1] = createMipmappedTextureFromAssets(loader, { pedestal }, true);
 
 	// Load the texture for the labels.
-	labelTexture = createMipmappedTextureFromAssets({ "textures/labels.png" }, false);
+	labelTexture = createMipmappedTextureFromAssets(loader, { labels }, false);
 
-	// Create a pipeline cache (although we'll only create one pipeline).
-	VkPipelineCacheCreateInfo pipelineCacheInfo = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
-	VK_CHECK(vkCreatePipelineCache(pContext->getDevice(), &pipelineCacheInfo, nullptr, &pipelineCache));
+	// Use the pipeline cache of the context, which is saved between runs.
+	pipelineCache = pContext->getPipelineCache().getCache();
 
 	return true;
 }
@@ -880,14 +808,14 @@ void Mipmapping::render(unsigned swapchainIndex, float deltaTime)
 
 	vkUpdateDescriptorSets(pContext->getDevice(), 1, &write, 0, nullptr);
 
-	// Bind the descriptor set.
-	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frame.descriptorSet, 0,
-	                        nullptr);
+	// Allocate this frame's uniform data from the uniform ring.
+	uint32_t uniformOffset;
+	UniformBufferData *bufData = static_cast<UniformBufferData *>(
+	    pContext->getUniformRing().allocate(sizeof(UniformBufferData), &uniformOffset));
 
-	// Update the uniform buffers memory.
-	UniformBufferData *bufData = nullptr;
-	VK_CHECK(vkMapMemory(pContext->getDevice(), frame.uniformBuffer.memory, 0, VK_WHOLE_SIZE, 0,
-	         reinterpret_cast<void **>(&bufData)));
+	// Bind the descriptor set, with the uniform data at a dynamic offset.
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frame.descriptorSet, 1,
+	                        &uniformOffset);
 
 	// Simple orthographic projection.
 	float aspect = float(width) / height;
@@ -902,8 +830,6 @@ void Mipmapping::render(unsigned swapchainIndex, float deltaTime)
 	// Write the type of mipmaps associated to the texture we are showing.
 	bufData->mipmapType = textureIndex;
 
-	vkUnmapMemory(pContext->getDevice(), frame.uniformBuffer.memory);
-
 	// Draw the quads.
 	vkCmdDrawIndexed(cmd, 6 * 13, 1, 0, 0, 0);
 
@@ -944,8 +870,6 @@ void Mipmapping::termPerFrame()
 
 	for (auto &frame : perFrame)
 	{
-		vkFreeMemory(device, frame.uniformBuffer.memory, nullptr);
-		vkDestroyBuffer(device, frame.uniformBuffer.buffer, nullptr);
 		vkDestroyDescriptorPool(device, frame.descriptorPool, nullptr);
 	}
 	perFrame.clear();
@@ -960,11 +884,11 @@ void Mipmapping::terminate()
 
 	// Vertex buffer
 	vkDestroyBuffer(device, vertexBuffer.buffer, nullptr);
-	vkFreeMemory(device, vertexBuffer.memory, nullptr);
+	pContext->getAllocator().free(vertexBuffer.allocation);
 
 	// Index buffer
 	vkDestroyBuffer(device, indexBuffer.buffer, nullptr);
-	vkFreeMemory(device, indexBuffer.memory, nullptr);
+	pContext->getAllocator().free(indexBuffer.allocation);
 
 	// Textures
 	for (auto &texture : textures)
@@ -972,19 +896,18 @@ void Mipmapping::terminate()
 		vkDestroyImageView(device, texture.view, nullptr);
 		vkDestroyImage(device, texture.image, nullptr);
 		vkDestroySampler(device, texture.sampler, nullptr);
-		vkFreeMemory(device, texture.memory, nullptr);
+		pContext->getAllocator().free(texture.allocation);
 	}
 
 	vkDestroyImageView(device, labelTexture.view, nullptr);
 	vkDestroyImage(device, labelTexture.image, nullptr);
 	vkDestroySampler(device, labelTexture.sampler, nullptr);
-	vkFreeMemory(device, labelTexture.memory, nullptr);
+	pContext->getAllocator().free(labelTexture.allocation);
 
 	// Per-frame resources
 	termPerFrame();
 	termBackbuffers();
 
-	vkDestroyPipelineCache(device, pipelineCache, nullptr);
 	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
 	vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
 }
@@ -995,14 +918,14 @@ void Mipmapping::initPerFrame(unsigned numBackbuffers)
 
 	for (unsigned i = 0; i < numBackbuffers; i++)
 	{
-		// Create one uniform buffer per swapchain frame. We will update the uniform buffer every frame
-		// and we don't want to stomp on a uniform buffer already in flight.
+		// The uniform data is allocated from the context's uniform ring every
+		// frame and bound with a dynamic offset, so the descriptor set always
+		// points at the ring buffer.
 		PerFrame frame;
-		frame.uniformBuffer = createBuffer(nullptr, sizeof(UniformBufferData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
 
 		// Allocate descriptor set from a pool.
 		static const VkDescriptorPoolSize poolSizes[2] = {
-			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 }, { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2 },
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 }, { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2 },
 		};
 
 		VkDescriptorPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
@@ -1023,7 +946,7 @@ void Mipmapping::initPerFrame(unsigned numBackbuffers)
 			{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET },
 		};
 
-		VkDescriptorBufferInfo bufferInfo = { frame.uniformBuffer.buffer, 0, sizeof(UniformBufferData) };
+		VkDescriptorBufferInfo bufferInfo = { pContext->getUniformRing().getBuffer(), 0, sizeof(UniformBufferData) };
 		VkDescriptorImageInfo imageInfo = { textures[0].sampler, textures[0].view, textures[0].layout };
 		VkDescriptorImageInfo labelImageInfo = { labelTexture.sampler, labelTexture.view, labelTexture.layout };
 
@@ -1042,7 +965,7 @@ void Mipmapping::initPerFrame(unsigned numBackbuffers)
 		writes[2].dstSet = frame.descriptorSet;
 		writes[2].dstBinding = 2;
 		writes[2].descriptorCount = 1;
-		writes[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		writes[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		writes[2].pBufferInfo = &bufferInfo;
 
 		vkUpdateDescriptorSets(device, 3, writes, 0, nullptr);
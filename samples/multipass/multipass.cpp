@@ -23,6 +23,7 @@
 #include "framework/common.hpp"
 #include "framework/context.hpp"
 #include "framework/math.hpp"
+#include "framework/mip_generator.hpp"
 #include "platform/platform.hpp"
 #include <algorithm>
 
@@ -52,7 +53,7 @@ struct Buffer
 	VkBuffer buffer;
 
 	// Buffer objects are backed by device memory.
-	VkDeviceMemory memory;
+	DeviceAllocation allocation;
 };
 
 struct Image
@@ -64,7 +65,7 @@ struct Image
 	VkImageView view;
 
 	// Memory for the image.
-	VkDeviceMemory memory;
+	DeviceAllocation allocation;
 };
 
 struct Texture
@@ -76,7 +77,7 @@ struct Texture
 	VkImageView view;
 
 	// Memory for the texture.
-	VkDeviceMemory memory;
+	DeviceAllocation allocation;
 
 	// Images have layouts, stores the current layout used.
 	VkImageLayout layout;
@@ -102,18 +103,6 @@ struct LightingData
 	vec2 invResolution;
 };
 
-static inline unsigned numMiplevels(unsigned width, unsigned height)
-{
-	unsigned levels = 0;
-	while (width || height)
-	{
-		width >>= 1;
-		height >>= 1;
-		levels++;
-	}
-	return levels;
-}
-
 class Multipass : public VulkanApplication
 {
 public:
@@ -170,23 +159,20 @@ private:
 	Texture texture;
 
 	// Image for the depth buffer.
-	Image depthImage;
+	TransientAttachment depthImage;
 	// A depth-only view for multipass.
 	VkImageView depthImageDepthOnlyView;
 
 	// Image for the normals.
-	Image normalImage;
+	TransientAttachment normalImage;
 
 	// Image for the albedo values.
-	Image albedoImage;
+	TransientAttachment albedoImage;
 
 	Buffer createBuffer(const void *data, size_t size, VkFlags usage);
 	Texture createTexture(const char *pPath);
 	void createDescriptors();
 
-	uint32_t findMemoryTypeFromRequirements(uint32_t deviceRequirements, uint32_t hostRequirements);
-	uint32_t findMemoryTypeFromRequirementsWithFallback(uint32_t deviceRequirements, uint32_t hostRequirements);
-
 	void createRenderPass(VkFormat format);
 	void termBackbuffers();
 
@@ -196,12 +182,6 @@ private:
 	void createGBufferPipeline();
 	void createPipelineLayout();
 
-	void imageMemoryBarrier(VkCommandBuffer cmd, VkImage image, VkAccessFlags srcAccessMask,
-	                        VkAccessFlags dstAccessMask, VkPipelineStageFlags srcStageMask,
-	                        VkPipelineStageFlags dstStageMask, VkImageLayout oldLayout, VkImageLayout newLayout);
-	void imageMemoryBarrierLevel(VkCommandBuffer cmd, VkImage image, unsigned level, VkAccessFlags srcAccessMask,
-	                             VkAccessFlags dstAccessMask, VkPipelineStageFlags srcStageMask,
-	                             VkPipelineStageFlags dstStageMask, VkImageLayout oldLayout, VkImageLayout newLayout);
 	Image createImage(VkFlags usage, VkFormat format, VkImageAspectFlags aspectMask, unsigned width, unsigned height,
 	                  unsigned mipLevels = 1);
 	VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectMask);
@@ -209,56 +189,6 @@ private:
 	float totalTime = 0.0f;
 };
 
-// To create a buffer, both the device and application have requirements from the buffer object.
-// Vulkan exposes the different types of buffers the device can allocate, and we have to find a suitable one.
-// deviceRequirements is a bitmask expressing which memory types can be used for a buffer object.
-// The different memory types' properties must match with what the application wants.
-uint32_t Multipass::findMemoryTypeFromRequirements(uint32_t deviceRequirements, uint32_t hostRequirements)
-{
-	const VkPhysicalDeviceMemoryProperties &props = pContext->getPlatform().getMemoryProperties();
-	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++)
-	{
-		if (deviceRequirements & (1u << i))
-		{
-			if ((props.memoryTypes[i].propertyFlags & hostRequirements) == hostRequirements)
-			{
-				return i;
-			}
-		}
-	}
-
-	LOGE("Failed to obtain suitable memory type.\n");
-	abort();
-}
-
-uint32_t Multipass::findMemoryTypeFromRequirementsWithFallback(uint32_t deviceRequirements, uint32_t hostRequirements)
-{
-	const VkPhysicalDeviceMemoryProperties &props = pContext->getPlatform().getMemoryProperties();
-	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++)
-	{
-		if (deviceRequirements & (1u << i))
-		{
-			if ((props.memoryTypes[i].propertyFlags & hostRequirements) == hostRequirements)
-			{
-				return i;
-			}
-		}
-	}
-
-	// On desktop systems, we'll need a fallback to plain device local.
-	if (hostRequirements & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
-		return findMemoryTypeFromRequirementsWithFallback(deviceRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-	// If we cannot find the particular memory type we're looking for, just pick the first one available.
-	if (hostRequirements != 0)
-		return findMemoryTypeFromRequirements(deviceRequirements, 0);
-	else
-	{
-		LOGE("Failed to obtain suitable memory type.\n");
-		abort();
-	}
-}
-
 Buffer Multipass::createBuffer(const void *data, size_t size, VkFlags usage)
 {
 	Buffer buffer;
@@ -274,27 +204,17 @@ Buffer Multipass::createBuffer(const void *data, size_t size, VkFlags usage)
 	VkMemoryRequirements memoryRequirements;
 	vkGetBufferMemoryRequirements(device, buffer.buffer, &memoryRequirements);
 
-	VkMemoryAllocateInfo memoryAllocateInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-	memoryAllocateInfo.allocationSize = memoryRequirements.size;
-
-	// We want host visible and coherent memory to simplify things.
-	memoryAllocateInfo.memoryTypeIndex = findMemoryTypeFromRequirements(
-	    memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-	VK_CHECK(vkAllocateMemory(device, &memoryAllocateInfo, nullptr, &buffer.memory));
+	// Sub-allocate host visible and coherent memory to simplify things.
+	VK_CHECK(pContext->getAllocator().allocate(memoryRequirements, MemoryTypeSelector::USAGE_UPLOAD,
+	                                           DeviceMemoryAllocator::RESOURCE_LINEAR, &buffer.allocation));
 
 	// Buffers are not backed by memory, so bind our memory explicitly to the buffer.
-	vkBindBufferMemory(device, buffer.buffer, buffer.memory, 0);
+	vkBindBufferMemory(device, buffer.buffer, buffer.allocation.memory, buffer.allocation.offset);
 
-	// Map the memory and dump data in there.
+	// Host visible memory is persistently mapped by the allocator, so dump the
+	// data straight in there.
 	if (data)
-	{
-		void *memoryPointer;
-		VK_CHECK(vkMapMemory(device, buffer.memory, 0, size, 0, &memoryPointer));
-
-		memcpy(memoryPointer, data, size);
-		vkUnmapMemory(device, buffer.memory);
-	}
+		memcpy(buffer.allocation.pHostPointer, data, size);
 
 	return buffer;
 }
@@ -374,53 +294,11 @@ void Multipass::initBuffers()
 	quadVertexBuffer = createBuffer(quadVertices, sizeof(quadVertices), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
 }
 
-void Multipass::imageMemoryBarrier(VkCommandBuffer cmd, VkImage image, VkAccessFlags srcAccessMask,
-                                   VkAccessFlags dstAccessMask, VkPipelineStageFlags srcStageMask,
-                                   VkPipelineStageFlags dstStageMask, VkImageLayout oldLayout, VkImageLayout newLayout)
-{
-	VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-
-	barrier.srcAccessMask = srcAccessMask;
-	barrier.dstAccessMask = dstAccessMask;
-	barrier.oldLayout = oldLayout;
-	barrier.newLayout = newLayout;
-	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.image = image;
-	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
-	barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
-
-	vkCmdPipelineBarrier(cmd, srcStageMask, dstStageMask, false, 0, nullptr, 0, nullptr, 1, &barrier);
-}
-
-void Multipass::imageMemoryBarrierLevel(VkCommandBuffer cmd, VkImage image, unsigned level, VkAccessFlags srcAccessMask,
-                                        VkAccessFlags dstAccessMask, VkPipelineStageFlags srcStageMask,
-                                        VkPipelineStageFlags dstStageMask, VkImageLayout oldLayout,
-                                        VkImageLayout newLayout)
-{
-	VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-
-	barrier.srcAccessMask = srcAccessMask;
-	barrier.dstAccessMask = dstAccessMask;
-	barrier.oldLayout = oldLayout;
-	barrier.newLayout = newLayout;
-	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.image = image;
-	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	barrier.subresourceRange.baseMipLevel = level;
-	barrier.subresourceRange.levelCount = 1;
-	barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
-
-	vkCmdPipelineBarrier(cmd, srcStageMask, dstStageMask, false, 0, nullptr, 0, nullptr, 1, &barrier);
-}
-
 Texture Multipass::createTexture(const char *pPath)
 {
-	// We want to first create a staging buffer.
+	// We want to first load the texture data.
 	//
-	// We will then copy this buffer into an optimally tiled texture with vkCmdCopyBufferToImage.
+	// We will then copy it into an optimally tiled texture with vkCmdCopyBufferToImage.
 	// The layout of such a texture is not specified as it is highly GPU-dependent and optimized for
 	// utiliving texture caches better.
 	unsigned width, height;
@@ -434,96 +312,28 @@ Texture Multipass::createTexture(const char *pPath)
 
 	VkDevice device = pContext->getDevice();
 
-	Buffer stagingBuffer = createBuffer(buffer.data(), width * height * 4, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
-
-	unsigned numLevels = numMiplevels(width, height);
-	Image textureImage =
-	    createImage(VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-	                VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, width, height, numLevels);
-
-	// We need to transfer the staging texture into the real texture.
-	// For this we will need a command buffer.
-	VkCommandBuffer commandBuffer = pContext->requestPrimaryCommandBuffer();
-
-	// We will only submit this once before it's recycled.
-	VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
-	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-	vkBeginCommandBuffer(commandBuffer, &beginInfo);
-
-	// Transition the uninitialized texture into a TRANSFER_DST_OPTIMAL layout.
-	// We do not need to wait for anything to make the transition, so use TOP_OF_PIPE_BIT as the srcStageMask.
-	imageMemoryBarrier(commandBuffer, textureImage.image, 0, VK_ACCESS_TRANSFER_WRITE_BIT,
-	                   VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
-	                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-	VkBufferImageCopy region;
-	memset(&region, 0, sizeof(region));
-	region.bufferOffset = 0;
-	region.bufferRowLength = width;
-	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	region.imageSubresource.layerCount = 1;
-	region.imageExtent.width = width;
-	region.imageExtent.height = height;
-	region.imageExtent.depth = 1;
-
-	// Copy the buffer to our optimally tiled image.
-	vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.buffer, textureImage.image,
-	                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-	// Begin mipmapping. First transition level 0 into a TRANSFER_SRC layout.
-	imageMemoryBarrierLevel(commandBuffer, textureImage.image, 0, VK_ACCESS_TRANSFER_WRITE_BIT,
-	                        VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-	                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-
-	// We can mip-map images in Vulkan using vkCmdBlitImage. There is no vkCmdGenerateMipmap or anything like that.
-	for (unsigned i = 1; i < numLevels; i++)
+	// Vulkan has no vkCmdGenerateMipmap, and blitting the levels on the GPU gives format dependent linear filtering.
+	// Instead, we generate the whole mip-chain on the CPU with a Kaiser filter, which keeps the smaller levels sharp.
+	vector<uint8_t> mipChain;
+	vector<VkBufferImageCopy> regions;
+	if (FAILED(generateMipChainRgba8888(&mipChain, &regions, buffer.data(), width * 4, width, height,
+	                                    VK_FORMAT_R8G8B8A8_UNORM, MIP_FILTER_KAISER)))
 	{
-		// Set up a blit from previous mip-level to the next.
-		VkImageBlit region = {};
-		region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		region.srcSubresource.mipLevel = i - 1;
-		region.srcSubresource.baseArrayLayer = 0;
-		region.srcSubresource.layerCount = 1;
-		region.dstSubresource = region.srcSubresource;
-		region.dstSubresource.mipLevel = i;
-		region.srcOffsets[1] = { std::max(int(width >> (i - 1)), 1), std::max(int(height >> (i - 1)), 1), 1 };
-		region.dstOffsets[1] = { std::max(int(width >> i), 1), std::max(int(height >> i), 1), 1 };
-
-		vkCmdBlitImage(commandBuffer, textureImage.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, textureImage.image,
-		               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, VK_FILTER_LINEAR);
-
-		// We're done transfering from this level now, transition it to SHADER_READ_ONLY.
-		imageMemoryBarrierLevel(commandBuffer, textureImage.image, i - 1, VK_ACCESS_TRANSFER_READ_BIT,
-		                        VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-		                        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-		                        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-		// If this is the last level, we can transition directly to SHADER_READ_ONLY.
-		if (i + 1 == numLevels)
-		{
-			imageMemoryBarrierLevel(commandBuffer, textureImage.image, i, VK_ACCESS_TRANSFER_WRITE_BIT,
-			                        VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-			                        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			                        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-		}
-		else
-		{
-			imageMemoryBarrierLevel(commandBuffer, textureImage.image, i, VK_ACCESS_TRANSFER_WRITE_BIT,
-			                        VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-			                        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-		}
+		LOGE("Failed to generate mip-chain.\n");
+		abort();
 	}
 
-	VK_CHECK(vkEndCommandBuffer(commandBuffer));
-	pContext->submit(commandBuffer);
-
-	// We want to free the staging buffer and memory right away, so wait for GPU to complete the transfer.
-	vkQueueWaitIdle(pContext->getGraphicsQueue());
+	unsigned numLevels = regions.size();
+	Image textureImage = createImage(VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+	                                 VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, width, height, numLevels);
 
-	// Now it's safe to free the temporary resources.
-	vkFreeMemory(device, stagingBuffer.memory, nullptr);
-	vkDestroyBuffer(device, stagingBuffer.buffer, nullptr);
+	// We need to transfer the pixels of every level into the real texture.
+	// The upload manager copies them into its persistent staging ring and batches the copy with all other uploads.
+	// Pending uploads are submitted right before the next command buffers we submit, and the whole texture is
+	// transitioned to SHADER_READ_ONLY once the copy has completed.
+	VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, numLevels, 0, 1 };
+	pContext->getUploadManager().uploadImage(textureImage.image, range, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+	                                         mipChain.data(), mipChain.size(), regions.data(), numLevels, 4);
 
 	// Finally, create a sampler, use tri-linear filtering here for best quality.
 	VkSamplerCreateInfo samplerInfo = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
@@ -545,7 +355,7 @@ Texture Multipass::createTexture(const char *pPath)
 	Texture ret = {
 		textureImage.image,
 		textureImage.view,
-		textureImage.memory,
+		textureImage.allocation,
 		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
 		sampler,
 		width,
@@ -604,25 +414,10 @@ Image Multipass::createImage(VkFlags usage, VkFormat format, VkImageAspectFlags
 	VkMemoryRequirements memoryRequirements;
 	vkGetImageMemoryRequirements(device, image.image, &memoryRequirements);
 
-	VkMemoryAllocateInfo memoryAllocateInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-	memoryAllocateInfo.allocationSize = memoryRequirements.size;
-
-	if (usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT)
-	{
-		// If an image is transient, try to find lazily allocated memory.
-		memoryAllocateInfo.memoryTypeIndex = findMemoryTypeFromRequirementsWithFallback(
-		    memoryRequirements.memoryTypeBits,
-		    VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-	}
-	else
-	{
-		// If a device local memory type exists, we should use that.
-		memoryAllocateInfo.memoryTypeIndex = findMemoryTypeFromRequirementsWithFallback(
-		    memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-	}
-
-	VK_CHECK(vkAllocateMemory(device, &memoryAllocateInfo, nullptr, &image.memory));
-	VK_CHECK(vkBindImageMemory(device, image.image, image.memory, 0));
+	// If a device local memory type exists, we should use that.
+	VK_CHECK(pContext->getAllocator().allocate(memoryRequirements, MemoryTypeSelector::USAGE_DEVICE_LOCAL,
+	                                           DeviceMemoryAllocator::RESOURCE_OPTIMAL, &image.allocation));
+	VK_CHECK(vkBindImageMemory(device, image.image, image.allocation.memory, image.allocation.offset));
 
 	image.view = createImageView(image.image, format, aspectMask);
 	return image;
@@ -795,9 +590,8 @@ bool Multipass::initialize(Context *pContext)
 {
 	this->pContext = pContext;
 
-	// Create pipeline cache.
-	VkPipelineCacheCreateInfo cacheInfo = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
-	VK_CHECK(vkCreatePipelineCache(pContext->getDevice(), &cacheInfo, nullptr, &pipelineCache));
+	// Use the pipeline cache of the context, which is saved between runs.
+	pipelineCache = pContext->getPipelineCache().getCache();
 
 	// Create the buffers.
 	initBuffers();
@@ -1358,18 +1152,21 @@ void Multipass::updateSwapchain(const vector<VkImage> &backbuffers, const Platfo
 	termBackbuffers();
 
 	// Create images for storing albedo and normal information between subpasses.
-	albedoImage = createImage(VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT |
-	                              VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-	                          VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, width, height);
+	// These images never leave the render pass, so they can live in lazily allocated memory
+	// which is never committed on Mali GPUs.
+	TransientAttachmentCache &transientAttachments = pContext->getTransientAttachmentCache();
+	albedoImage = transientAttachments.request(VK_FORMAT_R8G8B8A8_UNORM, width, height, VK_SAMPLE_COUNT_1_BIT,
+	                                           VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT |
+	                                               VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
 
-	normalImage = createImage(VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT |
-	                              VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-	                          VK_FORMAT_A2B10G10R10_UNORM_PACK32, VK_IMAGE_ASPECT_COLOR_BIT, width, height);
+	normalImage = transientAttachments.request(VK_FORMAT_A2B10G10R10_UNORM_PACK32, width, height, VK_SAMPLE_COUNT_1_BIT,
+	                                           VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT |
+	                                               VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
 
 	// Create depth buffer.
-	depthImage = createImage(VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
-	                             VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
-	                         depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT, width, height);
+	depthImage = transientAttachments.request(depthFormat, width, height, VK_SAMPLE_COUNT_1_BIT,
+	                                          VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+	                                              VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT);
 
 	// To read depth as an image attachment we need to restrict the aspect to be just the depth.
 	depthImageDepthOnlyView = createImageView(depthImage.image, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
@@ -1377,7 +1174,7 @@ void Multipass::updateSwapchain(const vector<VkImage> &backbuffers, const Platfo
 	uboAlignment = std::max(size_t(pContext->getPlatform().getGpuProperties().limits.minUniformBufferOffsetAlignment),
 	                        sizeof(mat4));
 	uniformBuffer = createBuffer(nullptr, backbuffers.size() * uboAlignment, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
-	VK_CHECK(vkMapMemory(device, uniformBuffer.memory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void **>(&uboData)));
+	uboData = static_cast<uint8_t *>(uniformBuffer.allocation.pHostPointer);
 
 	// We can't initialize descriptors until the images are created.
 	createDescriptors();
@@ -1646,25 +1443,16 @@ void Multipass::termBackbuffers()
 			vkDestroyPipeline(device, debugPipeline, nullptr);
 
 		// Depth, albedo and normal images.
-		vkDestroyImageView(device, depthImage.view, nullptr);
 		vkDestroyImageView(device, depthImageDepthOnlyView, nullptr);
-		vkDestroyImage(device, depthImage.image, nullptr);
-		vkFreeMemory(device, depthImage.memory, nullptr);
-		vkDestroyImageView(device, albedoImage.view, nullptr);
-		vkDestroyImage(device, albedoImage.image, nullptr);
-		vkFreeMemory(device, albedoImage.memory, nullptr);
-		vkDestroyImageView(device, normalImage.view, nullptr);
-		vkDestroyImage(device, normalImage.image, nullptr);
-		vkFreeMemory(device, normalImage.memory, nullptr);
+		TransientAttachmentCache &transientAttachments = pContext->getTransientAttachmentCache();
+		transientAttachments.release(depthImage);
+		transientAttachments.release(albedoImage);
+		transientAttachments.release(normalImage);
 	}
 
 	if (uniformBuffer.buffer != VK_NULL_HANDLE)
 		vkDestroyBuffer(device, uniformBuffer.buffer, nullptr);
-	if (uniformBuffer.memory != VK_NULL_HANDLE)
-	{
-		vkUnmapMemory(device, uniformBuffer.memory);
-		vkFreeMemory(device, uniformBuffer.memory, nullptr);
-	}
+	pContext->getAllocator().free(uniformBuffer.allocation);
 	uniformBuffer = {};
 }
 
@@ -1681,35 +1469,31 @@ void Multipass::terminate()
 	if (vertexBuffer.buffer != VK_NULL_HANDLE)
 		vkDestroyBuffer(device, vertexBuffer.buffer, nullptr);
 
-	if (vertexBuffer.memory != VK_NULL_HANDLE)
-		vkFreeMemory(device, vertexBuffer.memory, nullptr);
+	pContext->getAllocator().free(vertexBuffer.allocation);
 
 	// Index buffer.
 	if (indexBuffer.buffer != VK_NULL_HANDLE)
 		vkDestroyBuffer(device, indexBuffer.buffer, nullptr);
 
-	if (indexBuffer.memory != VK_NULL_HANDLE)
-		vkFreeMemory(device, indexBuffer.memory, nullptr);
+	pContext->getAllocator().free(indexBuffer.allocation);
 
 	// Instance buffer.
 	if (perInstanceBuffer.buffer != VK_NULL_HANDLE)
 		vkDestroyBuffer(device, perInstanceBuffer.buffer, nullptr);
 
-	if (perInstanceBuffer.memory != VK_NULL_HANDLE)
-		vkFreeMemory(device, perInstanceBuffer.memory, nullptr);
+	pContext->getAllocator().free(perInstanceBuffer.allocation);
 
 	// Vertex buffer for the quad.
 	if (quadVertexBuffer.buffer != VK_NULL_HANDLE)
 		vkDestroyBuffer(device, quadVertexBuffer.buffer, nullptr);
 
-	if (quadVertexBuffer.memory != VK_NULL_HANDLE)
-		vkFreeMemory(device, quadVertexBuffer.memory, nullptr);
+	pContext->getAllocator().free(quadVertexBuffer.allocation);
 
 	// Texture.
 	vkDestroyImageView(device, texture.view, nullptr);
 	vkDestroyImage(device, texture.image, nullptr);
 	vkDestroySampler(device, texture.sampler, nullptr);
-	vkFreeMemory(device, texture.memory, nullptr);
+	pContext->getAllocator().free(texture.allocation);
 
 	// Resources.
 	if (descriptorPool != VK_NULL_HANDLE)
@@ -1723,9 +1507,6 @@ void Multipass::terminate()
 	for (auto &layout : setLayouts)
 		if (layout != VK_NULL_HANDLE)
 			vkDestroyDescriptorSetLayout(device, layout, nullptr);
-
-	if (pipelineCache != VK_NULL_HANDLE)
-		vkDestroyPipelineCache(device, pipelineCache, nullptr);
 }
 
 VulkanApplication *MaliSDK::createApplication()
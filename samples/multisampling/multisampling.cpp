@@ -50,7 +50,7 @@ struct Buffer
 	VkBuffer buffer;
 
 	// Buffer objects are backed by device memory.
-	VkDeviceMemory memory;
+	DeviceAllocation allocation;
 };
 
 struct Texture
@@ -62,7 +62,7 @@ struct Texture
 	VkImageView view;
 
 	// Memory for the texture.
-	VkDeviceMemory memory;
+	DeviceAllocation allocation;
 
 	// Images have layouts, stores the current layout used.
 	VkImageLayout layout;
@@ -73,23 +73,8 @@ struct Texture
 	unsigned width, height;
 };
 
-struct RenderTarget
-{
-	// The image object itself.
-	VkImage image;
-
-	// To use images in shaders, we need an image view.
-	VkImageView view;
-
-	// Memory for the texture.
-	VkDeviceMemory memory;
-
-	unsigned width, height;
-};
-
 struct PerFrame
 {
-	Buffer uniformBuffer;
 	VkDescriptorSet descriptorSet;
 	VkDescriptorPool descriptorPool;
 };
@@ -133,14 +118,11 @@ private:
 
 	Buffer vertexBuffer;
 	Texture texture;
-	RenderTarget multisampledRenderTarget;
+	TransientAttachment multisampledRenderTarget;
 
 	Buffer createBuffer(const void *pInitial, size_t size, VkFlags usage);
 	Texture createTextureFromAsset(const char *pPath);
-	RenderTarget createMultisampledRenderTarget(unsigned width, unsigned height, VkFormat format);
-
-	uint32_t findMemoryTypeFromRequirements(uint32_t deviceRequirements, uint32_t hostRequirements);
-	uint32_t findMemoryTypeFromRequirementsWithFallback(uint32_t deviceRequirements, uint32_t hostRequirements);
+	TransientAttachment createMultisampledRenderTarget(unsigned width, unsigned height, VkFormat format);
 
 	void initRenderPass(VkFormat format);
 	void termBackbuffers();
@@ -152,129 +134,27 @@ private:
 	void initPipeline();
 	void initPipelineLayout();
 
-	void imageMemoryBarrier(VkCommandBuffer cmd, VkImage image, VkAccessFlags srcAccessMask,
-	                        VkAccessFlags dstAccessMask, VkPipelineStageFlags srcStageMask,
-	                        VkPipelineStageFlags dstStageMask, VkImageLayout oldLayout, VkImageLayout newLayout);
-
 	float accumulatedTime = 0.0f;
 };
 
-// To create a buffer, both the device and application have requirements from the buffer object.
-// Vulkan exposes the different types of buffers the device can allocate, and we have to find a suitable one.
-// deviceRequirements is a bitmask expressing which memory types can be used for a buffer object.
-// The different memory types' properties must match with what the application wants.
-uint32_t Multisampling::findMemoryTypeFromRequirements(uint32_t deviceRequirements, uint32_t hostRequirements)
-{
-	const VkPhysicalDeviceMemoryProperties &props = pContext->getPlatform().getMemoryProperties();
-	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++)
-	{
-		if (deviceRequirements & (1u << i))
-		{
-			if ((props.memoryTypes[i].propertyFlags & hostRequirements) == hostRequirements)
-			{
-				return i;
-			}
-		}
-	}
-
-	LOGE("Failed to obtain suitable memory type.\n");
-	abort();
-}
-
-uint32_t Multisampling::findMemoryTypeFromRequirementsWithFallback(uint32_t deviceRequirements,
-                                                                   uint32_t hostRequirements)
+// The multisampled image will only be used as a transient render target.
+// Its purpose is only to hold the multisampled data before resolving the render pass.
+TransientAttachment Multisampling::createMultisampledRenderTarget(unsigned width, unsigned height, VkFormat format)
 {
-	const VkPhysicalDeviceMemoryProperties &props = pContext->getPlatform().getMemoryProperties();
-	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++)
-	{
-		if (deviceRequirements & (1u << i))
-		{
-			if ((props.memoryTypes[i].propertyFlags & hostRequirements) == hostRequirements)
-			{
-				return i;
-			}
-		}
-	}
-
-	// If we cannot find the particular memory type we're looking for, just pick the first one available.
-	if (hostRequirements != 0)
-		return findMemoryTypeFromRequirements(deviceRequirements, 0);
-	else
-	{
-		LOGE("Failed to obtain suitable memory type.\n");
-		abort();
-	}
-}
-
-RenderTarget Multisampling::createMultisampledRenderTarget(unsigned width, unsigned height, VkFormat format)
-{
-	VkDevice device = pContext->getDevice();
-
-	VkImageCreateInfo info = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
-	info.imageType = VK_IMAGE_TYPE_2D;
-	info.format = format;
-	info.extent.width = width;
-	info.extent.height = height;
-	info.extent.depth = 1;
-	info.mipLevels = 1;
-	info.arrayLayers = 1;
+	// The transient attachment cache adds VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT and uses LAZILY allocated memory
+	// if such a type is available. Lazily allocated memory is not actually allocated until the memory is actually used.
+	// This texture will only live on the tile buffer, so it never needs to be backed by actual memory.
+	//
 	// Use 4x MSAA. This is the best performance vs. quality tradeoff on Mali GPUs.
 	// Beyond 4x MSAA, there is less fill-rate. 4x MSAA has same throughput as no multisampling.
-	info.samples = VK_SAMPLE_COUNT_4_BIT;
-	info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-	info.tiling = VK_IMAGE_TILING_OPTIMAL;
-
-	// This image will only be used as a transient render target.
-	// Its purpose is only to hold the multisampled data before resolving the render pass.
-	info.usage = VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-	info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-
-	// Create texture.
-	VkImage image;
-	VkDeviceMemory memory;
-	VK_CHECK(vkCreateImage(device, &info, nullptr, &image));
-
-	// Allocate memory for the texture.
-	VkMemoryRequirements memReqs;
-	vkGetImageMemoryRequirements(device, image, &memReqs);
-
-	VkMemoryAllocateInfo alloc = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-	alloc.allocationSize = memReqs.size;
-	// For multisampled attachments, we will want to use LAZILY allocated if such a type is available.
-	// Lazily allocated memory is not actually allocated until the memory is actually used.
-	// This texture will only live on the tile buffer, so it never needs to be backed by actual memory.
-	alloc.memoryTypeIndex =
-	    findMemoryTypeFromRequirementsWithFallback(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
-	VK_CHECK(vkAllocateMemory(device, &alloc, nullptr, &memory));
-	vkBindImageMemory(device, image, memory, 0);
-
-	// Create an image view for the new texture.
-	// Note that CreateImageView must happen after BindImageMemory.
-	VkImageViewCreateInfo viewInfo = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
-	viewInfo.image = image;
-	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-	viewInfo.format = format;
-	viewInfo.components.r = VK_COMPONENT_SWIZZLE_R;
-	viewInfo.components.g = VK_COMPONENT_SWIZZLE_G;
-	viewInfo.components.b = VK_COMPONENT_SWIZZLE_B;
-	viewInfo.components.a = VK_COMPONENT_SWIZZLE_A;
-	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	viewInfo.subresourceRange.levelCount = 1;
-	viewInfo.subresourceRange.layerCount = 1;
-
-	VkImageView view;
-	VK_CHECK(vkCreateImageView(device, &viewInfo, nullptr, &view));
-
-	RenderTarget ret = {
-		image, view, memory, width, height,
-	};
-	return ret;
+	return pContext->getTransientAttachmentCache().request(format, width, height, VK_SAMPLE_COUNT_4_BIT,
+	                                                       VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
 }
 
 Texture Multisampling::createTextureFromAsset(const char *pPath)
 {
-	// We want to first create a staging buffer.
-	// We will then copy this buffer into an optimally tiled texture with vkCmdCopyBufferToImage.
+	// We want to first load the texture data.
+	// We will then copy it into an optimally tiled texture with vkCmdCopyBufferToImage.
 	// The layout of such a texture is not specified as it is highly GPU-dependent and optimized for
 	// utilizing texture caches better.
 	unsigned width, height;
@@ -288,9 +168,7 @@ Texture Multisampling::createTextureFromAsset(const char *pPath)
 
 	VkDevice device = pContext->getDevice();
 	VkImage image;
-	VkDeviceMemory memory;
-
-	Buffer stagingBuffer = createBuffer(buffer.data(), width * height * 4, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+	DeviceAllocation allocation;
 
 	// We will transition the actual texture into a proper layout before transfering any data, so leave it as undefined.
 	VkImageCreateInfo info = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
@@ -314,13 +192,10 @@ Texture Multisampling::createTextureFromAsset(const char *pPath)
 	VkMemoryRequirements memReqs;
 	vkGetImageMemoryRequirements(device, image, &memReqs);
 
-	VkMemoryAllocateInfo alloc = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-	alloc.allocationSize = memReqs.size;
 	// If a device local memory type exists, we should use that.
-	alloc.memoryTypeIndex =
-	    findMemoryTypeFromRequirementsWithFallback(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-	VK_CHECK(vkAllocateMemory(device, &alloc, nullptr, &memory));
-	vkBindImageMemory(device, image, memory, 0);
+	VK_CHECK(pContext->getAllocator().allocate(memReqs, MemoryTypeSelector::USAGE_DEVICE_LOCAL,
+	                                           DeviceMemoryAllocator::RESOURCE_OPTIMAL, &allocation));
+	vkBindImageMemory(device, image, allocation.memory, allocation.offset);
 
 	// Create an image view for the new texture.
 	// Note that CreateImageView must happen after BindImageMemory.
@@ -339,23 +214,11 @@ Texture Multisampling::createTextureFromAsset(const char *pPath)
 	VkImageView view;
 	VK_CHECK(vkCreateImageView(device, &viewInfo, nullptr, &view));
 
-	// Now we need to transfer the staging texture into the real texture.
-	// For this we will need a command buffer.
-	VkCommandBuffer cmd = pContext->requestPrimaryCommandBuffer();
-
-	// We will only submit this once before it's recycled.
-	VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
-	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-	vkBeginCommandBuffer(cmd, &beginInfo);
-
-	// Transition the uninitialized texture into a TRANSFER_DST_OPTIMAL layout.
-	// We do not need to wait for anything to make the transition, so use TOP_OF_PIPE_BIT as the srcStageMask.
-	imageMemoryBarrier(cmd, image, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-	                   VK_PIPELINE_STAGE_TRANSFER_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-	VkBufferImageCopy region;
-	memset(&region, 0, sizeof(region));
-	region.bufferOffset = 0;
+	// Now we need to transfer the pixels into the real texture.
+	// The upload manager copies them into its persistent staging ring and batches the copy with all other uploads.
+	// Pending uploads are submitted together right before the next command buffers we submit, so we need
+	// neither a staging buffer nor a command buffer of our own.
+	VkBufferImageCopy region = {};
 	region.bufferRowLength = width;
 	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	region.imageSubresource.layerCount = 1;
@@ -363,23 +226,11 @@ Texture Multisampling::createTextureFromAsset(const char *pPath)
 	region.imageExtent.height = height;
 	region.imageExtent.depth = 1;
 
-	// Copy the buffer to our optimally tiled image.
-	vkCmdCopyBufferToImage(cmd, stagingBuffer.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-	// Wait for all transfers to complete before we let any fragment shading begin.
-	imageMemoryBarrier(cmd, image, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
-	                   VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-	                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-	VK_CHECK(vkEndCommandBuffer(cmd));
-	pContext->submit(cmd);
-
-	// We want to free the staging buffer and memory right away, so wait for GPU complete the transfer.
-	vkQueueWaitIdle(pContext->getGraphicsQueue());
-
-	// Now it's safe to free the temporary resources.
-	vkDestroyBuffer(device, stagingBuffer.buffer, nullptr);
-	vkFreeMemory(device, stagingBuffer.memory, nullptr);
+	// The texture is transitioned into a TRANSFER_DST_OPTIMAL layout for the copy, and into a
+	// SHADER_READ_ONLY_OPTIMAL layout once the copy has completed.
+	VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+	pContext->getUploadManager().uploadImage(image, range, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, buffer.data(),
+	                                         buffer.size(), &region, 1, 4);
 
 	// Finally, create a sampler.
 	VkSamplerCreateInfo samplerInfo = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
@@ -399,32 +250,11 @@ Texture Multisampling::createTextureFromAsset(const char *pPath)
 	VK_CHECK(vkCreateSampler(device, &samplerInfo, nullptr, &sampler));
 
 	Texture ret = {
-		image, view, memory, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, sampler, width, height,
+		image, view, allocation, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, sampler, width, height,
 	};
 	return ret;
 }
 
-void Multisampling::imageMemoryBarrier(VkCommandBuffer cmd, VkImage image, VkAccessFlags srcAccessMask,
-                                       VkAccessFlags dstAccessMask, VkPipelineStageFlags srcStageMask,
-                                       VkPipelineStageFlags dstStageMask, VkImageLayout oldLayout,
-                                       VkImageLayout newLayout)
-{
-	VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-
-	barrier.srcAccessMask = srcAccessMask;
-	barrier.dstAccessMask = dstAccessMask;
-	barrier.oldLayout = oldLayout;
-	barrier.newLayout = newLayout;
-	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.image = image;
-	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	barrier.subresourceRange.levelCount = 1;
-	barrier.subresourceRange.layerCount = 1;
-
-	vkCmdPipelineBarrier(cmd, srcStageMask, dstStageMask, false, 0, nullptr, 0, nullptr, 1, &barrier);
-}
-
 Buffer Multisampling::createBuffer(const void *pInitialData, size_t size, VkFlags usage)
 {
 	Buffer buffer;
@@ -440,26 +270,17 @@ Buffer Multisampling::createBuffer(const void *pInitialData, size_t size, VkFlag
 	VkMemoryRequirements memReqs;
 	vkGetBufferMemoryRequirements(device, buffer.buffer, &memReqs);
 
-	VkMemoryAllocateInfo alloc = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-	alloc.allocationSize = memReqs.size;
-
-	// We want host visible and coherent memory to simplify things.
-	alloc.memoryTypeIndex = findMemoryTypeFromRequirements(
-	    memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-	VK_CHECK(vkAllocateMemory(device, &alloc, nullptr, &buffer.memory));
+	// Sub-allocate host visible and coherent memory to simplify things.
+	VK_CHECK(pContext->getAllocator().allocate(memReqs, MemoryTypeSelector::USAGE_UPLOAD,
+	                                           DeviceMemoryAllocator::RESOURCE_LINEAR, &buffer.allocation));
 
 	// Buffers are not backed by memory, so bind our memory explicitly to the buffer.
-	vkBindBufferMemory(device, buffer.buffer, buffer.memory, 0);
+	vkBindBufferMemory(device, buffer.buffer, buffer.allocation.memory, buffer.allocation.offset);
 
-	// Map the memory and dump data in there.
+	// Host visible memory is persistently mapped by the allocator, so dump the
+	// data straight in there.
 	if (pInitialData)
-	{
-		void *pData;
-		VK_CHECK(vkMapMemory(device, buffer.memory, 0, size, 0, &pData));
-		memcpy(pData, pInitialData, size);
-		vkUnmapMemory(device, buffer.memory);
-	}
+		memcpy(buffer.allocation.pHostPointer, pInitialData, size);
 
 	return buffer;
 }
@@ -567,7 +388,7 @@ void Multisampling::initPipelineLayout()
 	bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
 	bindings[1].binding = 1;
-	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	bindings[1].descriptorCount = 1;
 	bindings[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
@@ -708,9 +529,8 @@ bool Multisampling::initialize(Context *pContext)
 	// Load texture.
 	texture = createTextureFromAsset("textures/icon.png");
 
-	// Create a pipeline cache (although we'll only create one pipeline).
-	VkPipelineCacheCreateInfo pipelineCacheInfo = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
-	VK_CHECK(vkCreatePipelineCache(pContext->getDevice(), &pipelineCacheInfo, nullptr, &pipelineCache));
+	// Use the pipeline cache of the context, which is saved between runs.
+	pipelineCache = pContext->getPipelineCache().getCache();
 
 	return true;
 }
@@ -771,14 +591,13 @@ void Multisampling::render(unsigned swapchainIndex, float deltaTime)
 	VkDeviceSize offset = 0;
 	vkCmdBindVertexBuffers(cmd, 0, 1, &vertexBuffer.buffer, &offset);
 
-	// Bind the descriptor set.
-	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frame.descriptorSet, 0,
-	                        nullptr);
+	// Allocate this frame's uniform data from the uniform ring.
+	uint32_t uniformOffset;
+	mat4 *pMatrix = static_cast<mat4 *>(pContext->getUniformRing().allocate(sizeof(mat4), &uniformOffset));
 
-	// Update the uniform buffers memory.
-	mat4 *pMatrix = nullptr;
-	VK_CHECK(vkMapMemory(pContext->getDevice(), frame.uniformBuffer.memory, 0, sizeof(mat4), 0,
-	                     reinterpret_cast<void **>(&pMatrix)));
+	// Bind the descriptor set, with the uniform data at a dynamic offset.
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frame.descriptorSet, 1,
+	                        &uniformOffset);
 
 	float aspect = float(width) / height;
 	float textureAspect = float(texture.width) / texture.height;
@@ -796,7 +615,6 @@ void Multisampling::render(unsigned swapchainIndex, float deltaTime)
 
 	// Fix up the projection matrix so it matches what Vulkan expects.
 	*pMatrix = vulkanStyleProjection(proj) * model;
-	vkUnmapMemory(pContext->getDevice(), frame.uniformBuffer.memory);
 
 	// Draw a quad with one instance.
 	vkCmdDraw(cmd, 4, 1, 0, 0);
@@ -830,9 +648,7 @@ void Multisampling::termBackbuffers()
 		vkDestroyRenderPass(device, renderPass, nullptr);
 		vkDestroyPipeline(device, pipeline, nullptr);
 
-		vkDestroyImageView(device, multisampledRenderTarget.view, nullptr);
-		vkDestroyImage(device, multisampledRenderTarget.image, nullptr);
-		vkFreeMemory(device, multisampledRenderTarget.memory, nullptr);
+		pContext->getTransientAttachmentCache().release(multisampledRenderTarget);
 	}
 }
 
@@ -842,8 +658,6 @@ void Multisampling::termPerFrame()
 
 	for (auto &frame : perFrame)
 	{
-		vkDestroyBuffer(device, frame.uniformBuffer.buffer, nullptr);
-		vkFreeMemory(device, frame.uniformBuffer.memory, nullptr);
 		vkDestroyDescriptorPool(device, frame.descriptorPool, nullptr);
 	}
 	perFrame.clear();
@@ -858,19 +672,18 @@ void Multisampling::terminate()
 
 	// Vertex buffer
 	vkDestroyBuffer(device, vertexBuffer.buffer, nullptr);
-	vkFreeMemory(device, vertexBuffer.memory, nullptr);
+	pContext->getAllocator().free(vertexBuffer.allocation);
 
 	// Texture
 	vkDestroyImageView(device, texture.view, nullptr);
 	vkDestroyImage(device, texture.image, nullptr);
 	vkDestroySampler(device, texture.sampler, nullptr);
-	vkFreeMemory(device, texture.memory, nullptr);
+	pContext->getAllocator().free(texture.allocation);
 
 	// Per-frame resources
 	termPerFrame();
 	termBackbuffers();
 
-	vkDestroyPipelineCache(device, pipelineCache, nullptr);
 	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
 	vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
 }
@@ -881,11 +694,13 @@ void Multisampling::initPerFrame(unsigned numBackbuffers)
 
 	for (unsigned i = 0; i < numBackbuffers; i++)
 	{
+		// The uniform data is allocated from the context's uniform ring every
+		// frame and bound with a dynamic offset, so the descriptor set always
+		// points at the ring buffer.
 		PerFrame frame;
-		frame.uniformBuffer = createBuffer(nullptr, sizeof(mat4), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
 
 		static const VkDescriptorPoolSize poolSizes[2] = {
-			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 }, { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 },
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 }, { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 },
 		};
 
 		VkDescriptorPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
@@ -904,7 +719,7 @@ void Multisampling::initPerFrame(unsigned numBackbuffers)
 			{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET }, { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET },
 		};
 
-		VkDescriptorBufferInfo bufferInfo = { frame.uniformBuffer.buffer, 0, sizeof(mat4) };
+		VkDescriptorBufferInfo bufferInfo = { pContext->getUniformRing().getBuffer(), 0, sizeof(mat4) };
 		VkDescriptorImageInfo imageInfo = { texture.sampler, texture.view, texture.layout };
 
 		writes[0].dstSet = frame.descriptorSet;
@@ -916,7 +731,7 @@ void Multisampling::initPerFrame(unsigned numBackbuffers)
 		writes[1].dstSet = frame.descriptorSet;
 		writes[1].dstBinding = 1;
 		writes[1].descriptorCount = 1;
-		writes[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		writes[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		writes[1].pBufferInfo = &bufferInfo;
 
 		vkUpdateDescriptorSets(device, 2, writes, 0, nullptr);
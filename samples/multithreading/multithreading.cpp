@@ -36,6 +36,7 @@ using namespace glm;
 #define NUM_INSTANCES_Y 32
 #define NUM_INSTANCES (NUM_INSTANCES_X * NUM_INSTANCES_Y)
 #define MAX_INSTANCES_PER_DRAW_CALL 16
+#define INSTANCES_PER_SLICE (MAX_INSTANCES_PER_DRAW_CALL * 4)
 
 // This sample expands rotating_texture with drawing many rotating quads.
 
@@ -57,7 +58,7 @@ struct Buffer
 	VkBuffer buffer;
 
 	// Buffer objects are backed by device memory.
-	VkDeviceMemory memory;
+	DeviceAllocation allocation;
 };
 
 struct Texture
@@ -69,7 +70,7 @@ struct Texture
 	VkImageView view;
 
 	// Memory for the texture.
-	VkDeviceMemory memory;
+	DeviceAllocation allocation;
 
 	// Images have layouts, stores the current layout used.
 	VkImageLayout layout;
@@ -82,7 +83,6 @@ struct Texture
 
 struct PerFrame
 {
-	Buffer uniformBuffer;
 	VkDescriptorSet descriptorSet;
 	VkDescriptorPool descriptorPool;
 };
@@ -131,9 +131,6 @@ private:
 	Buffer createBuffer(const void *pInitial, size_t size, VkFlags usage);
 	Texture createTextureFromAsset(const char *pPath);
 
-	uint32_t findMemoryTypeFromRequirements(uint32_t deviceRequirements, uint32_t hostRequirements);
-	uint32_t findMemoryTypeFromRequirementsWithFallback(uint32_t deviceRequirements, uint32_t hostRequirements);
-
 	void initRenderPass(VkFormat format);
 	void termBackbuffers();
 
@@ -144,68 +141,19 @@ private:
 	void initPipeline();
 	void initPipelineLayout();
 
-	void imageMemoryBarrier(VkCommandBuffer cmd, VkImage image, VkAccessFlags srcAccessMask,
-	                        VkAccessFlags dstAccessMask, VkPipelineStageFlags srcStageMask,
-	                        VkPipelineStageFlags dstStageMask, VkImageLayout oldLayout, VkImageLayout newLayout);
-
 	float accumulatedTime = 0.0f;
 
 	ThreadPool threadPool;
 
-	void renderScene(VkCommandBuffer cmd, unsigned beginInstance, unsigned endInstance, VkDescriptorSet set);
+	VkCommandBuffer beginSecondaryCommandBuffer(VkFramebuffer framebuffer);
+	void renderScene(VkCommandBuffer cmd, unsigned beginInstance, unsigned endInstance, VkDescriptorSet set,
+	                 uint32_t uniformOffset);
 };
 
-// To create a buffer, both the device and application have requirements from the buffer object.
-// Vulkan exposes the different types of buffers the device can allocate, and we have to find a suitable one.
-// deviceRequirements is a bitmask expressing which memory types can be used for a buffer object.
-// The different memory types' properties must match with what the application wants.
-uint32_t MultiThreading::findMemoryTypeFromRequirements(uint32_t deviceRequirements, uint32_t hostRequirements)
-{
-	const VkPhysicalDeviceMemoryProperties &props = pContext->getPlatform().getMemoryProperties();
-	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++)
-	{
-		if (deviceRequirements & (1u << i))
-		{
-			if ((props.memoryTypes[i].propertyFlags & hostRequirements) == hostRequirements)
-			{
-				return i;
-			}
-		}
-	}
-
-	LOGE("Failed to obtain suitable memory type.\n");
-	abort();
-}
-
-uint32_t MultiThreading::findMemoryTypeFromRequirementsWithFallback(uint32_t deviceRequirements,
-                                                                    uint32_t hostRequirements)
-{
-	const VkPhysicalDeviceMemoryProperties &props = pContext->getPlatform().getMemoryProperties();
-	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++)
-	{
-		if (deviceRequirements & (1u << i))
-		{
-			if ((props.memoryTypes[i].propertyFlags & hostRequirements) == hostRequirements)
-			{
-				return i;
-			}
-		}
-	}
-
-	// If we cannot find the particular memory type we're looking for, just pick the first one available.
-	if (hostRequirements != 0)
-		return findMemoryTypeFromRequirements(deviceRequirements, 0);
-	else
-	{
-		LOGE("Failed to obtain suitable memory type.\n");
-		abort();
-	}
-}
-
 Texture MultiThreading::createTextureFromAsset(const char *pPath)
 {
-	// We want to first create a staging buffer.
-	// We will then copy this buffer into an optimally tiled texture with vkCmdCopyBufferToImage.
+	// We want to first load the texture data.
+	// We will then copy it into an optimally tiled texture with vkCmdCopyBufferToImage.
 	// The layout of such a texture is not specified as it is highly GPU-dependent and optimized for
 	// utilizing texture caches better.
 	unsigned width, height;
@@ -219,9 +167,7 @@ Texture MultiThreading::createTextureFromAsset(const char *pPath)
 
 	VkDevice device = pContext->getDevice();
 	VkImage image;
-	VkDeviceMemory memory;
-
-	Buffer stagingBuffer = createBuffer(buffer.data(), width * height * 4, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+	DeviceAllocation allocation;
 
 	// We will transition the actual texture into a proper layout before transfering any data, so leave it as undefined.
 	VkImageCreateInfo info = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
@@ -245,12 +191,9 @@ Texture MultiThreading::createTextureFromAsset(const char *pPath)
 	VkMemoryRequirements memReqs;
 	vkGetImageMemoryRequirements(device, image, &memReqs);
 
-	VkMemoryAllocateInfo alloc = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-	alloc.allocationSize = memReqs.size;
-	alloc.memoryTypeIndex =
-	    findMemoryTypeFromRequirementsWithFallback(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-	VK_CHECK(vkAllocateMemory(device, &alloc, nullptr, &memory));
-	vkBindImageMemory(device, image, memory, 0);
+	VK_CHECK(pContext->getAllocator().allocate(memReqs, MemoryTypeSelector::USAGE_DEVICE_LOCAL,
+	                                           DeviceMemoryAllocator::RESOURCE_OPTIMAL, &allocation));
+	vkBindImageMemory(device, image, allocation.memory, allocation.offset);
 
 	// Create an image view for the new texture.
 	// Note that CreateImageView must happen after BindImageMemory.
@@ -269,22 +212,11 @@ Texture MultiThreading::createTextureFromAsset(const char *pPath)
 	VkImageView view;
 	VK_CHECK(vkCreateImageView(device, &viewInfo, nullptr, &view));
 
-	// Now we need to transfer the staging texture into the real texture.
-	// For this we will need a command buffer.
-	VkCommandBuffer cmd = pContext->requestPrimaryCommandBuffer();
-
-	// We will only submit this once before it's recycled.
-	VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
-	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-	vkBeginCommandBuffer(cmd, &beginInfo);
-
-	imageMemoryBarrier(cmd, image, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-	                   VK_PIPELINE_STAGE_TRANSFER_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
-	                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-	VkBufferImageCopy region;
-	memset(&region, 0, sizeof(region));
-	region.bufferOffset = 0;
+	// Now we need to transfer the pixels into the real texture.
+	// The upload manager copies them into its persistent staging ring and batches the copy with all other uploads.
+	// Pending uploads are submitted together right before the next command buffers we submit, so we need
+	// neither a staging buffer nor a command buffer of our own.
+	VkBufferImageCopy region = {};
 	region.bufferRowLength = width;
 	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	region.imageSubresource.layerCount = 1;
@@ -292,22 +224,11 @@ Texture MultiThreading::createTextureFromAsset(const char *pPath)
 	region.imageExtent.height = height;
 	region.imageExtent.depth = 1;
 
-	// Copy the buffer to our optimally tiled image.
-	vkCmdCopyBufferToImage(cmd, stagingBuffer.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-	imageMemoryBarrier(cmd, image, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
-	                   VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-	                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-	VK_CHECK(vkEndCommandBuffer(cmd));
-	pContext->submit(cmd);
-
-	// We want to free the staging buffer and memory right away, so wait for GPU complete the transfer.
-	vkQueueWaitIdle(pContext->getGraphicsQueue());
-
-	// Now it's safe to free the temporary resources.
-	vkDestroyBuffer(device, stagingBuffer.buffer, nullptr);
-	vkFreeMemory(device, stagingBuffer.memory, nullptr);
+	// The texture is transitioned into a TRANSFER_DST_OPTIMAL layout for the copy, and into a
+	// SHADER_READ_ONLY_OPTIMAL layout once the copy has completed.
+	VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+	pContext->getUploadManager().uploadImage(image, range, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, buffer.data(),
+	                                         buffer.size(), &region, 1, 4);
 
 	// Finally, create a sampler.
 	VkSamplerCreateInfo samplerInfo = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
@@ -327,32 +248,11 @@ Texture MultiThreading::createTextureFromAsset(const char *pPath)
 	VK_CHECK(vkCreateSampler(device, &samplerInfo, nullptr, &sampler));
 
 	Texture ret = {
-		image, view, memory, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, sampler, width, height,
+		image, view, allocation, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, sampler, width, height,
 	};
 	return ret;
 }
 
-void MultiThreading::imageMemoryBarrier(VkCommandBuffer cmd, VkImage image, VkAccessFlags srcAccessMask,
-                                        VkAccessFlags dstAccessMask, VkPipelineStageFlags srcStageMask,
-                                        VkPipelineStageFlags dstStageMask, VkImageLayout oldLayout,
-                                        VkImageLayout newLayout)
-{
-	VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-
-	barrier.srcAccessMask = srcAccessMask;
-	barrier.dstAccessMask = dstAccessMask;
-	barrier.oldLayout = oldLayout;
-	barrier.newLayout = newLayout;
-	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.image = image;
-	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	barrier.subresourceRange.levelCount = 1;
-	barrier.subresourceRange.layerCount = 1;
-
-	vkCmdPipelineBarrier(cmd, srcStageMask, dstStageMask, false, 0, nullptr, 0, nullptr, 1, &barrier);
-}
-
 Buffer MultiThreading::createBuffer(const void *pInitialData, size_t size, VkFlags usage)
 {
 	Buffer buffer;
@@ -368,26 +268,17 @@ Buffer MultiThreading::createBuffer(const void *pInitialData, size_t size, VkFla
 	VkMemoryRequirements memReqs;
 	vkGetBufferMemoryRequirements(device, buffer.buffer, &memReqs);
 
-	VkMemoryAllocateInfo alloc = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-	alloc.allocationSize = memReqs.size;
-
-	// We want host visible and coherent memory to simplify things.
-	alloc.memoryTypeIndex = findMemoryTypeFromRequirements(
-	    memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-	VK_CHECK(vkAllocateMemory(device, &alloc, nullptr, &buffer.memory));
+	// Sub-allocate host visible and coherent memory to simplify things.
+	VK_CHECK(pContext->getAllocator().allocate(memReqs, MemoryTypeSelector::USAGE_UPLOAD,
+	                                           DeviceMemoryAllocator::RESOURCE_LINEAR, &buffer.allocation));
 
 	// Buffers are not backed by memory, so bind our memory explicitly to the buffer.
-	vkBindBufferMemory(device, buffer.buffer, buffer.memory, 0);
+	vkBindBufferMemory(device, buffer.buffer, buffer.allocation.memory, buffer.allocation.offset);
 
-	// Map the memory and dump data in there.
+	// Host visible memory is persistently mapped by the allocator, so dump the
+	// data straight in there.
 	if (pInitialData)
-	{
-		void *pData;
-		VK_CHECK(vkMapMemory(device, buffer.memory, 0, size, 0, &pData));
-		memcpy(pData, pInitialData, size);
-		vkUnmapMemory(device, buffer.memory);
-	}
+		memcpy(buffer.allocation.pHostPointer, pInitialData, size);
 
 	return buffer;
 }
@@ -493,7 +384,7 @@ void MultiThreading::initPipelineLayout()
 	bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
 	bindings[1].binding = 1;
-	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	bindings[1].descriptorCount = 1;
 	bindings[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
@@ -631,8 +522,14 @@ bool MultiThreading::initialize(Context *pContext)
 	this->pContext = pContext;
 
 	// Initialize thread pool for rendering later.
-	threadPool.setWorkerThreadCount(OS::getNumberOfCpuThreads());
-	pContext->setRenderingThreadCount(OS::getNumberOfCpuThreads());
+	// Command buffer recording is on the critical path of every frame, so keep
+	// the workers off the LITTLE cores on big.LITTLE systems.
+	// The main thread records slices too while it waits for the workers, and
+	// every recording thread needs one of the Context's thread slots.
+	unsigned workerThreadCount = glm::min(ThreadPool::getCpuCount(CPU_CLASS_PERFORMANCE),
+	                                      unsigned(Context::MaxRenderingThreads) - 1);
+	threadPool.setWorkerThreadCount(workerThreadCount, CPU_CLASS_PERFORMANCE);
+	pContext->setRenderingThreadCount(workerThreadCount + 1);
 
 	// Create the vertex buffer and instance buffer.
 	initVertexBuffers();
@@ -643,14 +540,40 @@ bool MultiThreading::initialize(Context *pContext)
 	// Load texture.
 	texture = createTextureFromAsset("textures/icon.png");
 
-	// Create a pipeline cache (although we'll only create one pipeline).
-	VkPipelineCacheCreateInfo pipelineCacheInfo = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
-	VK_CHECK(vkCreatePipelineCache(pContext->getDevice(), &pipelineCacheInfo, nullptr, &pipelineCache));
+	// Use the pipeline cache of the context, which is saved between runs.
+	pipelineCache = pContext->getPipelineCache().getCache();
 
 	return true;
 }
 
-void MultiThreading::renderScene(VkCommandBuffer cmd, unsigned beginInstance, unsigned endInstance, VkDescriptorSet set)
+VkCommandBuffer MultiThreading::beginSecondaryCommandBuffer(VkFramebuffer framebuffer)
+{
+	VkCommandBuffer secondaryCmd = pContext->requestSecondaryCommandBuffer();
+	if (secondaryCmd == VK_NULL_HANDLE)
+	{
+		LOGE("Failed to get a secondary command buffer.\n");
+		abort();
+	}
+
+	// Use RENDER_PASS_CONTINUE_BIT since this secondary command buffer will be part of a render pass.
+	// It is possible to use secondary command buffers for other things than just rendering.
+	VkCommandBufferBeginInfo secondaryBeginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+	VkCommandBufferInheritanceInfo inheritance = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+	secondaryBeginInfo.flags =
+	    VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+	secondaryBeginInfo.pInheritanceInfo = &inheritance;
+
+	// The secondary buffer doesn't really know about the primary command buffer yet, so give it some essential knowledge.
+	inheritance.renderPass = renderPass;
+	inheritance.framebuffer = framebuffer;
+	inheritance.subpass = 0;
+
+	vkBeginCommandBuffer(secondaryCmd, &secondaryBeginInfo);
+	return secondaryCmd;
+}
+
+void MultiThreading::renderScene(VkCommandBuffer cmd, unsigned beginInstance, unsigned endInstance, VkDescriptorSet set,
+                                 uint32_t uniformOffset)
 {
 	// Bind the graphics pipeline.
 	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
@@ -678,8 +601,8 @@ void MultiThreading::renderScene(VkCommandBuffer cmd, unsigned beginInstance, un
 	VkBuffer buffers[2] = { vertexBuffer.buffer, instanceBuffer.buffer };
 	vkCmdBindVertexBuffers(cmd, 0, 2, buffers, offsets);
 
-	// Bind the descriptor set.
-	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &set, 0, nullptr);
+	// Bind the descriptor set, with the uniform data at a dynamic offset.
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &set, 1, &uniformOffset);
 
 	// Simulate a lot of draw calls.
 	// NOTE: Normally, you could just instance the quads as is in a single draw call.
@@ -715,10 +638,9 @@ void MultiThreading::render(unsigned swapchainIndex, float deltaTime)
 	clearValue.color.float32[2] = 0.2f;
 	clearValue.color.float32[3] = 1.0f;
 
-	// Update the uniform buffers memory.
-	mat4 *pMatrix = nullptr;
-	VK_CHECK(vkMapMemory(pContext->getDevice(), frame.uniformBuffer.memory, 0, sizeof(mat4), 0,
-	                     reinterpret_cast<void **>(&pMatrix)));
+	// Allocate this frame's uniform data from the uniform ring.
+	uint32_t uniformOffset;
+	mat4 *pMatrix = static_cast<mat4 *>(pContext->getUniformRing().allocate(sizeof(mat4), &uniformOffset));
 
 	float aspect = float(width) / height;
 	float textureAspect = float(texture.width) / texture.height;
@@ -736,7 +658,6 @@ void MultiThreading::render(unsigned swapchainIndex, float deltaTime)
 
 	// Fix up the projection matrix so it matches what Vulkan expects.
 	*pMatrix = vulkanStyleProjection(proj) * model;
-	vkUnmapMemory(pContext->getDevice(), frame.uniformBuffer.memory);
 
 	// Begin the render pass.
 	VkRenderPassBeginInfo rpBegin = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
@@ -750,40 +671,22 @@ void MultiThreading::render(unsigned swapchainIndex, float deltaTime)
 	// We will use secondary command buffers only to submit commands in this subpass.
 	vkCmdBeginRenderPass(cmd, &rpBegin, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
-	unsigned numThreads = threadPool.getWorkerThreadCount();
-	vector<VkCommandBuffer> commandBuffers(numThreads);
-
-	// Push rendering work to threads.
-	for (unsigned i = 0; i < numThreads; i++)
-	{
-		VkCommandBuffer secondaryCmd = pContext->requestSecondaryCommandBuffer(i);
-		commandBuffers[i] = secondaryCmd;
-
-		// Use RENDER_PASS_CONTINUE_BIT since this secondary command buffer will be part of a render pass.
-		// It is possible to use secondary command buffers for other things than just rendering.
-		VkCommandBufferBeginInfo secondaryBeginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
-		VkCommandBufferInheritanceInfo inheritance = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
-		secondaryBeginInfo.flags =
-		    VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
-		secondaryBeginInfo.pInheritanceInfo = &inheritance;
-
-		// The secondary buffer doesn't really know about the primary command buffer yet, so give it some essential knowledge.
-		inheritance.renderPass = renderPass;
-		inheritance.framebuffer = backbuffer.framebuffer;
-		inheritance.subpass = 0;
-
-		vkBeginCommandBuffer(secondaryCmd, &secondaryBeginInfo);
-
-		unsigned beginInstance = (i * NUM_INSTANCES) / numThreads;
-		unsigned endInstance = ((i + 1) * NUM_INSTANCES) / numThreads;
-		VkDescriptorSet descriptorSet = frame.descriptorSet;
-
-		// Push our work to our thread pool.
-		threadPool.pushWorkToThread(i, [=] { renderScene(secondaryCmd, beginInstance, endInstance, descriptorSet); });
-	}
-
-	// Wait for thread pool to go idle.
-	threadPool.waitIdle();
+	// Split the scene into more slices than we have threads.
+	// The thread pool will distribute the slices dynamically, so a thread which is done early
+	// can pick up slices from threads which have been given more expensive work.
+	unsigned numSlices = (NUM_INSTANCES + INSTANCES_PER_SLICE - 1) / INSTANCES_PER_SLICE;
+	vector<VkCommandBuffer> commandBuffers(numSlices);
+	VkDescriptorSet descriptorSet = frame.descriptorSet;
+
+	// Record the slices on our worker threads and this thread. This call returns when all slices have been recorded.
+	threadPool.parallelFor(0, NUM_INSTANCES, INSTANCES_PER_SLICE,
+	                       [&](unsigned, unsigned beginInstance, unsigned endInstance) {
+		                       // We don't know up front which thread will record a slice, so the command buffer
+		                       // is requested from the command pool bound to the thread which actually records it.
+		                       VkCommandBuffer secondaryCmd = beginSecondaryCommandBuffer(backbuffer.framebuffer);
+		                       commandBuffers[beginInstance / INSTANCES_PER_SLICE] = secondaryCmd;
+		                       renderScene(secondaryCmd, beginInstance, endInstance, descriptorSet, uniformOffset);
+		                   });
 
 	// Submit the secondary command buffers to the primary command buffer.
 	vkCmdExecuteCommands(cmd, commandBuffers.size(), commandBuffers.data());
@@ -825,8 +728,6 @@ void MultiThreading::termPerFrame()
 
 	for (auto &frame : perFrame)
 	{
-		vkDestroyBuffer(device, frame.uniformBuffer.buffer, nullptr);
-		vkFreeMemory(device, frame.uniformBuffer.memory, nullptr);
 		vkDestroyDescriptorPool(device, frame.descriptorPool, nullptr);
 	}
 	perFrame.clear();
@@ -841,21 +742,20 @@ void MultiThreading::terminate()
 
 	// Vertex buffers
 	vkDestroyBuffer(device, vertexBuffer.buffer, nullptr);
-	vkFreeMemory(device, vertexBuffer.memory, nullptr);
+	pContext->getAllocator().free(vertexBuffer.allocation);
 	vkDestroyBuffer(device, instanceBuffer.buffer, nullptr);
-	vkFreeMemory(device, instanceBuffer.memory, nullptr);
+	pContext->getAllocator().free(instanceBuffer.allocation);
 
 	// Texture
 	vkDestroyImageView(device, texture.view, nullptr);
 	vkDestroyImage(device, texture.image, nullptr);
 	vkDestroySampler(device, texture.sampler, nullptr);
-	vkFreeMemory(device, texture.memory, nullptr);
+	pContext->getAllocator().free(texture.allocation);
 
 	// Per-frame resources
 	termPerFrame();
 	termBackbuffers();
 
-	vkDestroyPipelineCache(device, pipelineCache, nullptr);
 	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
 	vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
 }
@@ -866,11 +766,13 @@ void MultiThreading::initPerFrame(unsigned numBackbuffers)
 
 	for (unsigned i = 0; i < numBackbuffers; i++)
 	{
+		// The uniform data is allocated from the context's uniform ring every
+		// frame and bound with a dynamic offset, so the descriptor set always
+		// points at the ring buffer.
 		PerFrame frame;
-		frame.uniformBuffer = createBuffer(nullptr, sizeof(mat4), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
 
 		static const VkDescriptorPoolSize poolSizes[2] = {
-			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 }, { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 },
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 }, { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 },
 		};
 
 		VkDescriptorPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
@@ -889,7 +791,7 @@ void MultiThreading::initPerFrame(unsigned numBackbuffers)
 			{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET }, { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET },
 		};
 
-		VkDescriptorBufferInfo bufferInfo = { frame.uniformBuffer.buffer, 0, sizeof(mat4) };
+		VkDescriptorBufferInfo bufferInfo = { pContext->getUniformRing().getBuffer(), 0, sizeof(mat4) };
 		VkDescriptorImageInfo imageInfo = { texture.sampler, texture.view, texture.layout };
 
 		writes[0].dstSet = frame.descriptorSet;
@@ -901,7 +803,7 @@ void MultiThreading::initPerFrame(unsigned numBackbuffers)
 		writes[1].dstSet = frame.descriptorSet;
 		writes[1].dstBinding = 1;
 		writes[1].descriptorCount = 1;
-		writes[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		writes[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		writes[1].pBufferInfo = &bufferInfo;
 
 		vkUpdateDescriptorSets(device, 2, writes, 0, nullptr);
@@ -48,7 +48,7 @@ struct Buffer
 	VkBuffer buffer;
 
 	// Buffer objects are backed by device memory.
-	VkDeviceMemory memory;
+	DeviceAllocation allocation;
 };
 
 struct Texture
@@ -60,7 +60,7 @@ struct Texture
 	VkImageView view;
 
 	// Memory for the texture.
-	VkDeviceMemory memory;
+	DeviceAllocation allocation;
 
 	// Images have layouts, stores the current layout used.
 	VkImageLayout layout;
@@ -72,10 +72,9 @@ struct Texture
 };
 
 // We have one PerFrame struct for every swapchain image.
-// Every swapchain image will have its own uniform buffer and descriptor set.
+// Every swapchain image will have its own descriptor set.
 struct PerFrame
 {
-	Buffer uniformBuffer;
 	VkDescriptorSet descriptorSet;
 	VkDescriptorPool descriptorPool;
 };
@@ -123,9 +122,6 @@ private:
 	Buffer createBuffer(const void *pInitial, size_t size, VkFlags usage);
 	Texture createTextureFromAsset(const char *pPath);
 
-	uint32_t findMemoryTypeFromRequirements(uint32_t deviceRequirements, uint32_t hostRequirements);
-	uint32_t findMemoryTypeFromRequirementsWithFallback(uint32_t deviceRequirements, uint32_t hostRequirements);
-
 	void initRenderPass(VkFormat format);
 	void termBackbuffers();
 
@@ -136,65 +132,14 @@ private:
 	void initPipeline();
 	void initPipelineLayout();
 
-	void imageMemoryBarrier(VkCommandBuffer cmd, VkImage image, VkAccessFlags srcAccessMask,
-	                        VkAccessFlags dstAccessMask, VkPipelineStageFlags srcStageMask,
-	                        VkPipelineStageFlags dstStageMask, VkImageLayout oldLayout, VkImageLayout newLayout);
-
 	float accumulatedTime = 0.0f;
 };
 
-// To create a buffer, both the device and application have requirements from the buffer object.
-// Vulkan exposes the different types of buffers the device can allocate, and we have to find a suitable one.
-// deviceRequirements is a bitmask expressing which memory types can be used for a buffer object.
-// The different memory types' properties must match with what the application wants.
-uint32_t RotatingTexture::findMemoryTypeFromRequirements(uint32_t deviceRequirements, uint32_t hostRequirements)
-{
-	const VkPhysicalDeviceMemoryProperties &props = pContext->getPlatform().getMemoryProperties();
-	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++)
-	{
-		if (deviceRequirements & (1u << i))
-		{
-			if ((props.memoryTypes[i].propertyFlags & hostRequirements) == hostRequirements)
-			{
-				return i;
-			}
-		}
-	}
-
-	LOGE("Failed to obtain suitable memory type.\n");
-	abort();
-}
-
-uint32_t RotatingTexture::findMemoryTypeFromRequirementsWithFallback(uint32_t deviceRequirements,
-                                                                     uint32_t hostRequirements)
-{
-	const VkPhysicalDeviceMemoryProperties &props = pContext->getPlatform().getMemoryProperties();
-	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++)
-	{
-		if (deviceRequirements & (1u << i))
-		{
-			if ((props.memoryTypes[i].propertyFlags & hostRequirements) == hostRequirements)
-			{
-				return i;
-			}
-		}
-	}
-
-	// If we cannot find the particular memory type we're looking for, just pick the first one available.
-	if (hostRequirements != 0)
-		return findMemoryTypeFromRequirements(deviceRequirements, 0);
-	else
-	{
-		LOGE("Failed to obtain suitable memory type.\n");
-		abort();
-	}
-}
-
 Texture RotatingTexture::createTextureFromAsset(const char *pPath)
 {
-	// We want to first create a staging buffer.
+	// We want to first load the texture data.
 	//
-	// We will then copy this buffer into an optimally tiled texture with vkCmdCopyBufferToImage.
+	// We will then copy it into an optimally tiled texture with vkCmdCopyBufferToImage.
 	// The layout of such a texture is not specified as it is highly GPU-dependent and optimized for
 	// utilizing texture caches better.
 	unsigned width, height;
@@ -208,10 +153,7 @@ Texture RotatingTexture::createTextureFromAsset(const char *pPath)
 
 	VkDevice device = pContext->getDevice();
 	VkImage image;
-	VkDeviceMemory memory;
-
-	// Copy commands such as vkCmdCopyBufferToImage will need TRANSFER_SRC_BIT.
-	Buffer stagingBuffer = createBuffer(buffer.data(), width * height * 4, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+	DeviceAllocation allocation;
 
 	// We will transition the actual texture into a proper layout before transfering any data, so leave it as undefined.
 	VkImageCreateInfo info = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
@@ -235,19 +177,16 @@ Texture RotatingTexture::createTextureFromAsset(const char *pPath)
 	VkMemoryRequirements memReqs;
 	vkGetImageMemoryRequirements(device, image, &memReqs);
 
-	VkMemoryAllocateInfo alloc = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-	alloc.allocationSize = memReqs.size;
 	// If a device local memory type exists, we should use that.
 	// DEVICE_LOCAL implies that the device has the fastest possible access to this resource, which
 	// is clearly what we want here.
 	// On integrated GPUs such as Mali, memory types are generally *both* DEVICE_LOCAL and HOST_VISIBLE at the same time,
 	// since the GPU can directly access the same memory as the CPU can.
-	alloc.memoryTypeIndex =
-	    findMemoryTypeFromRequirementsWithFallback(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-	VK_CHECK(vkAllocateMemory(device, &alloc, nullptr, &memory));
+	VK_CHECK(pContext->getAllocator().allocate(memReqs, MemoryTypeSelector::USAGE_DEVICE_LOCAL,
+	                                           DeviceMemoryAllocator::RESOURCE_OPTIMAL, &allocation));
 
 	// Bind the newly allocated memory to the image.
-	vkBindImageMemory(device, image, memory, 0);
+	vkBindImageMemory(device, image, allocation.memory, allocation.offset);
 
 	// Create an image view for the new texture.
 	// Note that CreateImageView must happen after BindImageMemory.
@@ -266,23 +205,11 @@ Texture RotatingTexture::createTextureFromAsset(const char *pPath)
 	VkImageView view;
 	VK_CHECK(vkCreateImageView(device, &viewInfo, nullptr, &view));
 
-	// Now we need to transfer the staging texture into the real texture.
-	// For this we will need a command buffer.
-	VkCommandBuffer cmd = pContext->requestPrimaryCommandBuffer();
-
-	// We will only submit this once before it's recycled.
-	VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
-	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-	vkBeginCommandBuffer(cmd, &beginInfo);
-
-	// Transition the uninitialized texture into a TRANSFER_DST_OPTIMAL layout.
-	// We do not need to wait for anything to make the transition, so use TOP_OF_PIPE_BIT as the srcStageMask.
-	imageMemoryBarrier(cmd, image, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-	                   VK_PIPELINE_STAGE_TRANSFER_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-	VkBufferImageCopy region;
-	memset(&region, 0, sizeof(region));
-	region.bufferOffset = 0;
+	// Now we need to transfer the pixels into the real texture.
+	// The upload manager copies them into its persistent staging ring and batches the copy with all other uploads.
+	// Pending uploads are submitted together right before the next command buffers we submit, so we need
+	// neither a staging buffer nor a command buffer of our own.
+	VkBufferImageCopy region = {};
 	region.bufferRowLength = width;
 	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	region.imageSubresource.layerCount = 1;
@@ -290,23 +217,11 @@ Texture RotatingTexture::createTextureFromAsset(const char *pPath)
 	region.imageExtent.height = height;
 	region.imageExtent.depth = 1;
 
-	// Copy the buffer to our optimally tiled image.
-	vkCmdCopyBufferToImage(cmd, stagingBuffer.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-	// Wait for all transfers to complete before we let any fragment shading begin.
-	imageMemoryBarrier(cmd, image, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
-	                   VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-	                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-	VK_CHECK(vkEndCommandBuffer(cmd));
-	pContext->submit(cmd);
-
-	// We want to free the staging buffer and memory right away, so wait for GPU complete the transfer.
-	vkQueueWaitIdle(pContext->getGraphicsQueue());
-
-	// Now it's safe to free the temporary resources.
-	vkFreeMemory(device, stagingBuffer.memory, nullptr);
-	vkDestroyBuffer(device, stagingBuffer.buffer, nullptr);
+	// The texture is transitioned into a TRANSFER_DST_OPTIMAL layout for the copy, and into a
+	// SHADER_READ_ONLY_OPTIMAL layout once the copy has completed.
+	VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+	pContext->getUploadManager().uploadImage(image, range, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, buffer.data(),
+	                                         buffer.size(), &region, 1, 4);
 
 	// Finally, create a sampler.
 	VkSamplerCreateInfo samplerInfo = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
@@ -326,32 +241,11 @@ Texture RotatingTexture::createTextureFromAsset(const char *pPath)
 	VK_CHECK(vkCreateSampler(device, &samplerInfo, nullptr, &sampler));
 
 	Texture ret = {
-		image, view, memory, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, sampler, width, height,
+		image, view, allocation, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, sampler, width, height,
 	};
 	return ret;
 }
 
-void RotatingTexture::imageMemoryBarrier(VkCommandBuffer cmd, VkImage image, VkAccessFlags srcAccessMask,
-                                         VkAccessFlags dstAccessMask, VkPipelineStageFlags srcStageMask,
-                                         VkPipelineStageFlags dstStageMask, VkImageLayout oldLayout,
-                                         VkImageLayout newLayout)
-{
-	VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-
-	barrier.srcAccessMask = srcAccessMask;
-	barrier.dstAccessMask = dstAccessMask;
-	barrier.oldLayout = oldLayout;
-	barrier.newLayout = newLayout;
-	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.image = image;
-	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	barrier.subresourceRange.levelCount = 1;
-	barrier.subresourceRange.layerCount = 1;
-
-	vkCmdPipelineBarrier(cmd, srcStageMask, dstStageMask, false, 0, nullptr, 0, nullptr, 1, &barrier);
-}
-
 Buffer RotatingTexture::createBuffer(const void *pInitialData, size_t size, VkFlags usage)
 {
 	Buffer buffer;
@@ -367,26 +261,17 @@ Buffer RotatingTexture::createBuffer(const void *pInitialData, size_t size, VkFl
 	VkMemoryRequirements memReqs;
 	vkGetBufferMemoryRequirements(device, buffer.buffer, &memReqs);
 
-	VkMemoryAllocateInfo alloc = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-	alloc.allocationSize = memReqs.size;
-
-	// We want host visible and coherent memory to simplify things.
-	alloc.memoryTypeIndex = findMemoryTypeFromRequirements(
-	    memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-	VK_CHECK(vkAllocateMemory(device, &alloc, nullptr, &buffer.memory));
+	// Sub-allocate host visible and coherent memory to simplify things.
+	VK_CHECK(pContext->getAllocator().allocate(memReqs, MemoryTypeSelector::USAGE_UPLOAD,
+	                                           DeviceMemoryAllocator::RESOURCE_LINEAR, &buffer.allocation));
 
 	// Buffers are not backed by memory, so bind our memory explicitly to the buffer.
-	vkBindBufferMemory(device, buffer.buffer, buffer.memory, 0);
+	vkBindBufferMemory(device, buffer.buffer, buffer.allocation.memory, buffer.allocation.offset);
 
-	// Map the memory and dump data in there.
+	// Host visible memory is persistently mapped by the allocator, so dump the
+	// data straight in there.
 	if (pInitialData)
-	{
-		void *pData;
-		VK_CHECK(vkMapMemory(device, buffer.memory, 0, size, 0, &pData));
-		memcpy(pData, pInitialData, size);
-		vkUnmapMemory(device, buffer.memory);
-	}
+		memcpy(buffer.allocation.pHostPointer, pInitialData, size);
 
 	return buffer;
 }
@@ -476,7 +361,7 @@ void RotatingTexture::initPipelineLayout()
 
 	// In our vertex shader, we have one uniform buffer with layout(set = 0, binding = 1).
 	bindings[1].binding = 1;
-	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	bindings[1].descriptorCount = 1;
 	bindings[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
@@ -616,9 +501,8 @@ bool RotatingTexture::initialize(Context *pContext)
 	// Load texture.
 	texture = createTextureFromAsset("textures/icon.png");
 
-	// Create a pipeline cache (although we'll only create one pipeline).
-	VkPipelineCacheCreateInfo pipelineCacheInfo = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
-	VK_CHECK(vkCreatePipelineCache(pContext->getDevice(), &pipelineCacheInfo, nullptr, &pipelineCache));
+	// Use the pipeline cache of the context, which is saved between runs.
+	pipelineCache = pContext->getPipelineCache().getCache();
 
 	return true;
 }
@@ -679,14 +563,13 @@ void RotatingTexture::render(unsigned swapchainIndex, float deltaTime)
 	VkDeviceSize offset = 0;
 	vkCmdBindVertexBuffers(cmd, 0, 1, &vertexBuffer.buffer, &offset);
 
-	// Bind the descriptor set.
-	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frame.descriptorSet, 0,
-	                        nullptr);
+	// Allocate this frame's uniform data from the uniform ring.
+	uint32_t uniformOffset;
+	mat4 *pMatrix = static_cast<mat4 *>(pContext->getUniformRing().allocate(sizeof(mat4), &uniformOffset));
 
-	// Update the uniform buffers memory.
-	mat4 *pMatrix = nullptr;
-	VK_CHECK(vkMapMemory(pContext->getDevice(), frame.uniformBuffer.memory, 0, sizeof(mat4), 0,
-	                     reinterpret_cast<void **>(&pMatrix)));
+	// Bind the descriptor set, with the uniform data at a dynamic offset.
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frame.descriptorSet, 1,
+	                        &uniformOffset);
 
 	float aspect = float(width) / height;
 	float textureAspect = float(texture.width) / texture.height;
@@ -704,7 +587,6 @@ void RotatingTexture::render(unsigned swapchainIndex, float deltaTime)
 
 	// Fix up the projection matrix so it matches what Vulkan expects.
 	*pMatrix = vulkanStyleProjection(proj) * model;
-	vkUnmapMemory(pContext->getDevice(), frame.uniformBuffer.memory);
 
 	// Draw a quad with one instance.
 	vkCmdDraw(cmd, 4, 1, 0, 0);
@@ -746,8 +628,6 @@ void RotatingTexture::termPerFrame()
 
 	for (auto &frame : perFrame)
 	{
-		vkFreeMemory(device, frame.uniformBuffer.memory, nullptr);
-		vkDestroyBuffer(device, frame.uniformBuffer.buffer, nullptr);
 		vkDestroyDescriptorPool(device, frame.descriptorPool, nullptr);
 	}
 	perFrame.clear();
@@ -762,19 +642,18 @@ void RotatingTexture::terminate()
 
 	// Vertex buffer
 	vkDestroyBuffer(device, vertexBuffer.buffer, nullptr);
-	vkFreeMemory(device, vertexBuffer.memory, nullptr);
+	pContext->getAllocator().free(vertexBuffer.allocation);
 
 	// Texture
 	vkDestroyImageView(device, texture.view, nullptr);
 	vkDestroyImage(device, texture.image, nullptr);
 	vkDestroySampler(device, texture.sampler, nullptr);
-	vkFreeMemory(device, texture.memory, nullptr);
+	pContext->getAllocator().free(texture.allocation);
 
 	// Per-frame resources
 	termPerFrame();
 	termBackbuffers();
 
-	vkDestroyPipelineCache(device, pipelineCache, nullptr);
 	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
 	vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
 }
@@ -785,14 +664,14 @@ void RotatingTexture::initPerFrame(unsigned numBackbuffers)
 
 	for (unsigned i = 0; i < numBackbuffers; i++)
 	{
-		// Create one uniform buffer per swapchain frame. We will update the uniform buffer every frame
-		// and we don't want to stomp on a uniform buffer already in flight.
+		// The uniform data is allocated from the context's uniform ring every
+		// frame and bound with a dynamic offset, so the descriptor set always
+		// points at the ring buffer.
 		PerFrame frame;
-		frame.uniformBuffer = createBuffer(nullptr, sizeof(mat4), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
 
 		// Allocate descriptor set from a pool.
 		static const VkDescriptorPoolSize poolSizes[2] = {
-			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 }, { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 },
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 }, { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 },
 		};
 
 		VkDescriptorPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
@@ -812,7 +691,7 @@ void RotatingTexture::initPerFrame(unsigned numBackbuffers)
 			{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET }, { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET },
 		};
 
-		VkDescriptorBufferInfo bufferInfo = { frame.uniformBuffer.buffer, 0, sizeof(mat4) };
+		VkDescriptorBufferInfo bufferInfo = { pContext->getUniformRing().getBuffer(), 0, sizeof(mat4) };
 		VkDescriptorImageInfo imageInfo = { texture.sampler, texture.view, texture.layout };
 
 		writes[0].dstSet = frame.descriptorSet;
@@ -824,7 +703,7 @@ void RotatingTexture::initPerFrame(unsigned numBackbuffers)
 		writes[1].dstSet = frame.descriptorSet;
 		writes[1].dstBinding = 1;
 		writes[1].descriptorCount = 1;
-		writes[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		writes[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		writes[1].pBufferInfo = &bufferInfo;
 
 		vkUpdateDescriptorSets(device, 2, writes, 0, nullptr);
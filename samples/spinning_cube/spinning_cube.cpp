@@ -48,7 +48,7 @@ struct Buffer
 	VkBuffer buffer;
 
 	// Buffer objects are backed by device memory.
-	VkDeviceMemory memory;
+	DeviceAllocation allocation;
 };
 
 struct Texture
@@ -60,7 +60,7 @@ struct Texture
 	VkImageView view;
 
 	// Memory for the texture.
-	VkDeviceMemory memory;
+	DeviceAllocation allocation;
 
 	// Images have layouts, stores the current layout used.
 	VkImageLayout layout;
@@ -118,22 +118,13 @@ private:
 
 	Texture texture;
 
-	// Memory for the depth buffer.
-	VkDeviceMemory depthBufferMemory;
-
-	// Image for the depth buffer.
-	VkImage depthBufferImage;
-
-	// Image view for the depth buffer.
-	VkImageView depthBufferView;
+	// The depth buffer, which is only used during the render pass.
+	TransientAttachment depthBuffer;
 
 	Buffer createBuffer(const void *pInitial, size_t size, VkFlags usage);
 	Texture createTextureFromAsset(const char *pPath);
 	void initializeDescriptorSets();
 
-	uint32_t findMemoryTypeFromRequirements(uint32_t deviceRequirements, uint32_t hostRequirements);
-	uint32_t findMemoryTypeFromRequirementsWithFallback(uint32_t deviceRequirements, uint32_t hostRequirements);
-
 	void initRenderPass(VkFormat format);
 	void termBackbuffers();
 
@@ -141,67 +132,16 @@ private:
 	void initPipeline();
 	void initPipelineLayout();
 
-	void imageMemoryBarrier(VkCommandBuffer cmd, VkImage image, VkAccessFlags srcAccessMask,
-	                        VkAccessFlags dstAccessMask, VkPipelineStageFlags srcStageMask,
-	                        VkPipelineStageFlags dstStageMask, VkImageLayout oldLayout, VkImageLayout newLayout);
-
 	void initDepthBuffer(unsigned width, unsigned height);
 
 	float accumulatedTime = 0.0f;
 };
 
-// To create a buffer, both the device and application have requirements from the buffer object.
-// Vulkan exposes the different types of buffers the device can allocate, and we have to find a suitable one.
-// deviceRequirements is a bitmask expressing which memory types can be used for a buffer object.
-// The different memory types' properties must match with what the application wants.
-uint32_t SpinningCube::findMemoryTypeFromRequirements(uint32_t deviceRequirements, uint32_t hostRequirements)
-{
-	const VkPhysicalDeviceMemoryProperties &props = pContext->getPlatform().getMemoryProperties();
-	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++)
-	{
-		if (deviceRequirements & (1u << i))
-		{
-			if ((props.memoryTypes[i].propertyFlags & hostRequirements) == hostRequirements)
-			{
-				return i;
-			}
-		}
-	}
-
-	LOGE("Failed to obtain suitable memory type.\n");
-	abort();
-}
-
-uint32_t SpinningCube::findMemoryTypeFromRequirementsWithFallback(uint32_t deviceRequirements,
-                                                                  uint32_t hostRequirements)
-{
-	const VkPhysicalDeviceMemoryProperties &props = pContext->getPlatform().getMemoryProperties();
-	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++)
-	{
-		if (deviceRequirements & (1u << i))
-		{
-			if ((props.memoryTypes[i].propertyFlags & hostRequirements) == hostRequirements)
-			{
-				return i;
-			}
-		}
-	}
-
-	// If we cannot find the particular memory type we're looking for, just pick the first one available.
-	if (hostRequirements != 0)
-		return findMemoryTypeFromRequirements(deviceRequirements, 0);
-	else
-	{
-		LOGE("Failed to obtain suitable memory type.\n");
-		abort();
-	}
-}
-
 Texture SpinningCube::createTextureFromAsset(const char *pPath)
 {
-	// We want to first create a staging buffer.
+	// We want to first load the texture data.
 	//
-	// We will then copy this buffer into an optimally tiled texture with vkCmdCopyBufferToImage.
+	// We will then copy it into an optimally tiled texture with vkCmdCopyBufferToImage.
 	// The layout of such a texture is not specified as it is highly GPU-dependent and optimized for
 	// utilizing texture caches better.
 	unsigned width, height;
@@ -215,9 +155,7 @@ Texture SpinningCube::createTextureFromAsset(const char *pPath)
 
 	VkDevice device = pContext->getDevice();
 	VkImage image;
-	VkDeviceMemory memory;
-
-	Buffer stagingBuffer = createBuffer(buffer.data(), width * height * 4, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+	DeviceAllocation allocation;
 
 	// We will transition the actual texture into a proper layout before transfering any data, so leave it as undefined.
 	VkImageCreateInfo info = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
@@ -241,13 +179,10 @@ Texture SpinningCube::createTextureFromAsset(const char *pPath)
 	VkMemoryRequirements memReqs;
 	vkGetImageMemoryRequirements(device, image, &memReqs);
 
-	VkMemoryAllocateInfo alloc = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-	alloc.allocationSize = memReqs.size;
 	// If a device local memory type exists, we should use that.
-	alloc.memoryTypeIndex =
-	    findMemoryTypeFromRequirementsWithFallback(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-	VK_CHECK(vkAllocateMemory(device, &alloc, nullptr, &memory));
-	vkBindImageMemory(device, image, memory, 0);
+	VK_CHECK(pContext->getAllocator().allocate(memReqs, MemoryTypeSelector::USAGE_DEVICE_LOCAL,
+	                                           DeviceMemoryAllocator::RESOURCE_OPTIMAL, &allocation));
+	vkBindImageMemory(device, image, allocation.memory, allocation.offset);
 
 	// Create an image view for the new texture.
 	// Note that CreateImageView must happen after BindImageMemory.
@@ -266,23 +201,11 @@ Texture SpinningCube::createTextureFromAsset(const char *pPath)
 	VkImageView view;
 	VK_CHECK(vkCreateImageView(device, &viewInfo, nullptr, &view));
 
-	// Now we need to transfer the staging texture into the real texture.
-	// For this we will need a command buffer.
-	VkCommandBuffer cmd = pContext->requestPrimaryCommandBuffer();
-
-	// We will only submit this once before it's recycled.
-	VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
-	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-	vkBeginCommandBuffer(cmd, &beginInfo);
-
-	// Transition the uninitialized texture into a TRANSFER_DST_OPTIMAL layout.
-	// We do not need to wait for anything to make the transition, so use TOP_OF_PIPE_BIT as the srcStageMask.
-	imageMemoryBarrier(cmd, image, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-	                   VK_PIPELINE_STAGE_TRANSFER_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-	VkBufferImageCopy region;
-	memset(&region, 0, sizeof(region));
-	region.bufferOffset = 0;
+	// Now we need to transfer the pixels into the real texture.
+	// The upload manager copies them into its persistent staging ring and batches the copy with all other uploads.
+	// Pending uploads are submitted together right before the next command buffers we submit, so we need
+	// neither a staging buffer nor a command buffer of our own.
+	VkBufferImageCopy region = {};
 	region.bufferRowLength = width;
 	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	region.imageSubresource.layerCount = 1;
@@ -290,23 +213,11 @@ Texture SpinningCube::createTextureFromAsset(const char *pPath)
 	region.imageExtent.height = height;
 	region.imageExtent.depth = 1;
 
-	// Copy the buffer to our optimally tiled image.
-	vkCmdCopyBufferToImage(cmd, stagingBuffer.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-	// Wait for all transfers to complete before we let any fragment shading begin.
-	imageMemoryBarrier(cmd, image, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
-	                   VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-	                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-	VK_CHECK(vkEndCommandBuffer(cmd));
-	pContext->submit(cmd);
-
-	// We want to free the staging buffer and memory right away, so wait for GPU complete the transfer.
-	vkQueueWaitIdle(pContext->getGraphicsQueue());
-
-	// Now it's safe to free the temporary resources.
-	vkDestroyBuffer(device, stagingBuffer.buffer, nullptr);
-	vkFreeMemory(device, stagingBuffer.memory, nullptr);
+	// The texture is transitioned into a TRANSFER_DST_OPTIMAL layout for the copy, and into a
+	// SHADER_READ_ONLY_OPTIMAL layout once the copy has completed.
+	VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+	pContext->getUploadManager().uploadImage(image, range, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, buffer.data(),
+	                                         buffer.size(), &region, 1, 4);
 
 	// Finally, create a sampler.
 	VkSamplerCreateInfo samplerInfo = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
@@ -326,32 +237,11 @@ Texture SpinningCube::createTextureFromAsset(const char *pPath)
 	VK_CHECK(vkCreateSampler(device, &samplerInfo, nullptr, &sampler));
 
 	Texture ret = {
-		image, view, memory, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, sampler, width, height,
+		image, view, allocation, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, sampler, width, height,
 	};
 	return ret;
 }
 
-void SpinningCube::imageMemoryBarrier(VkCommandBuffer cmd, VkImage image, VkAccessFlags srcAccessMask,
-                                      VkAccessFlags dstAccessMask, VkPipelineStageFlags srcStageMask,
-                                      VkPipelineStageFlags dstStageMask, VkImageLayout oldLayout,
-                                      VkImageLayout newLayout)
-{
-	VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-
-	barrier.srcAccessMask = srcAccessMask;
-	barrier.dstAccessMask = dstAccessMask;
-	barrier.oldLayout = oldLayout;
-	barrier.newLayout = newLayout;
-	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.image = image;
-	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	barrier.subresourceRange.levelCount = 1;
-	barrier.subresourceRange.layerCount = 1;
-
-	vkCmdPipelineBarrier(cmd, srcStageMask, dstStageMask, false, 0, nullptr, 0, nullptr, 1, &barrier);
-}
-
 Buffer SpinningCube::createBuffer(const void *pInitialData, size_t size, VkFlags usage)
 {
 	Buffer buffer;
@@ -367,26 +257,17 @@ Buffer SpinningCube::createBuffer(const void *pInitialData, size_t size, VkFlags
 	VkMemoryRequirements memReqs;
 	vkGetBufferMemoryRequirements(device, buffer.buffer, &memReqs);
 
-	VkMemoryAllocateInfo alloc = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-	alloc.allocationSize = memReqs.size;
-
-	// We want host visible and coherent memory to simplify things.
-	alloc.memoryTypeIndex = findMemoryTypeFromRequirements(
-	    memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-	VK_CHECK(vkAllocateMemory(device, &alloc, nullptr, &buffer.memory));
+	// Sub-allocate host visible and coherent memory to simplify things.
+	VK_CHECK(pContext->getAllocator().allocate(memReqs, MemoryTypeSelector::USAGE_UPLOAD,
+	                                           DeviceMemoryAllocator::RESOURCE_LINEAR, &buffer.allocation));
 
 	// Buffers are not backed by memory, so bind our memory explicitly to the buffer.
-	vkBindBufferMemory(device, buffer.buffer, buffer.memory, 0);
+	vkBindBufferMemory(device, buffer.buffer, buffer.allocation.memory, buffer.allocation.offset);
 
-	// Map the memory and dump data in there.
+	// Host visible memory is persistently mapped by the allocator, so dump the
+	// data straight in there.
 	if (pInitialData)
-	{
-		void *pData;
-		VK_CHECK(vkMapMemory(device, buffer.memory, 0, size, 0, &pData));
-		memcpy(pData, pInitialData, size);
-		vkUnmapMemory(device, buffer.memory);
-	}
+		memcpy(buffer.allocation.pHostPointer, pInitialData, size);
 
 	return buffer;
 }
@@ -672,7 +553,6 @@ void SpinningCube::initializeDescriptorSets()
 bool SpinningCube::initialize(Context *pContext)
 {
 	this->pContext = pContext;
-	VkDevice device = pContext->getDevice();
 
 	// Create the vertex buffer.
 	initVertexAndIndexBuffers();
@@ -683,9 +563,8 @@ bool SpinningCube::initialize(Context *pContext)
 	// Load texture.
 	texture = createTextureFromAsset("textures/icon.png");
 
-	// Create a pipeline cache (although we'll only create one pipeline).
-	VkPipelineCacheCreateInfo pipelineCacheInfo = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
-	VK_CHECK(vkCreatePipelineCache(device, &pipelineCacheInfo, nullptr, &pipelineCache));
+	// Use the pipeline cache of the context, which is saved between runs.
+	pipelineCache = pContext->getPipelineCache().getCache();
 
 	// Initialize the descriptor set
 	initializeDescriptorSets();
@@ -810,9 +689,7 @@ void SpinningCube::termBackbuffers()
 		vkDestroyPipeline(device, pipeline, nullptr);
 
 		// Depth buffer
-		vkDestroyImageView(device, depthBufferView, nullptr);
-		vkDestroyImage(device, depthBufferImage, nullptr);
-		vkFreeMemory(device, depthBufferMemory, nullptr);
+		pContext->getTransientAttachmentCache().release(depthBuffer);
 	}
 }
 
@@ -825,27 +702,26 @@ void SpinningCube::terminate()
 
 	// Position buffer.
 	vkDestroyBuffer(device, positionBuffer.buffer, nullptr);
-	vkFreeMemory(device, positionBuffer.memory, nullptr);
+	pContext->getAllocator().free(positionBuffer.allocation);
 
 	// Texture coordinate buffer.
 	vkDestroyBuffer(device, texCoordsBuffer.buffer, nullptr);
-	vkFreeMemory(device, texCoordsBuffer.memory, nullptr);
+	pContext->getAllocator().free(texCoordsBuffer.allocation);
 
 	// Index buffer.
 	vkDestroyBuffer(device, indexBuffer.buffer, nullptr);
-	vkFreeMemory(device, indexBuffer.memory, nullptr);
+	pContext->getAllocator().free(indexBuffer.allocation);
 
 	// Texture.
 	vkDestroyImageView(device, texture.view, nullptr);
 	vkDestroyImage(device, texture.image, nullptr);
 	vkDestroySampler(device, texture.sampler, nullptr);
-	vkFreeMemory(device, texture.memory, nullptr);
+	pContext->getAllocator().free(texture.allocation);
 
 	// Resources
 	vkDestroyDescriptorPool(device, descriptorPool, nullptr);
 	termBackbuffers();
 
-	vkDestroyPipelineCache(device, pipelineCache, nullptr);
 	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
 	vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
 }
@@ -891,7 +767,7 @@ void SpinningCube::updateSwapchain(const vector<VkImage> &newBackbuffers, const
 		VK_CHECK(vkCreateImageView(device, &view, nullptr, &backbuffer.view));
 
 		// Build the framebuffer.
-		VkImageView attachments[2] = { backbuffer.view, depthBufferView };
+		VkImageView attachments[2] = { backbuffer.view, depthBuffer.view };
 		VkFramebufferCreateInfo fbInfo = { VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
 		fbInfo.renderPass = renderPass;
 		fbInfo.attachmentCount = 2;
@@ -908,55 +784,14 @@ void SpinningCube::updateSwapchain(const vector<VkImage> &newBackbuffers, const
 
 void SpinningCube::initDepthBuffer(unsigned width, unsigned height)
 {
-	VkDevice device = pContext->getDevice();
-
-	// Create the image for the depth buffer. Note that imageInfo.usage includes the
-	// VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT flag. This flag allows lazy allocation of the depth buffer.
-	// For Mali GPU this flag will allow the driver to never allocate memory for the depth buffer and use the
+	// The depth buffer is cleared at the beginning of the render pass and discarded at the end of it,
+	// so it is a transient attachment. The transient attachment cache creates the image with the
+	// VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT flag and backs it with lazily allocated memory if possible.
+	// For Mali GPU this allows the driver to never allocate memory for the depth buffer and use the
 	// on-chip tile buffer instead.
-	VkImageCreateInfo imageInfo = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
-	imageInfo.imageType = VK_IMAGE_TYPE_2D;
-	imageInfo.format = depthBufferFormat;
-	imageInfo.extent.width = width;
-	imageInfo.extent.height = height;
-	imageInfo.extent.depth = 1;
-	imageInfo.mipLevels = 1;
-	imageInfo.arrayLayers = 1;
-	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-	imageInfo.usage = VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-
-	VK_CHECK(vkCreateImage(device, &imageInfo, nullptr, &depthBufferImage));
-
-	// Allocate memory for the depth image. Prefer a memory type with lazily allocation support.
-	VkMemoryRequirements memoryRequirements = { 0 };
-	vkGetImageMemoryRequirements(device, depthBufferImage, &memoryRequirements);
-	uint32_t memoryTypeIndex = findMemoryTypeFromRequirementsWithFallback(memoryRequirements.memoryTypeBits,
-	                                                                      VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
-
-	VkMemoryAllocateInfo memInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-	memInfo.allocationSize = memoryRequirements.size;
-	memInfo.memoryTypeIndex = memoryTypeIndex;
-
-	VK_CHECK(vkAllocateMemory(device, &memInfo, nullptr, &depthBufferMemory));
-	VK_CHECK(vkBindImageMemory(device, depthBufferImage, depthBufferMemory, 0));
-
-	// Create the depth buffer image.
-	VkImageViewCreateInfo viewInfo = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
-	viewInfo.image = depthBufferImage;
-	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-	viewInfo.format = depthBufferFormat;
-	viewInfo.components.r = VK_COMPONENT_SWIZZLE_R;
-	viewInfo.components.g = VK_COMPONENT_SWIZZLE_G;
-	viewInfo.components.b = VK_COMPONENT_SWIZZLE_B;
-	viewInfo.components.a = VK_COMPONENT_SWIZZLE_A;
-	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-	viewInfo.subresourceRange.levelCount = 1;
-	viewInfo.subresourceRange.layerCount = 1;
-
-	VK_CHECK(vkCreateImageView(device, &viewInfo, nullptr, &depthBufferView));
+	depthBuffer = pContext->getTransientAttachmentCache().request(depthBufferFormat, width, height,
+	                                                              VK_SAMPLE_COUNT_1_BIT,
+	                                                              VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
 }
 
 VulkanApplication *MaliSDK::createApplication()
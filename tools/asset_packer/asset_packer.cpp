@@ -0,0 +1,232 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Bundles a directory of assets into an asset pack, see framework/asset_pack.hpp.
+// Entries are compressed if that saves at least an eighth of their size.
+//
+// Usage: asset-packer [--no-compress] <assets directory> <output pack>
+
+#include "framework/asset_pack.hpp"
+#include <algorithm>
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+using namespace MaliSDK;
+using namespace std;
+
+namespace
+{
+struct InputFile
+{
+	string name;
+	uint64_t hash;
+	uint64_t size;
+	uint32_t flags;
+	vector<uint8_t> data;
+};
+
+bool readFile(const string &path, vector<uint8_t> *pData)
+{
+	FILE *file = fopen(path.c_str(), "rb");
+	if (!file)
+		return false;
+
+	fseek(file, 0, SEEK_END);
+	long len = ftell(file);
+	rewind(file);
+
+	pData->resize(len);
+	bool ok = len == 0 || fread(pData->data(), 1, len, file) == size_t(len);
+	fclose(file);
+	return ok;
+}
+
+// Collects all regular files below a directory, with names relative to the
+// root of the assets.
+bool collectFiles(const string &root, const string &prefix, const vector<string> &skipPaths, vector<string> *pNames)
+{
+	string dirPath = prefix.empty() ? root : root + "/" + prefix;
+	DIR *dir = opendir(dirPath.c_str());
+	if (!dir)
+	{
+		fprintf(stderr, "Failed to open directory %s.\n", dirPath.c_str());
+		return false;
+	}
+
+	bool ok = true;
+	while (dirent *pEntry = readdir(dir))
+	{
+		if (pEntry->d_name[0] == '.')
+			continue;
+
+		string name = prefix.empty() ? string(pEntry->d_name) : prefix + "/" + pEntry->d_name;
+		string path = root + "/" + name;
+		if (find(begin(skipPaths), end(skipPaths), path) != end(skipPaths))
+			continue;
+
+		struct stat s;
+		if (stat(path.c_str(), &s) < 0)
+			continue;
+
+		if (S_ISDIR(s.st_mode))
+			ok = collectFiles(root, name, skipPaths, pNames) && ok;
+		else if (S_ISREG(s.st_mode))
+			pNames->push_back(name);
+	}
+
+	closedir(dir);
+	return ok;
+}
+
+uint64_t alignOffset(uint64_t offset)
+{
+	return (offset + ASSET_PACK_ALIGNMENT - 1) & ~uint64_t(ASSET_PACK_ALIGNMENT - 1);
+}
+}
+
+int main(int argc, char **argv)
+{
+	bool compress = true;
+	int arg = 1;
+	if (arg < argc && strcmp(argv[arg], "--no-compress") == 0)
+	{
+		compress = false;
+		arg++;
+	}
+
+	if (argc - arg != 2)
+	{
+		fprintf(stderr, "Usage: %s [--no-compress] <assets directory> <output pack>\n", argv[0]);
+		return 1;
+	}
+
+	string root = argv[arg];
+	string outputPath = argv[arg + 1];
+
+	// The pack usually lives in the directory it is built from, so don't pack
+	// an old version of it, or the temporary file of an interrupted run.
+	string tempPath = outputPath + ".tmp";
+	vector<string> names;
+	if (!collectFiles(root, "", { outputPath, tempPath }, &names))
+		return 1;
+
+	vector<InputFile> files;
+	files.reserve(names.size());
+	uint64_t totalSize = 0;
+	for (auto &name : names)
+	{
+		InputFile file;
+		file.name = name;
+		file.hash = hashAssetName(name.c_str(), name.size());
+		file.flags = 0;
+		if (!readFile(root + "/" + name, &file.data))
+		{
+			fprintf(stderr, "Failed to read %s.\n", name.c_str());
+			return 1;
+		}
+		file.size = file.data.size();
+		totalSize += file.size;
+
+		if (compress && !file.data.empty())
+		{
+			vector<uint8_t> compressed;
+			compressAssetData(file.data.data(), file.data.size(), &compressed);
+			if (compressed.size() <= file.data.size() - file.data.size() / 8)
+			{
+				file.data = move(compressed);
+				file.flags |= ASSET_PACK_ENTRY_COMPRESSED;
+			}
+		}
+
+		files.push_back(move(file));
+	}
+
+	// The reader does a binary search over the hashes.
+	sort(begin(files), end(files), [](const InputFile &a, const InputFile &b) {
+		return a.hash != b.hash ? a.hash < b.hash : a.name < b.name;
+	});
+
+	AssetPackHeader header = {};
+	header.magic = ASSET_PACK_MAGIC;
+	header.version = ASSET_PACK_VERSION;
+	header.entryCount = files.size();
+
+	string namesBlob;
+	vector<AssetPackEntry> entries(files.size());
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		entries[i].nameHash = files[i].hash;
+		entries[i].nameOffset = namesBlob.size();
+		entries[i].nameLength = files[i].name.size();
+		entries[i].size = files[i].size;
+		entries[i].storedSize = files[i].data.size();
+		entries[i].flags = files[i].flags;
+		namesBlob += files[i].name;
+	}
+	header.namesSize = namesBlob.size();
+
+	uint64_t offset = sizeof(header) + entries.size() * sizeof(AssetPackEntry) + namesBlob.size();
+	for (auto &entry : entries)
+	{
+		offset = alignOffset(offset);
+		entry.offset = offset;
+		offset += entry.storedSize;
+	}
+
+	// Write to a temporary file first, so an interrupted build never leaves a
+	// truncated pack behind.
+	FILE *output = fopen(tempPath.c_str(), "wb");
+	if (!output)
+	{
+		fprintf(stderr, "Failed to open %s for writing.\n", tempPath.c_str());
+		return 1;
+	}
+
+	bool ok = fwrite(&header, sizeof(header), 1, output) == 1;
+	if (!entries.empty())
+		ok = ok && fwrite(entries.data(), sizeof(AssetPackEntry), entries.size(), output) == entries.size();
+	ok = ok && fwrite(namesBlob.data(), 1, namesBlob.size(), output) == namesBlob.size();
+
+	static const uint8_t padding[ASSET_PACK_ALIGNMENT] = {};
+	uint64_t written = sizeof(header) + entries.size() * sizeof(AssetPackEntry) + namesBlob.size();
+	for (size_t i = 0; i < files.size() && ok; i++)
+	{
+		size_t paddingSize = size_t(entries[i].offset - written);
+		ok = fwrite(padding, 1, paddingSize, output) == paddingSize;
+		ok = ok && fwrite(files[i].data.data(), 1, files[i].data.size(), output) == files[i].data.size();
+		written = entries[i].offset + entries[i].storedSize;
+	}
+
+	ok = fclose(output) == 0 && ok;
+	if (!ok || rename(tempPath.c_str(), outputPath.c_str()) != 0)
+	{
+		fprintf(stderr, "Failed to write %s.\n", outputPath.c_str());
+		remove(tempPath.c_str());
+		return 1;
+	}
+
+	printf("Packed %u assets, %llu KiB into %llu KiB.\n", unsigned(files.size()),
+	       (unsigned long long)(totalSize / 1024), (unsigned long long)(written / 1024));
+	return 0;
+}
@@ -0,0 +1,151 @@
+/* Copyright (c) 2016-2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Compresses an image to a .astc file with the built-in ASTC encoder, see
+// framework/astc_encoder.hpp. The output can be loaded with
+// `loadASTCTextureFromAsset`, like files written by astcenc.
+//
+// Usage: astc-encoder [--block WxH] [--flip-y] [--threads N] <input image> <output.astc>
+
+#include "framework/astc_decoder.hpp"
+#include "framework/astc_encoder.hpp"
+#include "framework/thread_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
+using namespace MaliSDK;
+using namespace std;
+
+namespace
+{
+VkFormat getFormat(unsigned blockWidth, unsigned blockHeight)
+{
+	for (int format = VK_FORMAT_ASTC_4x4_UNORM_BLOCK; format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK; format++)
+	{
+		unsigned width, height;
+		if (getASTCBlockSize(VkFormat(format), &width, &height) && width == blockWidth && height == blockHeight)
+			return VkFormat(format);
+	}
+	return VK_FORMAT_UNDEFINED;
+}
+
+int usage(const char *pName)
+{
+	fprintf(stderr, "Usage: %s [--block WxH] [--flip-y] [--threads N] <input image> <output.astc>\n", pName);
+	return 1;
+}
+}
+
+int main(int argc, char **argv)
+{
+	unsigned blockWidth = 6;
+	unsigned blockHeight = 6;
+	bool flipY = false;
+	unsigned numThreads = thread::hardware_concurrency();
+
+	int arg = 1;
+	for (; arg < argc && strncmp(argv[arg], "--", 2) == 0; arg++)
+	{
+		if (strcmp(argv[arg], "--block") == 0 && arg + 1 < argc)
+		{
+			if (sscanf(argv[++arg], "%ux%u", &blockWidth, &blockHeight) != 2)
+				return usage(argv[0]);
+		}
+		else if (strcmp(argv[arg], "--flip-y") == 0)
+			flipY = true;
+		else if (strcmp(argv[arg], "--threads") == 0 && arg + 1 < argc)
+			numThreads = strtoul(argv[++arg], nullptr, 0);
+		else
+			return usage(argv[0]);
+	}
+
+	if (argc - arg != 2)
+		return usage(argv[0]);
+
+	VkFormat format = getFormat(blockWidth, blockHeight);
+	if (format == VK_FORMAT_UNDEFINED)
+	{
+		fprintf(stderr, "Unsupported block size %u x %u.\n", blockWidth, blockHeight);
+		return 1;
+	}
+
+	int width, height, components;
+	stbi_uc *pPixels = stbi_load(argv[arg], &width, &height, &components, STBI_rgb_alpha);
+	if (!pPixels)
+	{
+		fprintf(stderr, "Failed to load %s: %s.\n", argv[arg], stbi_failure_reason());
+		return 1;
+	}
+
+	// Textures are uploaded bottom row first by some of the samples.
+	size_t rowPitch = size_t(width) * 4;
+	if (flipY)
+	{
+		for (int y = 0; y < height / 2; y++)
+			swap_ranges(pPixels + y * rowPitch, pPixels + (y + 1) * rowPitch, pPixels + (height - 1 - y) * rowPitch);
+	}
+
+	// The calling thread is idle while the pool works, so it needs one worker
+	// less than there are threads.
+	ThreadPool pool;
+	pool.setWorkerThreadCount(max(numThreads, 1u) - 1);
+
+	auto start = chrono::steady_clock::now();
+	vector<uint8_t> blocks;
+	Result res = encodeASTCFromRgba8888(&blocks, pPixels, rowPitch, width, height, format, &pool);
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	stbi_image_free(pPixels);
+	if (FAILED(res))
+	{
+		fprintf(stderr, "Failed to encode %s.\n", argv[arg]);
+		return 1;
+	}
+
+	uint8_t header[ASTC_FILE_HEADER_SIZE];
+	writeASTCFileHeader(header, format, width, height);
+
+	FILE *pFile = fopen(argv[arg + 1], "wb");
+	if (!pFile)
+	{
+		fprintf(stderr, "Failed to create %s.\n", argv[arg + 1]);
+		return 1;
+	}
+
+	bool written = fwrite(header, 1, sizeof(header), pFile) == sizeof(header) &&
+	               fwrite(blocks.data(), 1, blocks.size(), pFile) == blocks.size();
+	if (fclose(pFile) != 0 || !written)
+	{
+		fprintf(stderr, "Failed to write %s.\n", argv[arg + 1]);
+		return 1;
+	}
+
+	printf("Encoded %d x %d texels to %u x %u blocks in %.1f ms.\n", width, height, blockWidth, blockHeight,
+	       seconds * 1000.0);
+	return 0;
+}